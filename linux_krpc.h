@@ -85,11 +85,35 @@ struct rpc_err {
     int re_errno;
 };
 
-#define XDR_INLINE(xdrs,size) NULL      /* can't do it */
-#define IXDR_PUT_U_LONG(buf,what) /*nothing */
-#define IXDR_PUT_LONG(buf,what) /*nothing */
-#define IXDR_GET_U_LONG(buf) 0
-#define IXDR_GET_LONG(buf) 0
+/*
+ * Inline buffer access, as in the classic XDR interface.  XDR_INLINE hands
+ * back a pointer to the next size bytes of the request/reply buffer and
+ * advances past them, or NULL if they aren't all there (or we're freeing).
+ * Callers fall back to the field-by-field routines on NULL, so fixed-size
+ * headers can be moved with the IXDR_* macros without a call per word.
+ */
+typedef s32 rpc_inline_t;
+
+static inline rpc_inline_t *
+mvfs_linux_xdr_inline(
+    XDR *x,
+    u_int size
+)
+{
+    rpc_inline_t *buf;
+
+    if (x->x_op == XDR_FREE || x->x_data + size > x->x_limit)
+        return NULL;
+    buf = (rpc_inline_t *)x->x_data;
+    x->x_data += size;
+    return buf;
+}
+
+#define XDR_INLINE(xdrs,size) mvfs_linux_xdr_inline((xdrs), (size))
+#define IXDR_PUT_U_LONG(buf,what) (*(buf)++ = (rpc_inline_t)htonl((u32)(what)))
+#define IXDR_PUT_LONG(buf,what) IXDR_PUT_U_LONG(buf,what)
+#define IXDR_GET_U_LONG(buf) ((u_long)ntohl((u32)*(buf)++))
+#define IXDR_GET_LONG(buf) ((long)(s32)ntohl((u32)*(buf)++))
 
 #define xdr_short undefined_mvfs_rhat_xdr_short
 /*#define xdr_opaque mvfs_rhat_xdr_opaque*/
@@ -1180,6 +1180,9 @@ typedef struct mvfs_bhinfo mvfs_bhinfo_t;
 /*
  * Structure for fetching stats
  * Only those buffers with non-NULL ptrs are fetched.
+ * Callers built before viewenctime/viewdectime were added pass the shorter
+ * structure; the MVFS takes the buffers that were passed and leaves the
+ * rest unset.
  */
 
 struct mvfs_statbufs {
@@ -1197,6 +1200,8 @@ struct mvfs_statbufs {
 	OPTIONAL mfs_strbuf_t viewopcnt;
 	OPTIONAL mfs_strbuf_t viewoptime;
 	OPTIONAL mfs_strbuf_t viewophist;
+	OPTIONAL mfs_strbuf_t viewenctime;	/* XDR encode time per view op */
+	OPTIONAL mfs_strbuf_t viewdectime;	/* XDR decode time per view op */
 };
 typedef struct mvfs_statbufs mvfs_statbufs_t;
 	
@@ -1535,6 +1540,17 @@ typedef struct mvfs_cache_usage {
 #define	MVFS_CACHE_MFREE	4
 #define	MVFS_CACHE_CTFREE	5
 #define	MVFS_CACHE_RPCHANDLES	6
+/*
+ * Per NUMA node occupancy.  Nodes are folded into MVFS_CACHE_NUMA_MAXNODES
+ * slots (node id modulo the slot count).  [INUSE][MVFS_CACHE_NUMA_NODES]
+ * is the number of slots in use, [MAX][MVFS_CACHE_NUMA_NODES] the number
+ * of slots there is room for.  The per node entries only have an INUSE
+ * count; their MAX is the total for the cache, reported above.
+ */
+#define	MVFS_CACHE_NUMA_NODES	7
+#define	MVFS_CACHE_NUMA_MAXNODES 4
+#define	MVFS_CACHE_MFREE_NODE(n) (8 + (n))	/* vob freelist mnodes */
+#define	MVFS_CACHE_DNC_NODE(n)	(12 + (n))	/* DNC entries in use */
 
 /*
  * MVFS_CMD_GET_CACHE_USAGE fetches the various cache sizes and usage counts
@@ -1576,7 +1592,7 @@ typedef struct mvfs_cache_sizes {
 #define MVFS_SETCACHE_AGE_CVP_TIME      10
 #define MVFS_SETCACHE_VOBHASHTAB_SZ     11 /* mount-time only */
 #define MVFS_SETCACHE_CVPHASHTAB_SZ     12 /* mount-time only */
-#define MVFS_SETCACHE_DNCHASHTAB_SZ     13 /* mount-time only */
+#define MVFS_SETCACHE_DNCHASHTAB_SZ     13 /* resized in place at run-time */
 #define MVFS_SETCACHE_THREADHASHTAB_SZ  14 /* mount-time only */
 #define MVFS_SETCACHE_PROCHASHTAB_SZ    15 /* mount-time only */
 #define MVFS_SETCACHE_LARGEINIT         16 /* mount-time only */
@@ -1596,7 +1612,6 @@ typedef struct mvfs_cache_sizes {
   MVFS_CACHEBIT(CVPHASHTAB_SZ) |                  \
   MVFS_CACHEBIT(OTHERHASHTAB_SZ) |                \
   MVFS_CACHEBIT(VOBFREEHASHTAB_SZ) |              \
-  MVFS_CACHEBIT(DNCHASHTAB_SZ) |                \
   MVFS_CACHEBIT(THREADHASHTAB_SZ) |             \
   MVFS_CACHEBIT(PROCHASHTAB_SZ) |               \
   MVFS_CACHEBIT(RDDIR_BLOCKS) |                 \
@@ -1892,13 +1907,80 @@ typedef struct mvfs_mkviewtag_info_ex mvfs_mkviewtag_info_ex_t;
 #define MVFS_CMD_ENABLE_PVIEW_STATS 63
 #define MVFS_CMD_DISABLE_PVIEW_STATS 64
 
+/*
+ * Bulk read of the MVFS Name Cache.
+ *
+ * Fills the caller's buffer with as many name cache entries as fit,
+ * packed as variable-length mvfs_iodncrec records, and returns a cursor
+ * to pass back in for the next batch.  Names are returned in full (unlike
+ * MVFS_CMD_READ_DNC).  The cache is only locked one hash chain at a time,
+ * so a dump of a busy cache is not a snapshot: entries added or removed
+ * while it runs may or may not be seen.
+ *
+ * Each record is followed by its strings, each NUL terminated, in the
+ * order name, dir view tag, result view tag, mount point.  The lengths
+ * in the record don't count the NULs; reclen does, and is rounded up to
+ * a multiple of 8 so the next record is aligned.  A view tag is empty if
+ * the view has gone away since the entry was read.
+ *
+ * The kernel never fills more than MVFS_IODNCBULK_BUFMAX bytes per call,
+ * so there is no point passing a bigger buffer.  ENOSPC means buflen was
+ * too small for even one record.
+ */
+#define MVFS_IODNCBULK_BUFMAX	(64*1024)
+
+struct mvfs_iodncrec {
+	ks_uint32_t  reclen;	/* Bytes in record, strings included */
+	ks_uint16_t  flags;	/* MVFS_IONC_* flags */
+	ks_uint16_t  namelen;	/* Length of name */
+	ks_uint16_t  dvwlen;	/* Length of dir view tag */
+	ks_uint16_t  vvwlen;	/* Length of result view tag */
+	ks_uint16_t  mplen;	/* Length of mount point pname */
+	ks_uint16_t  pad;
+	ks_uint32_t  hits;	/* Lookups satisfied since added */
+	ks_uint32_t  age;	/* Seconds since added or changed */
+	ks_uint32_t  ddbid;	/* Dir FID */
+	ks_uint32_t  dgen;
+	ks_uint32_t  vdbid;	/* Result FID (0.0 for ENOENT entries) */
+	ks_uint32_t  vgen;
+};
+typedef struct mvfs_iodncrec mvfs_iodncrec_t;
+
+struct mvfs_iodncbulk {
+	ks_uint64_t  cursor;	/* (INOUT) where to resume; 0 to start */
+	ks_uint64_t  buf;	/* (IN) user address of record buffer */
+	ks_uint32_t  buflen;	/* (IN) size of buffer */
+	ks_uint32_t  used;	/* (OUT) bytes of records returned */
+	ks_uint32_t  count;	/* (OUT) number of records returned */
+	ks_uint32_t  eocache;	/* (OUT) non-zero if no more entries */
+};
+typedef struct mvfs_iodncbulk mvfs_iodncbulk_t;
+
+#define MVFS_CMD_READ_DNC_BULK 65
+/*
+ * {
+ *     int rc;
+ *
+ *     bulkp->cursor = 0;
+ *     do {
+ *         MVFS_CMD(mh, rc, status, MVFS_CMD_READ_DNC_BULK,
+ *		    0,
+ *		    &MFS_NULL_STRBUFPN_PAIR, bulkp, sizeof(*bulkp));
+ *         if (rc != 0) {
+ *             <error handling>
+ *         }
+ *         <walk bulkp->count records in bulkp->buf>
+ *     } while (!bulkp->eocache);
+ * }
+ */
+
 #define MVFS_FILEUTL_ABSOBJPN(AP, AOP, SZAOP, RC) *(AOP) = NULLC, (RC) = 0
 
 /*
  * Used for validation in mfs_vnodeops.c
  */
 #define MVFS_CMD_MIN 1
-#define MVFS_CMD_MAX 64
+#define MVFS_CMD_MAX 65
 
 #endif /* MFSMIOCTL_H_ */
 /* $Id: d0b818f4.009611e3.8267.00:01:84:c3:8a:52 $ */
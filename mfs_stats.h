@@ -101,7 +101,16 @@ extern char  *mfs_viewopnames[];
  * is moved to the end of the each structure.
  */
 
-#define MFS_CLNTSTAT_VERS	3
+/*
+ * View server health states, indexing the vwhlthtrans stats below.  See
+ * mvfs_vwhealth_enter() in mvfs_rpcutl.c.
+ */
+#define MVFS_VWHLTH_HEALTHY	0	/* Server is answering */
+#define MVFS_VWHLTH_SUSPECT	1	/* A call timed out, probe in progress */
+#define MVFS_VWHLTH_DOWN	2	/* Probe got no reply */
+#define MVFS_VWHLTH_NSTATES	3
+
+#define MFS_CLNTSTAT_VERS	4
 struct mfs_clntstat {
 	MVFS_STAT_CNT_T  clntget;		/* Clnt statistics */
 	MVFS_STAT_CNT_T  clntfree;
@@ -115,10 +124,25 @@ struct mfs_clntstat {
 	MVFS_STAT_CNT_T  mfsmaxdelay;	/* Number of RPC's longer than 30 secs */
 	MVFS_STAT_CNT_T  mfsmaxdelaytime;	/* Longest delayed RPC */
 	timestruc_t  mvfsthread_time;	/* thread/process gunk timing */
+	MVFS_STAT_CNT_T  vwhlthtrans[MVFS_VWHLTH_NSTATES]; /* Entries to state */
+	MVFS_STAT_CNT_T  vwhlthfastfail;	/* Calls failed without an RPC */
+	MVFS_STAT_CNT_T  vwhlthwait;	/* Calls that waited for a probe */
+	MVFS_STAT_CNT_T  vwhlthdetect;	/* Secs from SUSPECT to DOWN (sum) */
+	MVFS_STAT_CNT_T  vwhlthrecover;	/* Secs not HEALTHY (sum) */
+	MVFS_STAT_CNT_T  vwhlthmaxrecover;	/* Longest time not HEALTHY */
         ks_uint32_t    version;
 };
 
-#define MFS_MNSTAT_VERS		6
+/*
+ * Periodic maintenance tasks, indexing the mnmaint* stats below.  See
+ * mvfs_maint_run() in mvfs_vfsops.c.
+ */
+#define MVFS_MAINT_PROCPURGE	0	/* Dead process cleanup */
+#define MVFS_MAINT_CREDLIST	1	/* Cleartext cred list trimming */
+#define MVFS_MAINT_CLEANHM	2	/* Idle history-mode view removal */
+#define MVFS_MAINT_NTASKS	3
+
+#define MFS_MNSTAT_VERS		9
 struct mfs_mnstat {
 	MVFS_STAT_CNT_T  mnget;		/* Mnode statistics */
         MVFS_STAT_CNT_T  mnfound;
@@ -134,10 +158,20 @@ struct mfs_mnstat {
         MVFS_STAT_CNT_T  mnotherhashcnt;
         MVFS_STAT_CNT_T  mnflushvfscnt;
         MVFS_STAT_CNT_T  mnflushvwcnt;
+        MVFS_STAT_CNT_T  mnshrinkvobfree;	/* Released at kernel's request */
+        MVFS_STAT_CNT_T  mnshrinkcvpfree;
+        MVFS_STAT_CNT_T  mnshrinkdnc;
+        MVFS_STAT_CNT_T  mnshrinkrddir;
+        MVFS_STAT_CNT_T  mnfreelistpass;	/* Background freelist passes */
+        MVFS_STAT_CNT_T  mnfreelistinline;	/* Freelist trimmed by caller */
+        MVFS_STAT_CNT_T  mnmaintrun[MVFS_MAINT_NTASKS];  /* Task runs */
+        MVFS_STAT_CNT_T  mnmaintbusy[MVFS_MAINT_NTASKS]; /* Skipped, running */
+        MVFS_STAT_CNT_T  mnmaintlate[MVFS_MAINT_NTASKS]; /* Ran a period late */
+        MVFS_STAT_CNT_T  mnmaintusec[MVFS_MAINT_NTASKS]; /* Run time (usec) */
         ks_uint32_t    version;
 };
 
-#define MFS_CLEARSTAT_VERS	5
+#define MFS_CLEARSTAT_VERS	6
 struct mfs_clearstat {
 	MVFS_STAT_CNT_T  clearget;	/* Cleartext op statistics */
 	MVFS_STAT_CNT_T  clearcreate;
@@ -160,6 +194,11 @@ struct mfs_clearstat {
 	MVFS_STAT_CNT_T  clearreclaim;	/* reclaimed from free list */
 	MVFS_STAT_CNT_T  clearreclaimmiss;/* had cltxt but we dropped it */
 	MVFS_STAT_CNT_T  cleargetlkup;	/* lookups for creds */
+	MVFS_STAT_CNT_T  clearprefetch;	/* prefetches queued */
+	MVFS_STAT_CNT_T  clearprefetchdone; /* prefetches which got cltxt */
+	MVFS_STAT_CNT_T  clearprefetchdrop; /* prefetches over limits */
+	MVFS_STAT_CNT_T  clearprefetcherr; /* prefetches which failed */
+	MVFS_STAT_CNT_T  clearprefetchhit; /* prefetched cltxt later used */
         ks_uint32_t    version;
 };
 
@@ -172,7 +211,7 @@ struct mfs_rvcstat {
         ks_uint32_t    version;
 }; 
 
-#define MFS_DNCSTAT_VERS	5
+#define MFS_DNCSTAT_VERS	6
 struct mfs_dncstat {			/* Protect with DNC spinlock! */
 	MVFS_STAT_CNT_T  dnc_hits;	/* Hits (total) */
 	MVFS_STAT_CNT_T  dnc_hitdot;	/* Hits because looked up "." */
@@ -213,10 +252,11 @@ struct mfs_dncstat {			/* Protect with DNC spinlock! */
 	MVFS_STAT_CNT_T  dnc_missdir;	/* missed on dir */
 	MVFS_STAT_CNT_T  dnc_missreg;	/* missed on regular file */
 	MVFS_STAT_CNT_T  dnc_missnoent;	/* missed on noent */
+	MVFS_STAT_CNT_T  dnc_lookupshared; /* lookup RPCs saved by waiting */
         ks_uint32_t    version;
 };
 
-#define MFS_ACSTAT_VERS		4
+#define MFS_ACSTAT_VERS		6
 struct mfs_acstat {
 	MVFS_STAT_CNT_T  ac_hits;		/* Attribute cache statistics */
         MVFS_STAT_CNT_T  ac_misses;
@@ -233,6 +273,9 @@ struct mfs_acstat {
 	MVFS_STAT_CNT_T  ac_lvutmiss;	/* misses on LVUT as part of timo miss */
         MVFS_STAT_CNT_T ac_rddirhit;	/* rddir hits */
         MVFS_STAT_CNT_T ac_rddirmiss;	/* rddir misses */
+        MVFS_STAT_CNT_T ac_shared;	/* getattr RPCs saved by waiting */
+        MVFS_STAT_CNT_T ac_revalsame;	/* refetched attrs were unchanged */
+        MVFS_STAT_CNT_T ac_revalchanged; /* refetched attrs had changed */
         ks_uint32_t    version;
 };
 
@@ -255,11 +298,16 @@ struct mfs_austat {
         ks_uint32_t    version;
 };
 
-#define MVFS_EACSTAT_VERS 1
+#define MVFS_EACSTAT_VERS 3
 struct mvfs_eacstat {
     MVFS_STAT_CNT_T  eac_hits;      /* EACL cache statistics */
     MVFS_STAT_CNT_T  eac_misses;
     MVFS_STAT_CNT_T  eac_hashcnt;
+    MVFS_STAT_CNT_T  eac_dchits;    /* Access decisions reused */
+    MVFS_STAT_CNT_T  eac_dcmisses;  /* Access decisions evaluated */
+    MVFS_STAT_CNT_T  eac_evalusec;  /* Total usec spent evaluating */
+    MVFS_STAT_CNT_T  eac_fetches;   /* EACL fetches from the view */
+    MVFS_STAT_CNT_T  eac_fetchwaits; /* Waits on another caller's fetch */
     ks_uint32_t    version;
 };
 
@@ -151,6 +151,16 @@ mvfs_eaclhash_validate_eaclh(
     CRED_T *cred
 );
 
+STATIC tbs_status_t MVFS_NOINLINE
+mvfs_eaclhash_check(
+    mvfs_eaclhash_entry_p ep,
+    tbs_acl_permission_set_t requested_perms,
+    CRED_T *cred,
+    const tbs_sid_acl_id_principal_t *owner_usid_p,
+    const tbs_sid_acl_id_principal_t *owner_gsid_p,
+    tbs_boolean_t *granted_p
+);
+
 STATIC void MVFS_NOINLINE
 mvfs_eaclhash_dump(void);
 
@@ -300,11 +310,8 @@ mvfs_chkaccess_acl(
                 requested_perms |= ELEMENT_RIGHTS_READ_INFO;
             }
         }
-        status =
-            tbs_sid_acl_check_permission_creds(ep->eah_eaclh,
-                                               requested_perms, cred,
-                                               owner_usid_p, owner_gsid_p,
-                                               &granted);
+        status = mvfs_eaclhash_check(ep, requested_perms, cred,
+                                     owner_usid_p, owner_gsid_p, &granted);
 
         if (status == TBS_ST_OK) {
             error = (granted ? 0 : EACCES);
@@ -733,9 +740,14 @@ mvfs_acl_inval_oid(
                  MFS_OIDEQ(ep->eah_policy_oid, *obj_oid_p)))
             {
                 /* Setting the time to zero will cause the EACL to be re-fetched
-                ** the next time someone validates this entry.
+                ** the next time someone validates this entry.  If a fetch is
+                ** in flight it may have read the old EACL, so have it publish
+                ** a zero time, too.
                 */
                 MVFS_INIT_TIMEVAL(ep->eah_eacl_lut);
+                if (ep->eah_fetching) {
+                    ep->eah_stale = TRUE;
+                }
             }
         }
         MVFS_EACLHASH_UNLOCK(&mlplockp);
@@ -842,9 +854,10 @@ mvfs_eaclhash_get(
     /* We only need to compute this once, and then pass it around. */
     hash_val = MVFS_EACLHASH(macldp, keyp);
 
-    /* We need to hold this lock while we use the entry fields, even for the
-    ** duration of the EACL update RPC.  We may want to consider a per-entry
-    ** lock if this gets to be too much.
+    /* We need to hold this lock while we use the entry fields.  It is dropped
+    ** for the duration of the EACL update RPC (see
+    ** mvfs_eaclhash_update_eaclh), which is why a new entry goes into the
+    ** hashtable before its EACL is fetched.
     */
     MVFS_EACLHASH_LOCK(macldp, hash_val, &mlplockp);
 
@@ -869,17 +882,24 @@ mvfs_eaclhash_get(
             new_ep->eah_key.eah_view_type = keyp->eah_view_type;
             MVFS_INIT_TIMEVAL(new_ep->eah_eacl_lut);
             new_ep->eah_policy_oid = TBS_OID_NULL;
+            new_ep->eah_gen = 0;
+            new_ep->eah_fetching = FALSE;
+            new_ep->eah_stale = FALSE;
+            INITLOCK(&(new_ep->eah_fetchlock), "eahfetch");
+            new_ep->eah_dcnext = 0;
+            BZERO(new_ep->eah_dcache, sizeof(new_ep->eah_dcache));
 
             /* Set the eah_eaclh field to NULL since the
             ** mvfs_eaclhash_update_eacl assumes it is overwriting a previous
-            ** one if it is non-NULL.  Note, this call also fills in the real
-            ** values for the policy_oid and lut that we initialized above
-            ** (since it does an RPC to get all that information).
+            ** one if it is non-NULL.  Add the entry before fetching so that
+            ** racing lookups of the same key find it and wait on our fetch
+            ** rather than start their own.  Note, the update also fills in
+            ** the real values for the policy_oid and lut that we initialized
+            ** above (since it does an RPC to get all that information).
             */
             new_ep->eah_eaclh = NULL;
-            mvfs_eaclhash_update_eaclh(new_ep, hash_val, mnp, vfsp, cred);
-
             mvfs_eaclhash_add_entry(new_ep, hash_val);
+            mvfs_eaclhash_update_eaclh(new_ep, hash_val, mnp, vfsp, cred);
             ep = new_ep;
         }
     }
@@ -1046,21 +1066,35 @@ mvfs_eaclhash_free_entry(
     mvfs_eaclhash_entry_p ep
 )
 {
+    int i;
+
     DEBUG_ASSERT(ep != NULL);
     DEBUG_ASSERT(ep->eah_hdr.next == NULL);
     DEBUG_ASSERT(ep->eah_hdr.prev == NULL);
     DEBUG_ASSERT(ep->eah_refcnt == 0);
+    DEBUG_ASSERT(!ep->eah_fetching);
 
     if (ep->eah_eaclh != TBS_SID_ACL_H_NULL) {
         tbs_sid_acl_free(&(ep->eah_eaclh));
     }
+    FREELOCK(&(ep->eah_fetchlock));
+    for (i = 0; i < MVFS_EACL_DCACHE_SLOTS; i++) {
+        if (ep->eah_dcache[i].ead_cred != NULL) {
+            MDKI_CRFREE(ep->eah_dcache[i].ead_cred);
+        }
+    }
     MDB_VLOG((MFS_VACCESS, "mvfs_eaclhash_free_entry: ep=%p\n", ep));
     KMEM_FREE(ep, sizeof(struct mvfs_eaclhash_entry));
 }
 
 /* MVFS_EACLHASH_UPDATE_EACLH - Update the EACL handle in an EACL hashtable
-** entry.  Free the current one first, if necessary, and then make the RPC to
-** the view server to get the updated EACL handle.
+** entry by making the RPC to the view server to get the updated EACL handle.
+** Called and returns with the chain lock held, but drops it for the RPC so a
+** slow view server doesn't hold up lookups of other entries on the chain.  The
+** new EACL is assembled privately and swapped in (and the old one freed) under
+** the chain lock.  Only one caller fetches for an entry at a time; anyone else
+** who needs it updated meanwhile waits for that fetch and uses its result.
+** The caller's reference on the entry keeps it around while unlocked.
 */
 STATIC void MVFS_NOINLINE
 mvfs_eaclhash_update_eaclh(
@@ -1076,14 +1110,44 @@ mvfs_eaclhash_update_eaclh(
     tbs_boolean_t restarted;
     view_eacl_cursor_t cursor;
     tbs_status_t status;
+    tbs_sid_acl_h_t eaclh = TBS_SID_ACL_H_NULL;
+    tbs_sid_acl_h_t old_eaclh;
+    struct timeval lut;
+    tbs_oid_t policy_oid;
+    LOCK_T *mlplockp;
+    mvfs_acl_data_t *macldp = MDKI_ACL_GET_DATAP();
 
     DEBUG_ASSERT(ep != NULL);
     DEBUG_ASSERT(mvfs_eaclhash_islocked(&(ep->eah_key), hash_val));
 
-    /* We're going to replace the existing EACL handle, so free it first. */
-    if (ep->eah_eaclh != TBS_SID_ACL_H_NULL) {
-        tbs_sid_acl_free(&(ep->eah_eaclh));
+    /* We were called with this chain's lock held, find it again so we can drop
+    ** it and retake it.
+    */
+    MVFS_LOCK_SELECT(&(macldp->mvfs_eaclhash_mlp), hash_val,
+                     HASH_MVFS_LOCK_MAP, &mlplockp);
+
+    if (ep->eah_fetching) {
+        /* Someone else is already fetching this EACL.  Wait for them to
+        ** publish it (they hold the fetch lock until then) and use theirs.
+        */
+        MVFS_EACLHASH_UNLOCK(&mlplockp);
+        BUMPSTAT(mvfs_eacstat.eac_fetchwaits);
+        MVFS_LOCK(&(ep->eah_fetchlock));
+        MVFS_UNLOCK(&(ep->eah_fetchlock));
+        MVFS_EACLHASH_LOCK(macldp, hash_val, &mlplockp);
+        MDB_VLOG((MFS_VACCESS, "mvfs_eaclhash_update_eaclh: ep=%p waited\n",
+                  ep));
+        return;
     }
+    ep->eah_fetching = TRUE;
+    ep->eah_stale = FALSE;
+    MVFS_LOCK(&(ep->eah_fetchlock));
+
+    /* The RPC leaves the policy_oid alone on errors, so start from ours. */
+    lut = ep->eah_eacl_lut;
+    policy_oid = ep->eah_policy_oid;
+    MVFS_EACLHASH_UNLOCK(&mlplockp);
+    BUMPSTAT(mvfs_eacstat.eac_fetches);
     /* Call the RPC repeatedly, using a cursor, to accumulate and reassemble all
     ** the parts of the EACL.  The first call will allocate space for the entire
     ** EACL and return a non-null cursor offset if more data must be retrieved
@@ -1103,9 +1167,9 @@ mvfs_eaclhash_update_eaclh(
         error = mvfs_clnt_get_eacl_mnp(mnp, vfsp, cred,
                                        &(ep->eah_key.eah_rolemap_oid),
                                        &cursor,
-                                       &(ep->eah_eaclh),
-                                       &(ep->eah_eacl_lut),
-                                       &(ep->eah_policy_oid),
+                                       &eaclh,
+                                       &lut,
+                                       &policy_oid,
                                        &status);
 
         if ((error == 0) && (status == TBS_ST_ESTALE) && !restarted) {
@@ -1118,8 +1182,8 @@ mvfs_eaclhash_update_eaclh(
                      " block=%d offset=%d\n",
                      count, (int)(cursor.next_offset));
 
-            if (ep->eah_eaclh != TBS_SID_ACL_H_NULL) {
-                tbs_sid_acl_free(&(ep->eah_eaclh));
+            if (eaclh != TBS_SID_ACL_H_NULL) {
+                tbs_sid_acl_free(&eaclh);
             }
             VIEW_EACL_CURSOR_RESET(&cursor);
             restarted = TRUE;
@@ -1172,10 +1236,31 @@ mvfs_eaclhash_update_eaclh(
                  MVFS_UUID_ARG(&(ep->eah_key.eah_rolemap_oid)));
 
         /* We could have accumulated a partial EACL, so free it. */
-        if (ep->eah_eaclh != TBS_SID_ACL_H_NULL) {
-            tbs_sid_acl_free(&(ep->eah_eaclh));
+        if (eaclh != TBS_SID_ACL_H_NULL) {
+            tbs_sid_acl_free(&eaclh);
         }
     }
+    /* Publish the result.  Any access decisions made against the old EACL
+    ** are no longer valid.  If the entry was invalidated while we were
+    ** fetching, what we got may already be out of date, so zero the time to
+    ** have the next validate fetch it again.
+    */
+    MVFS_EACLHASH_LOCK(macldp, hash_val, &mlplockp);
+    old_eaclh = ep->eah_eaclh;
+    ep->eah_eaclh = eaclh;
+    ep->eah_eacl_lut = lut;
+    ep->eah_policy_oid = policy_oid;
+    if (ep->eah_stale) {
+        MVFS_INIT_TIMEVAL(ep->eah_eacl_lut);
+        ep->eah_stale = FALSE;
+    }
+    ep->eah_gen++;
+    ep->eah_fetching = FALSE;
+    MVFS_UNLOCK(&(ep->eah_fetchlock));
+
+    if (old_eaclh != TBS_SID_ACL_H_NULL) {
+        tbs_sid_acl_free(&old_eaclh);
+    }
     MDB_VLOG((MFS_VACCESS, "mvfs_eaclhash_update_eaclh: ep=%p\n", ep));
 }
 
@@ -1213,9 +1298,11 @@ mvfs_eaclhash_validate_eaclh(
 
     /* Check the EACL mtime to see if the EACL might need updating.  If the EACL
     ** handle is NULL, we had an error when we last checked, so only check again
-    ** after a timeout.
+    ** after a timeout.  If a fetch is already in flight, the update waits for
+    ** it rather than use the EACL it is replacing.
     */
-    if (MVFS_TIMEVAL_NEWER(&(mnp->mn_vob.attr.eacl_mtime),
+    if (ep->eah_fetching ||
+        MVFS_TIMEVAL_NEWER(&(mnp->mn_vob.attr.eacl_mtime),
                            &(ep->eah_eacl_lut)) ||
         ((ep->eah_eaclh == TBS_SID_ACL_H_NULL) &&
          (ep->eah_eacl_lut.tv_sec + mvfs_eacl_err_timeout < MDKI_CTIME())))
@@ -1228,6 +1315,109 @@ mvfs_eaclhash_validate_eaclh(
     MDB_VLOG((MFS_VACCESS, "mvfs_eaclhash_validate_eaclh: ep=%p\n", ep));
 }
 
+/* MVFS_EACLHASH_CHECK - Check the requested permissions against the EACL in a
+** hashtable entry, reusing an earlier decision for the same credentials,
+** permissions and owner if the EACL hasn't been replaced since.  Otherwise,
+** evaluate the EACL and remember the result.  The chain lock is held across
+** the evaluation so the EACL handle can't be freed out from under us.  A NULL
+** EACL handle (we failed to fetch it) denies access.
+*/
+STATIC tbs_status_t MVFS_NOINLINE
+mvfs_eaclhash_check(
+    mvfs_eaclhash_entry_p ep,
+    tbs_acl_permission_set_t requested_perms,
+    CRED_T *cred,
+    const tbs_sid_acl_id_principal_t *owner_usid_p,
+    const tbs_sid_acl_id_principal_t *owner_gsid_p,
+    tbs_boolean_t *granted_p
+)
+{
+    int i;
+    ks_uint32_t hash_val;
+    ks_uint32_t fp;
+    LOCK_T *mlplockp;
+    tbs_status_t status = TBS_ST_OK;
+    tbs_boolean_t hit = FALSE;
+    tbs_boolean_t evaluated = FALSE;
+    struct mvfs_eacl_decision *dp;
+    struct mvfs_eacl_decision *freedp = NULL;
+    CRED_T *oldcred = NULL;
+    timestruc_t stime, dtime, ztime;
+    mvfs_acl_data_t *macldp = MDKI_ACL_GET_DATAP();
+
+    DEBUG_ASSERT(ep != NULL);
+
+    fp = MVFS_CRED_FINGERPRINT(cred);
+    *granted_p = FALSE;
+
+    hash_val = MVFS_EACLHASH(macldp, &(ep->eah_key));
+    MVFS_EACLHASH_LOCK(macldp, hash_val, &mlplockp);
+
+    if (ep->eah_eaclh == TBS_SID_ACL_H_NULL) {
+        /* Someone else's refetch failed since we validated it. */
+        goto unlock;
+    }
+    for (i = 0; i < MVFS_EACL_DCACHE_SLOTS; i++) {
+        dp = &(ep->eah_dcache[i]);
+        if (dp->ead_cred == NULL || dp->ead_gen != ep->eah_gen) {
+            /* Unused or stale, so a good one to replace. */
+            if (freedp == NULL) freedp = dp;
+            continue;
+        }
+        if (dp->ead_fp == fp &&
+            dp->ead_perms == requested_perms &&
+            dp->ead_ouid == owner_usid_p->id_uid &&
+            dp->ead_ogid == owner_gsid_p->id_gid &&
+            MDKI_CR_EQUAL(dp->ead_cred, cred))
+        {
+            *granted_p = dp->ead_granted;
+            hit = TRUE;
+            goto unlock;
+        }
+    }
+    MDKI_HRTIME(&stime);
+    status = tbs_sid_acl_check_permission_creds(ep->eah_eaclh,
+                                                requested_perms, cred,
+                                                owner_usid_p, owner_gsid_p,
+                                                granted_p);
+    MVFS_TIME_DELTA(stime, dtime, ztime);
+    evaluated = TRUE;
+
+    if (status == TBS_ST_OK) {
+        if (freedp == NULL) {
+            freedp = &(ep->eah_dcache[ep->eah_dcnext]);
+            ep->eah_dcnext = (ep->eah_dcnext + 1) % MVFS_EACL_DCACHE_SLOTS;
+        }
+        oldcred = freedp->ead_cred;
+        MDKI_CRHOLD(cred);
+        freedp->ead_cred = cred;
+        freedp->ead_fp = fp;
+        freedp->ead_gen = ep->eah_gen;
+        freedp->ead_ouid = owner_usid_p->id_uid;
+        freedp->ead_ogid = owner_gsid_p->id_gid;
+        freedp->ead_perms = requested_perms;
+        freedp->ead_granted = *granted_p;
+    }
+  unlock:
+    MVFS_EACLHASH_UNLOCK(&mlplockp);
+
+    if (oldcred != NULL) {
+        MDKI_CRFREE(oldcred);
+    }
+    if (hit) {
+        BUMPSTAT(mvfs_eacstat.eac_dchits);
+    } else if (evaluated) {
+        BUMPSTAT(mvfs_eacstat.eac_dcmisses);
+        BUMPSTAT_VAL(mvfs_eacstat.eac_evalusec,
+                     (MVFS_STAT_CNT_T) dtime.tv_sec * 1000000 +
+                     dtime.tv_nsec / 1000);
+    }
+    MDB_VLOG((MFS_VACCESS, "mvfs_eaclhash_check:"
+              " ep=%p perms=%#lx granted=%d %s\n",
+              ep, requested_perms, *granted_p, hit ? "hit" : "miss"));
+    return(status);
+}
+
 /* MVFS_EACLHASH_DUMP - Dump the contents of the (non-NULL) entries in the EACL
 ** hashtable to the mvfs_log.  Callers use this when MVFS_DEBUG is set, and the
 ** logging is only done if the MFS_VACCESS bit is set, as well.
@@ -66,6 +66,24 @@ struct mvfs_eaclhash_slot {
     ks_uint32_t eah_entry_cnt;
 };
 
+/* A previously evaluated access decision against the EACL in an entry.  The
+** decision is only good for the EACL generation it was made against, and for
+** the same credentials, requested permissions and object owner (an EACL may
+** grant rights to the owner principals).  The fingerprint is a cheap filter,
+** the held cred is compared in full before the decision is reused.
+*/
+#define MVFS_EACL_DCACHE_SLOTS 8
+
+struct mvfs_eacl_decision {
+    CRED_T *ead_cred;                   /* Held, NULL if slot is unused */
+    ks_uint32_t ead_fp;                 /* MVFS_CRED_FINGERPRINT(ead_cred) */
+    ks_uint32_t ead_gen;                /* eah_gen when evaluated */
+    MVFS_USER_ID ead_ouid;
+    MVFS_GROUP_ID ead_ogid;
+    tbs_acl_permission_set_t ead_perms;
+    tbs_boolean_t ead_granted;
+};
+
 /* External callers use a handle to reference this hashtable entry. */
 struct mvfs_eaclhash_entry {
     struct mvfs_eaclhash_entry_hdr eah_hdr; /* Must be first in this structure. */
@@ -74,6 +92,12 @@ struct mvfs_eaclhash_entry {
     struct timeval eah_eacl_lut;
     tbs_oid_t eah_policy_oid;
     tbs_sid_acl_h_t eah_eaclh;
+    ks_uint32_t eah_gen;                /* Bumped when eah_eaclh is replaced */
+    tbs_boolean_t eah_fetching;         /* An EACL fetch is in flight */
+    tbs_boolean_t eah_stale;            /* Invalidated during that fetch */
+    LOCK_T eah_fetchlock;               /* Held by the fetcher for its duration */
+    u_int eah_dcnext;                   /* Next decision slot to replace */
+    struct mvfs_eacl_decision eah_dcache[MVFS_EACL_DCACHE_SLOTS];
 };
 
 typedef struct mvfs_eaclhash_entry_hdr * mvfs_eaclhash_entry_hdr_p;
@@ -350,6 +350,9 @@ typedef int mfs_class_t;
  *	The on_destroy flag is protected by the mvfs_mndestroylock.  Once set,
  *	it is never cleared.  Marked with a "D".
  *
+ *	The dirty_next and dirty_prev links and the on_dirty flag are
+ *	protected by the mvfs_mndirtylock.  Marked with a "Y".
+ *
  *	The stale flag is protected by the mnode lock as is the rest of the flag
  *	word.  Marked with "M". 
  *
@@ -388,6 +391,9 @@ typedef int mfs_class_t;
  *
  *	freelist_time is set under the header lock.  Not marked.
  *
+ *	numa_node is set in mvfs_mnallocatemnode before anyone else can see
+ *	the mnode and never changes.  Not marked.
+ *
  *    Beware that some systems cannot lock bitfields
  *    on less than quadword (8 byte) boundaries due to vagaries of the
  *    compiler load/modify/store code sequences.  All processors
@@ -401,6 +407,8 @@ struct mfs_mnhdr {			/* Basic hdr info for all mfs objects */
 /*HS*/	struct mfs_mnode *prev;		/* Prev ptr */
 /*FD*/	struct mfs_mnode *free_next;	/* Free list next */
 /*FD*/ 	struct mfs_mnode *free_prev;	/* Free list previous */
+/*Y*/	struct mfs_mnode *dirty_next;	/* Dirty list next */
+/*Y*/	struct mfs_mnode *dirty_prev;	/* Dirty list previous */
 	LOCK_T		  hdr_lock;	/* Mnode header lock (see above) */
 	u_int		  mcount;	/* Reference count */
 	mfs_class_t	  mclass;	/* Mnode Class of MFS object */
@@ -408,11 +416,13 @@ struct mfs_mnhdr {			/* Basic hdr info for all mfs objects */
 /*F*/	u_int		  mfree;	/* Mnode is on vobfree list flag */
 /*F*/	u_int		  trans_destroy;/* Mnode moving to destroy list flag */
 /*D*/	u_int		  on_destroy;	/* Mnode is on destroy list flag */
+/*Y*/	u_int		  on_dirty;	/* Mnode is on dirty list flag */
 /*M*/	u_int		  stale;	/* Flag to mark stale mnodes in hash */
 /*M*/	u_int		  cached_pages : 1; /* vnode has cached pages */
 /*M*/	u_int		  clear_dirty : 1; /* cleartext pages are dirty */
 /*M*/	u_int		  clear_mmap : 1; /* mmap switched to cleartext */
-/*M*/	u_int		  pad : 29;	/* unused flag bits */
+	u_int		  numa_node : 8; /* NUMA node slot of the memory */
+/*M*/	u_int		  pad : 21;	/* unused flag bits */
 	size_t		  msize;	/* Size (in bytes) of this mnode */
 /***/	LOCK_T		  lock;		/* Lock on structure */
 MVFS_LH(LOCK_T		  lock_high;)	/* High Level lock on structure (for I/O) */
@@ -490,12 +500,14 @@ struct mfs_rebindent {		/* Dir version cache entry */
 typedef struct mvfs_clr_creds {
     struct mvfs_clr_creds *next;
     CRED_T *cred;
+    ks_uint32_t fp;                     /* MVFS_CRED_FINGERPRINT(cred) */
 } mvfs_clr_creds_t;
 
 struct mfs_clearinfo {			/* Cleartext information */
 	mfs_pn_char_t	 *nm;		/* Cleartext pname */
 	LOCK_T		 cl_info_lock;	/* Lock for cred cache */
 	mvfs_clr_creds_t *ok_creds;     /* creds that have looked up the name */
+	ks_uint32_t	  ok_creds_bloom; /* MVFS_CRED_BLOOM of ok_creds fps */
 	u_long		  revalidate_time;  /* Time (secs) to do revalidate */
 	u_int		  isvob : 1;	/* Cleartext in vob */
 	u_int		  rwerr : 1;	/* Cleartext RW error */
@@ -505,9 +517,11 @@ struct mfs_clearinfo {			/* Cleartext information */
 	u_int		  used : 1;	/* used cltxt since last reclaim */
 	u_int		  delete_on_close : 1; /* cltxt is marked for deletion */
 	u_int		  ostale_logged : 1; /* have logged open stale warning */
-	u_int		  pad : 24;	/* Pad space */
+	u_int		  prefetched : 1; /* cltxt fetched by prefetch, unused */
+	u_int		  pad : 23;	/* Pad space */
 	VATTR_T	  	  va;		/* Stat of cleartext */
         time_t            atime_pushed; /* vob container setattr time, for scrubber */
+	u_char		  prefetch_queued; /* On the prefetch queue (ctp_lock) */
 };
 
 #define MVFS_CTXT_ATIME_REFRESH_DEF 3600 /* default interval 1 hr between forced setattr */
@@ -517,30 +531,46 @@ struct mfs_clearinfo {			/* Cleartext information */
 	(mnp)->mn_vob.rebind.self = 0; \
     }
 
+
 /*
- * On unix, we need to check access to the cleartext path as well as to the 
- * MVFS path.  This gets tedious, but we try to keep track of creds we've already
- * looked at to save some redundant work.  See the comments near mfs_getcleartext()
- * for a full explanation. 
+ * Speculative cleartext prefetch.  Requests are queued (holding the vnode
+ * and the requesting cred) by lookup and are serviced by at most
+ * mvfs_ctxt_prefetch_threads asynchronous workers.  Each worker owns one
+ * bit in ctp_slots while it runs.  The queue and all of the counters
+ * (including the per-view mfs_viewnode.ctxt_prefetch_cnt) are protected
+ * by ctp_lock.
  */
-#define MVFS_CRED_HASHSZ 61         /* FIXME: nice prime number? */
-
-typedef struct mvfs_credlist_data {
-    /* System-wide credlist chains and spinlock.
-     * Mnode cred lists are protected by the mnode locks.
-     */
-    mvfs_clr_creds_t *mvfs_sys_credlist[MVFS_CRED_HASHSZ];
-    mvfs_clr_creds_t *mvfs_free_creds;
-    SPLOCK_T mvfs_sys_credlist_lock;
-
-#ifdef MVFS_DEBUG
-    /* buckets for chain length accounting.  Useful for determining if the hash
-     * algorithm is distributing well.
-     */
-    ks_uint32_t mvfs_sys_crlen[MVFS_CRED_HASHSZ];
-#endif
+typedef struct mvfs_ctxt_prefetch_req {
+    struct mvfs_ctxt_prefetch_req *next;
+    VNODE_T *vp;                        /* Held VOB file vnode */
+    CRED_T *cred;                       /* Held cred of the requester */
+} mvfs_ctxt_prefetch_req_t;
+
+#define MVFS_CTXT_PREFETCH_MAXTHREADS       8
+#define MVFS_CTXT_PREFETCH_THREADS_DEF      2
+#define MVFS_CTXT_PREFETCH_VIEW_MAX_DEF     16
+#define MVFS_CTXT_PREFETCH_QMAX_DEF         256
+
+typedef struct mvfs_ctxt_prefetch_data {
+    mvfs_ctxt_prefetch_req_t *ctp_head; /* FIFO of pending requests */
+    mvfs_ctxt_prefetch_req_t *ctp_tail;
+    int ctp_qlen;                       /* Number of pending requests */
+    u_int ctp_slots;                    /* Bitmask of running workers */
+    tbs_boolean_t ctp_active;           /* Workers may be scheduled */
+    SPLOCK_T ctp_lock;
+} mvfs_ctxt_prefetch_data_t;
 
-} mvfs_credlist_data_t;  
+/*
+ * Periodic maintenance.  Each MVFS_MAINT_* task (see mfs_stats.h) runs on
+ * its own interval.  mm_busy keeps a task from running twice at once when
+ * mfs_vsync() and the port's maintenance work items overlap, and mm_due is
+ * the time the task is next due.  Both are protected by mm_lock.
+ */
+typedef struct mvfs_maint_data {
+    tbs_boolean_t mm_busy[MVFS_MAINT_NTASKS];
+    time_t mm_due[MVFS_MAINT_NTASKS];
+    SPLOCK_T mm_lock;
+} mvfs_maint_data_t;
 
 #define MFS_INDEX_CACHE_LOOKUP_BEST(vp,o,bip,bop) { *(bip) = *(bop) = o; }
 #define mfs_index_cache_add(vp,i,o)	/* do nothing */
@@ -571,6 +601,10 @@ struct mvfs_rddir_cache {
 EXTERN void
 mvfs_rddir_cache_destroy(struct mfs_mnode *mnp);
 
+/* call with the mnode on the vob freelist and its hash chain locked */
+EXTERN int
+mvfs_rddir_cache_reclaim(struct mfs_mnode *mnp);
+
 /* call with mnode locked */
 EXTERN void
 mvfs_rddir_cache_flush(struct mfs_mnode *mnp);
@@ -645,7 +679,10 @@ MVFS_CL(LOCK_T           cred_lock;)    /* Lock while changing cred */
 	u_long		  attrgen;	/* Attribute generation number */
 	timestruc_t	  attrsettime;	/* Last time attrs set */
 	timestruc_t	  attrtime;	/* Time attributes valid until */
+	short		  ac_adapt;	/* Timeout scaling from revalidations */
 	struct timeval    lvut;		/* last VOB update time from getattr */
+	u_int		  getattr_seq;	/* Getattr RPCs done (see mfs_clnt_getattr) */
+	u_int		  lookup_seq;	/* Lookup RPCs done in this dir */
 	view_vstat_t  	  attr;		/* Cached attributes */
         /* 
          * The user and group identities in the view_vstat_t struct are not
@@ -716,6 +753,52 @@ typedef struct splock_pool {
 
 #define HASH_SPLOCK_SET_POOLSIZE(sp_poolsize, hash_size) {sp_poolsize = hash_size;}
 
+/*
+ * On unix, we need to check access to the cleartext path as well as to the 
+ * MVFS path.  This gets tedious, but we try to keep track of creds we've already
+ * looked at to save some redundant work.  See the comments near mfs_getcleartext()
+ * for a full explanation. 
+ *
+ * Creds are compared by fingerprint (a hash of the uid, gid and groups)
+ * before the full MDKI_CR_EQUAL comparison.  Each mnode keeps a small
+ * bloom filter of the fingerprints on its ok_creds list so that a cred
+ * which never looked up the cleartext is rejected without walking the list.
+ *
+ * The system-wide table has a power of 2 number of chains.  It starts out
+ * scaled with mvfs_largeinit and is doubled (up to MVFS_CRED_HASHSZ_MAX)
+ * when an insert finds a chain longer than MVFS_CRED_CHAIN_GROW.  Lookups
+ * walk it under MDKI_RCU_READ_LOCK alone.  Inserts take the spinlock for
+ * the cred's group in mvfs_sys_credlist_lockpool; the pool is sized for the
+ * initial table and a group is the fingerprint modulo the pool size, so a
+ * cred's lock stays the same as the table grows.  A grow moves the chains
+ * over to the new table one group at a time, under that group's lock.
+ */
+#define MVFS_CRED_BLOOM(fp) ((1U << ((fp) & 31)) | (1U << (((fp) >> 5) & 31)))
+#define MVFS_CRED_FINGERPRINT(cr) mvfs_cred_fingerprint(cr)
+
+#define MVFS_CRED_HASHSZ_MIN 64
+#define MVFS_CRED_HASHSZ_MAX 4096
+#define MVFS_CRED_CHAIN_GROW 4
+
+typedef struct mvfs_credlist_tbl {
+    struct mvfs_credlist_tbl *ct_next;  /* Table being grown into, if any */
+    int ct_moved;                       /* Lock groups moved to ct_next */
+    ks_uint32_t ct_sz;                  /* Number of chains (power of 2) */
+    mvfs_clr_creds_t *ct_chain[1];      /* Really ct_sz of them */
+} mvfs_credlist_tbl_t;
+
+#define MVFS_CREDLIST_TBL_BYTES(sz) \
+    (sizeof(mvfs_credlist_tbl_t) + ((sz) - 1) * sizeof(mvfs_clr_creds_t *))
+
+typedef struct mvfs_credlist_data {
+    /* System-wide credlist table and spinlocks.
+     * Mnode cred lists are protected by the mnode locks.
+     */
+    mvfs_credlist_tbl_t *mvfs_sys_credtbl;
+    splock_pool_t mvfs_sys_credlist_lockpool;
+    LOCK_T mvfs_sys_credlist_growlock;  /* Serializes grows and flushes */
+} mvfs_credlist_data_t;
+
 /* mvfs_lock pools
  * To reduce lock contention on MP systems, in some places
  * we use a pool of LOCK_T's in place of one single lock.  
@@ -797,18 +880,33 @@ typedef struct mvfs_lock_pool {
 	((mnp)->mn_vob.cleartext.isvob)
 
 /* A vobstamp structure holds a last VOB update time (LVUT) plus its
- * update timestamp.  All vobstamps in all view nodes, as well as all
- * vobstamp_next fields, are accessed under the mvfs_vobstamp_lock.
+ * update timestamp.  Each view node keeps its vobstamps in an open
+ * addressed hash table keyed on the VOB uuid, which doubles (up to
+ * MVFS_VOBSTAMP_TBL_MAX slots) as the view uses more VOBs.  Updates are
+ * made under the view's stamplock and inside a write section of its
+ * stampseq; readers take no lock, they just retry if stampseq moved.
+ * A table that has been replaced by a bigger one may still be in use by
+ * a reader, so it is kept on the new table's retired list until the view
+ * node is destroyed.
  */
 
-extern SPLOCK_T mvfs_vobstamp_lock;
-
 struct mvfs_vobstamp {
 	struct timeval	lvut;		/* the LVUT itself */
 	tbs_uuid_t	vobuuid;	/* VOB uuid for this VOB */
 	time_t		valid_thru;	/* how long is this valid? */
 };
-#define	MVFS_NUM_VOB_STAMPS	20	/* FIXME: select a size? */
+
+struct mvfs_vobstamp_tbl {
+	struct mvfs_vobstamp_tbl *retired; /* Table this one replaced */
+	int		size;		/* Slots, a power of 2 */
+	int		count;		/* Slots in use */
+	struct mvfs_vobstamp ents[1];	/* Really size of them */
+};
+#define MVFS_VOBSTAMP_TBL_BYTES(n) \
+	(sizeof(struct mvfs_vobstamp_tbl) + ((n) - 1) * sizeof(struct mvfs_vobstamp))
+#define	MVFS_VOBSTAMP_TBL_MIN	8
+#define	MVFS_VOBSTAMP_TBL_MAX	1024
+#define	MVFS_VOBSTAMP_PROBES	8	/* Longest probe sequence */
 
 /* Structure for MVFS statistics.  The statistics are maintained on a per-CPU
  * basis.  They are allocated and initialized in mvfs_misc_init when the
@@ -835,6 +933,8 @@ typedef struct mvfs_statistics_data {
         MVFS_STAT_CNT_T mfs_viewopcnt[VIEW_NUM_PROCS]; /* RPC ops to viewserver */
         timestruc_t mfs_viewoptime[VIEW_NUM_PROCS];/* time for the RPCs */ 
         struct mfs_rpchist mfs_viewophist;    /* Histogram of the RPC times */
+        timestruc_t mvfs_viewenctime[VIEW_NUM_PROCS]; /* XDR encode time */
+        timestruc_t mvfs_viewdectime[VIEW_NUM_PROCS]; /* XDR decode time */
 } mvfs_stats_data_t; 
 
 /*
@@ -857,6 +957,19 @@ struct mvfs_pvstat {
         struct mfs_dncstat      dncstat;	/* DNC stats */
 };
 
+/* Round trip time estimate for one view op, kept the way TCP keeps SRTT and
+ * RTTVAR (see mvfs_rtt_sample() in mvfs_rpcutl.c).  Times are in
+ * milliseconds; srtt is scaled by 8 and rttvar by 4.  backoff doubles the
+ * timeout after each call that timed out or was retransmitted, until the
+ * next clean sample.
+ */
+struct mvfs_rttest {
+        int	srtt;		/* Smoothed RTT << 3, 0 if no samples yet */
+        int	rttvar;		/* RTT mean deviation << 2 */
+        u_int	backoff;	/* Timeout shift, up to MVFS_RTT_MAXBACKOFF */
+};
+#define MVFS_RTT_MAXBACKOFF	6
+
 /* Histogram of RPC delays.  This is used to initiliaze the corresponding
  * structure in mvfs_statistics_data.
  */
@@ -896,17 +1009,49 @@ struct mfs_viewnode {
     MVFS_GROUP_ID   cgid;       /* Creator's gid or gid/SID for nt view */
     timestruc_t     ctime;      /* Created time */
     time_t          usedtime;   /* Last used time (for cleanup) */
-    LOCK_T          stamplock;  /* Lock on vobstamps */
-    struct mvfs_vobstamp vobstamps[MVFS_NUM_VOB_STAMPS]; /* VOB update times */
-    int             vobstamp_next;      /* round-robin replacement ptr */
+    LOCK_T          stamplock;  /* Serializes vobstamp updates */
+    MDKI_SEQ_T      stampseq;   /* Bumped around vobstamp updates */
+    struct mvfs_vobstamp_tbl *vobstamps; /* VOB update times */
     time_t          rpctime;    /* Last RPC time (for cleanup) */
     struct mvfs_pvstat *pvstat; /* Per-view statistics */
-};
+    int             ctxt_prefetch_cnt; /* Queued cltxt prefetches */
 
+    /* View server health, shared by all mvfs_vwcall()s to this view.  The
+    ** state and times are under hlthlock.  While the server is not HEALTHY,
+    ** only the holder of hlthprobe talks to it; see mvfs_vwhealth_enter().
+    */
+    SPLOCK_T        hlthlock;
+    LOCK_T          hlthprobe;  /* Held by the one caller probing the server */
+    u_int           hlthstate;  /* MVFS_VWHLTH_* (mfs_stats.h) */
+    time_t          hlthsince;  /* When the server last left HEALTHY */
+    time_t          hlthnext;   /* DOWN: earliest time for the next probe */
+
+    SPLOCK_T        rttlock;    /* Protects rtt[] */
+    struct mvfs_rttest *rtt;    /* Per-op RTT estimates [VIEW_NUM_PROCS] */
+};
 
+/* How mvfs_vwcall() callers behave while another caller is probing a view
+** server that has stopped answering (mvfs_view_health_policy).  Hard mounts
+** always wait, since they must not see a timeout error.
+*/
+#define MVFS_VWHLTH_POLICY_OFF		0	/* Each call retries on its own */
+#define MVFS_VWHLTH_POLICY_WAIT		1	/* Wait for the probe's result */
+#define MVFS_VWHLTH_POLICY_FAILFAST	2	/* Soft mounts fail at once */
+
+
+/* Ramdir entries are also chained into a hash on the name, so /view/<tag>
+ * lookups don't have to scan the table or take the viewroot lock.  Writers
+ * still serialize on the viewroot's mnode lock and change the chains inside
+ * a write section of the ramdir's sequence counter; readers walk the chains
+ * under MDKI_RCU_READ_LOCK and retry if the counter moved.  A removed
+ * entry's name and vnode hold are only given up after MDKI_RCU_SYNC(), so a
+ * reader never touches a freed name or holds a vnode on its way out.
+ */
 struct mfs_ramdirent {
 	mfs_pn_char_t 	*nm;	/* Ptr to name */
         VNODE_T 	*vp;	/* Ptr to vnode */
+	u_int		nmhash;	/* Hash of nm */
+	int		hnext;	/* Next slot on hash chain, or -1 */
 };
 
 typedef struct mfs_ramdirent mfs_ramdirent_t;
@@ -915,6 +1060,9 @@ struct mfs_ramdirnode {
 	int		max;		/* Max cnt of elements allowed */
 	int		hwm;		/* High water mark for table */
 	mfs_ramdirent_t *ents;		/* Ptr to table of entries */
+	int		hashsize;	/* Number of hash chains (power of 2) */
+	int		*hashtbl;	/* First slot on each chain, or -1 */
+	MDKI_SEQ_T	hashseq;	/* Bumped around chain updates */
 	timestruc_t	atime;		/* Accessed time */
         timestruc_t 	mtime;		/* Last modified time */
 	timestruc_t	ctime;		/* Created time */
@@ -986,6 +1134,22 @@ typedef struct mvfs_mndestroylist {
     } mn_hdr;
 } mvfs_mndestroylist_t;
 
+/*
+ * The mnode dirty list: VOB mnodes with cached_pages set, drained by
+ * mvfs_mnsyncmnodes.  See mvfs_mnode.c for details.
+ */
+
+typedef struct mvfs_mndirtylist {
+    struct {
+    	mfs_mnode_t *next;
+    	mfs_mnode_t *prev;
+    	mfs_mnode_t *free_next;
+    	mfs_mnode_t *free_prev;
+    	mfs_mnode_t *dirty_next;
+    	mfs_mnode_t *dirty_prev;
+    } mn_hdr;
+} mvfs_mndirtylist_t;
+
 /*
  * Audit file structure.
  * There is one of these for each active auditfile.
@@ -1173,6 +1337,24 @@ typedef struct mvfs_thread mvfs_thread_t;
 
 #define MVFS_PROCHASH_SZ	511	/* size of generic proc hash table */
 
+/*
+ * One-entry cache per thread hash bucket remembering the last thread
+ * found there, so a task re-entering the MVFS need not walk the chain
+ * under the bucket splock.  Readers look at it without the splock and
+ * retry on tc_seq; writers hold the bucket splock.  An entry is cleared
+ * before its thread is unhashed and freed.  The thread's process id and
+ * tag are copied in, so a reader can decide whether the entry is its own
+ * without touching the thread, which may be freed as soon as the read
+ * section ends if it is not.
+ */
+typedef struct mvfs_thread_cache {
+    MDKI_SEQ_T      tc_seq;
+    MVFS_THREADID_T tc_threadid;        /* thread ID tc_thread belongs to */
+    MVFS_PROCID_T   tc_procid;          /* tc_thread->thr_proc->mp_procid */
+    MVFS_PROCTAG_T  tc_proctag;         /* tc_thread->thr_proc->mp_proctag */
+    mvfs_thread_t   *tc_thread;         /* NULL if empty */
+} mvfs_thread_cache_t;
+
 /* The lockless split ordered hash set implementation is used for 
  * thread hash on some of the platforms (i.e. if MVFS_USE_SPLIT_ORDERED_HASH
  * is defined).  Older thread hash implementation can be reverted back
@@ -1198,6 +1380,7 @@ typedef struct mvfs_proc_thread_data {
      */
     splock_pool_t mvfs_threadid_spl_pool;
     mvfs_thread_t **mvfs_threadid_hashtable;
+    mvfs_thread_cache_t *mvfs_threadid_cache; /* parallel to hashtable */
     mvfs_proc_t **mvfs_procid_hashtable;
     SPLOCK_T mvfs_proc_alloclock;
 
@@ -1302,9 +1485,11 @@ extern u_long mfs_mn_newattrgen(P_NONE);
 #define MHDRLOCK_PREFIX  "mh"
 #define MLOCK_PREFIX     "mn"
 #define STAMPLOCK_PREFIX "vs"
+#define HLTHPROBE_PREFIX "vh"
 
 #define MLOCK_ADDR(mnp)		&(mnp)->mn_hdr.lock
 #define STAMPLOCK_ADDR(mnp)	&(mnp)->mn_view.stamplock
+#define HLTHPROBE_ADDR(mnp)	&(mnp)->mn_view.hlthprobe
 #define MHDRLOCK_ADDR(mnp)	&(mnp)->mn_hdr.hdr_lock
 
 #define MLOCK(mnp)	  MVFS_LOCK(MLOCK_ADDR(mnp))
@@ -1613,6 +1798,18 @@ typedef struct mvfs_sp_ent {
 
 #define VFS_FSID(vfsp)		MDKI_VFSID(vfsp)
 
+/*
+ * Indexes kept on VOB mounts so the mfs_findvfs_* routines don't have to
+ * scan the whole mount table.
+ */
+#define MVFS_VOBMNT_HKEY_TAG		0	/* mmi_vobtag */
+#define MVFS_VOBMNT_HKEY_MNTPATH	1	/* mmi_mntpath */
+#define MVFS_VOBMNT_HKEY_OID		2	/* mmi_voboid */
+#define MVFS_VOBMNT_HKEY_UUID		3	/* mmi_vobuuid */
+#define MVFS_VOBMNT_HKEY_FH		4	/* MVFS_VFS_FHKEY (port) */
+#define MVFS_VOBMNT_NHKEYS		5
+#define MVFS_VOBMNT_HASHSIZE		512	/* buckets per index, power of 2 */
+
 /*
  * MFS mount (vfs) info.  This is the same for both a VOB
  * mount and the viewserver root mount.  A lot of fields are
@@ -1656,6 +1853,13 @@ struct mfs_mntinfo {
         mvfs_sp_ent_t	*mmi_sptable;	/* split pool table entries;
 					   NULL if none  */
 	SPLOCK_T	 mmi_rclock;	/* spinlock for mmi_refcnt */
+	/*
+	 * VOB mount registry hash keys and chain links (one per index, see
+	 * mvfs_vobmnt_addhash in mvfs_vfsops.c).  Written under the
+	 * mvfs_mountlock; chains may also be walked under MDKI_RCU_READ_LOCK.
+	 */
+	u_int		 mmi_hval[MVFS_VOBMNT_NHKEYS];
+	VFS_T		*mmi_hnext[MVFS_VOBMNT_NHKEYS];
 };
 
 #define MFS_VOBMNT	1
@@ -2314,6 +2518,11 @@ mvfs_record_cred(
     CRED_T *cred
 );
 
+extern ks_uint32_t
+mvfs_cred_fingerprint(
+    CRED_T *cred
+);
+
 extern ks_uint32_t
 mvfs_hash_cred(
     CRED_T *cred
@@ -2324,6 +2533,18 @@ mvfs_clear_log_stale(
     VNODE_T *vp
 );
 
+EXTERN void
+mvfs_ctxt_prefetch(
+    VNODE_T *vp,
+    CALL_DATA_T *cd
+);
+
+EXTERN void
+mvfs_ctxt_prefetch_worker(
+    int slot,
+    CALL_DATA_T *cd
+);
+
 /* Utility routines -- the macros may be overridden in an mdep file */
 
 EXTERN tbs_boolean_t
@@ -2412,6 +2633,12 @@ EXTERN int
 mfs_ramdir_refchk(P1(VNODE_T *)
 		  PN(int *));
 
+EXTERN int
+mvfs_ramdir_hashinit(P1(struct mfs_mnode *mnp));
+
+EXTERN void
+mvfs_ramdir_hashfree(P1(struct mfs_mnode *mnp));
+
 EXTERN int 
 mfs_viewdirmkdir(
     VNODE_T *dvp,
@@ -2540,6 +2767,8 @@ mvfs_viewdir_save_vobstamp(P1(VNODE_T *vw)
 			   PN(tbs_uuid_t *vobuuid)
 			   PN(time_t timeout)
 			   PN(struct timeval *newlvut));
+EXTERN void
+mvfs_viewdir_free_vobstamps(P1(struct mfs_mnode *mnp));
 
 EXTERN int
 mvfs_viewinit(mvfs_cache_sizes_t *mma_sizes);
@@ -2633,6 +2862,19 @@ mvfs_mnsyncmnodes(
     CALL_DATA_T *cd
 );
 
+EXTERN void
+mvfs_mndirty_add(mfs_mnode_t *mnp);
+
+/*
+ * Ports that cache pages on VOB vnodes must set cached_pages through this
+ * macro (with the mnode locked) so that sync can find the mnode on the
+ * dirty list rather than by scanning every hash chain.
+ */
+#define MVFS_MN_SET_CACHED_PAGES(mnp) { \
+	(mnp)->mn_hdr.cached_pages = 1; \
+	mvfs_mndirty_add(mnp); \
+    }
+
 EXTERN mfs_mnode_t *
 mfs_mngetnextoid(P1(int *)
 		 PN(VNODE_T *)
@@ -2662,12 +2904,52 @@ mfs_mninvaloid(P1(tbs_oid_t *)
 #define MVFS_MN_CVPFLUSH_HALF 2
 #define MVFS_MN_CVPFLUSH_ALL 3
 #define MVFS_MN_CVPFLUSH_AGED 4
+#define MVFS_MN_CVPFLUSH_COUNT 5	/* explicit count, spread over chains */
 #define MVFS_DEFAULT_AGE_CVP_TIME (60*60*24*3)
 
 EXTERN void
 mvfs_mnflush_cvpfreelist(int flush_type,
                          CALL_DATA_T *cd);
 
+/* One bounded pass of the background freelist reclaimer; non-zero if
+ * another pass is needed.
+ */
+EXTERN int
+mvfs_mnfreelist_reclaim(CALL_DATA_T *cd);
+
+/*
+ * Caches that can be trimmed on demand when the kernel is short of memory.
+ * mvfs_shrink_count() returns a (lockless) estimate of the objects in a
+ * cache; mvfs_shrink() looks at up to nr of them and returns how many were
+ * actually freed.  Only unreferenced objects are released: mnodes on the
+ * vob freelist, cleartext vnodes held by freelist mnodes, readdir blocks
+ * cached on freelist mnodes and name cache entries.
+ */
+#define MVFS_SHRINK_VOBFREE	0
+#define MVFS_SHRINK_CVPFREE	1
+#define MVFS_SHRINK_DNC		2
+#define MVFS_SHRINK_RDDIR	3
+#define MVFS_SHRINK_NCACHES	4
+
+/*
+ * NUMA node slots.  mnodes and name cache entries are tagged with the slot
+ * of the node that allocated (or last filled) them, and the vob freelist
+ * is split into one run of hash chains per slot.  Node ids beyond the
+ * number of slots share a slot.
+ */
+#define MVFS_NUMA_MAXNODES	MVFS_CACHE_NUMA_MAXNODES
+#define MVFS_NUMA_SLOT(node)	((u_int)(node) % MVFS_NUMA_MAXNODES)
+
+EXTERN int
+mvfs_shrink_count(int cache);
+
+EXTERN int
+mvfs_shrink(
+    int cache,
+    int nr,
+    CALL_DATA_T *cd
+);
+
 EXTERN void
 mfs_mnflush(
     CALL_DATA_T *cd
@@ -4052,7 +4334,8 @@ mvfs_stats_data_per_cpu_init(void);
 }
 
 /*
- * The following macros, SETSTAT_MAX_DELAY, SETPVSTAT_MAX_DELAY and SET_MAXDELAY
+ * The following macros, SETSTAT_MAX_DELAY, SETPVSTAT_MAX_DELAY,
+ * SETSTAT_VWHLTH_RECOVER, SETPVSTAT_VWHLTH_RECOVER and SET_MAXDELAY
  * are used in mvfs_rpcutl.c
  */ 
 /* Macro to update the max delay stats. */
@@ -4079,6 +4362,31 @@ mvfs_stats_data_per_cpu_init(void);
         } \
 }
 
+/* Macros to add up the time a view server spent not HEALTHY, and keep the
+ * longest such time, per-cpu and per-view.
+ */
+#define SETSTAT_VWHLTH_RECOVER(secs) \
+        MVFS_STAT_MEMALLOC1 \
+        sdp->mfs_clntstat.vwhlthrecover += (secs); \
+        if ((secs) > sdp->mfs_clntstat.vwhlthmaxrecover) { \
+            sdp->mfs_clntstat.vwhlthmaxrecover = (secs); \
+        } \
+        MVFS_STAT_MEMALLOC2
+
+#define SETPVSTAT_VWHLTH_RECOVER(view, secs) { \
+        mvfs_common_data_t *mcdp = MDKI_COMMON_GET_DATAP(); \
+        if (mcdp->mvfs_pview_stat_enabled == TRUE) { \
+            MVFS_SAVE_PRIORITY_T spl; \
+            struct mvfs_pvstat *pvp = VTOM(view)->mn_view.pvstat; \
+            MVFS_PVCLNT_STATLOCK_LOCK(spl, pvp); \
+            (pvp->clntstat.vwhlthrecover) += (secs); \
+            if ((secs) > (pvp->clntstat.vwhlthmaxrecover)) { \
+                (pvp->clntstat.vwhlthmaxrecover) = (secs); \
+            } \
+            MVFS_PVCLNT_STATLOCK_UNLOCK(spl, pvp); \
+        } \
+}
+
 /* Macro to update the cleartext or rpc max delay counts. */
 #define SET_MAXDELAY(secs, nsecs, field) \
     MVFS_STAT_MEMALLOC1 \
@@ -4285,6 +4593,19 @@ mvfs_stats_data_per_cpu_init(void);
         mvfs_bumptime(&(stime), &(dtime), (&(sdp->nm))); \
         MVFS_STAT_MEMALLOC2
 
+/*
+ * Macro to add an already measured interval to cumulative stats, for ports
+ * that time things with a finer clock than MDKI_HRTIME.
+ */
+#define MVFS_ADDTIME(dtime, nm) \
+        MVFS_STAT_MEMALLOC1 \
+        if ((sdp->nm.tv_nsec += (dtime).tv_nsec) >= 1000000000) { \
+            sdp->nm.tv_nsec -= 1000000000; \
+            sdp->nm.tv_sec++; \
+        } \
+        sdp->nm.tv_sec += (dtime).tv_sec; \
+        MVFS_STAT_MEMALLOC2
+
 /*
  * Macro to calculate elapsed time, but without adding to cumulative stats
  */
@@ -57,11 +57,15 @@ int mvfs_cltxt_creds_enabled = 1;       /* not STATIC, so it's patchable */
 STATIC CRED_T *
 mvfs_find_cred(
     mvfs_clr_creds_t *aclist,
-    CRED_T *cred
+    CRED_T *cred,
+    ks_uint32_t fp
 );
 STATIC void
 mvfs_clear_release_credlist(mvfs_clr_creds_t *a_clist);
 
+STATIC void
+mvfs_ctxt_prefetch_drain(void);
+
 /* MFS_CLEARPERR - print an error on a cleartext file */
 
 void
@@ -761,6 +765,7 @@ mvfs_new_cltxt(
 
     CVN_RELE(mnp->mn_hdr.realvp, cd);       /* drop reference to old cltxt vnode */
     mnp->mn_hdr.realvp = new_cvp;
+    mnp->mn_vob.cleartext.prefetched = 0;
     if (mnp->mn_hdr.realvp != NULL) {
         /* new_cvp is often NULL, but if it's not we better hold what we're
         ** saving away. */
@@ -794,6 +799,11 @@ mvfs_new_cltxt(
  * or finds one but it doesn't match the already-known realvp, we have
  * to be careful to respond appropriately.
  *
+ * Each cached cred carries a fingerprint of its identity, and the mnode
+ * keeps a bloom filter of those fingerprints, so that a CRED_T which has
+ * not been seen on the mnode is usually rejected without walking the list,
+ * and MDKI_CR_EQUAL is only called for creds with a matching fingerprint.
+ *
  * When a CRED_T is being added to an mnode, it is first looked up in a
  * system-wide hash table of known CRED_Ts.  There may be an equivalent
  * CRED_T already known to MVFS, and if so that CRED_T is referenced
@@ -827,6 +837,7 @@ mfs_getcleartext(
     int clookup_retries = 0;	/* Clookup retries */
     tbs_boolean_t record_creds = TRUE;
     CRED_T *fcred;
+    ks_uint32_t fp;
 
     mnp = VTOM(vp);
 
@@ -857,6 +868,11 @@ mfs_getcleartext(
 
 
     if (mnp->mn_hdr.realvp != NULL) {
+        if (mnp->mn_vob.cleartext.prefetched) {
+            /* First use of a cleartext activated by mvfs_ctxt_prefetch() */
+            mnp->mn_vob.cleartext.prefetched = 0;
+            BUMPSTAT(mfs_clearstat.clearprefetchhit);
+        }
         /*
          * Verify that this caller has permissions to look up the cleartext
          * name (alas, requiring a lookup if we don't find their creds
@@ -864,9 +880,16 @@ mfs_getcleartext(
          * going on here.
          */
         if (DO_CLTXT_CREDS()) {
+            fp = MVFS_CRED_FINGERPRINT(MVFS_CD2CRED(cd));
 	    MCILOCK(mnp);
-            fcred = mvfs_find_cred(mnp->mn_vob.cleartext.ok_creds,
-                                   MVFS_CD2CRED(cd));
+            if ((mnp->mn_vob.cleartext.ok_creds_bloom & MVFS_CRED_BLOOM(fp)) ==
+                MVFS_CRED_BLOOM(fp))
+            {
+                fcred = mvfs_find_cred(mnp->mn_vob.cleartext.ok_creds,
+                                       MVFS_CD2CRED(cd), fp);
+            } else {
+                fcred = NULL;
+            }
 	    MCIUNLOCK(mnp);
             if (fcred == NULL) {
                 /* needs to run a lookup */
@@ -1526,18 +1549,46 @@ mfs_clear_closevp(
 struct mvfs_slab_list *mvfs_cred_list_slabs;
 #endif
 
+/*
+ * Fingerprint of the identity in a cred.  Equal creds (by MDKI_CR_EQUAL)
+ * have equal fingerprints.  Only the first few groups are mixed in, which
+ * is enough to tell apart the creds seen on any one system in practice.
+ */
 ks_uint32_t
-mvfs_hash_cred(CRED_T *cred)
+mvfs_cred_fingerprint(CRED_T *cred)
 {
-    register ks_uint32_t rval;
-
-    /* FIXME: this hash function needs testing under a realistic
-       distribution of credentials to determine whether its
-       distribution is suitable. */
-    rval = (((ks_uint32_t) MDKI_CR_GET_UID(cred)) << 8) +
-        (ks_uint32_t) MDKI_CR_GET_GID(cred);
+    register ks_uint32_t h;
+    CRED_GID_T *gp;
+    CRED_GID_T *gend;
+    int n;
+
+    h = (ks_uint32_t) MDKI_CR_GET_UID(cred) * 0x9e3779b1U;
+    h ^= (ks_uint32_t) MDKI_CR_GET_GID(cred) + 0x7f4a7c15U + (h << 6) + (h >> 2);
+    gp = MDKI_CR_GET_GRPLIST(cred);
+    gend = MDKI_CR_END_GRPLIST(cred);
+    h ^= (ks_uint32_t) (gend - gp) + (h << 6) + (h >> 2);
+    for (n = 0; gp < gend && n < 4; gp++, n++)
+        h ^= (ks_uint32_t) *gp + 0x9e3779b9U + (h << 6) + (h >> 2);
+
+    /* final avalanche so both the low and high bits are usable */
+    h ^= h >> 16;
+    h *= 0x85ebca6bU;
+    h ^= h >> 13;
+    return h;
+}
 
-    return rval % MVFS_CRED_HASHSZ;
+ks_uint32_t
+mvfs_hash_cred(CRED_T *cred)
+{
+    mvfs_common_data_t *mcdp = MDKI_COMMON_GET_DATAP();
+    mvfs_credlist_tbl_t *tbl;
+    ks_uint32_t h;
+
+    MDKI_RCU_READ_LOCK();
+    tbl = MDKI_ATOMIC_PTR_READ(&(mcdp->cred.mvfs_sys_credtbl));
+    h = MVFS_CRED_FINGERPRINT(cred) & (tbl->ct_sz - 1);
+    MDKI_RCU_READ_UNLOCK();
+    return h;
 }
 
 void
@@ -1548,6 +1599,7 @@ mvfs_clear_release_mnode_credlist(struct mfs_mnode *mnp)
     MCILOCK(mnp);
     mvfs_clear_release_credlist(mnp->mn_vob.cleartext.ok_creds);
     mnp->mn_vob.cleartext.ok_creds = NULL;
+    mnp->mn_vob.cleartext.ok_creds_bloom = 0;
     MCIUNLOCK(mnp);
     MDB_XLOG((MDB_CLEAROPS, "mnode %"KS_FMT_PTR_T" drop credlist\n", mnp));
 }
@@ -1568,17 +1620,24 @@ mvfs_clear_release_credlist(mvfs_clr_creds_t *a_clist)
     }
 }
 
+/*
+ * Search a cred list.  System table chains may be searched under
+ * MDKI_RCU_READ_LOCK alone, so the links are read with MDKI_ATOMIC_PTR_READ.
+ */
 STATIC CRED_T *
 mvfs_find_cred(
     mvfs_clr_creds_t *aclist,
-    CRED_T *cred
+    CRED_T *cred,
+    ks_uint32_t fp
 )
 {
     mvfs_clr_creds_t *clist;
-    for (clist = aclist; clist != NULL; clist = clist->next) {
+    for (clist = aclist; clist != NULL;
+         clist = MDKI_ATOMIC_PTR_READ(&(clist->next)))
+    {
         if (clist->cred == cred)
             return clist->cred;
-        if (MDKI_CR_EQUAL(cred, clist->cred))
+        if (clist->fp == fp && MDKI_CR_EQUAL(cred, clist->cred))
             /* FIXME: should we replace the cred on the list with this
                copy?  might make future checks quicker (since the
                pointers would be equal and the test would be quicker),
@@ -1590,15 +1649,91 @@ mvfs_find_cred(
     return NULL;
 }
 
+STATIC mvfs_credlist_tbl_t *
+mvfs_credlist_tbl_alloc(ks_uint32_t sz)
+{
+    mvfs_credlist_tbl_t *tbl;
+
+    tbl = (mvfs_credlist_tbl_t *)
+          KMEM_ALLOC(MVFS_CREDLIST_TBL_BYTES(sz), KM_SLEEP);
+    if (tbl != NULL) {
+        BZERO(tbl, MVFS_CREDLIST_TBL_BYTES(sz));
+        tbl->ct_sz = sz;
+    }
+    return tbl;
+}
+
+/*
+ * Double the system cred table.  Each lock group's chains are moved to
+ * the new table under that group's lock, and ct_moved tells inserters
+ * which groups now live in ct_next.  Entries are relinked, not copied, so
+ * a lockless reader standing on one may follow it into a chain of the new
+ * table; that can only make it miss, and a miss is retried under the lock.
+ * The old table is freed once no reader can still be looking at it.
+ */
+STATIC void
+mvfs_credlist_grow(ks_uint32_t oldsz)
+{
+    mvfs_common_data_t *mcdp = MDKI_COMMON_GET_DATAP();
+    mvfs_credlist_tbl_t *otbl, *ntbl;
+    mvfs_clr_creds_t *clist, *nclist, **chainp;
+    ks_uint32_t i, sz;
+    int group, ngroups;
+    SPLOCK_T *lockp;
+    SPL_T s;
+
+    /* Someone else is already at it; the table will be bigger soon. */
+    if (!CONDITIONAL_LOCK(&(mcdp->cred.mvfs_sys_credlist_growlock)))
+        return;
+    otbl = mcdp->cred.mvfs_sys_credtbl;
+    sz = otbl->ct_sz;
+    if (sz != oldsz || sz >= MVFS_CRED_HASHSZ_MAX ||
+        (ntbl = mvfs_credlist_tbl_alloc(sz << 1)) == NULL)
+    {
+        MVFS_UNLOCK(&(mcdp->cred.mvfs_sys_credlist_growlock));
+        return;
+    }
+    otbl->ct_next = ntbl;
+
+    ngroups = mcdp->cred.mvfs_sys_credlist_lockpool.spl_count;
+    for (group = 0; group < ngroups; group++) {
+        SPLOCK_SELECT(&(mcdp->cred.mvfs_sys_credlist_lockpool), group,
+                      HASH_SPLOCK_PER_GROUP, &lockp);
+        SPLOCK(*lockp, s);
+        for (i = group; i < sz; i += ngroups) {
+            for (clist = otbl->ct_chain[i]; clist != NULL; clist = nclist) {
+                nclist = clist->next;
+                chainp = &(ntbl->ct_chain[clist->fp & (ntbl->ct_sz - 1)]);
+                MDKI_ATOMIC_PTR_SET(&(clist->next), *chainp);
+                MDKI_ATOMIC_PTR_SET(chainp, clist);
+            }
+            MDKI_ATOMIC_PTR_SET(&(otbl->ct_chain[i]), NULL);
+        }
+        otbl->ct_moved = group + 1;
+        SPUNLOCK(*lockp, s);
+    }
+
+    /* The new chains must be visible before the new table is. */
+    MDKI_MEMORY_BARRIER();
+    MDKI_ATOMIC_PTR_SET(&(mcdp->cred.mvfs_sys_credtbl), ntbl);
+    MDKI_RCU_SYNC();
+    KMEM_FREE(otbl, MVFS_CREDLIST_TBL_BYTES(sz));
+    MDB_XLOG((MDB_CLEAROPS, "credlist grown to %d chains\n", sz << 1));
+    MVFS_UNLOCK(&(mcdp->cred.mvfs_sys_credlist_growlock));
+}
+
 void
 mvfs_record_cred(
     struct mfs_mnode *mnp,
     CRED_T *cred
 )
 {
-    mvfs_clr_creds_t *clist, *sys_clist;
+    mvfs_clr_creds_t *clist, *sys_clist, *scl, **chainp;
+    mvfs_credlist_tbl_t *tbl;
     CRED_T *fcred;
-    ks_uint32_t crhash;
+    ks_uint32_t fp, sz;
+    int chainlen;
+    SPLOCK_T *lockp;
     SPL_T s;
     mvfs_common_data_t *mcdp = MDKI_COMMON_GET_DATAP();
 
@@ -1611,69 +1746,88 @@ mvfs_record_cred(
                   cred));
         return;
     }
-    crhash = MVFS_HASH_CRED(cred);
-
-    SPLOCK(mcdp->cred.mvfs_sys_credlist_lock, s);
-    /* Make sure we have a free cred list handy.  If not, get one and
-        leave it ready in case of need.  This burns maybe a few cred
-        lists (as many as can get added during a race in this code) to
-        avoid a potential add/add race if we drop/reacquire the lock
-        below to do an allocation. */
-
-    if (mcdp->cred.mvfs_free_creds == NULL) {
-        SPUNLOCK(mcdp->cred.mvfs_sys_credlist_lock, s);
+    fp = MVFS_CRED_FINGERPRINT(cred);
+
+    /* Usually the cred (or an equivalent one) is known already. */
+    MDKI_RCU_READ_LOCK();
+    tbl = MDKI_ATOMIC_PTR_READ(&(mcdp->cred.mvfs_sys_credtbl));
+    fcred = mvfs_find_cred(
+                MDKI_ATOMIC_PTR_READ(&(tbl->ct_chain[fp & (tbl->ct_sz - 1)])),
+                cred, fp);
+    if (fcred != NULL) {
+        /* The table's reference keeps it alive until after a grace period */
+        MDKI_CRHOLD(fcred);
+    }
+    MDKI_RCU_READ_UNLOCK();
+    sys_clist = NULL;
+    sz = 0;
+    chainlen = 0;
 
+    if (fcred == NULL) {
+        /* Allocate the system chain entry before taking the chain lock.
+           It is given back below if an equivalent cred got there first. */
         if ((sys_clist = (mvfs_clr_creds_t *)MVFS_CLR_CRED_ALLOC()) == NULL) {
             MDB_XLOG((MDB_CLEAROPS,
                       "MVFS_CLR_CRED_ALLOC() failed for sys "
                       "credlist cred=%"KS_FMT_PTR_T"\n",
                       cred));
-
-            /* Clean up the previous memory allocation
-            */
             MVFS_CLR_CRED_FREE((caddr_t)clist, sizeof(mvfs_clr_creds_t));
             return;
         }
-        SPLOCK(mcdp->cred.mvfs_sys_credlist_lock, s);
-        sys_clist->next = mcdp->cred.mvfs_free_creds;
-        sys_clist->cred = NULL;
-        mcdp->cred.mvfs_free_creds = sys_clist;
+        SPLOCK_SELECT(&(mcdp->cred.mvfs_sys_credlist_lockpool), fp,
+                      HASH_SPLOCK_PER_GROUP, &lockp);
+        MDKI_RCU_READ_LOCK();
+        SPLOCK(*lockp, s);
+        /* Find the table this cred's group lives in now. */
+        tbl = MDKI_ATOMIC_PTR_READ(&(mcdp->cred.mvfs_sys_credtbl));
+        while (tbl->ct_next != NULL &&
+               (fp % mcdp->cred.mvfs_sys_credlist_lockpool.spl_count) <
+               (ks_uint32_t) tbl->ct_moved)
+        {
+            tbl = tbl->ct_next;
+        }
+        chainp = &(tbl->ct_chain[fp & (tbl->ct_sz - 1)]);
+        fcred = mvfs_find_cred(*chainp, cred, fp);
+        if (fcred == NULL) {
+            /* not found in system hash table, add it there as well as to
+               the mnode chain */
+            MDKI_CRHOLD(cred);          /* ref for sys_clist, goes in bucket */
+            sys_clist->cred = cred;
+            sys_clist->fp = fp;
+            sys_clist->next = *chainp;
+            /* The entry must be visible before it is on the chain. */
+            MDKI_MEMORY_BARRIER();
+            MDKI_ATOMIC_PTR_SET(chainp, sys_clist);
+            sys_clist = NULL;           /* now owned by the table */
+            for (scl = *chainp; scl != NULL; scl = scl->next)
+                chainlen++;
+            sz = tbl->ct_sz;
+            fcred = cred;
+        }
+        MDKI_CRHOLD(fcred);             /* ref for clist, goes on mnp chain */
+        SPUNLOCK(*lockp, s);
+        MDKI_RCU_READ_UNLOCK();
+        if (sys_clist != NULL)
+            MVFS_CLR_CRED_FREE((caddr_t)sys_clist, sizeof(mvfs_clr_creds_t));
     }
-    fcred = mvfs_find_cred(mcdp->cred.mvfs_sys_credlist[crhash], cred);
-    if (fcred == NULL) {
-        /* not found in system hash table, add it there as well as to the
-           mnode chain */
-        MDKI_CRHOLD(cred);              /* ref for clist, goes on mnp chain */
-        clist->cred = cred;
-        /* pull a clist from the free_creds list */
-        sys_clist = mcdp->cred.mvfs_free_creds;
-        mcdp->cred.mvfs_free_creds = sys_clist->next;
-
-        MDKI_CRHOLD(cred);              /* ref for sys_clist, goes in bucket */
-        sys_clist->cred = cred;
-        sys_clist->next = mcdp->cred.mvfs_sys_credlist[crhash];
-        mcdp->cred.mvfs_sys_credlist[crhash] = sys_clist;
-        SPUNLOCK(mcdp->cred.mvfs_sys_credlist_lock, s);
-
-#ifdef MVFS_DEBUG
-        mcdp->cred.mvfs_sys_crlen[crhash]++;
-#endif
-    } else {
-        /* found on system list, just hold & reference it in the mnode chain */
-        MDKI_CRHOLD(fcred);
-        SPUNLOCK(mcdp->cred.mvfs_sys_credlist_lock, s);
-        clist->cred = fcred;
+    if (fcred != cred) {
         MDB_XLOG((MDB_CLEAROPS, "found cred %"KS_FMT_PTR_T" on sys list as %"KS_FMT_PTR_T"\n",
                   cred, fcred));
     }
+    clist->cred = fcred;
+    clist->fp = fp;
     MCILOCK(mnp);
     clist->next = mnp->mn_vob.cleartext.ok_creds;
     mnp->mn_vob.cleartext.ok_creds = clist;
+    mnp->mn_vob.cleartext.ok_creds_bloom |= MVFS_CRED_BLOOM(fp);
     MCIUNLOCK(mnp);
 
     MDB_XLOG((MDB_CLEAROPS, "mnode %"KS_FMT_PTR_T" adding cred %"KS_FMT_PTR_T" as %"KS_FMT_PTR_T", %d/%d\n",
               mnp, cred, clist->cred,
               MDKI_CR_GET_UID(cred), MDKI_CR_GET_GID(cred)));
+
+    if (chainlen > MVFS_CRED_CHAIN_GROW)
+        mvfs_credlist_grow(sz);
 }
 
 extern int
@@ -1681,10 +1835,50 @@ mvfs_clear_init(mvfs_cache_sizes_t *mma_sizes)
 {
     mvfs_common_data_t *mcdp = MDKI_COMMON_GET_DATAP();
 
-    INITSPLOCK(mcdp->cred.mvfs_sys_credlist_lock, "mvfs_sys_credlist_spl");
+    ks_uint32_t sz;
+    int sp_poolsize;
+
+    /* Scale the initial system cred table with the rest of the caches. */
+    sz = MVFS_CRED_HASHSZ_MIN;
+    while (sz < MVFS_CRED_HASHSZ_MAX &&
+           sz < MVFS_CRED_HASHSZ_MIN * (ks_uint32_t)(mcdp->mvfs_largeinit + 1))
+    {
+        sz <<= 1;
+    }
+    mcdp->cred.mvfs_sys_credtbl = mvfs_credlist_tbl_alloc(sz);
+    if (mcdp->cred.mvfs_sys_credtbl == NULL) {
+        mvfs_log(MFS_LOG_ERR, "mvfs_clear_init: no memory (credlist)\n");
+        return ENOMEM;
+    }
+    /* Grown tables are multiples of this size, see mvfs_credlist_grow. */
+    HASH_SPLOCK_SET_POOLSIZE(sp_poolsize, sz);
+    if (mvfs_splock_pool_init(&(mcdp->cred.mvfs_sys_credlist_lockpool),
+                              sp_poolsize, NULL, "mvfs_sys_credlist_spl") != 0)
+    {
+        KMEM_FREE(mcdp->cred.mvfs_sys_credtbl, MVFS_CREDLIST_TBL_BYTES(sz));
+        mcdp->cred.mvfs_sys_credtbl = NULL;
+        return ENOMEM;
+    }
+    INITLOCK(&(mcdp->cred.mvfs_sys_credlist_growlock),
+             "mvfs_sys_credlist_grow");
+
     if (mcdp->mvfs_ctxt_atime_refresh == 0)
         mcdp->mvfs_ctxt_atime_refresh = MVFS_CTXT_ATIME_REFRESH_DEF;
     mcdp->mvfs_init_sizes.size[MVFS_SETCACHE_CTXT_ATIME_REFRESH] = mcdp->mvfs_ctxt_atime_refresh;
+
+    if (mcdp->mvfs_ctxt_prefetch_threads <= 0)
+        mcdp->mvfs_ctxt_prefetch_threads = MVFS_CTXT_PREFETCH_THREADS_DEF;
+    if (mcdp->mvfs_ctxt_prefetch_threads > MVFS_CTXT_PREFETCH_MAXTHREADS)
+        mcdp->mvfs_ctxt_prefetch_threads = MVFS_CTXT_PREFETCH_MAXTHREADS;
+    if (mcdp->mvfs_ctxt_prefetch_view_max <= 0)
+        mcdp->mvfs_ctxt_prefetch_view_max = MVFS_CTXT_PREFETCH_VIEW_MAX_DEF;
+    if (mcdp->mvfs_ctxt_prefetch_qmax <= 0)
+        mcdp->mvfs_ctxt_prefetch_qmax = MVFS_CTXT_PREFETCH_QMAX_DEF;
+    INITSPLOCK(mcdp->ctxt_prefetch.ctp_lock, "mvfs_ctxt_prefetch_spl");
+    mcdp->ctxt_prefetch.ctp_head = mcdp->ctxt_prefetch.ctp_tail = NULL;
+    mcdp->ctxt_prefetch.ctp_qlen = 0;
+    mcdp->ctxt_prefetch.ctp_slots = 0;
+    mcdp->ctxt_prefetch.ctp_active = TRUE;
     return 0;
 }
 
@@ -1692,11 +1886,22 @@ extern void
 mvfs_clear_free(void)
 {
     mvfs_common_data_t *mcdp = MDKI_COMMON_GET_DATAP();
+    SPL_T s;
+
+    /* Stop the prefetch workers and drop whatever they left queued. */
+    SPLOCK(mcdp->ctxt_prefetch.ctp_lock, s);
+    mcdp->ctxt_prefetch.ctp_active = FALSE;
+    SPUNLOCK(mcdp->ctxt_prefetch.ctp_lock, s);
+    MVFS_CTXT_PREFETCH_WAIT();
+    mvfs_ctxt_prefetch_drain();
+    FREESPLOCK(mcdp->ctxt_prefetch.ctp_lock);
 
     mvfs_flush_credlists(TRUE);
-    mvfs_clear_release_credlist(mcdp->cred.mvfs_free_creds);
-    mcdp->cred.mvfs_free_creds = NULL;
-    FREESPLOCK(mcdp->cred.mvfs_sys_credlist_lock);
+    mvfs_splock_pool_free(&(mcdp->cred.mvfs_sys_credlist_lockpool));
+    FREELOCK(&(mcdp->cred.mvfs_sys_credlist_growlock));
+    KMEM_FREE(mcdp->cred.mvfs_sys_credtbl,
+              MVFS_CREDLIST_TBL_BYTES(mcdp->cred.mvfs_sys_credtbl->ct_sz));
+    mcdp->cred.mvfs_sys_credtbl = NULL;
 }
 
 /* FIXME: This is called periodically.  It's possible we would clean
@@ -1711,10 +1916,12 @@ mvfs_flush_credlists(
     tbs_boolean_t force
 )
 {
-    register int i;
+    register ks_uint32_t i;
     SPL_T s;
+    SPLOCK_T *lockp;
     static int periodic_threshold = MVFS_CREDLIST_FLUSH_INTERVAL;
-    mvfs_clr_creds_t *clist;
+    mvfs_clr_creds_t *clist, *dead, **tailp;
+    mvfs_credlist_tbl_t *tbl;
     mvfs_common_data_t *mcdp = MDKI_COMMON_GET_DATAP();
 
     if (!force && --periodic_threshold > 0)
@@ -1722,15 +1929,241 @@ mvfs_flush_credlists(
 
     periodic_threshold = MVFS_CREDLIST_FLUSH_INTERVAL;
 
-    for (i = 0; i < MVFS_CRED_HASHSZ; i++) {
-        SPLOCK(mcdp->cred.mvfs_sys_credlist_lock, s);
-        clist = mcdp->cred.mvfs_sys_credlist[i];
-        mcdp->cred.mvfs_sys_credlist[i] = NULL;
-#ifdef MVFS_DEBUG
-        mcdp->cred.mvfs_sys_crlen[i] = 0;
-#endif
-        SPUNLOCK(mcdp->cred.mvfs_sys_credlist_lock, s);
-        mvfs_clear_release_credlist(clist);
+    /* Empty the chains, then release the entries once lockless readers
+       are done with them. */
+    dead = NULL;
+    tailp = &dead;
+    MVFS_LOCK(&(mcdp->cred.mvfs_sys_credlist_growlock));
+    tbl = mcdp->cred.mvfs_sys_credtbl;
+    for (i = 0; i < tbl->ct_sz; i++) {
+        SPLOCK_SELECT(&(mcdp->cred.mvfs_sys_credlist_lockpool), i,
+                      HASH_SPLOCK_PER_GROUP, &lockp);
+        SPLOCK(*lockp, s);
+        clist = tbl->ct_chain[i];
+        MDKI_ATOMIC_PTR_SET(&(tbl->ct_chain[i]), NULL);
+        SPUNLOCK(*lockp, s);
+        for (*tailp = clist; *tailp != NULL; tailp = &((*tailp)->next))
+            continue;
+    }
+    MVFS_UNLOCK(&(mcdp->cred.mvfs_sys_credlist_growlock));
+    if (dead != NULL) {
+        MDKI_RCU_SYNC();
+        mvfs_clear_release_credlist(dead);
+    }
+}
+
+/*
+ * Speculative cleartext prefetch.
+ *
+ * Opening a VOB file whose cleartext is not active costs a cleartext RPC
+ * to the view server and a lookup of the container, all done by the opener
+ * while it waits.  When enabled by mvfs_ctxt_prefetch, a successful lookup
+ * queues a request to activate the cleartext in the background, so that a
+ * following open finds mn_hdr.realvp already set.  A vnode is queued at
+ * most once; mn_vob.cleartext.prefetch_queued (under ctp_lock) says it is
+ * on the queue, so a repeated lookup doesn't have to search for it.
+ *
+ * The queue is bounded globally (mvfs_ctxt_prefetch_qmax) and per view
+ * (mvfs_ctxt_prefetch_view_max); requests beyond either bound are
+ * dropped, never waited for.  At most mvfs_ctxt_prefetch_threads
+ * workers run at once, each started through MVFS_CTXT_PREFETCH_START and
+ * draining the queue until it is empty.
+ */
+
+STATIC void
+mvfs_ctxt_prefetch_release(
+    mvfs_ctxt_prefetch_req_t *req
+)
+{
+    mvfs_ctxt_prefetch_data_t *ctp = &(MDKI_COMMON_GET_DATAP()->ctxt_prefetch);
+    struct mfs_mnode *vwmnp = VTOM(MFS_VIEW(req->vp));
+    SPL_T s;
+
+    SPLOCK(ctp->ctp_lock, s);
+    vwmnp->mn_view.ctxt_prefetch_cnt--;
+    VTOM(req->vp)->mn_vob.cleartext.prefetch_queued = 0;
+    SPUNLOCK(ctp->ctp_lock, s);
+
+    MDKI_CRFREE(req->cred);
+    VN_RELE(req->vp);
+    KMEM_FREE(req, sizeof(*req));
+}
+
+/* Release all queued requests (workers must not be running). */
+STATIC void
+mvfs_ctxt_prefetch_drain(void)
+{
+    mvfs_ctxt_prefetch_data_t *ctp = &(MDKI_COMMON_GET_DATAP()->ctxt_prefetch);
+    mvfs_ctxt_prefetch_req_t *req, *nreq;
+    SPL_T s;
+
+    SPLOCK(ctp->ctp_lock, s);
+    req = ctp->ctp_head;
+    ctp->ctp_head = ctp->ctp_tail = NULL;
+    ctp->ctp_qlen = 0;
+    SPUNLOCK(ctp->ctp_lock, s);
+
+    for (; req != NULL; req = nreq) {
+        nreq = req->next;
+        BUMPSTAT(mfs_clearstat.clearprefetchdrop);
+        mvfs_ctxt_prefetch_release(req);
+    }
+}
+
+void
+mvfs_ctxt_prefetch(
+    VNODE_T *vp,
+    CALL_DATA_T *cd
+)
+{
+    mvfs_common_data_t *mcdp = MDKI_COMMON_GET_DATAP();
+    mvfs_ctxt_prefetch_data_t *ctp = &(mcdp->ctxt_prefetch);
+    mvfs_ctxt_prefetch_req_t *req;
+    struct mfs_mnode *mnp;
+    struct mfs_mnode *vwmnp;
+    int slot = -1;
+    int dropped = 0;
+    SPL_T s;
+
+    if (mcdp->mvfs_ctxt_prefetch == 0 || !ctp->ctp_active)
+        return;
+
+    /* Only VOB files in a view whose cleartext is not active yet */
+    if (!MFS_VPISMFS(vp) || !MVFS_ISVTYPE(vp, VREG))
+        return;
+    mnp = VTOM(vp);
+    if (!MFS_ISVOB(mnp) || MFS_VIEW(vp) == NULL ||
+        mnp->mn_hdr.realvp != NULL)
+    {
+        return;
+    }
+    /* Unlocked peek; rechecked under ctp_lock below. */
+    if (mnp->mn_vob.cleartext.prefetch_queued)
+        return;
+
+    req = (mvfs_ctxt_prefetch_req_t *) KMEM_ALLOC(sizeof(*req), KM_NOSLEEP);
+    if (req == NULL) {
+        BUMPSTAT(mfs_clearstat.clearprefetchdrop);
+        return;
+    }
+    req->next = NULL;
+    req->vp = vp;
+    req->cred = MVFS_CD2CRED(cd);
+    vwmnp = VTOM(MFS_VIEW(vp));
+
+    SPLOCK(ctp->ctp_lock, s);
+    if (mnp->mn_vob.cleartext.prefetch_queued) {
+        /* Already queued, nothing to do. */
+        SPUNLOCK(ctp->ctp_lock, s);
+        KMEM_FREE(req, sizeof(*req));
+        return;
+    }
+    if (ctp->ctp_qlen >= mcdp->mvfs_ctxt_prefetch_qmax ||
+        vwmnp->mn_view.ctxt_prefetch_cnt >= mcdp->mvfs_ctxt_prefetch_view_max)
+    {
+        dropped = 1;
+    } else {
+        mnp->mn_vob.cleartext.prefetch_queued = 1;
+        VN_HOLD(vp);
+        MDKI_CRHOLD(req->cred);
+        if (ctp->ctp_tail != NULL)
+            ctp->ctp_tail->next = req;
+        else
+            ctp->ctp_head = req;
+        ctp->ctp_tail = req;
+        ctp->ctp_qlen++;
+        vwmnp->mn_view.ctxt_prefetch_cnt++;
+
+        /* Start another worker if we are below the limit. */
+        for (slot = 0; slot < mcdp->mvfs_ctxt_prefetch_threads; slot++) {
+            if ((ctp->ctp_slots & (1 << slot)) == 0) {
+                ctp->ctp_slots |= (1 << slot);
+                break;
+            }
+        }
+        if (slot == mcdp->mvfs_ctxt_prefetch_threads)
+            slot = -1;
+    }
+    SPUNLOCK(ctp->ctp_lock, s);
+
+    if (dropped) {
+        KMEM_FREE(req, sizeof(*req));
+        BUMPSTAT(mfs_clearstat.clearprefetchdrop);
+        return;
+    }
+    BUMPSTAT(mfs_clearstat.clearprefetch);
+
+    if (slot >= 0 && MVFS_CTXT_PREFETCH_START(slot) != 0) {
+        /*
+         * The port can't run the worker.  Give up on prefetching
+         * altogether once nothing else is left to service the queue.
+         */
+        SPLOCK(ctp->ctp_lock, s);
+        ctp->ctp_slots &= ~(1 << slot);
+        if (ctp->ctp_slots == 0)
+            ctp->ctp_active = FALSE;
+        SPUNLOCK(ctp->ctp_lock, s);
+        if (!ctp->ctp_active)
+            mvfs_ctxt_prefetch_drain();
+    }
+}
+
+/*
+ * Body of prefetch worker "slot", called by the port with a call data
+ * set up for the worker thread.  Returns when the queue is empty.
+ */
+void
+mvfs_ctxt_prefetch_worker(
+    int slot,
+    CALL_DATA_T *cd
+)
+{
+    mvfs_ctxt_prefetch_data_t *ctp = &(MDKI_COMMON_GET_DATAP()->ctxt_prefetch);
+    mvfs_ctxt_prefetch_req_t *req;
+    struct mfs_mnode *mnp;
+    CALL_DATA_T *ncd;
+    int error;
+    SPL_T s;
+
+    for (;;) {
+        SPLOCK(ctp->ctp_lock, s);
+        req = ctp->ctp_head;
+        if (req == NULL || !ctp->ctp_active) {
+            ctp->ctp_slots &= ~(1 << slot);
+            SPUNLOCK(ctp->ctp_lock, s);
+            break;
+        }
+        ctp->ctp_head = req->next;
+        if (ctp->ctp_head == NULL)
+            ctp->ctp_tail = NULL;
+        ctp->ctp_qlen--;
+        SPUNLOCK(ctp->ctp_lock, s);
+
+        /* Act with the creds of the process which did the lookup. */
+        ncd = MVFS_ALLOC_SUBSTITUTE_CRED(cd, req->cred);
+        if (!MVFS_SUBSTITUTE_CRED_IS_VALID(ncd)) {
+            BUMPSTAT(mfs_clearstat.clearprefetcherr);
+            mvfs_ctxt_prefetch_release(req);
+            continue;
+        }
+        mnp = VTOM(req->vp);
+        MLOCK(mnp);
+        /* Someone may have opened it in the meantime. */
+        if (mnp->mn_hdr.realvp == NULL) {
+            error = mfs_getcleartext(req->vp, NULL, ncd);
+            if (error == 0) {
+                mnp->mn_vob.cleartext.prefetched = 1;
+                BUMPSTAT(mfs_clearstat.clearprefetchdone);
+            } else {
+                MDB_XLOG((MDB_CLEAROPS,
+                          "prefetch: mnp=%"KS_FMT_PTR_T" error=%d\n",
+                          mnp, error));
+                BUMPSTAT(mfs_clearstat.clearprefetcherr);
+            }
+        }
+        MUNLOCK(mnp);
+        MVFS_FREE_SUBSTITUTE_CRED(ncd);
+        mvfs_ctxt_prefetch_release(req);
     }
 }
 static const char vnode_verid_mvfs_clearops_c[] = "$Id:  83c54eaa.46fd11e3.8592.00:01:84:c3:8a:52 $";
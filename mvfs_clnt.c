@@ -265,6 +265,7 @@ mfs_clnt_getattr_mnp(
         */
         mnp->mn_vob.lvut = rrp->lvut;
         mvfs_attrcache(mnp, vfsp, &(rrp->vstat), FALSE, cd);
+        mnp->mn_vob.getattr_seq++;  /* Tell waiters in mfs_clnt_getattr */
 
         /* Fix up stats for a 'history mode' symlink.  The size returned does
         ** not include the hm suffix we will add, because the view_server
@@ -296,6 +297,8 @@ mfs_clnt_getattr(
     CALL_DATA_T *cd
 )
 {
+    mfs_mnode_t *mnp = VTOM(vp);
+    u_int seq;
     int error;
 
     /* 
@@ -303,10 +306,27 @@ mfs_clnt_getattr(
      * ops. e.g. don't want go fetch attrs, then dir op gets and changes
      * them/caches them, then get the lock to update the attributes and put in
      * old ones.
+     *
+     * The mnode lock also means only one getattr RPC per (view, object) is
+     * outstanding.  When many callers miss the attribute cache at once
+     * (e.g. a parallel build stat'ing the same header), the rest queue
+     * behind the first on the lock.  If a getattr RPC completed while we
+     * waited and the attributes it cached are still usable, share them
+     * rather than asking the view again.  The unlocked read of the sequence
+     * number is only a hint; a stale value just costs us an RPC.
      */
-    MLOCK(VTOM(vp));
-    error = mfs_clnt_getattr_mnp(VTOM(vp), vp->v_vfsp, cd);
-    MUNLOCK(VTOM(vp));
+    seq = mnp->mn_vob.getattr_seq;
+    MLOCK(mnp);
+    if (mnp->mn_vob.getattr_seq != seq && MFS_ATTRISVALID(vp) &&
+        MVFS_MYTHREAD(cd)->thr_attrgen <= mnp->mn_vob.attrgen)
+    {
+        BUMPSTAT(mfs_acstat.ac_shared);
+        BUMP_VACSTATM(mnp, acstat.ac_shared);
+        error = 0;
+    } else {
+        error = mfs_clnt_getattr_mnp(mnp, vp->v_vfsp, cd);
+    }
+    MUNLOCK(mnp);
     return(error);
 }
 
@@ -668,6 +688,8 @@ typedef struct mvfs_clnt_lookup_vars {
     int pri;
     u_int dncflags;
     int view_op;
+    u_int seq;
+    tbs_boolean_t may_share;
 } mvfs_clnt_lookup_vars_t;
 
 int
@@ -680,6 +702,9 @@ mfs_clnt_lookup(
 {
     HEAP_ALLOC_RPC_ARGS_AND_VARS(view_lookup, mvfs_clnt_lookup_vars_t, lvp);
 
+    /* Note how many lookups the dir has seen before we wait for its lock. */
+    lvp->seq = VTOM(dvp)->mn_vob.lookup_seq;
+    lvp->may_share = TRUE;
     lvp->hm_warp_opt = VIEW_HM_WARP_OPT_NONE;
     lvp->isdotdot = 0;
     lvp->view_op = VIEW_LOOKUP;
@@ -787,7 +812,38 @@ mfs_clnt_lookup(
 retry:
     MLOCK(lvp->mnp);
 
+    /*
+     * The dir lock is held across the RPC, so concurrent lookups in this
+     * dir (typically of the same name, after a flush or a view restart)
+     * queue up behind whoever is talking to the view.  If a lookup RPC
+     * finished here while we waited, its answer is probably in the name
+     * cache now, so check there once before making our own call.
+     * mfs_dnclookup() may lock the dir itself, so drop it first.
+     */
+    if (lvp->may_share && lvp->mnp->mn_vob.lookup_seq != lvp->seq) {
+        lvp->may_share = FALSE;
+        MUNLOCK(lvp->mnp);
+        *vpp = mfs_dnclookup(dvp, nm, NULL, cd);
+        if (*vpp == NULL)
+            goto retry;
+        if (lvp->hm) {
+            ASSERT(rap->name != nm);
+            STRFREE(rap->name);
+        }
+        if (*vpp == MFS_DNC_ENOENTVP) {
+            *vpp = NULL;
+            error = ENOENT;
+        } else {
+            error = 0;
+        }
+        BUMPSTAT(mfs_dncstat.dnc_lookupshared);
+        BUMP_VDNCSTATV(lvp->vw, dncstat.dnc_lookupshared);
+        goto done;
+    }
+    lvp->may_share = FALSE;
+
     MVFS_VWCALL(lvp->vw, dvp->v_vfsp, VIEW_LOOKUP, view_lookup, );
+    lvp->mnp->mn_vob.lookup_seq++;
 
     if (lvp->hm) {
 	ASSERT(rap->name != nm);
@@ -42,6 +42,10 @@ typedef struct mvfs_common_data
                                            per-view statistics */
 
     int mvfs_ctxt_atime_refresh;
+    int mvfs_ctxt_prefetch;
+    int mvfs_ctxt_prefetch_threads;
+    int mvfs_ctxt_prefetch_view_max;
+    int mvfs_ctxt_prefetch_qmax;
     int mvfs_dncdirmax;
     int mvfs_dncregmax;
     int mvfs_dncnoentmax;
@@ -67,9 +71,12 @@ typedef struct mvfs_common_data
     mvfs_rpc_data_t mvfs_rpc;           /* RPC client handle cache */
     mvfs_proc_thread_data_t proc_thr;   /* MVFS proc/thread state structs */
     mvfs_credlist_data_t cred;          /* System-wide credlist */
+    mvfs_ctxt_prefetch_data_t ctxt_prefetch; /* Cleartext prefetch queue */
+    mvfs_maint_data_t maint;            /* Periodic maintenance tasks */
 } mvfs_common_data_t;
 
 EXTERN int mvfs_copy_tunable(mvfs_common_data_t *mcdp);
 EXTERN void mfs_periodic_maintenance(CALL_DATA_T *cd);
+EXTERN int mvfs_maint_run(int task, CALL_DATA_T *cd);
 #endif /* MVFS_COMMON_H_ */
 /* $Id: 8bd55282.46fd11e3.8592.00:01:84:c3:8a:52 $ */
@@ -867,21 +867,27 @@ CopyOutMvfs_bhinfo(
 int
 CopyInMvfs_statbufs(
     caddr_t uargp,
+    size_t len,
     struct mvfs_statbufs *kargp,
     MVFS_CALLER_INFO *callinfo
 )
 {
+	/* Older callers pass a shorter structure; leave the rest unset. */
 #if defined(ATRIA_LP64) || defined(ATRIA_LLP64)
 	int res;
 	struct mvfs_statbufs_32 vbl_32;
 	if (MDKI_CALLER_IS_32BIT(callinfo)) {
-		res = COPYIN(uargp, (caddr_t)&vbl_32, sizeof(struct mvfs_statbufs_32));
+		BZERO(&vbl_32, sizeof(vbl_32));
+		res = COPYIN(uargp, (caddr_t)&vbl_32,
+			     KS_MIN(len, sizeof(struct mvfs_statbufs_32)));
 		if (!res)
 			mvfs_statbufs_32_to_mvfs_statbufs(&vbl_32, kargp);
 		return res;
 	}
 #endif /* ATRIA_LP64 */
-	return(COPYIN(uargp, (caddr_t)kargp, sizeof(struct mvfs_statbufs)));
+	BZERO(kargp, sizeof(*kargp));
+	return(COPYIN(uargp, (caddr_t)kargp,
+		      KS_MIN(len, sizeof(struct mvfs_statbufs))));
 }
 
 int
@@ -978,6 +984,26 @@ CopyOutMvfs_cache_sizes(
     return(COPYOUT((caddr_t)kargp, uargp, sizeof(struct mvfs_cache_sizes)));
 }
 
+int
+CopyInMvfs_iodncbulk(
+    caddr_t uargp,
+    struct mvfs_iodncbulk *kargp,
+    MVFS_CALLER_INFO *callinfo
+)
+{
+	return(COPYIN(uargp, (caddr_t)kargp, sizeof(struct mvfs_iodncbulk)));
+}
+
+int
+CopyOutMvfs_iodncbulk(
+    struct mvfs_iodncbulk *kargp,
+    caddr_t uargp,
+    MVFS_CALLER_INFO *callinfo
+)
+{
+    return(COPYOUT((caddr_t)kargp, uargp, sizeof(struct mvfs_iodncbulk)));
+}
+
 int
 CopyOutMvfs_cache_usage(
     struct mvfs_cache_usage *kargp,
@@ -63,13 +63,15 @@ extern int CopyInMfs_ioncent(caddr_t , struct mfs_ioncent *, MVFS_CALLER_INFO *c
 extern int CopyOutMfs_ioncent(struct mfs_ioncent *, caddr_t, MVFS_CALLER_INFO *callinfo);
 extern int CopyInMvfs_bhinfo(caddr_t , struct mvfs_bhinfo *, MVFS_CALLER_INFO *callinfo);
 extern int CopyOutMvfs_bhinfo(struct mvfs_bhinfo *, caddr_t, MVFS_CALLER_INFO *callinfo);
-extern int CopyInMvfs_statbufs(caddr_t , struct mvfs_statbufs *, MVFS_CALLER_INFO *callinfo);
+extern int CopyInMvfs_statbufs(caddr_t , size_t, struct mvfs_statbufs *, MVFS_CALLER_INFO *callinfo);
 extern int CopyInMvfs_io_xattr(caddr_t , struct mvfs_io_xattr *, MVFS_CALLER_INFO *callinfo);
 extern int CopyOutMvfs_io_xattr(struct mvfs_io_xattr *, caddr_t, MVFS_CALLER_INFO *callinfo);
 extern int CopyInMvfs_export_viewinfo(caddr_t , struct mvfs_export_viewinfo *, MVFS_CALLER_INFO *callinfo);
 extern int CopyOutMvfs_export_viewinfo(struct mvfs_export_viewinfo *, caddr_t, MVFS_CALLER_INFO *callinfo);
 extern int CopyInMvfs_cache_sizes(caddr_t , struct mvfs_cache_sizes *, MVFS_CALLER_INFO *callinfo);
 extern int CopyOutMvfs_cache_sizes(struct mvfs_cache_sizes *, caddr_t, MVFS_CALLER_INFO *callinfo);
+extern int CopyInMvfs_iodncbulk(caddr_t , struct mvfs_iodncbulk *, MVFS_CALLER_INFO *callinfo);
+extern int CopyOutMvfs_iodncbulk(struct mvfs_iodncbulk *, caddr_t, MVFS_CALLER_INFO *callinfo);
 extern int CopyInTbs_uuid_s(caddr_t , struct tbs_uuid_s *, MVFS_CALLER_INFO *callinfo);
 extern int CopyInTbs_oid_s(caddr_t , struct tbs_oid_s *, MVFS_CALLER_INFO *callinfo);
 extern int CopyOutMfs_clntstat(struct mfs_clntstat *, caddr_t, size_t , MVFS_CALLER_INFO *callinfo);
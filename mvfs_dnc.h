@@ -57,10 +57,17 @@ struct mfs_dncent {
 	struct mfs_dncent *lruprev;	/* LRU list prev */
 	u_long		   addtime;	/* Last add/change time (secs) */
 	struct mfs_dncent *lruhead;	/* Which LRU list DNC is on */
+	struct mfs_dncent *dirnext;	/* Dir FID index next */
+	struct mfs_dncent **dirpprev;	/* Dir FID index link to us */
+	struct mfs_dncent *objnext;	/* Result FID index next */
+	struct mfs_dncent **objpprev;	/* Result FID index link to us */
+	struct mfs_dncent *vwnext;	/* View index next */
+	struct mfs_dncent **vwpprev;	/* View index link to us */
 	u_int		   in_trans : 1; /* dnc entry in transition - ignore */
         u_int              nullbh : 1;  /* dnc entry valid for null bh */
         u_int              invalid : 1; /* Marks invalidated entries */
-	u_int              mbz : 5;	/* Unused flag bits */
+	u_int              numa_node : 2; /* NUMA node slot that filled it */
+	u_int              mbz : 3;	/* Unused flag bits */
         u_char		   bhx;		/* Build handle list index */
         u_short            flags;       /* Name cache entry flags */
         VNODE_T	          *dvw;		/* Dir view */
@@ -69,13 +76,16 @@ struct mfs_dncent {
         u_long		   dncgen;	/* Dir mnode generation */
 	view_bhandle_t	   bh[MFS_DNCBHMAX];	/* Non-null build handle list */
 	int		   len;		/* Name length */
+	u_int		   nmhash;	/* mfs_namehash() of the name */
+	u_int		   hits;	/* Lookups found it (under hash lock) */
         char              *nm_p;        /* Ptr to the name */
 	char	           nm_inline[MFS_DNMAXSHORTNAME];	/* Stg for short names*/
 	VNODE_T 	  *vvw;		/* Vnode result view */
 	mfs_fid_t	   vfid;	/* Vnode result FID */
 	struct timeval     vevtime;	/* Vob event time of vp when added */
 	CRED_T      *cred;	/* Credentials */
-        int		   dnc_hash;        /* Name hash value, use as splock index */
+        int		   dnc_hash;        /* Hash chain (see below), use as splock index */
+	u_int		   dnc_key;	/* Full hash, picks the bucket in any table */
 };
 
 typedef struct mfs_dncent mfs_dncent_t;
@@ -92,6 +102,28 @@ typedef struct mfs_dnchash_slot {
     mfs_dncent_t *prev;
 } mfs_dnchash_slot_t;
 
+/*
+ * Secondary indexes, so that invalidating or flushing the entries for a
+ * directory, an object or a view only visits the entries concerned
+ * instead of the whole cache.  An entry is on the indexes exactly when
+ * it is on a hash chain.
+ *
+ * The FID index is keyed on (vfsp, fid); each slot has one list of
+ * entries by directory FID and one by result FID (name-not-found entries
+ * have no result FID and are only on the directory list).  It has as
+ * many slots as the hash table.  The view index is keyed on the view
+ * vnode and is the same size as the FID index, so it grows with the cache
+ * and a view's slot holds few other views' entries; entries whose
+ * directory and result views differ (rare) all go in the extra
+ * MVFS_DNCVWIDX_XVIEW slot, which view walks always check.
+ * The directory vnode is not held by the entry, so the lists can't hang
+ * off the directory mnode itself.
+ */
+typedef struct mfs_dncfidx_slot {
+    mfs_dncent_t *dirfirst;
+    mfs_dncent_t *objfirst;
+} mfs_dncfidx_slot_t;
+
 typedef struct mfs_dnclru {
     mfs_dncent_t *next;
     mfs_dncent_t *prev;
@@ -100,15 +132,34 @@ typedef struct mfs_dnclru {
     SPLOCK_T     *lruspl;
 } mfs_dnclru_t;
 
+/*
+ * The hash table can be resized while the cache is in use.  The old
+ * table is then kept, and drained a few buckets at a time by lookups and
+ * adds, until all its entries are on the new one (see
+ * mvfs_dnc_rehash_step()).  A hash chain is named by its bucket and by
+ * which of the two tables it is in: MVFS_DNCHASH_ALT is set in the chain
+ * number for the table in the "alternate" slot, and the tables swap
+ * slots on each resize so that the chains of the draining table keep
+ * their numbers.  Which table a key's chain is in, and so its chain
+ * number, only changes with mvfs_dnc_hashseq bumped and the cache
+ * write-locked.
+ */
+#define MVFS_DNCHASH_ALT	0x40000000
+#define MVFS_DNCHASH_BUCKET(chain) ((chain) & ~MVFS_DNCHASH_ALT)
+
 /* DNC hash table locking. On most platforms, we use a pool of spinlocks 
- * for the hash chains, for improved granularity. 
+ * for the hash chains, for improved granularity.  The pool is sized
+ * when the cache is set up and chains share its locks modulo its size,
+ * so that it needn't change when the hash table does.  Two chains can
+ * share a lock, so code holding one chain lock must check before it
+ * takes another.
  */
 /* Pool of spinlocks.  Some pool parameters are controlled in mdep files */
 #define NC_HASH_LOCK_T  splock_pool_t
 
 #define NC_HASH_LOCK(hash_val, lockpp, st, _ncdp) { \
         if (hash_val != -1) {  \
-            SPLOCK_SELECT(&(_ncdp->mvfs_dnc_hash_lock), hash_val, HASH_SPLOCK_MAP, lockpp); \
+            SPLOCK_SELECT(&(_ncdp->mvfs_dnc_hash_lock), hash_val, HASH_SPLOCK_PER_GROUP, lockpp); \
             SPLOCK(**(lockpp), st);  \
         } else {  \
             *lockpp = NULL;  \
@@ -126,10 +177,35 @@ typedef struct mfs_dnclru {
 
 #define NC_HASH_LOCK_FREE(lockp) mvfs_splock_pool_free(lockp)
 
+/* Secondary index locking, one pool covering both indexes (see
+ * mfs_dncfidx_slot_t above).
+ */
+#define NC_IDX_LOCK(slot, lockpp, st, _ncdp) { \
+        SPLOCK_SELECT(&(_ncdp->mvfs_dnc_idx_lock), slot, HASH_SPLOCK_MAP, lockpp); \
+        SPLOCK(**(lockpp), st);  \
+        }
+
+#define NC_IDX_UNLOCK(lockp, st) SPUNLOCK(*(lockp), st)
+
+#define NC_IDX_LOCK_INIT(_ncdp)   { \
+        int idx_poolsize; \
+        HASH_SPLOCK_SET_POOLSIZE(idx_poolsize, _ncdp->mvfs_dncfidxsize); \
+        if (mvfs_splock_pool_init(&(_ncdp->mvfs_dnc_idx_lock), idx_poolsize, NULL, "mvfs_dnc_idx_spl") != 0) \
+            MDKI_PANIC("mfs_dncinit: no memory (index locks)"); \
+        }
+
 typedef struct mvfs_dnlc_data
 {
     int mvfs_dnchashsize;
     mfs_dnchash_slot_t *mfs_dnchash;
+    /* Table being drained after a resize (NULL if none), and the next of
+     * its buckets to move.  See MVFS_DNCHASH_ALT.
+     */
+    int mvfs_dncohashsize;
+    mfs_dnchash_slot_t *mfs_dncohash;
+    int mvfs_dnc_rehash_next;
+    int mvfs_dnchashalt;        /* MVFS_DNCHASH_ALT if mfs_dnchash is alt */
+    MDKI_SEQ_T mvfs_dnc_hashseq;
     mfs_dnclru_t mfs_dncdirlru;
     mfs_dnclru_t mfs_dncreglru;
     mfs_dnclru_t mfs_dncnoentlru;
@@ -143,6 +219,13 @@ typedef struct mvfs_dnlc_data
     SPLOCK_T mvfs_dnc_reglru_lock;
     SPLOCK_T mvfs_dnc_noentlru_lock;
     NC_HASH_LOCK_T mvfs_dnc_hash_lock;
+    /* Secondary indexes.  The index locks are leaf locks: take them after
+     * any hash chain and LRU lock, and never hold two at once.
+     */
+    int mvfs_dncfidxsize;
+    mfs_dncfidx_slot_t *mfs_dncfidx;
+    mfs_dncent_t **mfs_dncvwidx;       /* mvfs_dncfidxsize + 1 slots */
+    NC_HASH_LOCK_T mvfs_dnc_idx_lock;
     int mfs_dncmax;
     int mvfs_old_dncmax;
     int mfs_dnc_enoent_start;
@@ -157,6 +240,17 @@ typedef struct mvfs_dnlc_data
      * removing from cache, and we will already be using LRU lock there
      */
     int mvfs_dnc_noent_other;
+
+    /* Count of entries holding something (see UNUSED()), which is what
+     * the kernel's shrinker can get back from us.  Changed only by the
+     * owner of an in-transit entry, so it has to be atomic.
+     */
+    MVFS_DNC_COUNT_T mvfs_dnc_inuse;
+
+    /* Next slot to look at when the kernel asks us to shrink the cache.
+     * Only a hint, so it is read and updated without a lock.
+     */
+    int mvfs_dnc_shrink_cursor;
 } mvfs_dnlc_data_t;
 
 /*
@@ -372,6 +466,27 @@ mfs_dnc_flushvw(
     CALL_DATA_T *cd
 );
 
+/**************************************************************************
+ * MVFS_DNC_SHRINK - release name cache entries under memory pressure
+ *
+ * IN nr_to_scan    Number of cache slots to look at
+ *
+ * Description:
+ *      Called when the kernel wants memory back.  Walks the cache like a
+ *      clock hand, starting where the previous call stopped, and releases
+ *      the vnode, view and cred holds of every entry it passes over.
+ *      Returns the number of entries released.  MVFS_DNC_SHRINK_COUNT
+ *      returns the number of slots the clock hand can visit.
+ */
+EXTERN int
+mvfs_dnc_shrink_count(void);
+
+EXTERN int
+mvfs_dnc_shrink(
+    int nr_to_scan,
+    CALL_DATA_T *cd
+);
+
 /**************************************************************************
  * MVFS_DNC_FLUSHVFS(VFS_T *vfsp);
  *
@@ -451,6 +566,21 @@ mfs_dnc_getent(
     CALL_DATA_T *cd
 );
 
+/***************************************************************************
+ * MVFS_DNC_GETBULK - fill a buffer with name cache entries for the ioctl
+ *                    that reads the name cache in bulk
+ * IN OUT bp        Ptr to (kernel copy) of the bulk read structure.  The
+ *                  cursor says where to start and is updated to where the
+ *                  next call should pick up; records go to the user
+ *                  buffer it names.
+ */
+
+EXTERN int
+mvfs_dnc_getbulk(
+    struct mvfs_iodncbulk *bp,
+    CALL_DATA_T *cd
+);
+
 /***************************************************************************
  * MVFS_DNCFREE - clean up and release all resources used by the name cache
  */
@@ -468,6 +598,10 @@ mvfs_dnc_count(mvfs_cache_usage_t *curusage);
 /***************************************************************************
  * MVFS_DNC_SETCACHES - change the sizes of the DNC
  * IN szp		ptr to new cache sizes structure
+ *
+ * Changing the entry counts replaces (flushes) the cache.  Changing the
+ * hash table size doesn't; entries move to the new table over the
+ * lookups and adds that follow.
  */
 EXTERN int 
 mvfs_dnc_setcaches(
@@ -207,6 +207,7 @@ mfs_dncfind(
     VNODE_T *vw, 
     char *nm, 
     int len,
+    u_int nmhash,
     tbs_boolean_t case_insensitive,
     int hash, 
     CRED_T *cred
@@ -219,10 +220,11 @@ mvfs_dncadd_subr(
     u_int dnc_flags,
     char *nm,
     int len,
+    u_int nmhash,
     mfs_fid_t *vfidp,
     VTYPE_T type,
     struct timeval *evtp,
-    int hash,
+    u_int key,
     CALL_DATA_T *cd
 );
 
@@ -232,6 +234,7 @@ mfs_dnc_inval_case_synonyms(
     VNODE_T *vw,
     char *nm,
     int len,
+    u_int nmhash,
     int hash
 );
 
@@ -274,35 +277,204 @@ mfs_dncrele(
     struct mfs_dncent *dnp,
     CALL_DATA_T *cd
 );
-STATIC u_long 
+STATIC u_int 
 mfs_namehash(
     char *nm,
     int *lenp
 );
+STATIC int
+mvfs_dnc_nameeq(
+    char *nm1,
+    char *nm2,
+    int len
+);
 STATIC int  
 mvfs_dnclist_init(void);
 STATIC int
 mvfs_find_dnchashsize(int maxentry);
+STATIC void
+mvfs_dncidx_insert(
+    struct mfs_dncent *dnp
+);
+STATIC void
+mvfs_dncidx_remove(
+    struct mfs_dncent *dnp
+);
+STATIC u_short
+mvfs_dnc_ioncflags(
+    struct mfs_dncent *dnp
+);
+STATIC int
+mvfs_dnc_chain(
+    u_int key,
+    mvfs_dnlc_data_t *ncdp
+);
+STATIC int
+mvfs_dnc_bulkchain(
+    u_int bucket,
+    mvfs_dnlc_data_t *ncdp
+);
+STATIC void
+mvfs_dnc_rehash_bucket(
+    mvfs_dnlc_data_t *ncdp
+);
+STATIC void
+mvfs_dnc_rehash_step(
+    tbs_boolean_t wait
+);
+STATIC int
+mvfs_dnc_hash_resize(
+    int size
+);
+STATIC int
+mvfs_dnc_primesize(
+    int num
+);
+STATIC int
+mvfs_dnc_setcache_ents(
+    mvfs_cache_sizes_t *szp,
+    CALL_DATA_T *cd
+);
+STATIC char *
+mvfs_dnc_bulk_viewtag(
+    VNODE_T *vwroot,
+    VNODE_T *vw,
+    int id
+);
 
 /*
  * Hash for name cache entries.  All names are hashed in 1 table.
  * Hash size should be a prime number, and the nmhash value should
  * come from the "mfs_namehash()" routine (which also returns length of
- * the string).
+ * the string, and has already folded the length in).  The dir FID, VOB
+ * and dir view are folded in here, and the result goes through a final
+ * mixing step so that names which differ only slightly, or the same
+ * name in many dirs or views, spread over the whole table.
+ *
+ * The full 32-bit key is kept in the entry; the bucket is taken from it
+ * (see mvfs_dnc_chain()) only once the table to use is known.
  */
 
 #define MFS_DNCHASHMAX 18181    /* max hash size */
 #define MFS_DNCHASHMIN 509      /* min hash size */
+#define MVFS_DNCHASHSETMAX 1048573 /* max hash size set by hand */
 #define MFS_DNC_AVECHAIN 10     /*average chain length for each hash slot*/
-#define MFS_DNCHASH(dvp, nmhash, len, _ncdp)     \
-        ((nmhash + len + \
-	    VTOM(dvp)->mn_hdr.fid.mf_dbid + \
-	    VTOM(dvp)->mn_hdr.fid.mf_gen) % _ncdp->mvfs_dnchashsize)
+#define MVFS_DNC_GOLDEN32 0x9e3779b9U
+
+/* Buckets of the old table moved per step while draining it */
+#define MVFS_DNC_REHASH_BATCH 8
+
+#define MVFS_DNC_MIX32(h) \
+        ((h) ^= (h) >> 16, (h) *= 0x85ebca6bU, (h) ^= (h) >> 13, \
+         (h) *= 0xc2b2ae35U, (h) ^= (h) >> 16)
+
+#define MVFS_DNCKEY(dvp, nmhash) mvfs_dnc_bucket((nmhash), (dvp))
+
+STATIC u_int
+mvfs_dnc_bucket(
+    u_int nmhash,
+    VNODE_T *dvp
+)
+{
+    u_int h;
+
+    h = nmhash ^
+        ((u_int)VTOM(dvp)->mn_hdr.fid.mf_dbid * MVFS_DNC_GOLDEN32) ^
+        (u_int)VTOM(dvp)->mn_hdr.fid.mf_gen ^
+        (u_int)((u_long)MFS_VIEW(dvp) >> 4) ^
+        ((u_int)((u_long)dvp->v_vfsp >> 4) * MVFS_DNC_GOLDEN32);
+    MVFS_DNC_MIX32(h);
+    return h;
+}
+
+#define MVFS_RVCKEY(vw, vfsp)                                           \
+ ((u_int)(mfs_uuid_to_hash32(&(VTOM(vw)->mn_view.svr.uuid)) +           \
+          mfs_uuid_to_hash32(&(VFS_TO_MMI(vfsp)->mmi_svr.uuid))))
+
+/*
+ * Head of a hash chain, given its chain number.  The caller must hold the
+ * chain lock, having found the chain number under it (NC_HASH_LOCK_KEY)
+ * or from an entry on the chain.  See mvfs_dnc_chainhead().
+ */
+#define NC_HASH_HEAD(chain, _ncdp) mvfs_dnc_chainhead((chain), (_ncdp))
+
+/*
+ * Lock the hash chain for a key, returning its chain number in chain.
+ * Lookups don't hold the cache rwlock, so the chain is picked under
+ * mvfs_dnc_hashseq and picked again if a resize moved the key's bucket
+ * before we got the lock.  (With the rwlock held this never loops.)
+ */
+#define NC_HASH_LOCK_KEY(key, chain, lockpp, st, _ncdp) {               \
+        u_int _seq;                                                     \
+        for (;;) {                                                      \
+            _seq = MDKI_SEQ_READ_BEGIN(&((_ncdp)->mvfs_dnc_hashseq));   \
+            (chain) = mvfs_dnc_chain((key), (_ncdp));                   \
+            NC_HASH_LOCK((chain), (lockpp), st, (_ncdp));               \
+            if (!MDKI_SEQ_READ_RETRY(&((_ncdp)->mvfs_dnc_hashseq), _seq)) \
+                break;                                                  \
+            NC_HASH_UNLOCK(*(lockpp), st, (_ncdp));                     \
+        } }
+
+/*
+ * A resize swaps the tables and flips mvfs_dnchashalt with no chain locks
+ * held, only under mvfs_dnc_hashseq (lookups don't hold the rwlock that
+ * keeps it out).  A locked chain stays in the same table across a swap,
+ * since chain numbers name tables by slot and the slots swap with the
+ * tables, but mvfs_dnchashalt and the table pointer must be read from the
+ * same side of it, or an old bucket number could index the new table.
+ * So read them together in a mvfs_dnc_hashseq read section.  The table
+ * can't be freed while we hold one of its chain locks (see
+ * mvfs_dnc_rehash_bucket()).
+ */
+STATIC mfs_dncent_t *
+mvfs_dnc_chainhead(
+    int chain,
+    mvfs_dnlc_data_t *ncdp
+)
+{
+    mfs_dnchash_slot_t *tab;
+    int size;
+    u_int seq;
+
+    do {
+        seq = MDKI_SEQ_READ_BEGIN(&(ncdp->mvfs_dnc_hashseq));
+        if ((chain & MVFS_DNCHASH_ALT) == ncdp->mvfs_dnchashalt) {
+            tab = ncdp->mfs_dnchash;
+            size = ncdp->mvfs_dnchashsize;
+        } else {
+            tab = ncdp->mfs_dncohash;
+            size = ncdp->mvfs_dncohashsize;
+        }
+    } while (MDKI_SEQ_READ_RETRY(&(ncdp->mvfs_dnc_hashseq), seq));
+
+    ASSERT(tab != NULL && MVFS_DNCHASH_BUCKET(chain) < size);
+    return((mfs_dncent_t *)&(tab[MVFS_DNCHASH_BUCKET(chain)]));
+}
+
+/* Move some of the old table over, if a resize is in progress */
+#define MVFS_DNC_REHASH(_ncdp, wait)                                    \
+        if ((_ncdp)->mfs_dncohash != NULL) mvfs_dnc_rehash_step(wait)
+
+/*
+ * Slots in the secondary indexes.  An entry's view slot is -1 if it has
+ * no view at all (never the case for anything a view walk looks for).
+ */
+#define MVFS_DNCFIDX(vfsp, fid, _ncdp)                                  \
+        ((u_long)(((u_long)(vfsp) >> 4) + (fid).mf_dbid + (fid).mf_gen) \
+         % (_ncdp)->mvfs_dncfidxsize)
 
-#define MVFS_RVCHASH(vw, vfsp, _ncdp)                                  \
- (((mfs_uuid_to_hash32(&(VTOM(vw)->mn_view.svr.uuid)) +         \
-    mfs_uuid_to_hash32(&(VFS_TO_MMI(vfsp)->mmi_svr.uuid))))     \
-  % _ncdp->mvfs_dnchashsize)
+#define MVFS_DNCVWIDX(vw, _ncdp) \
+        ((int)(((u_long)(vw) >> 4) % (_ncdp)->mvfs_dncfidxsize))
+
+#define MVFS_DNCVWIDX_XVIEW(_ncdp) ((_ncdp)->mvfs_dncfidxsize)
+
+#define MVFS_DNCVWIDX_SLOTS(_ncdp) ((_ncdp)->mvfs_dncfidxsize + 1)
+
+#define MVFS_DNCVWIDX_ENT(dp, _ncdp)                                    \
+        (((dp)->dvw != NULL && (dp)->vvw != NULL && (dp)->dvw != (dp)->vvw) ? \
+         MVFS_DNCVWIDX_XVIEW(_ncdp) :                                   \
+         ((dp)->dvw != NULL ? MVFS_DNCVWIDX((dp)->dvw, _ncdp) :         \
+          ((dp)->vvw != NULL ? MVFS_DNCVWIDX((dp)->vvw, _ncdp) : -1)))
 
 mvfs_dnlc_data_t mvfs_dnlc_data_var;
 
@@ -351,12 +523,35 @@ mvfs_dnlc_data_t mvfs_dnlc_data_var;
 #define NC_RMHASH_LOCKED(dp) {  \
         DEBUG_ASSERT((dp)->next);     \
         DEBUG_ASSERT((dp)->prev);     \
+        mvfs_dncidx_remove(dp);       \
         (dp)->next->prev = (dp)->prev;  \
         (dp)->prev->next = (dp)->next;  \
         (dp)->next = (dp)->prev = NULL; \
         (dp)->dnc_hash = -1;  \
     }
 
+/*
+ * The index lists are NULL terminated, with a back pointer to whatever
+ * points at the entry, so the list heads are single pointers.  Call with
+ * the index slot locked.
+ */
+#define NC_INSIDX_LOCKED(headp, dp, nextf, pprevf) { \
+        register mfs_dncent_t **HEADP = (headp); \
+        DEBUG_ASSERT((dp)->pprevf == NULL); \
+        (dp)->nextf = *HEADP; \
+        if (*HEADP != NULL) (*HEADP)->pprevf = &((dp)->nextf); \
+        *HEADP = (dp); \
+        (dp)->pprevf = HEADP; \
+    }
+
+#define NC_RMIDX_LOCKED(dp, nextf, pprevf) { \
+        DEBUG_ASSERT((dp)->pprevf != NULL); \
+        *((dp)->pprevf) = (dp)->nextf; \
+        if ((dp)->nextf != NULL) (dp)->nextf->pprevf = (dp)->pprevf; \
+        (dp)->nextf = NULL; \
+        (dp)->pprevf = NULL; \
+    }
+
 #define SET_IN_TRANS(dp) { \
 	DEBUG_ASSERT((dp)->in_trans == 0); \
 	(dp)->in_trans = 1; \
@@ -416,7 +611,6 @@ STATIC int
 mvfs_find_dnchashsize(int maxentry)
 {
     int num;
-    int sqnum, i, isprime;
 
     num = maxentry/MFS_DNC_AVECHAIN;
 
@@ -424,7 +618,15 @@ mvfs_find_dnchashsize(int maxentry)
         return MFS_DNCHASHMIN;
     if (num >= MFS_DNCHASHMAX)
         return MFS_DNCHASHMAX;
-    
+    return mvfs_dnc_primesize(num);
+}
+
+/* smallest prime no less than num */
+STATIC int
+mvfs_dnc_primesize(int num)
+{
+    int sqnum, i, isprime;
+
     while (1) {
         isprime = 1; 
         sqnum = num/2;
@@ -463,6 +665,23 @@ mvfs_dnclist_init()
         KMEM_FREE(ncdp->mfs_dnchash, (ncdp->mvfs_dnchashsize)*sizeof(mfs_dnchash_slot_t));
         ncdp->mfs_dnchash = NULL;
     }
+    if (ncdp->mfs_dncohash != NULL) {
+        KMEM_FREE(ncdp->mfs_dncohash,
+                  (ncdp->mvfs_dncohashsize)*sizeof(mfs_dnchash_slot_t));
+        ncdp->mfs_dncohash = NULL;
+    }
+    ncdp->mvfs_dncohashsize = 0;
+    ncdp->mvfs_dnc_rehash_next = 0;
+    ncdp->mvfs_dnchashalt = 0;
+    if (ncdp->mfs_dncfidx != NULL) {
+        KMEM_FREE(ncdp->mfs_dncfidx, (ncdp->mvfs_dncfidxsize)*sizeof(mfs_dncfidx_slot_t));
+        ncdp->mfs_dncfidx = NULL;
+    }
+    if (ncdp->mfs_dncvwidx != NULL) {
+        KMEM_FREE(ncdp->mfs_dncvwidx,
+                  MVFS_DNCVWIDX_SLOTS(ncdp)*sizeof(mfs_dncent_t *));
+        ncdp->mfs_dncvwidx = NULL;
+    }
 
     ncdp->mvfs_dnchashsize = mvfs_find_dnchashsize(ncdp->mfs_dncmax);
     
@@ -483,13 +702,47 @@ mvfs_dnclist_init()
         }
     }
     
+    /* The FID index starts out the same size as the hash table, but
+     * keeps its size if the hash table is resized later.
+     */
+    ncdp->mvfs_dncfidxsize = ncdp->mvfs_dnchashsize;
+    ncdp->mfs_dncfidx = (mfs_dncfidx_slot_t *)
+            KMEM_ALLOC((ncdp->mvfs_dncfidxsize)*sizeof(mfs_dncfidx_slot_t), KM_SLEEP);
+    if (ncdp->mfs_dncfidx == NULL) {
+        mvfs_log(MFS_LOG_ERR,
+                 "Failed to allocate %d bytes for DNC index.\n",
+                 ncdp->mvfs_dncfidxsize*sizeof(mfs_dncfidx_slot_t));
+        KMEM_FREE(ncdp->mfs_dnchash, (ncdp->mvfs_dnchashsize)*sizeof(mfs_dnchash_slot_t));
+        ncdp->mfs_dnchash = NULL;
+        return(ENOMEM);
+    }
+    ncdp->mfs_dncvwidx = (mfs_dncent_t **)
+            KMEM_ALLOC(MVFS_DNCVWIDX_SLOTS(ncdp)*sizeof(mfs_dncent_t *), KM_SLEEP);
+    if (ncdp->mfs_dncvwidx == NULL) {
+        mvfs_log(MFS_LOG_ERR,
+                 "Failed to allocate %d bytes for DNC view index.\n",
+                 MVFS_DNCVWIDX_SLOTS(ncdp)*sizeof(mfs_dncent_t *));
+        KMEM_FREE(ncdp->mfs_dncfidx, (ncdp->mvfs_dncfidxsize)*sizeof(mfs_dncfidx_slot_t));
+        ncdp->mfs_dncfidx = NULL;
+        KMEM_FREE(ncdp->mfs_dnchash, (ncdp->mvfs_dnchashsize)*sizeof(mfs_dnchash_slot_t));
+        ncdp->mfs_dnchash = NULL;
+        return(ENOMEM);
+    }
+    
     NC_HASH_LOCK_INIT(ncdp);
+    NC_IDX_LOCK_INIT(ncdp);
     /* Initialize list hdrs */
 
     for (i=0; i < ncdp->mvfs_dnchashsize; i++) {
 	ncdp->mfs_dnchash[i].next = ncdp->mfs_dnchash[i].prev = 
 		(mfs_dncent_t *)&(ncdp->mfs_dnchash[i]);
     }
+    for (i=0; i < ncdp->mvfs_dncfidxsize; i++) {
+	ncdp->mfs_dncfidx[i].dirfirst = ncdp->mfs_dncfidx[i].objfirst = NULL;
+    }
+    for (i=0; i < MVFS_DNCVWIDX_SLOTS(ncdp); i++) {
+	ncdp->mfs_dncvwidx[i] = NULL;
+    }
     ncdp->mfs_dncdirlru.lrunext = ncdp->mfs_dncdirlru.lruprev = 
 		(mfs_dncent_t *)&(ncdp->mfs_dncdirlru);
     ncdp->mfs_dncdirlru.lruspl = &(ncdp->mvfs_dnc_dirlru_lock);
@@ -521,6 +774,71 @@ mvfs_dnclist_init()
     return(0);
 }
 
+/*
+ * Put an entry on, or take it off, the secondary indexes.  Called with
+ * the entry's hash chain locked, as it goes on or comes off the chain.
+ */
+STATIC void
+mvfs_dncidx_insert(
+    register struct mfs_dncent *dnp
+)
+{
+    register mvfs_dnlc_data_t *ncdp = MDKI_DNLC_GET_DATAP();
+    SPLOCK_T *idx_spl;
+    SPL_T si;
+    int slot;
+
+    slot = MVFS_DNCFIDX(dnp->vfsp, dnp->dfid, ncdp);
+    NC_IDX_LOCK(slot, &idx_spl, si, ncdp);
+    NC_INSIDX_LOCKED(&(ncdp->mfs_dncfidx[slot].dirfirst), dnp,
+                     dirnext, dirpprev);
+    NC_IDX_UNLOCK(idx_spl, si);
+
+    if (!MFS_FIDNULL(dnp->vfid)) {
+        slot = MVFS_DNCFIDX(dnp->vfsp, dnp->vfid, ncdp);
+        NC_IDX_LOCK(slot, &idx_spl, si, ncdp);
+        NC_INSIDX_LOCKED(&(ncdp->mfs_dncfidx[slot].objfirst), dnp,
+                         objnext, objpprev);
+        NC_IDX_UNLOCK(idx_spl, si);
+    }
+
+    if ((slot = MVFS_DNCVWIDX_ENT(dnp, ncdp)) != -1) {
+        NC_IDX_LOCK(slot, &idx_spl, si, ncdp);
+        NC_INSIDX_LOCKED(&(ncdp->mfs_dncvwidx[slot]), dnp, vwnext, vwpprev);
+        NC_IDX_UNLOCK(idx_spl, si);
+    }
+}
+
+STATIC void
+mvfs_dncidx_remove(
+    register struct mfs_dncent *dnp
+)
+{
+    register mvfs_dnlc_data_t *ncdp = MDKI_DNLC_GET_DATAP();
+    SPLOCK_T *idx_spl;
+    SPL_T si;
+    int slot;
+
+    if (dnp->dirpprev != NULL) {
+        slot = MVFS_DNCFIDX(dnp->vfsp, dnp->dfid, ncdp);
+        NC_IDX_LOCK(slot, &idx_spl, si, ncdp);
+        NC_RMIDX_LOCKED(dnp, dirnext, dirpprev);
+        NC_IDX_UNLOCK(idx_spl, si);
+    }
+    if (dnp->objpprev != NULL) {
+        slot = MVFS_DNCFIDX(dnp->vfsp, dnp->vfid, ncdp);
+        NC_IDX_LOCK(slot, &idx_spl, si, ncdp);
+        NC_RMIDX_LOCKED(dnp, objnext, objpprev);
+        NC_IDX_UNLOCK(idx_spl, si);
+    }
+    if (dnp->vwpprev != NULL) {
+        slot = MVFS_DNCVWIDX_ENT(dnp, ncdp);
+        NC_IDX_LOCK(slot, &idx_spl, si, ncdp);
+        NC_RMIDX_LOCKED(dnp, vwnext, vwpprev);
+        NC_IDX_UNLOCK(idx_spl, si);
+    }
+}
+
 #define DIRMAX_FORMULA(scale) (200 * ((scale)+1))
 #define REGMAX_FORMULA(scale) (800 * ((scale)+1))
 #define NOENTMAX_FORMULA(scale) (800 * ((scale)+1))
@@ -555,11 +873,21 @@ mvfs_dncinit(mvfs_cache_sizes_t *mma_sizes)
      */ 
     ncdp->mvfs_dnchashsize = MFS_DNCHASHMIN;
     ncdp->mfs_dnchash = NULL;
+    ncdp->mvfs_dncohashsize = 0;
+    ncdp->mfs_dncohash = NULL;
+    ncdp->mvfs_dnc_rehash_next = 0;
+    ncdp->mvfs_dnchashalt = 0;
+    MDKI_SEQ_INIT(&(ncdp->mvfs_dnc_hashseq));
+    ncdp->mvfs_dncfidxsize = 0;
+    ncdp->mfs_dncfidx = NULL;
+    ncdp->mfs_dncvwidx = NULL;
     ncdp->mfs_dncmax = 0;     /* Total DNC ents - filled in on init */ 
     ncdp->mfs_dnc_enoent_start = 0;
     ncdp->mvfs_old_dnc = 0;
     ncdp->mvfs_dnc_initialzed = FALSE;
     ncdp->mvfs_dnc_noent_other = 0;
+    MDKI_ATOMIC_SET_UINT32(&(ncdp->mvfs_dnc_inuse), 0);
+    ncdp->mvfs_dnc_shrink_cursor = 0;
 
     /* Initialize the global cache lock */
     MVFS_RW_LOCK_INIT(&(ncdp->mvfs_dnc_rwlock), "mvfs_dnlc_lock");
@@ -642,6 +970,7 @@ retry:
     KMEM_FREE(ncdp->mfs_dnc, (ncdp->mfs_dncmax)*sizeof(struct mfs_dncent)); 
 nclockfree:
     NC_HASH_LOCK_FREE(&(ncdp->mvfs_dnc_hash_lock)); 
+    NC_HASH_LOCK_FREE(&(ncdp->mvfs_dnc_idx_lock)); 
     FREESPLOCK(ncdp->mvfs_dnc_dirlru_lock);
     FREESPLOCK(ncdp->mvfs_dnc_reglru_lock);
     FREESPLOCK(ncdp->mvfs_dnc_noentlru_lock);
@@ -654,13 +983,38 @@ mvfs_dnc_setcaches(
     mvfs_cache_sizes_t *szp,
     CALL_DATA_T *cd
 )
+{
+    mvfs_dnlc_data_t *ncdp = MDKI_DNLC_GET_DATAP();
+    int error;
+
+    if ((error = mvfs_dnc_setcache_ents(szp, cd)) != 0)
+        return(error);
+
+    /* The hash table is resized in place, without a flush. */
+    if (MVFS_SIZE_VALID(szp, DNCHASHTAB_SZ) && ncdp->mfs_dnc != NULL) {
+        error = mvfs_dnc_hash_resize(szp->size[MVFS_SETCACHE_DNCHASHTAB_SZ]);
+    }
+    if (MVFS_SIZE_PRESENT(szp, DNCHASHTAB_SZ))
+	szp->size[MVFS_SETCACHE_DNCHASHTAB_SZ] = ncdp->mvfs_dnchashsize;
+    return(error);
+}
+
+/*
+ * Change the number of entries.  This replaces the whole cache (and sizes
+ * the hash table to suit the new entry count).
+ */
+STATIC int
+mvfs_dnc_setcache_ents(
+    mvfs_cache_sizes_t *szp,
+    CALL_DATA_T *cd
+)
 {
     register mvfs_dnlc_data_t *ncdp = MDKI_DNLC_GET_DATAP();
     mvfs_common_data_t *mcdp = MDKI_COMMON_GET_DATAP();
     struct mfs_dncent *new_mvfs_dnc, *free_mvfs_dnc = 0;
     int new_mvfs_dncmax, rval, free_mvfs_dncmax = 0 /* shut up GCC */;
     SPL_T  srw;
-    NC_HASH_LOCK_T free_hash_locks;
+    NC_HASH_LOCK_T free_hash_locks, free_idx_locks;
 
     if ((!MVFS_SIZE_VALID(szp, DNCDIRMAX) ||
          szp->size[MVFS_SETCACHE_DNCDIRMAX] == mcdp->mvfs_dncdirmax) &&
@@ -727,6 +1081,7 @@ mvfs_dnc_setcaches(
 	ncdp->mvfs_old_dnc = 0;
     }
     free_hash_locks =  ncdp->mvfs_dnc_hash_lock;
+    free_idx_locks =  ncdp->mvfs_dnc_idx_lock;
 
     MVFS_SIZE_RUNTIME_SET(mcdp->mvfs_dncdirmax, szp, DNCDIRMAX);
     MVFS_SIZE_RUNTIME_SET(mcdp->mvfs_dncregmax, szp, DNCREGMAX);
@@ -742,6 +1097,7 @@ mvfs_dnc_setcaches(
 	KMEM_FREE(free_mvfs_dnc, free_mvfs_dncmax*sizeof(struct mfs_dncent));
     }
     NC_HASH_LOCK_FREE(&free_hash_locks);
+    NC_HASH_LOCK_FREE(&free_idx_locks);
 
     if (MVFS_SIZE_PRESENT(szp, DNCDIRMAX))
 	szp->size[MVFS_SETCACHE_DNCDIRMAX] = mcdp->mvfs_dncdirmax;
@@ -753,6 +1109,180 @@ mvfs_dnc_setcaches(
     return 0;
 }
 
+/*
+ * Pick the hash chain for a key.  Keys whose bucket in the old table
+ * hasn't been moved yet stay there.  Call with the cache rwlock held or
+ * inside a mvfs_dnc_hashseq read section (see NC_HASH_LOCK_KEY).
+ */
+STATIC int
+mvfs_dnc_chain(
+    u_int key,
+    mvfs_dnlc_data_t *ncdp
+)
+{
+    int bucket;
+
+    if (ncdp->mfs_dncohash != NULL) {
+        bucket = (int)(key % (u_int)ncdp->mvfs_dncohashsize);
+        if (bucket >= ncdp->mvfs_dnc_rehash_next)
+            return(bucket | (ncdp->mvfs_dnchashalt ^ MVFS_DNCHASH_ALT));
+    }
+    return((int)(key % (u_int)ncdp->mvfs_dnchashsize) | ncdp->mvfs_dnchashalt);
+}
+
+/*
+ * Start moving the cache to a hash table of (about) the given size.
+ * Entries are moved a few buckets at a time by the lookups and adds that
+ * follow (see mvfs_dnc_rehash_step()), so no single one of them pays for
+ * rehashing the whole cache.  A resize still draining is finished first.
+ */
+STATIC int
+mvfs_dnc_hash_resize(int size)
+{
+    mvfs_dnlc_data_t *ncdp = MDKI_DNLC_GET_DATAP();
+    mfs_dnchash_slot_t *newhash, *ofree;
+    int i, ofreesize, osize;
+    SPL_T srw;
+
+    if (size < MFS_DNCHASHMIN) size = MFS_DNCHASHMIN;
+    if (size > MVFS_DNCHASHSETMAX) size = MVFS_DNCHASHSETMAX;
+    size = mvfs_dnc_primesize(size);
+    if (size == ncdp->mvfs_dnchashsize)
+        return(0);
+
+    /* Admin ioctl with no locks held, so it can wait for memory */
+    newhash = (mfs_dnchash_slot_t *)
+            KMEM_ALLOC(size*sizeof(mfs_dnchash_slot_t), KM_SLEEP);
+    if (newhash == NULL)
+        return(ENOMEM);
+    for (i = 0; i < size; i++) {
+        newhash[i].next = newhash[i].prev = (mfs_dncent_t *)&(newhash[i]);
+    }
+
+    MVFS_RW_WRITE_LOCK(&(ncdp->mvfs_dnc_rwlock), srw);
+    if (ncdp->mfs_dnchash == NULL) {
+        /* Cache torn down under us */
+        MVFS_RW_WRITE_UNLOCK(&(ncdp->mvfs_dnc_rwlock), srw);
+        KMEM_FREE(newhash, size*sizeof(mfs_dnchash_slot_t));
+        return(0);
+    }
+    ofree = ncdp->mfs_dncohash;
+    ofreesize = ncdp->mvfs_dncohashsize;
+    while (ncdp->mfs_dncohash != NULL) {
+        mvfs_dnc_rehash_bucket(ncdp);
+    }
+    osize = ncdp->mvfs_dnchashsize;
+    MDKI_SEQ_WRITE_BEGIN(&(ncdp->mvfs_dnc_hashseq));
+    ncdp->mfs_dncohash = ncdp->mfs_dnchash;
+    ncdp->mvfs_dncohashsize = ncdp->mvfs_dnchashsize;
+    ncdp->mvfs_dnc_rehash_next = 0;
+    ncdp->mfs_dnchash = newhash;
+    ncdp->mvfs_dnchashsize = size;
+    ncdp->mvfs_dnchashalt ^= MVFS_DNCHASH_ALT;
+    MDKI_SEQ_WRITE_END(&(ncdp->mvfs_dnc_hashseq));
+    MVFS_RW_WRITE_UNLOCK(&(ncdp->mvfs_dnc_rwlock), srw);
+
+    if (ofree != NULL)
+        KMEM_FREE(ofree, ofreesize*sizeof(mfs_dnchash_slot_t));
+    mvfs_log(MFS_LOG_DEBUG, "dnc hash resize %d -> %d buckets\n",
+             osize, size);
+    return(0);
+}
+
+/*
+ * Move the next bucket of the old hash table to the new one, and drop the
+ * old table once it is empty (it is left for the caller to free, see
+ * mvfs_dnc_rehash_step()).  Call with the cache write-locked, so only
+ * lookups (which hold no more than one chain lock, and pick their chain
+ * under mvfs_dnc_hashseq) can be looking at the chains.
+ */
+STATIC void
+mvfs_dnc_rehash_bucket(mvfs_dnlc_data_t *ncdp)
+{
+    mfs_dncent_t *ohp, *nhp, *dnp;
+    int ochain, nchain;
+    SPLOCK_T *ospl, *nspl;
+    SPL_T so, sn;
+
+    ochain = ncdp->mvfs_dnc_rehash_next |
+             (ncdp->mvfs_dnchashalt ^ MVFS_DNCHASH_ALT);
+    NC_HASH_LOCK(ochain, &ospl, so, ncdp);
+    ohp = NC_HASH_HEAD(ochain, ncdp);
+
+    /* Take from the tail and put at the head, to keep the chain order */
+    while ((dnp = ohp->prev) != ohp) {
+        dnp->prev->next = dnp->next;
+        dnp->next->prev = dnp->prev;
+        dnp->next = dnp->prev = NULL;
+
+        nchain = (int)(dnp->dnc_key % (u_int)ncdp->mvfs_dnchashsize) |
+                 ncdp->mvfs_dnchashalt;
+        SPLOCK_SELECT(&(ncdp->mvfs_dnc_hash_lock), nchain,
+                      HASH_SPLOCK_PER_GROUP, &nspl);
+        if (nspl != ospl) SPLOCK(*nspl, sn);
+        nhp = NC_HASH_HEAD(nchain, ncdp);
+        NC_INSHASH_LOCKED(nhp, dnp);
+        dnp->dnc_hash = nchain;
+        if (nspl != ospl) SPUNLOCK(*nspl, sn);
+    }
+
+    /* Lookups that picked this chain before we locked it will retry. */
+    MDKI_SEQ_WRITE_BEGIN(&(ncdp->mvfs_dnc_hashseq));
+    if (++(ncdp->mvfs_dnc_rehash_next) >= ncdp->mvfs_dncohashsize) {
+        ncdp->mfs_dncohash = NULL;
+    }
+    MDKI_SEQ_WRITE_END(&(ncdp->mvfs_dnc_hashseq));
+    NC_HASH_UNLOCK(ospl, so, ncdp);
+}
+
+/*
+ * Move a batch of old hash buckets while a resize is in progress.
+ * Lookups don't wait for the write lock (if they can't get it someone
+ * else is busy in the cache, and a later call will do the work); adds
+ * do, so the old table is drained while the cache is in use.
+ */
+STATIC void
+mvfs_dnc_rehash_step(tbs_boolean_t wait)
+{
+    mvfs_dnlc_data_t *ncdp = MDKI_DNLC_GET_DATAP();
+    mfs_dnchash_slot_t *ofree = NULL;
+    int i, ofreesize = 0;
+    SPL_T srw;
+
+    if (wait) {
+        MVFS_RW_WRITE_LOCK(&(ncdp->mvfs_dnc_rwlock), srw);
+    } else if (!MVFS_RW_TRY_WRITE_LOCK(&(ncdp->mvfs_dnc_rwlock), srw)) {
+        return;
+    }
+    if (ncdp->mfs_dncohash != NULL) {
+        ofree = ncdp->mfs_dncohash;
+        ofreesize = ncdp->mvfs_dncohashsize;
+        for (i = 0; i < MVFS_DNC_REHASH_BATCH && ncdp->mfs_dncohash != NULL;
+             i++)
+        {
+            mvfs_dnc_rehash_bucket(ncdp);
+        }
+        if (ncdp->mfs_dncohash != NULL) {
+            ofree = NULL;               /* not done yet */
+        } else {
+            ncdp->mvfs_dncohashsize = 0;
+            ncdp->mvfs_dnc_rehash_next = 0;
+        }
+    }
+    MVFS_RW_WRITE_UNLOCK(&(ncdp->mvfs_dnc_rwlock), srw);
+
+    /*
+     * A lookup can still have a pointer into the old table only if it
+     * holds the lock of a chain we haven't moved, and we have moved them
+     * all, so it is safe to free.
+     */
+    if (ofree != NULL) {
+        KMEM_FREE(ofree, ofreesize*sizeof(mfs_dnchash_slot_t));
+        mvfs_log(MFS_LOG_DEBUG, "dnc hash resize done, %d buckets\n",
+                 ncdp->mvfs_dnchashsize);
+    }
+}
+
 int
 mvfs_dnc_getcaches(
     mvfs_cache_sizes_t *szp
@@ -805,6 +1335,7 @@ mvfs_dncfree()
         MVFS mount was unmounted. */
         KMEM_FREE(ncdp->mfs_dnc, (ncdp->mfs_dncmax)*sizeof(struct mfs_dncent));
         NC_HASH_LOCK_FREE(&(ncdp->mvfs_dnc_hash_lock)); 
+        NC_HASH_LOCK_FREE(&(ncdp->mvfs_dnc_idx_lock)); 
         FREESPLOCK(ncdp->mvfs_dnc_dirlru_lock);
         FREESPLOCK(ncdp->mvfs_dnc_reglru_lock);
         FREESPLOCK(ncdp->mvfs_dnc_noentlru_lock);
@@ -816,6 +1347,20 @@ mvfs_dncfree()
         KMEM_FREE(ncdp->mfs_dnchash, (ncdp->mvfs_dnchashsize)*sizeof(mfs_dnchash_slot_t));
         ncdp->mfs_dnchash = NULL;
     }
+    if (ncdp->mfs_dncohash != NULL) {
+        KMEM_FREE(ncdp->mfs_dncohash,
+                  (ncdp->mvfs_dncohashsize)*sizeof(mfs_dnchash_slot_t));
+        ncdp->mfs_dncohash = NULL;
+    }
+    if (ncdp->mfs_dncfidx != NULL) {
+        KMEM_FREE(ncdp->mfs_dncfidx, (ncdp->mvfs_dncfidxsize)*sizeof(mfs_dncfidx_slot_t));
+        ncdp->mfs_dncfidx = NULL;
+    }
+    if (ncdp->mfs_dncvwidx != NULL) {
+        KMEM_FREE(ncdp->mfs_dncvwidx,
+                  MVFS_DNCVWIDX_SLOTS(ncdp)*sizeof(mfs_dncent_t *));
+        ncdp->mfs_dncvwidx = NULL;
+    }
     mcdp->mvfs_dncdirmax = mcdp->mvfs_init_sizes.size[MVFS_SETCACHE_DNCDIRMAX];
     mcdp->mvfs_dncregmax = mcdp->mvfs_init_sizes.size[MVFS_SETCACHE_DNCREGMAX];
     mcdp->mvfs_dncnoentmax = mcdp->mvfs_init_sizes.size[MVFS_SETCACHE_DNCNOENTMAX];
@@ -864,28 +1409,7 @@ mfs_dnc_getent(
 
     ncp->eocache = 0;		/* Not EOF */
 
-    ncp->flags   = 0;
-    if (dncentp->nullbh) ncp->flags |= MVFS_IONC_NULLBH;
-    if (MFS_FIDNULL(dncentp->vfid)) ncp->flags |= MVFS_IONC_ENOENT;
-    
-    /* 
-     * Parse out the new DNC flags 05/06/95
-     * This is a pain that we can't just pass the flags out
-     * to user-space, but for compatibility, I didn't want
-     * to change the user-space structure, so I just added
-     * the new flags as new flags in the existing ioctl.
-     * As a result, I have to parse out each flag to its corresponding
-     * ioctl flag individually.
-     */
-    if (dncentp->invalid) ncp->flags |= MVFS_IONC_INVALID;
-    if (MVFS_FLAGON(dncentp->flags, MFS_DNC_BHINVARIANT))
-            ncp->flags |= MVFS_IONC_BHINVARIANT;
-    if (MVFS_FLAGON(dncentp->flags, MFS_DNC_NOTINDIR))
-            ncp->flags |= MVFS_IONC_NOTINDIR;
-    if (MVFS_FLAGON(dncentp->flags, MFS_DNC_CASE_INSENSITIVE))
-            ncp->flags |= MVFS_IONC_CASE_INSENSITIVE;
-    if (MVFS_FLAGON(dncentp->flags, MVFS_DNC_RVC_ENT))
-            ncp->flags |= MVFS_IONC_RVC;
+    ncp->flags   = mvfs_dnc_ioncflags(dncentp);
 
     /* Copy out the time added to the cache */
                     
@@ -937,32 +1461,372 @@ mfs_dnc_getent(
     return(error);
 }
 
+/*
+ * Translate an entry's state to the MVFS_IONC_* flags of the name cache
+ * read ioctls.
+ */
+STATIC u_short
+mvfs_dnc_ioncflags(struct mfs_dncent *dnp)
+{
+    u_short flags = 0;
+
+    if (dnp->nullbh) flags |= MVFS_IONC_NULLBH;
+    if (MFS_FIDNULL(dnp->vfid)) flags |= MVFS_IONC_ENOENT;
+
+    /* 
+     * Parse out the new DNC flags 05/06/95
+     * This is a pain that we can't just pass the flags out
+     * to user-space, but for compatibility, I didn't want
+     * to change the user-space structure, so I just added
+     * the new flags as new flags in the existing ioctl.
+     * As a result, I have to parse out each flag to its corresponding
+     * ioctl flag individually.
+     */
+    if (dnp->invalid) flags |= MVFS_IONC_INVALID;
+    if (MVFS_FLAGON(dnp->flags, MFS_DNC_BHINVARIANT))
+            flags |= MVFS_IONC_BHINVARIANT;
+    if (MVFS_FLAGON(dnp->flags, MFS_DNC_NOTINDIR))
+            flags |= MVFS_IONC_NOTINDIR;
+    if (MVFS_FLAGON(dnp->flags, MFS_DNC_CASE_INSENSITIVE))
+            flags |= MVFS_IONC_CASE_INSENSITIVE;
+    if (MVFS_FLAGON(dnp->flags, MVFS_DNC_RVC_ENT))
+            flags |= MVFS_IONC_RVC;
+    return(flags);
+}
+
+/*
+ * Entry as staged by the first pass of mvfs_dnc_getbulk().  The name and
+ * mount point follow it, each NUL terminated.  The view vnodes are only
+ * compared against the /view table, never dereferenced: they aren't held.
+ */
+typedef struct mvfs_dncbulk_stage {
+    ks_uint64_t     cursor;     /* Cursor that resumes at this entry */
+    VNODE_T         *dvw;
+    VNODE_T         *vvw;
+    int             dvw_id;     /* /view slots the views had */
+    int             vvw_id;
+    mvfs_iodncrec_t rec;
+} mvfs_dncbulk_stage_t;
+
+#define MVFS_DNCBULK_ALIGN(n)		(((n) + 7) & ~7)
+#define MVFS_DNCBULK_CURSOR(bucket, pos) \
+        (((ks_uint64_t)(bucket) << 32) | (ks_uint32_t)(pos))
+
+/*
+ * Tag of a staged view, or NULL if it is gone.  Call with the viewroot
+ * locked.
+ */
+STATIC char *
+mvfs_dnc_bulk_viewtag(
+    VNODE_T *vwroot,
+    VNODE_T *vw,
+    int id
+)
+{
+    mfs_mnode_t *rmnp;
+
+    if (vwroot == NULL || vw == NULL || id == MFS_NULLVID)
+        return(NULL);
+    rmnp = VTOM(vwroot);
+    if (id < 0 || id >= rmnp->mn_ramdir.hwm ||
+        rmnp->mn_ramdir.ents[id].vp != vw)
+    {
+        return(NULL);
+    }
+    return(rmnp->mn_ramdir.ents[id].nm);
+}
+
+/*
+ * Chain to read for a bulk read cursor bucket, or -1 past the end.
+ * Buckets [0, mvfs_dnchashsize) are the hash table, and any after that
+ * the old one still being drained.  Call with the cache rwlock held.
+ */
+STATIC int
+mvfs_dnc_bulkchain(
+    u_int bucket,
+    mvfs_dnlc_data_t *ncdp
+)
+{
+    if (bucket < (u_int)ncdp->mvfs_dnchashsize)
+        return((int)bucket | ncdp->mvfs_dnchashalt);
+    bucket -= ncdp->mvfs_dnchashsize;
+    if (ncdp->mfs_dncohash != NULL && bucket < (u_int)ncdp->mvfs_dncohashsize)
+        return((int)bucket | (ncdp->mvfs_dnchashalt ^ MVFS_DNCHASH_ALT));
+    return(-1);
+}
+
+/*
+ * Read a batch of name cache entries for the bulk read ioctl.
+ *
+ * Pass 1 walks the hash chains from the cursor, holding the rwlock (for
+ * read) and one chain lock at a time, and stages each entry with its
+ * full name and mount point.  View tags come from the /view directory,
+ * which needs the (sleeping) viewroot lock, so pass 2 looks them all up
+ * under a single hold of that lock while building the records to hand
+ * back.  If pass 2 runs out of room it resumes from the staged cursor of
+ * the first record that didn't fit.
+ *
+ * The cursor is the hash bucket in the high 32 bits and the position on
+ * that chain in the low 32; while a hash resize is draining, the buckets
+ * of the old table follow those of the new one (see mvfs_dnc_bulkchain()).
+ * Chains change between calls, so an entry can be missed or returned
+ * twice; this is a diagnostic, not a snapshot.
+ */
+int
+mvfs_dnc_getbulk(
+    struct mvfs_iodncbulk *bp,
+    CALL_DATA_T *cd
+)
+{
+    mvfs_dnlc_data_t *ncdp = MDKI_DNLC_GET_DATAP();
+    mfs_dncent_t *hp, *dnp;
+    mvfs_dncbulk_stage_t *sp;
+    mvfs_iodncrec_t *rp;
+    VNODE_T *vwroot;
+    char *stage = NULL, *out = NULL, *cp, *mp, *dvwnm, *vvwnm;
+    size_t bufsz, sused, oused, sz;
+    size_t dvwlen, vvwlen;
+    ks_uint64_t next;
+    u_int bucket, pos, n;
+    u_int count = 0;
+    int chain;
+    tbs_boolean_t full = FALSE;
+    time_t now;
+    int error = 0;
+    SPL_T sh, srw;
+    SPLOCK_T *hash_spl;
+
+    bp->used = 0;
+    bp->count = 0;
+    bp->eocache = 1;
+
+    if (ncdp->mfs_dnc == NULL) return(0);
+
+    bufsz = bp->buflen;
+    if (bufsz > MVFS_IODNCBULK_BUFMAX)
+        bufsz = MVFS_IODNCBULK_BUFMAX;
+    if (bufsz < sizeof(mvfs_iodncrec_t) + 4)
+        return(ENOSPC);
+
+    if ((stage = KMEM_ALLOC(bufsz, KM_SLEEP)) == NULL ||
+        (out = KMEM_ALLOC(bufsz, KM_SLEEP)) == NULL)
+    {
+        error = ENOMEM;
+        goto cleanup;
+    }
+
+    /* Pass 1: stage entries, one chain at a time */
+
+    now = MDKI_CTIME();
+    sused = 0;
+    bucket = (u_int)(bp->cursor >> 32);
+    pos = (u_int)(bp->cursor & 0xffffffff);
+    next = bp->cursor;
+    for (; !full; bucket++, pos = 0) {
+        MVFS_RW_READ_LOCK(&(ncdp->mvfs_dnc_rwlock), srw);
+        if ((chain = mvfs_dnc_bulkchain(bucket, ncdp)) == -1) {
+            MVFS_RW_READ_UNLOCK(&(ncdp->mvfs_dnc_rwlock), srw);
+            break;
+        }
+        NC_HASH_LOCK(chain, &hash_spl, sh, ncdp);
+        hp = NC_HASH_HEAD(chain, ncdp);
+        for (n = 0, dnp = hp->next; dnp != hp; n++, dnp = dnp->next) {
+            if (n < pos || dnp->in_trans) continue;
+
+            mp = VFS_TO_MMI(dnp->vfsp)->mmi_mntpath;
+            sz = MVFS_DNCBULK_ALIGN(sizeof(*sp) + dnp->len + 1 +
+                                    (mp != NULL ? STRLEN(mp) : 0) + 1);
+            if (sused + sz > bufsz) {
+                next = MVFS_DNCBULK_CURSOR(bucket, n);
+                full = TRUE;
+                break;
+            }
+            sp = (mvfs_dncbulk_stage_t *)(stage + sused);
+            BZERO(sp, sizeof(*sp));
+            sp->cursor = MVFS_DNCBULK_CURSOR(bucket, n);
+            sp->dvw = dnp->dvw;
+            sp->dvw_id = (dnp->dvw != NULL) ? VTOM(dnp->dvw)->mn_view.id :
+                                              MFS_NULLVID;
+            sp->vvw = dnp->vvw;
+            sp->vvw_id = (dnp->vvw != NULL) ? VTOM(dnp->vvw)->mn_view.id :
+                                              MFS_NULLVID;
+            sp->rec.flags = mvfs_dnc_ioncflags(dnp);
+            sp->rec.hits = dnp->hits;
+            sp->rec.age = (now > (time_t)dnp->addtime) ?
+                                (ks_uint32_t)(now - dnp->addtime) : 0;
+            sp->rec.ddbid = dnp->dfid.mf_dbid;
+            sp->rec.dgen = dnp->dfid.mf_gen;
+            sp->rec.vdbid = dnp->vfid.mf_dbid;
+            sp->rec.vgen = dnp->vfid.mf_gen;
+            cp = (char *)(sp + 1);
+            sp->rec.namelen = (ks_uint16_t)dnp->len;
+            BCOPY(dnp->nm_p, cp, dnp->len);
+            cp[dnp->len] = '\0';
+            cp += dnp->len + 1;
+            if (mp != NULL) {
+                sp->rec.mplen = (ks_uint16_t)STRLEN(mp);
+                BCOPY(mp, cp, sp->rec.mplen);
+            }
+            cp[sp->rec.mplen] = '\0';
+            sp->rec.reclen = (ks_uint32_t)sz;  /* staged size, for now */
+            sused += sz;
+        }
+        NC_HASH_UNLOCK(hash_spl, sh, ncdp);
+        MVFS_RW_READ_UNLOCK(&(ncdp->mvfs_dnc_rwlock), srw);
+        if (full) break;
+    }
+
+    /* Pass 2: add the view tags and pack the records to return */
+
+    oused = 0;
+    vwroot = mfs_getviewroot();
+    if (vwroot != NULL) MLOCK(VTOM(vwroot));
+    for (sz = 0; sz < sused; sz += sp->rec.reclen) {
+        sp = (mvfs_dncbulk_stage_t *)(stage + sz);
+        dvwnm = mvfs_dnc_bulk_viewtag(vwroot, sp->dvw, sp->dvw_id);
+        vvwnm = mvfs_dnc_bulk_viewtag(vwroot, sp->vvw, sp->vvw_id);
+        dvwlen = (dvwnm != NULL) ? STRLEN(dvwnm) : 0;
+        vvwlen = (vvwnm != NULL) ? STRLEN(vvwnm) : 0;
+        n = MVFS_DNCBULK_ALIGN(sizeof(*rp) + sp->rec.namelen + 1 +
+                               dvwlen + 1 + vvwlen + 1 + sp->rec.mplen + 1);
+        if (oused + n > bufsz) {
+            next = sp->cursor;
+            full = TRUE;
+            break;
+        }
+        rp = (mvfs_iodncrec_t *)(out + oused);
+        BZERO(rp, n);
+        *rp = sp->rec;
+        rp->reclen = n;
+        rp->dvwlen = (ks_uint16_t)dvwlen;
+        rp->vvwlen = (ks_uint16_t)vvwlen;
+        cp = (char *)(rp + 1);
+        BCOPY((char *)(sp + 1), cp, rp->namelen);
+        cp += rp->namelen + 1;
+        if (dvwnm != NULL) BCOPY(dvwnm, cp, dvwlen);
+        cp += dvwlen + 1;
+        if (vvwnm != NULL) BCOPY(vvwnm, cp, vvwlen);
+        cp += vvwlen + 1;
+        BCOPY((char *)(sp + 1) + rp->namelen + 1, cp, rp->mplen);
+        oused += n;
+        count++;
+    }
+    if (vwroot != NULL) {
+        MUNLOCK(VTOM(vwroot));
+        ATRIA_VN_RELE(vwroot, cd);
+    }
+
+    if (full && count == 0) {
+        error = ENOSPC;         /* not even one record fits */
+        goto cleanup;
+    }
+    if (oused != 0 &&
+        (error = COPYOUT(out, (caddr_t)(size_t)bp->buf, oused)) != 0)
+    {
+        goto cleanup;
+    }
+    bp->used = (ks_uint32_t)oused;
+    bp->count = count;
+    bp->eocache = full ? 0 : 1;
+    bp->cursor = full ? next : MVFS_DNCBULK_CURSOR(bucket, 0);
+
+  cleanup:
+    if (stage != NULL) KMEM_FREE(stage, bufsz);
+    if (out != NULL) KMEM_FREE(out, bufsz);
+    return(error);
+}
+
 /*
  * Hash and get len of a name
+ *
+ * The name is taken a word at a time.  Where the port provides
+ * MVFS_LOAD_WORD_ZEROPAD, which may read past the end of the string (and
+ * of its allocation) without faulting or upsetting memory checkers, a
+ * word is loaded whole and used as is unless it holds the terminating
+ * null.  Otherwise, and for the word holding the null, the bytes up to
+ * the null are copied into a zeroed word, so nothing past the end of the
+ * name is ever read.  Either way the word value is the same, so the hash
+ * doesn't depend on the alignment of the name or on the port.
  */
 
-STATIC u_long MVFS_NOINLINE
+#define MVFS_WORD_ONES		((u_long)~0UL / 0xff)
+#define MVFS_WORD_HIGHS		(MVFS_WORD_ONES << 7)
+#define MVFS_WORD_HASZERO(w)	(((w) - MVFS_WORD_ONES) & ~(w) & MVFS_WORD_HIGHS)
+
+STATIC u_int MVFS_NOINLINE
 mfs_namehash(
     char *nm,
     int *lenp
 )
 {
-    int c;
+    u_long w;
     u_long hash = 0;
-    u_long len = 0;
+    int len = 0;
+    int i;
 
-    /* 
-     * To make hash ANSI case-insensitive without worrying about
-     * multibyte character sets, we just ignore the bit that
-     * discriminates upper from lower-case ANSI 7-bit characters (0x20)
-     */
-    while((c = *nm++) != '\0') {
-	len++;
-	hash = (hash >> 16 & 0xffff) + (hash << 3 & 0x7ffff) + (c & ~0x20);
+    for (;;) {
+#ifdef MVFS_LOAD_WORD_ZEROPAD
+        w = MVFS_LOAD_WORD_ZEROPAD(nm);
+        if (!MVFS_WORD_HASZERO(w)) {
+            goto full;
+        }
+#endif
+        /* Copy the bytes of this word up to the null, if there is one */
+        w = 0;
+        for (i = 0; i < sizeof(w) && nm[i] != '\0'; i++)
+            ;
+        BCOPY(nm, &w, i);
+        if (i < sizeof(w)) {
+            len += i;
+            if (i > 0) {
+                w &= ~(MVFS_WORD_ONES * 0x20);
+                hash = (hash ^ w) * (u_long) 0x9e3779b97f4a7c15ULL;
+            }
+            break;
+        }
+      full:
+        /* 
+         * To make hash ANSI case-insensitive without worrying about
+         * multibyte character sets, we just ignore the bit that
+         * discriminates upper from lower-case ANSI 7-bit characters (0x20)
+         */
+        w &= ~(MVFS_WORD_ONES * 0x20);
+        hash = (hash ^ w) * (u_long) 0x9e3779b97f4a7c15ULL;
+        hash = (hash << 27) | (hash >> (sizeof(hash) * 8 - 27));
+        nm += sizeof(w);
+        len += sizeof(w);
     }
 
     *lenp = len;
-    return (hash);
+    /* Fold to 32 bits (without shifting a 32-bit long by 32) and add len */
+    return ((u_int)hash ^ (u_int)((hash >> 16) >> 16)) + (u_int)len;
+}
+
+/*
+ * Compare two names of the given length, a word at a time.  Both names
+ * are at least len bytes long, so no load here runs past either one.
+ */
+STATIC int
+mvfs_dnc_nameeq(
+    char *nm1,
+    char *nm2,
+    int len
+)
+{
+    u_long w1, w2;
+
+    while (len >= sizeof(w1)) {
+        BCOPY(nm1, &w1, sizeof(w1));
+        BCOPY(nm2, &w2, sizeof(w2));
+        if (w1 != w2) return FALSE;
+        nm1 += sizeof(w1);
+        nm2 += sizeof(w2);
+        len -= sizeof(w1);
+    }
+    while (len-- > 0) {
+        if (*nm1++ != *nm2++) return FALSE;
+    }
+    return TRUE;
 }
 
 /*
@@ -985,6 +1849,9 @@ mfs_dncrele(
 )
 {
     ASSERT(dnp->in_trans);
+    if (!UNUSED(dnp)) {
+        MDKI_ATOMIC_DECR_UINT32(&(MDKI_DNLC_GET_DATAP()->mvfs_dnc_inuse));
+    }
     if (dnp->dvw != NULL) ATRIA_VN_RELE(dnp->dvw, cd);
     dnp->dvw  = NULL;
     if (dnp->vvw != NULL) ATRIA_VN_RELE(dnp->vvw, cd);
@@ -1009,9 +1876,9 @@ mfs_dncadd(
     CALL_DATA_T *cd
 )
 {
-    mvfs_dnlc_data_t *ncdp = MDKI_DNLC_GET_DATAP();
     int len;
-    register int hash;
+    u_int key;
+    u_int nmhash;
     mfs_fid_t vfid;
     struct timeval vevtime;
 
@@ -1046,12 +1913,12 @@ mfs_dncadd(
      * Get name hash.
      */
 
-    hash = mfs_namehash(nm, &len);
+    nmhash = mfs_namehash(nm, &len);
     if (len == 0) return;       /* Null name never cached */
 
     /* Modify name hash into DNC hash */
 
-    hash = MFS_DNCHASH(dvp, hash, len, ncdp);
+    key = MVFS_DNCKEY(dvp, nmhash);
 
     /*
      * send in the target VP's view if we have one.
@@ -1059,9 +1926,9 @@ mfs_dncadd(
      * or it complains of integral size mismatch.
      */
     mvfs_dncadd_subr(dvp, vp ? MFS_VIEW(vp) : NULL,
-		     dnc_flags, nm, len, &vfid,
+		     dnc_flags, nm, len, nmhash, &vfid,
 		     (VTYPE_T) (vp ? MVFS_GETVTYPE(vp) : VNON), &vevtime,
-		     hash, cd);
+		     key, cd);
 }
 
 STATIC void MVFS_NOINLINE
@@ -1071,10 +1938,11 @@ mvfs_dncadd_subr(
     u_int dnc_flags,
     register char *nm,
     int len,
+    u_int nmhash,
     mfs_fid_t *vfidp,
     VTYPE_T type,
     struct timeval *evtp,
-    register int hash,
+    u_int key,
     CALL_DATA_T *cd
 )
 {
@@ -1088,6 +1956,7 @@ mvfs_dncadd_subr(
     VFS_T *dvfsp;
     register mvfs_thread_t *mth = MVFS_MYTHREAD(cd);
     register int lru_hash; 
+    int hash;
     int addbhinvar = 0;
     int addnoop = 0;
     int addbh = 0;
@@ -1108,10 +1977,12 @@ mvfs_dncadd_subr(
     /* Count total adds */
     DNC_BUMPVW(dvw, dnc_add);
 
+    MVFS_DNC_REHASH(ncdp, TRUE);
+
     /* Lock structures */
 
     MVFS_RW_READ_LOCK(&(ncdp->mvfs_dnc_rwlock), srw);
-    NC_HASH_LOCK(hash, &hash_spl, sh, ncdp);
+    NC_HASH_LOCK_KEY(key, hash, &hash_spl, sh, ncdp);
 
     /* 
      * Check for entry already existing (under lock). This happens
@@ -1137,7 +2008,7 @@ mvfs_dncadd_subr(
 
     stvw = MVFS_FLAGON(dnc_flags, MVFS_DNC_RVC_ENT) ? tvw : dvw;
     if ((dnp = mfs_dncfind(&dvfid, dvfsp, stvw,
-			   nm, len, FALSE, hash, MVFS_CD2CRED(cd)))
+			   nm, len, nmhash, FALSE, hash, MVFS_CD2CRED(cd)))
 	!= NULL)
     {
 	if (MFS_FIDEQ(*vfidp, dnp->vfid) && MFS_TVEQ(*evtp, dnp->vevtime)) {
@@ -1334,8 +2205,8 @@ get_lru:
      * cache since they may no longer be valid
      * CMBU00059370: Lock the hash chain for the new hash value. 
      */
-    NC_HASH_LOCK(hash, &hash_spl ,sh, ncdp);
-    mfs_dnc_inval_case_synonyms(&dvfid, dvw, nm, len, hash);
+    NC_HASH_LOCK_KEY(key, hash, &hash_spl, sh, ncdp);
+    mfs_dnc_inval_case_synonyms(&dvfid, dvw, nm, len, nmhash, hash);
 
     NC_HASH_UNLOCK(hash_spl, sh, ncdp);
     MVFS_RW_READ_UNLOCK(&(ncdp->mvfs_dnc_rwlock), srw);
@@ -1344,14 +2215,19 @@ get_lru:
     /* Fill in the entry with the new stuff */
 
     dnp->addtime = MDKI_CTIME();    /* Time added or changed */
+    dnp->hits = 0;
     dnp->invalid = 0;               /* Clear bits */
+    dnp->numa_node = MVFS_NUMA_SLOT(MVFS_NUMA_NODE_ID());
     dnp->flags = (u_short)dnc_flags;         /* Set flag bits passed in */
     dnp->dvw = dvw;
     if (dnp->dvw) VN_HOLD(dnp->dvw);
+    if (!UNUSED(dnp)) {
+        MDKI_ATOMIC_INCR_UINT32(&(ncdp->mvfs_dnc_inuse));
+    }
     dnp->vfsp = dvp->v_vfsp;
     dnp->dfid = VTOM(dvp)->mn_hdr.fid;
     dnp->dncgen = VTOM(dvp)->mn_hdr.dncgen;
-    dnp->dnc_hash = hash;  /* save for spinlock pool index */
+    dnp->dnc_key = key;
     mfs_dncbhset(dnp, &mth->thr_bh);
     /* Also valid for null bh if bh_invariant flag passed in. */
     if (MVFS_FLAGON(dnc_flags, MFS_DNC_BHINVARIANT)) dnp->nullbh = 1;
@@ -1364,6 +2240,7 @@ get_lru:
 	dnp->vvw = NULL;
     }
     dnp->len = len;
+    dnp->nmhash = nmhash;
     if (len < MFS_DNMAXSHORTNAME) {
         BCOPY(nm, dnp->nm_inline, len);
         dnp->nm_inline[len] = '\0';
@@ -1393,7 +2270,7 @@ get_lru:
      */
 
     MVFS_RW_READ_LOCK(&(ncdp->mvfs_dnc_rwlock), srw);
-    NC_HASH_LOCK(hash, &hash_spl, sh, ncdp);
+    NC_HASH_LOCK_KEY(key, hash, &hash_spl, sh, ncdp);
     NC_SPLOCK_LRU(dnp,sl);
     CLR_IN_TRANS(dnp,ncdp) {
         NC_SPUNLOCK_LRU(dnp,sl);
@@ -1403,7 +2280,9 @@ get_lru:
 	return;
     }
     NC_INSLRU_LOCKED(dnp->lruhead->lruprev, dnp);
-    NC_INSHASH_LOCKED(&(ncdp->mfs_dnchash[hash]), dnp);
+    dnp->dnc_hash = hash;  /* save for spinlock pool index */
+    NC_INSHASH_LOCKED(NC_HASH_HEAD(hash, ncdp), dnp);
+    mvfs_dncidx_insert(dnp);
     if ((type == VNON) && MVFS_FLAGOFF(dnp->flags, MFS_DNC_NOTINDIR)) {
         ASSERT(dnp->lruhead == (mfs_dncent_t *)&(ncdp->mfs_dncnoentlru));
         ncdp->mvfs_dnc_noent_other++;      
@@ -1457,7 +2336,9 @@ mfs_dnc_add_flag(
     VNODE_T *vw;
     VFS_T *dvfsp;
     int len;
-    register int hash;
+    int hash;
+    u_int key;
+    u_int nmhash;
     mfs_mnode_t *mnp;
     SPLOCK_T *hash_spl;
     SPL_T sh, srw;
@@ -1500,12 +2381,12 @@ mfs_dnc_add_flag(
      * Get name hash.
      */
 
-    hash = mfs_namehash(nm, &len);
+    nmhash = mfs_namehash(nm, &len);
     if (len == 0) goto done;        /* Null name never cached */
 
     /* Modify name hash into DNC hash */
 
-    hash = MFS_DNCHASH(dvp, hash, len, ncdp);
+    key = MVFS_DNCKEY(dvp, nmhash);
 
     /* Copy fields from potentially unwired structures */
 
@@ -1516,7 +2397,7 @@ mfs_dnc_add_flag(
     /* Lock structures */
 
     MVFS_RW_READ_LOCK(&(ncdp->mvfs_dnc_rwlock), srw);
-    NC_HASH_LOCK(hash, &hash_spl, sh, ncdp);
+    NC_HASH_LOCK_KEY(key, hash, &hash_spl, sh, ncdp);
 
     /* 
      * Look for the existing entry.  If not found, then this
@@ -1526,7 +2407,7 @@ mfs_dnc_add_flag(
      * and so we only do a case-sensitive lookup with dncfind.
      */
 
-    if ((dnp = mfs_dncfind(&dvfid, dvfsp, vw, nm, len, FALSE, hash,
+    if ((dnp = mfs_dncfind(&dvfid, dvfsp, vw, nm, len, nmhash, FALSE, hash,
 			   cred)) != NULL) {
         dnp->flags |= dnc_flags;
 
@@ -1567,6 +2448,7 @@ mfs_dnclookup(
     int error, error2;
     int len;
     int hash;
+    u_int nmhash, key;
     SPL_T sh, srw;
     SPLOCK_T *hash_spl;
 
@@ -1596,16 +2478,17 @@ mfs_dnclookup(
      * checks.
      */
      
-    hash = mfs_namehash(nm, &len);
-    hash = MFS_DNCHASH(dvp, hash, len, ncdp);
+    nmhash = mfs_namehash(nm, &len);
+    key = MVFS_DNCKEY(dvp, nmhash);
 
     /* Copy fields from potentially unwired structures */
 
     dvfid = VTOM(dvp)->mn_hdr.fid;
     dvfsp = dvp->v_vfsp;
 
-    NC_HASH_LOCK(hash, &hash_spl, sh, ncdp);
-    if ((dnp = mfs_dncfind(&dvfid, dvfsp, vw, nm, len, 
+    MVFS_DNC_REHASH(ncdp, FALSE);
+    NC_HASH_LOCK_KEY(key, hash, &hash_spl, sh, ncdp);
+    if ((dnp = mfs_dncfind(&dvfid, dvfsp, vw, nm, len, nmhash,
             MVFS_PN_CI_LOOKUP(pnp), hash, MVFS_CD2CRED(cd))) == NULL) {
 	/* Ordinary miss */
         NC_HASH_UNLOCK(hash_spl, sh, ncdp);
@@ -1613,6 +2496,7 @@ mfs_dnclookup(
 	return (NULL);
     }
 
+    dnp->hits++;
     error = mvfs_dnclookup_subr(dnp, vw, &vvw, cd);
     /* 
      * Must make a copy of dir cache info before releasing the lock
@@ -1878,12 +2762,15 @@ mvfs_rvclookup(
     mvfs_common_data_t *mcdp = MDKI_COMMON_GET_DATAP();
     int error;
     int hash;
+    u_int key;
     struct mfs_dncent *dnp;
     struct timeval vevtime;
     mfs_fid_t vobrtfid;
     VFS_T *dvfsp;
     SPLOCK_T *hash_spl;
     SPL_T sh;
+    u_int dothash;
+    int dotlen;
 
     MVFS_INIT_TIMEVAL(vevtime);  /* The compiler wants these initialized. */
 
@@ -1905,10 +2792,9 @@ mvfs_rvclookup(
     }
 
     /*
-     * hash on view uuid & vob uuid.  cast to int _after_ taking modulus on
-     * unsigned value, to avoid signed-ness problems.
+     * hash on view uuid & vob uuid.
      */
-    hash = (int) MVFS_RVCHASH(vw, vobrtvp->v_vfsp, ncdp);
+    key = MVFS_RVCKEY(vw, vobrtvp->v_vfsp);
 
     /* Copy possibly unwired fid */
 
@@ -1916,11 +2802,12 @@ mvfs_rvclookup(
     dvfsp = vobrtvp->v_vfsp;
 
     MDB_XLOG((MDB_RVC_DNC, "seeking vr %"KS_FMT_PTR_T" vw %"KS_FMT_PTR_T" on hash %x dfid %lx.%x\n",
-			   V_TO_MMI(vobrtvp)->mmi_rootvp, vw, hash,
+			   V_TO_MMI(vobrtvp)->mmi_rootvp, vw, key,
 			   vobrtfid.mf_dbid, vobrtfid.mf_gen));
 
-    NC_HASH_LOCK(hash, &hash_spl, sh, ncdp);
-    if ((dnp = mfs_dncfind(&vobrtfid, dvfsp, vw, ".", 1, FALSE,
+    dothash = mfs_namehash(".", &dotlen);
+    NC_HASH_LOCK_KEY(key, hash, &hash_spl, sh, ncdp);
+    if ((dnp = mfs_dncfind(&vobrtfid, dvfsp, vw, ".", 1, dothash, FALSE,
 			   hash, MVFS_CD2CRED(cd))) == NULL) {
 	/* Ordinary miss */
         NC_HASH_UNLOCK(hash_spl, sh, ncdp);
@@ -1957,30 +2844,31 @@ mvfs_rvcenter(
     CALL_DATA_T *cd
 )
 {
-    mvfs_dnlc_data_t *ncdp = MDKI_DNLC_GET_DATAP();
-    int hash;
+    u_int key;
     struct timeval vevtime;
     register mfs_mnode_t *mnp;
+    u_int dothash;
+    int dotlen;
 
     ASSERT(MFS_VIEW(vobrtvp));
 
     /*
-     * hash on view uuid & vob uuid.  cast to int _after_ taking modulus on
-     * unsigned value, to avoid signed-ness problems.
+     * hash on view uuid & vob uuid.
      */
-    hash = (int) MVFS_RVCHASH(vw, vobrtvp->v_vfsp, ncdp);
+    key = MVFS_RVCKEY(vw, vobrtvp->v_vfsp);
 
     MDB_XLOG((MDB_RVC_DNC,
 	     "entering vr %"KS_FMT_PTR_T" vw %"KS_FMT_PTR_T" on hash %x fid %lx.%x dfid %lx.%x\n",
-	      V_TO_MMI(vobrtvp)->mmi_rootvp, vw, hash,
+	      V_TO_MMI(vobrtvp)->mmi_rootvp, vw, key,
 	      fidp->mf_dbid, fidp->mf_gen,
 	      VTOM(V_TO_MMI(vobrtvp)->mmi_rootvp)->mn_hdr.fid.mf_dbid,
 	      VTOM(V_TO_MMI(vobrtvp)->mmi_rootvp)->mn_hdr.fid.mf_gen));
     vevtime.tv_sec = MDKI_CTIME();
     vevtime.tv_usec = 0;
+    dothash = mfs_namehash(".", &dotlen);
 
     mvfs_dncadd_subr(V_TO_MMI(vobrtvp)->mmi_rootvp, vw, MVFS_DNC_RVC_ENT,
-		     ".", 1, fidp, VDIR, &vevtime, hash, cd);
+		     ".", 1, dothash, fidp, VDIR, &vevtime, key, cd);
     return 0;
 }
 
@@ -1993,36 +2881,40 @@ mvfs_rvcflush(
     /* cribbed from mfs_dnc_invalvw() */
 
     mvfs_dnlc_data_t *ncdp = MDKI_DNLC_GET_DATAP();
-    mvfs_common_data_t *mcdp = MDKI_COMMON_GET_DATAP();
     register int i, j;
     mfs_dncent_t *dnp;
-    SPL_T srw;
+    int slots[2];
+    SPLOCK_T *idx_spl;
+    SPL_T si, srw;
 
     ASSERT(vw != NULL);
     ASSERT(MFS_ISVIEW(VTOM(vw)));
 
     if (ncdp->mfs_dnc == NULL) return;	/* No name cache */
 
+    /* RVC entries have no dir view, so they are indexed under vw. */
+    slots[0] = MVFS_DNCVWIDX(vw, ncdp);
+    slots[1] = MVFS_DNCVWIDX_XVIEW(ncdp);
+
     MVFS_RW_WRITE_LOCK(&(ncdp->mvfs_dnc_rwlock), srw);
 
-    for (i=0, j=0; i < mcdp->mvfs_dncdirmax; i++) { /* only search directory portion */
-	dnp = &(ncdp->mfs_dnc[i]);
-	if (dnp->in_trans) continue;	/* Skip in-transition cases */
-	if (UNUSED(dnp)) {		/* Skip unused entries */
-	    ASSERT(dnp->cred == NULL);
-	    continue;
-	}
+    for (i=0, j=0; i < 2; i++) {
+        NC_IDX_LOCK(slots[i], &idx_spl, si, ncdp);
+        for (dnp = ncdp->mfs_dncvwidx[slots[i]]; dnp != NULL; dnp = dnp->vwnext) {
+	    if (dnp->in_trans) continue;	/* Skip in-transition cases */
 
-        /* Invalidate entry if result in the specified view, for the
-           specified VOB (if any) and it's an RVC */
+            /* Invalidate entry if result in the specified view, for the
+               specified VOB (if any) and it's an RVC */
 
-        if (dnp->vvw == vw && MVFS_FLAGON(dnp->flags, MVFS_DNC_RVC_ENT) &&
-            (vfsp == NULL || vfsp == dnp->vfsp))
-        {
-	    j++;			/* count them up */
-            dnp->invalid = 1;
-            dnp->nullbh = 0;
-	}
+            if (dnp->vvw == vw && MVFS_FLAGON(dnp->flags, MVFS_DNC_RVC_ENT) &&
+                (vfsp == NULL || vfsp == dnp->vfsp))
+            {
+	        j++;			/* count them up */
+                dnp->invalid = 1;
+                dnp->nullbh = 0;
+	    }
+        }
+        NC_IDX_UNLOCK(idx_spl, si);
     }
     MVFS_RW_WRITE_UNLOCK(&(ncdp->mvfs_dnc_rwlock), srw);
     BUMPSTAT_VAL(mfs_rvcstat.rvc_purge, j);
@@ -2094,7 +2986,8 @@ mfs_dncremove_one(
     mfs_fid_t dvfid, namefid, vobrtfid;
     VNODE_T *vw;
     VFS_T *dvfsp;
-    int len;
+    int len, dotlen;
+    u_int nmhash, dothash, key, rvckey;
     int hash, rvchash, rval = 0;
     tbs_boolean_t inval_rvc = 0;
     SPLOCK_T *hash_spl;
@@ -2112,17 +3005,18 @@ mfs_dncremove_one(
 
     /* Check for max name len */
 
-    hash = mfs_namehash(nm, &len);
+    nmhash = mfs_namehash(nm, &len);
     if (len == 0) return 0;
 
-    hash = MFS_DNCHASH(dvp, hash, len, ncdp);
+    key = MVFS_DNCKEY(dvp, nmhash);
+    dothash = mfs_namehash(".", &dotlen);
 
     /* Copy fields from potentially unwired structures */
 
     dvfid = VTOM(dvp)->mn_hdr.fid;
     vw = MFS_VIEW(dvp);
 
-    rvchash = MVFS_RVCHASH(vw, dvfsp, ncdp);
+    rvckey = MVFS_RVCKEY(vw, dvfsp);
     vobrtfid = VTOM(VFS_TO_MMI(dvfsp)->mmi_rootvp)->mn_hdr.fid;
 
     /* 
@@ -2136,8 +3030,8 @@ mfs_dncremove_one(
      * Use lock to make sure name, RVC analog, and any synonyms are 
      * all removed before a lookup can find them
      */
-    NC_HASH_LOCK(hash, &hash_spl, sh, ncdp);
-    if ((dnp = mfs_dncfind(&dvfid, dvfsp, vw, nm, len, FALSE, hash,
+    NC_HASH_LOCK_KEY(key, hash, &hash_spl, sh, ncdp);
+    if ((dnp = mfs_dncfind(&dvfid, dvfsp, vw, nm, len, nmhash, FALSE, hash,
 			   NULL)) != NULL) {
 	NC_RMHASH_LOCKED(dnp);
         NC_SPLOCK_LRU(dnp,sl);
@@ -2161,20 +3055,20 @@ mfs_dncremove_one(
          * we just unlinked from the chain, so if it finds anything,
          * something is seriously wrong.
          */
-        ASSERT(mfs_dncfind(&dvfid, dvfsp, vw, nm, len, FALSE, hash,
+        ASSERT(mfs_dncfind(&dvfid, dvfsp, vw, nm, len, nmhash, FALSE, hash,
 			   NULL) == NULL);    
 
         /* Now, invalidate any case-insensitive synonyms for this name */
-        mfs_dnc_inval_case_synonyms(&dvfid, vw, nm, len, hash);
+        mfs_dnc_inval_case_synonyms(&dvfid, vw, nm, len, nmhash, hash);
        
         NC_HASH_UNLOCK(hash_spl, sh, ncdp);
         namefid = dnp->vfid;
 
         /* now remove an RVC entry, if the name resolved to a directory and
            it was an alias for the target of the RVC */
-        NC_HASH_LOCK(rvchash, &hash_spl, sh, ncdp);
+        NC_HASH_LOCK_KEY(rvckey, rvchash, &hash_spl, sh, ncdp);
         if (dnp->lruhead == (mfs_dncent_t *)&(ncdp->mfs_dncdirlru) &&
-            (rvnp = mfs_dncfind(&vobrtfid, dvfsp, vw, ".", 1, FALSE,
+            (rvnp = mfs_dncfind(&vobrtfid, dvfsp, vw, ".", 1, dothash, FALSE,
                                rvchash, MVFS_CD2CRED(cd))) != NULL)
         {
             /* invalidate VOB root entry, if the same fid */
@@ -2209,7 +3103,7 @@ mfs_dncremove_one(
         rval = 1;
     } else {
         /* Not found, but still invalidate any synonyms for CI lookup */
-        mfs_dnc_inval_case_synonyms(&dvfid, vw, nm, len, hash);
+        mfs_dnc_inval_case_synonyms(&dvfid, vw, nm, len, nmhash, hash);
         NC_HASH_UNLOCK(hash_spl, sh, ncdp);
     }
 
@@ -2332,6 +3226,96 @@ mfs_dncflush(CALL_DATA_T *cd)
     mvfs_dncflush_subr(NULL, cd);
 }
 
+/*
+ * Shrink the cache on behalf of the kernel memory allocator.
+ *
+ * Every entry holding vnodes or creds is fair game, so the count is the
+ * number of entries in use (kept up to date by mfs_dncadd_subr() and
+ * mfs_dncrele()), not the size of the array.  Scanning
+ * sweeps a clock hand over the array starting where the last call left
+ * off, so repeated calls spread the damage instead of always hitting the
+ * first entries.  Each entry passed over is released the same way
+ * mvfs_dncflush_subr() does it, which drops its holds on the directory,
+ * target and view vnodes and lets those mnodes go to the freelist.
+ */
+int
+mvfs_dnc_shrink_count(void)
+{
+    mvfs_dnlc_data_t *ncdp = MDKI_DNLC_GET_DATAP();
+
+    if (ncdp->mfs_dnc == NULL) return 0;	/* No name cache */
+    return (int)MDKI_ATOMIC_READ_UINT32(&(ncdp->mvfs_dnc_inuse));
+}
+
+int
+mvfs_dnc_shrink(
+    int nr_to_scan,
+    CALL_DATA_T *cd
+)
+{
+    register mvfs_dnlc_data_t *ncdp = MDKI_DNLC_GET_DATAP();
+    register struct mfs_dncent *dnp;
+    int i;
+    int released = 0;
+    SPL_T sh, sl, srw;
+    SPLOCK_T *hash_spl;
+
+    if (ncdp->mfs_dnc == NULL) return 0;	/* No name cache */
+
+    MVFS_RW_READ_LOCK(&(ncdp->mvfs_dnc_rwlock), srw);
+    if (nr_to_scan > ncdp->mfs_dncmax)
+        nr_to_scan = ncdp->mfs_dncmax;
+    i = ncdp->mvfs_dnc_shrink_cursor;
+    while (nr_to_scan-- > 0) {
+        /* The cache may have been resized since the cursor was saved. */
+        if (i >= ncdp->mfs_dncmax)
+            i = 0;
+        dnp = &(ncdp->mfs_dnc[i++]);
+        if (dnp->in_trans || UNUSED(dnp))
+            continue;
+
+        NC_HASH_LOCK(dnp->dnc_hash, &hash_spl, sh, ncdp);
+        NC_SPLOCK_LRU(dnp,sl);
+        if (dnp->in_trans || UNUSED(dnp)) {
+            /* lost a race with another release */
+            NC_SPUNLOCK_LRU(dnp,sl);
+            NC_HASH_UNLOCK(hash_spl, sh, ncdp);
+            continue;
+        }
+        if (dnp->next) {
+            NC_RMHASH_LOCKED(dnp);
+            if (MFS_FIDNULL(dnp->vfid) && MVFS_FLAGOFF(dnp->flags, MFS_DNC_NOTINDIR)) {
+                ASSERT(dnp->lruhead == (mfs_dncent_t *)&(ncdp->mfs_dncnoentlru));
+                ncdp->mvfs_dnc_noent_other--;
+            }
+        }
+        NC_RMLRU_LOCKED(dnp);
+        SET_IN_TRANS(dnp);
+        NC_SPUNLOCK_LRU(dnp,sl);
+        NC_HASH_UNLOCK(hash_spl, sh, ncdp);
+
+        MVFS_RW_READ_UNLOCK(&(ncdp->mvfs_dnc_rwlock), srw);
+        mfs_dncrele(dnp, cd);
+        released++;
+        MVFS_RW_READ_LOCK(&(ncdp->mvfs_dnc_rwlock), srw);
+        NC_SPLOCK_LRU(dnp,sl);
+        CLR_IN_TRANS(dnp,ncdp) {
+            /* The cache was reallocated while we had the lock dropped. */
+            NC_SPUNLOCK_LRU(dnp,sl);
+            ncdp->mvfs_dnc_shrink_cursor = 0;
+            MVFS_RW_READ_UNLOCK(&(ncdp->mvfs_dnc_rwlock), srw);
+            DROP_REF_IN_TRANS(ncdp);
+            return released;
+        }
+        ASSERT(dnp->lruhead);
+        NC_INSLRU_LOCKED(dnp->lruhead, dnp);
+        NC_SPUNLOCK_LRU(dnp,sl);
+    }
+    ncdp->mvfs_dnc_shrink_cursor = i;
+    MVFS_RW_READ_UNLOCK(&(ncdp->mvfs_dnc_rwlock), srw);
+    return released;
+}
+
 /*
  * Flush all entries for a specific view
  *
@@ -2350,29 +3334,48 @@ mfs_dnc_flushvw(
 {
     register mvfs_dnlc_data_t *ncdp = MDKI_DNLC_GET_DATAP();
     register struct mfs_dncent *dnp;
+    int slots[2];
     register int i;
-    SPLOCK_T *hash_spl;
-    SPL_T sh, sl, srw;
+    int passes, hash;
+    SPLOCK_T *hash_spl, *idx_spl;
+    SPL_T sh, sl, si, srw;
 
     if (ncdp->mfs_dnc == NULL) return;	/* No name cache */
 
-    MVFS_RW_READ_LOCK(&(ncdp->mvfs_dnc_rwlock), srw);
-    for (i=0; i < ncdp->mfs_dncmax; i++) {
-	dnp = &(ncdp->mfs_dnc[i]);
-	if (dnp->in_trans) continue;	/* Skip in-transition entries */
-	if (UNUSED(dnp)) {		/* Skip unused entries */
-	    ASSERT(dnp->cred == NULL);
-	    continue;
-	}
+    slots[0] = MVFS_DNCVWIDX(vw, ncdp);
+    slots[1] = MVFS_DNCVWIDX_XVIEW(ncdp);
 
-        /* Skip entries not for this view */
-
-        if (dnp->dvw != vw && dnp->vvw != vw) continue;
+    /*
+     * Take the first entry for this view off the view index, release it,
+     * and go around again until there are none left.  Someone adding
+     * entries for the view as fast as we release them could keep us here,
+     * so never make more passes than a scan of the whole cache would.
+     */
+    MVFS_RW_READ_LOCK(&(ncdp->mvfs_dnc_rwlock), srw);
+    for (passes = ncdp->mfs_dncmax; passes > 0; passes--) {
+        dnp = NULL;
+        hash = -1;
+        for (i = 0; i < 2 && dnp == NULL; i++) {
+            NC_IDX_LOCK(slots[i], &idx_spl, si, ncdp);
+            for (dnp = ncdp->mfs_dncvwidx[slots[i]];
+                 dnp != NULL;
+                 dnp = dnp->vwnext)
+            {
+                if (!dnp->in_trans && (dnp->dvw == vw || dnp->vvw == vw)) {
+                    hash = dnp->dnc_hash;
+                    break;
+                }
+            }
+            NC_IDX_UNLOCK(idx_spl, si);
+        }
+        if (dnp == NULL) break;	/* None left */
 
         /* Flush the entry */
 
-        NC_HASH_LOCK(dnp->dnc_hash, &hash_spl, sh, ncdp);
-        if (dnp->dvw != vw && dnp->vvw != vw) {
+        NC_HASH_LOCK(hash, &hash_spl, sh, ncdp);
+        if (dnp->next == NULL || dnp->dnc_hash != hash ||
+            (dnp->dvw != vw && dnp->vvw != vw))
+        {
             /* something changed while we waited for hash lock */
             NC_HASH_UNLOCK(hash_spl, sh, ncdp);
             continue;
@@ -2384,12 +3387,10 @@ mfs_dnc_flushvw(
             NC_HASH_UNLOCK(hash_spl, sh, ncdp);
             continue;
         }
-	if (dnp->next) {
-            NC_RMHASH_LOCKED(dnp);
-            if (MFS_FIDNULL(dnp->vfid) && MVFS_FLAGOFF(dnp->flags, MFS_DNC_NOTINDIR)) {
-                ASSERT(dnp->lruhead == (mfs_dncent_t *)&(ncdp->mfs_dncnoentlru));
-                ncdp->mvfs_dnc_noent_other--;
-            }
+        NC_RMHASH_LOCKED(dnp);
+        if (MFS_FIDNULL(dnp->vfid) && MVFS_FLAGOFF(dnp->flags, MFS_DNC_NOTINDIR)) {
+            ASSERT(dnp->lruhead == (mfs_dncent_t *)&(ncdp->mfs_dncnoentlru));
+            ncdp->mvfs_dnc_noent_other--;
         }
 	NC_RMLRU_LOCKED(dnp);
 	SET_IN_TRANS(dnp);
@@ -2452,11 +3453,14 @@ mfs_dnc_invalvp(
 {
 
     register mvfs_dnlc_data_t *ncdp = MDKI_DNLC_GET_DATAP();
-    register int i, j;
+    register int j;
     mfs_dncent_t *dnp;
-    SPL_T srw;
+    SPLOCK_T *idx_spl;
+    SPL_T si, srw;
     VNODE_T *vw;
+    VFS_T *vfsp;
     mfs_fid_t vfid;
+    int slot;
 
     ASSERT(vp != NULL);
 
@@ -2465,31 +3469,44 @@ mfs_dnc_invalvp(
     
     vfid = VTOM(vp)->mn_hdr.fid;
     vw = MFS_VIEW(vp);
+    vfsp = vp->v_vfsp;
     
     MVFS_RW_WRITE_LOCK(&(ncdp->mvfs_dnc_rwlock), srw);
 
-    for (i=0, j=0; i < ncdp->mfs_dncmax; i++) {
-	dnp = &(ncdp->mfs_dnc[i]);
-	if (dnp->in_trans) continue;	/* Skip in-transition cases */
-	if (UNUSED(dnp)) {		/* Skip unused entries */
-	    ASSERT(dnp->cred == NULL);
-	    continue;
-	}
-
   	/* Flush entry on any of the following conditions:
          *    Vfsp matches and either dir (view, fid) matches or
          *    result object (view, fid) matches.
+         * Both kinds are on the FID index slot for (vfsp, fid).  The index
+         * lock is still needed since mfs_dncremove_one() unhashes entries
+         * without the cache lock.
          */
-
-	if (dnp->vfsp == vp->v_vfsp &&
-	         ((dnp->dvw == vw && MFS_FIDEQ(dnp->dfid, vfid)) ||
-                  (dnp->vvw == vw && MFS_FIDEQ(dnp->vfid, vfid))))
+    slot = MVFS_DNCFIDX(vfsp, vfid, ncdp);
+    NC_IDX_LOCK(slot, &idx_spl, si, ncdp);
+    for (dnp = ncdp->mfs_dncfidx[slot].dirfirst, j=0;
+         dnp != NULL;
+         dnp = dnp->dirnext)
+    {
+	if (dnp->in_trans) continue;	/* Skip in-transition cases */
+	if (dnp->vfsp == vfsp && dnp->dvw == vw && MFS_FIDEQ(dnp->dfid, vfid)) {
+            dnp->invalid = 1;
+            dnp->nullbh = 0;
+            j++;  /* count hits, for stats */
+	}
+    }
+    for (dnp = ncdp->mfs_dncfidx[slot].objfirst;
+         dnp != NULL;
+         dnp = dnp->objnext)
+    {
+	if (dnp->in_trans) continue;	/* Skip in-transition cases */
+	if (dnp->vfsp == vfsp && dnp->vvw == vw && MFS_FIDEQ(dnp->vfid, vfid) &&
+            !(dnp->dvw == vw && MFS_FIDEQ(dnp->dfid, vfid)))  /* counted above */
         {
             dnp->invalid = 1;
             dnp->nullbh = 0;
             j++;  /* count hits, for stats */
 	}
     }
+    NC_IDX_UNLOCK(idx_spl, si);
     MVFS_RW_WRITE_UNLOCK(&(ncdp->mvfs_dnc_rwlock), srw);
     DNC_BUMPVW(vw, dnc_invalvp); 
     BUMPSTAT_VAL(mfs_dncstat.dnc_invalhits, j);
@@ -2577,30 +3594,34 @@ mfs_dnc_invalvw(
     register mvfs_dnlc_data_t *ncdp = MDKI_DNLC_GET_DATAP();
     register int i, j;
     mfs_dncent_t *dnp;
-    SPL_T srw;
+    int slots[2];
+    SPLOCK_T *idx_spl;
+    SPL_T si, srw;
 
     ASSERT(vw != NULL);
     ASSERT(MFS_ISVIEW(VTOM(vw)));
 
     if (ncdp->mfs_dnc == NULL) return;	/* No name cache */
 
+    slots[0] = MVFS_DNCVWIDX(vw, ncdp);
+    slots[1] = MVFS_DNCVWIDX_XVIEW(ncdp);
+
     MVFS_RW_WRITE_LOCK(&(ncdp->mvfs_dnc_rwlock), srw);
 
-    for (i=0, j=0; i < ncdp->mfs_dncmax; i++) {
-	dnp = &(ncdp->mfs_dnc[i]);
-	if (dnp->in_trans) continue;	/* Skip in-transition cases */
-	if (UNUSED(dnp)) {		/* Skip unused entries */
-	    ASSERT(dnp->cred == NULL);
-	    continue;
-	}
+    for (i=0, j=0; i < 2; i++) {
+        NC_IDX_LOCK(slots[i], &idx_spl, si, ncdp);
+        for (dnp = ncdp->mfs_dncvwidx[slots[i]]; dnp != NULL; dnp = dnp->vwnext) {
+	    if (dnp->in_trans) continue;	/* Skip in-transition cases */
 
-        /* Invalidate entry if dir or result in the specified view */
+            /* Invalidate entry if dir or result in the specified view */
 
-        if (dnp->dvw == vw || dnp->vvw == vw) {
-            dnp->invalid = 1;
-            dnp->nullbh = 0;
-            j++;  /* count hits, for stats */
-	}
+            if (dnp->dvw == vw || dnp->vvw == vw) {
+                dnp->invalid = 1;
+                dnp->nullbh = 0;
+                j++;  /* count hits, for stats */
+	    }
+        }
+        NC_IDX_UNLOCK(idx_spl, si);
     }
     MVFS_RW_WRITE_UNLOCK(&(ncdp->mvfs_dnc_rwlock), srw);
     DNC_BUMPVW(vw, dnc_invalvw);
@@ -2622,6 +3643,7 @@ mfs_dnc_inval_case_synonyms(
     VNODE_T *vw,
     char *nm,
     int len,
+    u_int nmhash,
     int hash
 )
 {
@@ -2633,9 +3655,9 @@ mfs_dnc_inval_case_synonyms(
 
     ASSERT(len > 0);
 
-    hp = (mfs_dncent_t *)&(ncdp->mfs_dnchash[hash]);
+    hp = NC_HASH_HEAD(hash, ncdp);
     for (dnp = hp->next,j=0; dnp != (struct mfs_dncent *) hp; dnp = dnp->next) {
-	if (dnp->dvw == vw && dnp->len == len &&
+	if (dnp->nmhash == nmhash && dnp->dvw == vw && dnp->len == len &&
             MFS_FIDEQ(dnp->dfid, *dvfidp) &&
             MVFS_FLAGON(dnp->flags, MFS_DNC_CASE_INSENSITIVE) &&
             STRCASECMP(dnp->nm_p, nm) == 0)
@@ -2667,6 +3689,7 @@ mfs_dncfind(
     VNODE_T *vw,
     char *nm,
     int len,
+    u_int nmhash,	/* From mfs_namehash(), case-insensitive */
     tbs_boolean_t case_insensitive,
     int hash,
     CRED_T *cred	/* Check credentials? */
@@ -2681,15 +3704,16 @@ mfs_dncfind(
 
     ci_flag = case_insensitive ? MFS_DNC_CASE_INSENSITIVE : 0; 
 
-    ASSERT(hash < ncdp->mvfs_dnchashsize);
-    hp = (mfs_dncent_t *)&(ncdp->mfs_dnchash[hash]);
+    hp = NC_HASH_HEAD(hash, ncdp);
     MDB_XLOG((MDB_RVC_DNC,"hashchain %"KS_FMT_PTR_T" hval %x\n", hp, hash));
     for (dnp = hp->next; dnp != (struct mfs_dncent *) hp; dnp = dnp->next) {
 	/*
 	 * RVC entries have the target view set but not the directory view
 	 * set since the bare vob root is entered in the DNC.
 	 */
-	if (dnp->len == len && MFS_FIDEQ(dnp->dfid, *dvfidp)) {
+	if (dnp->nmhash == nmhash && dnp->len == len &&
+            MFS_FIDEQ(dnp->dfid, *dvfidp))
+        {
 	    if (MVFS_FLAGON(dnp->flags, MVFS_DNC_RVC_ENT) &&
 		dnp->vfsp == dvfsp && dnp->vvw == vw) {
 		MDB_XLOG((MDB_RVC_DNC,"dnp %"KS_FMT_PTR_T" RVCmatch\n", dnp));
@@ -2734,10 +3758,8 @@ mfs_dncfind(
                      * for files that exist are always the right
                      * choice in case-insensitive name lookup.
                      */
-                    if (*dnp->nm_p == *nm &&    /* check first/last char quick */
-                                dnp->nm_p[len-1] == nm[len-1] &&
-                                !MFS_FIDNULL(dnp->vfid) &&
-                                BCMP(dnp->nm_p, nm, len) == 0) {
+                    if (!MFS_FIDNULL(dnp->vfid) &&
+                        mvfs_dnc_nameeq(dnp->nm_p, nm, len)) {
                         return(dnp);
                     }
                 }
@@ -2749,16 +3771,15 @@ mfs_dncfind(
                  * translation, so they are good for case-sensitive
                  * lookups too.
                  */
-                if (*dnp->nm_p == *nm &&	/* check first char/last char quickly */
-	             dnp->nm_p[len-1] == nm[len-1] &&
-                     BCMP(dnp->nm_p, nm, len) == 0) {
+                if (mvfs_dnc_nameeq(dnp->nm_p, nm, len)) {
 		    return(dnp);
                 }
             }
 	} else {
 	    MDB_XLOG((MDB_RVC_DNC,
-		     "dnp %"KS_FMT_PTR_T" len/fid mismatch: %x/%x %lx:%x/%lx:%x\n",
+		     "dnp %"KS_FMT_PTR_T" hash/len/fid mismatch: %x/%x %x/%x %lx:%x/%lx:%x\n",
 		      dnp,
+		      dnp->nmhash, nmhash,
 		      dnp->len, len,
 		      dnp->dfid.mf_dbid, dnp->dfid.mf_gen,
 		      dvfidp->mf_dbid,
@@ -2901,12 +3922,17 @@ mvfs_dnc_count(
     register mvfs_dnlc_data_t *ncdp = MDKI_DNLC_GET_DATAP();
     mvfs_common_data_t *mcdp = MDKI_COMMON_GET_DATAP();
     u_int dirs = 0, regs = 0, noents = 0;
+    u_int nodes[MVFS_NUMA_MAXNODES];
     register int i;
 
+    for (i = 0; i < MVFS_NUMA_MAXNODES; i++)
+	nodes[i] = 0;
+
     for (i = 0; i < ncdp->mfs_dncmax; i++) {
 	if ((ncdp->mfs_dnc[i]).in_trans || (ncdp->mfs_dnc[i]).invalid ||
 	    UNUSED(&(ncdp->mfs_dnc[i])))
 	    continue;
+	nodes[(ncdp->mfs_dnc[i]).numa_node]++;
 	if (MFS_FIDNULL((ncdp->mfs_dnc[i]).vfid))
 	    noents++;
 	else if (i < mcdp->mvfs_dncdirmax)
@@ -2922,6 +3948,9 @@ mvfs_dnc_count(
     usage->cache_usage[MVFS_CACHE_MAX][MVFS_CACHE_DNCDIR] = mcdp->mvfs_dncdirmax;
     usage->cache_usage[MVFS_CACHE_MAX][MVFS_CACHE_DNCREG] = mcdp->mvfs_dncregmax;
     usage->cache_usage[MVFS_CACHE_MAX][MVFS_CACHE_DNCNOENT] = mcdp->mvfs_dncnoentmax;
+
+    for (i = 0; i < MVFS_NUMA_MAXNODES; i++)
+	usage->cache_usage[MVFS_CACHE_INUSE][MVFS_CACHE_DNC_NODE(i)] = nodes[i];
     return;
 }
 static const char vnode_verid_mvfs_dncops_c[] = "$Id:  84c54f22.46fd11e3.8592.00:01:84:c3:8a:52 $";
@@ -222,40 +222,412 @@ mdki_probe_fini(void)
 
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(3,6,0)
 /* We used the fs periodic sync for several tasks, so we need a replacement.
+** Each maintenance task (see mvfs_maint_run() in mvfs_vfsops.c) is its own
+** delayed work item on a dedicated workqueue, so one slow task can't hold up
+** the others or the shared kernel workqueue.  A run returns how long until
+** the task is next due, and the item requeues itself for then.
 */
-static void mdki_dw_callback(struct work_struct *work);
+#define MDKI_MAINT_SLOTS 4
 
-static DECLARE_DELAYED_WORK(mdki_dw_var, mdki_dw_callback);
+struct mdki_maint_work {
+    struct delayed_work dwork;
+    int task;
+};
+
+extern int mvfs_maint_run(int task, CALL_DATA_T *cd);
 
-/* declared on mvfs_mdki.h */
-extern void mfs_periodic_maintenance(CALL_DATA_T *cd);
+static struct workqueue_struct *mdki_maint_wq;
+static struct mdki_maint_work mdki_maint_works[MDKI_MAINT_SLOTS];
+static int mdki_maint_ntasks;
 
-static void mdki_dw_callback(struct work_struct *work)
+static void mdki_maint_callback(struct work_struct *work)
 {
+    struct mdki_maint_work *mw;
     CALL_DATA_T cd;
+    int secs;
 
+    mw = container_of(to_delayed_work(work), struct mdki_maint_work, dwork);
     mdki_linux_init_call_data(&cd);
-    /* XXX ned a protection against a race with sync */ 
-    mfs_periodic_maintenance(&cd);
+    secs = mvfs_maint_run(mw->task, &cd);
     mdki_linux_destroy_call_data(&cd);
-    /* XXX avoid schedule if unloading */ 
-    schedule_delayed_work(&mdki_dw_var, 10 * HZ);
+    /* Piggyback aging of the NFS file handle cache on each run. */
+    vnlayer_fhcache_age();
+    (void) queue_delayed_work(mdki_maint_wq, &mw->dwork, secs * HZ);
 }
 
-static int mdki_dw_init(void)
+extern int
+mdki_linux_maint_start(int ntasks)
 {
-    schedule_delayed_work(&mdki_dw_var, 10 * HZ);
+    int i;
+
+    if (ntasks > MDKI_MAINT_SLOTS)
+        return EINVAL;
+    mdki_maint_wq = alloc_workqueue("mvfs_maint", WQ_UNBOUND,
+                                    MDKI_MAINT_SLOTS);
+    if (mdki_maint_wq == NULL)
+        return ENOMEM;
+    mdki_maint_ntasks = ntasks;
+    for (i = 0; i < ntasks; i++) {
+        INIT_DELAYED_WORK(&mdki_maint_works[i].dwork, mdki_maint_callback);
+        mdki_maint_works[i].task = i;
+        /* The first run just reports when the task is due. */
+        (void) queue_delayed_work(mdki_maint_wq,
+                                  &mdki_maint_works[i].dwork, HZ);
+    }
     return 0;
 }
 
-static void mdki_dw_fini(void)
+extern void
+mdki_linux_maint_stop(void)
+{
+    int i;
+
+    if (mdki_maint_wq == NULL)
+        return;
+    /* Copes with the work items queueing themselves again. */
+    for (i = 0; i < mdki_maint_ntasks; i++)
+        cancel_delayed_work_sync(&mdki_maint_works[i].dwork);
+    destroy_workqueue(mdki_maint_wq);
+    mdki_maint_wq = NULL;
+    mdki_maint_ntasks = 0;
+}
+#else
+/* The fs periodic sync calls mfs_vsync(), which runs maintenance. */
+extern int
+mdki_linux_maint_start(int ntasks)
+{
+    return ENOSYS;
+}
+
+extern void
+mdki_linux_maint_stop(void)
+{
+}
+#endif
+
+/* Superblock hash that vnlayer_dentry_to_fh puts in NFS file handles. */
+extern u_int
+mdki_linux_vfs_fhkey(VFS_T *vfsp)
+{
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,24)
+    if (VFSTOSB(vfsp) != NULL)
+        return MDKI_FID_CALC_HASH(VFSTOSB(vfsp));
+#endif
+    return 0;
+}
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,20)
+/* Cleartext prefetch workers, see mvfs_ctxt_prefetch() in mvfs_clearops.c.
+** There is one work item per worker slot.  They run on their own workqueue
+** so that a slow view server can't hold up the shared kernel workqueue.
+** The core never asks for more slots than MVFS_CTXT_PREFETCH_MAXTHREADS.
+*/
+#define MDKI_CTXT_PREFETCH_SLOTS 8
+
+struct mdki_ctxt_prefetch_work {
+    struct work_struct work;
+    int slot;
+};
+
+extern void mvfs_ctxt_prefetch_worker(int slot, CALL_DATA_T *cd);
+
+static struct workqueue_struct *mdki_ctxt_prefetch_wq;
+static struct mdki_ctxt_prefetch_work
+    mdki_ctxt_prefetch_works[MDKI_CTXT_PREFETCH_SLOTS];
+
+static void mdki_ctxt_prefetch_callback(struct work_struct *work)
+{
+    struct mdki_ctxt_prefetch_work *cpw;
+    CALL_DATA_T cd;
+
+    cpw = container_of(work, struct mdki_ctxt_prefetch_work, work);
+    mdki_linux_init_call_data(&cd);
+    mvfs_ctxt_prefetch_worker(cpw->slot, &cd);
+    mdki_linux_destroy_call_data(&cd);
+}
+
+static int mdki_ctxt_prefetch_init(void)
+{
+    int i;
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,36)
+    mdki_ctxt_prefetch_wq = alloc_workqueue("mvfs_ctxt", WQ_UNBOUND,
+                                            MDKI_CTXT_PREFETCH_SLOTS);
+#else
+    mdki_ctxt_prefetch_wq = create_workqueue("mvfs_ctxt");
+#endif
+    if (mdki_ctxt_prefetch_wq == NULL)
+        return -ENOMEM;
+    for (i = 0; i < MDKI_CTXT_PREFETCH_SLOTS; i++) {
+        INIT_WORK(&mdki_ctxt_prefetch_works[i].work,
+                  mdki_ctxt_prefetch_callback);
+        mdki_ctxt_prefetch_works[i].slot = i;
+    }
+    return 0;
+}
+
+static void mdki_ctxt_prefetch_fini(void)
+{
+    if (mdki_ctxt_prefetch_wq != NULL) {
+        destroy_workqueue(mdki_ctxt_prefetch_wq);
+        mdki_ctxt_prefetch_wq = NULL;
+    }
+}
+
+extern int
+mdki_linux_ctxt_prefetch_start(int slot)
 {
-    cancel_delayed_work(&mdki_dw_var);
+    if (mdki_ctxt_prefetch_wq == NULL ||
+        slot < 0 || slot >= MDKI_CTXT_PREFETCH_SLOTS)
+    {
+        return ENOSYS;
+    }
+    /* Slot is owned by the caller, so the work item can't be pending. */
+    (void) queue_work(mdki_ctxt_prefetch_wq,
+                      &mdki_ctxt_prefetch_works[slot].work);
+    return 0;
 }
 
+extern void
+mdki_linux_ctxt_prefetch_wait(void)
+{
+    if (mdki_ctxt_prefetch_wq != NULL)
+        flush_workqueue(mdki_ctxt_prefetch_wq);
+}
 #else
-    #define mdki_dw_init() 0
-    #define mdki_dw_fini()
+    #define mdki_ctxt_prefetch_init() 0
+    #define mdki_ctxt_prefetch_fini()
+
+extern int
+mdki_linux_ctxt_prefetch_start(int slot)
+{
+    return ENOSYS;
+}
+
+extern void
+mdki_linux_ctxt_prefetch_wait(void)
+{
+}
+#endif
+
+/* Background trimming of the mnode freelist.  Each run of the work item is
+** one bounded pass of mvfs_mnfreelist_reclaim(); if there is more to do it
+** queues itself again rather than looping, so other work gets a turn.
+*/
+extern int mvfs_mnfreelist_reclaim(CALL_DATA_T *cd);
+
+static void mdki_freelist_callback(struct work_struct *work);
+
+static DECLARE_WORK(mdki_freelist_work, mdki_freelist_callback);
+
+static void mdki_freelist_callback(struct work_struct *work)
+{
+    CALL_DATA_T cd;
+    int more;
+
+    mdki_linux_init_call_data(&cd);
+    more = mvfs_mnfreelist_reclaim(&cd);
+    mdki_linux_destroy_call_data(&cd);
+    if (more)
+        schedule_work(&mdki_freelist_work);
+}
+
+extern int
+mdki_linux_freelist_reclaim_start(void)
+{
+    (void) schedule_work(&mdki_freelist_work);
+    return 0;
+}
+
+extern void
+mdki_linux_freelist_reclaim_stop(void)
+{
+    /* Copes with the work item queueing itself again. */
+    cancel_work_sync(&mdki_freelist_work);
+}
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(3,0,0)
+/* Shrinkers for the MVFS caches.  There is one per cache, indexed the same
+** way as the MVFS_SHRINK_* values in mvfs_base.h.  The MVFS allocates its
+** own memory GFP_NOFS (see mdki_linux_kmalloc()), so a reclaim that allows
+** __GFP_FS did not come from inside the MVFS holding its locks, and the
+** scan callbacks call mvfs_shrink() right there and report what it freed.
+** A GFP_NOFS reclaim may have come from the MVFS, so it only adds to the
+** pending count for the cache and kicks a work item, which calls
+** mvfs_shrink() later with its own call data and no locks held.
+*/
+#define MDKI_SHRINK_NCACHES 4   /* MVFS_SHRINK_NCACHES */
+
+struct mdki_shrinker {
+    struct shrinker shrinker;
+    int cache;
+    atomic_t pending;
+    int registered;
+};
+
+extern int mvfs_shrink_count(int cache);
+extern int mvfs_shrink(int cache, int nr, CALL_DATA_T *cd);
+
+static struct mdki_shrinker mdki_shrinkers[MDKI_SHRINK_NCACHES];
+
+static void mdki_shrink_callback(struct work_struct *work);
+
+static DECLARE_WORK(mdki_shrink_work, mdki_shrink_callback);
+
+static void mdki_shrink_callback(struct work_struct *work)
+{
+    CALL_DATA_T cd;
+    int i, nr;
+
+    mdki_linux_init_call_data(&cd);
+    for (i = 0; i < MDKI_SHRINK_NCACHES; i++) {
+        nr = atomic_xchg(&mdki_shrinkers[i].pending, 0);
+        if (nr > 0)
+            (void) mvfs_shrink(mdki_shrinkers[i].cache, nr, &cd);
+    }
+    mdki_linux_destroy_call_data(&cd);
+}
+
+static void
+mdki_shrink_defer(
+    struct mdki_shrinker *msp,
+    unsigned long nr_to_scan
+)
+{
+    if (nr_to_scan > INT_MAX / 2)
+        nr_to_scan = INT_MAX / 2;
+    /* Don't let requests pile up beyond what is there to scan. */
+    if (atomic_add_return((int) nr_to_scan, &msp->pending) >
+        mvfs_shrink_count(msp->cache))
+    {
+        atomic_set(&msp->pending, mvfs_shrink_count(msp->cache));
+    }
+    schedule_work(&mdki_shrink_work);
+}
+
+/* Shrink from the reclaim context itself (it allows __GFP_FS). */
+static unsigned long
+mdki_shrink_now(
+    struct mdki_shrinker *msp,
+    unsigned long nr
+)
+{
+    CALL_DATA_T cd;
+    int freed;
+
+    if (nr > INT_MAX)
+        nr = INT_MAX;
+    mdki_linux_init_call_data(&cd);
+    freed = mvfs_shrink(msp->cache, (int) nr, &cd);
+    mdki_linux_destroy_call_data(&cd);
+    return (unsigned long) freed;
+}
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(3,12,0)
+static unsigned long
+mdki_shrink_count_objects(
+    struct shrinker *shrink,
+    struct shrink_control *sc
+)
+{
+    struct mdki_shrinker *msp;
+
+    msp = container_of(shrink, struct mdki_shrinker, shrinker);
+    return (unsigned long) mvfs_shrink_count(msp->cache);
+}
+
+static unsigned long
+mdki_shrink_scan_objects(
+    struct shrinker *shrink,
+    struct shrink_control *sc
+)
+{
+    struct mdki_shrinker *msp;
+
+    msp = container_of(shrink, struct mdki_shrinker, shrinker);
+    if (!(sc->gfp_mask & __GFP_FS)) {
+        mdki_shrink_defer(msp, sc->nr_to_scan);
+        /* Nothing was freed yet; the work item does it. */
+        return SHRINK_STOP;
+    }
+    return mdki_shrink_now(msp, sc->nr_to_scan);
+}
+#else
+static int
+mdki_shrink(
+    struct shrinker *shrink,
+    struct shrink_control *sc
+)
+{
+    struct mdki_shrinker *msp;
+
+    msp = container_of(shrink, struct mdki_shrinker, shrinker);
+    if (sc->nr_to_scan != 0) {
+        if (!(sc->gfp_mask & __GFP_FS)) {
+            mdki_shrink_defer(msp, sc->nr_to_scan);
+            /* Can't make progress from here, the work item does it. */
+            return -1;
+        }
+        (void) mdki_shrink_now(msp, sc->nr_to_scan);
+    }
+    return mvfs_shrink_count(msp->cache);
+}
+#endif
+
+extern void
+mdki_linux_register_shrinkers(void)
+{
+    struct mdki_shrinker *msp;
+    int i;
+
+    for (i = 0; i < MDKI_SHRINK_NCACHES; i++) {
+        msp = &mdki_shrinkers[i];
+        msp->cache = i;
+        atomic_set(&msp->pending, 0);
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(3,12,0)
+        msp->shrinker.count_objects = mdki_shrink_count_objects;
+        msp->shrinker.scan_objects = mdki_shrink_scan_objects;
+#else
+        msp->shrinker.shrink = mdki_shrink;
+#endif
+        msp->shrinker.seeks = DEFAULT_SEEKS;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(3,12,0)
+        if (register_shrinker(&msp->shrinker) != 0) {
+            MDKI_VFS_LOG(VFS_LOG_WARN, "%s: shrinker %d not registered\n",
+                         __func__, i);
+            continue;
+        }
+#else
+        register_shrinker(&msp->shrinker);
+#endif
+        msp->registered = 1;
+    }
+}
+
+extern void
+mdki_linux_unregister_shrinkers(void)
+{
+    int i;
+
+    for (i = 0; i < MDKI_SHRINK_NCACHES; i++) {
+        if (mdki_shrinkers[i].registered) {
+            unregister_shrinker(&mdki_shrinkers[i].shrinker);
+            mdki_shrinkers[i].registered = 0;
+        }
+    }
+    /* No new work can be queued now, wait out any that is. */
+    cancel_work_sync(&mdki_shrink_work);
+}
+#else
+extern void
+mdki_linux_register_shrinkers(void)
+{
+}
+
+extern void
+mdki_linux_unregister_shrinkers(void)
+{
+}
 #endif
 
 #ifdef MVFS_DEBUG
@@ -496,9 +868,9 @@ mdki_linux_kmalloc(
          ptr = vmalloc(size);
     } else {
 #if LINUX_VERSION_CODE < KERNEL_VERSION(2,6,32)
-         ptr = kmalloc(size, flag == KM_SLEEP ? (GFP_KERNEL|__GFP_NOFAIL) : GFP_ATOMIC);
+         ptr = kmalloc(size, flag == KM_SLEEP ? (GFP_NOFS|__GFP_NOFAIL) : GFP_ATOMIC);
 #else
-         ptr = kmalloc(size, flag == KM_SLEEP ? GFP_KERNEL : GFP_ATOMIC);
+         ptr = kmalloc(size, flag == KM_SLEEP ? GFP_NOFS : GFP_ATOMIC);
 #endif
     }
     return(ptr);
@@ -516,6 +888,52 @@ mdki_linux_kfree(
         kfree(ptr);
 }
 
+/* Memory from here is freed with mdki_linux_kfree like any other. */
+extern void *
+mdki_linux_kmalloc_node(
+    size_t size,
+    int flag,
+    int node
+)
+{
+    void * ptr;
+
+#ifdef PERIODIC_ERROR
+    if (mdki_linux_periodic_error_cnt++ >= mdki_linux_periodic_error) {
+        mdki_linux_periodic_error_cnt = 0;
+        mdki_linux_emomem_generated++;
+	return NULL;
+    }
+#endif
+    if (node < 0 || !node_online(node))
+        node = numa_node_id();
+    if (size > SIZE_BRKPOINT) {
+         ptr = vmalloc_node(size, node);
+    } else {
+#if LINUX_VERSION_CODE < KERNEL_VERSION(2,6,32)
+         ptr = kmalloc_node(size, flag == KM_SLEEP ? (GFP_NOFS|__GFP_NOFAIL) : GFP_ATOMIC, node);
+#else
+         ptr = kmalloc_node(size, flag == KM_SLEEP ? GFP_NOFS : GFP_ATOMIC, node);
+#endif
+    }
+    return(ptr);
+}
+
+/* The answer can be stale as soon as it is returned (we may be preempted
+** and migrated), which is fine for placement hints.
+*/
+extern int
+mdki_linux_numa_node_id(void)
+{
+    return numa_node_id();
+}
+
+extern int
+mdki_linux_numa_node_count(void)
+{
+    return num_online_nodes();
+}
+
 int
 mdki_linux_maxnamelen(void)
 {
@@ -643,13 +1061,19 @@ mdki_linux_mdep_init(void)
 
     init_waitqueue_head(&vnlayer_inactive_waitq);
     mdki_probe_init();
-    return mdki_dw_init();
+    err = mdki_ctxt_prefetch_init();
+    if (err != 0) {
+        /* Not fatal, cleartext prefetch just stays off. */
+        MDKI_VFS_LOG(VFS_LOG_WARN, "%s: no cleartext prefetch workqueue: "
+                     "%d\n", __func__, err);
+    }
+    return 0;
 }
 
 void
 mdki_linux_mdep_unload(void)
 {
-    mdki_dw_fini();
+    mdki_ctxt_prefetch_fini();
     mdki_probe_fini();
     vnlayer_release_root_dentry();
 }
@@ -851,7 +1275,7 @@ vnlayer_root_dop_setup(
         return dentry;
     }
 
-    alias = kmalloc(sizeof(*alias), GFP_KERNEL);
+    alias = kmalloc(sizeof(*alias), GFP_NOFS);
     if (alias == NULL) {
         MDKI_SLEEP_UNLOCK(&vnlayer_dop_setup_lock);
         VNODE_DPUT(viewdent);
@@ -2706,6 +3130,9 @@ init_module(void)
         goto cleanup;
     init_state = CALLED_VNODE_CACHE_CREATE;
 
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,24)
+    vnlayer_fhcache_init();
+#endif
 
     err = init_mvfs_module();
     if (err != 0) {
@@ -222,6 +222,16 @@ extern IN_OPS_T vnlayer_clrvnode_iops;
 # define MDKI_PATH_RELEASE(ND) path_release(ND)
 #endif
 
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,24)
+/* Recently decoded NFS file handles, see vnlayer_decode_fh */
+extern void
+vnlayer_fhcache_init(void);
+extern void
+vnlayer_fhcache_purge(SUPER_T *sb);
+extern void
+vnlayer_fhcache_age(void);
+#endif
+
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(3,8,0)
 # define MDKI_LOCK_SB(SB)
 # define MDKI_UNLOCK_SB(SB)
@@ -194,7 +194,7 @@ mdki_linux_clnt_call(
     int procnum,
     void *args,
     void *results,
-    int rpctimeout,
+    int rpctimeout_ms,
     bool_t intr,
     CRED_T *cred,
     enum clnt_stat *status
@@ -214,13 +214,14 @@ mdki_linux_clnt_call(
     STACK_CHECK_DECL()
 
     MDKI_TRACE(TRACE_RPC,
-               "clnt_call %p proc %d timeo %d intr %d cred %p\n",
-               rpc_cl, procnum, rpctimeout, intr, cred);
+               "clnt_call %p proc %d timeo %dms intr %d cred %p\n",
+               rpc_cl, procnum, rpctimeout_ms, intr, cred);
 #if LINUX_VERSION_CODE < KERNEL_VERSION(2,6,24)
     rpc_cl->cl_intr = intr;
     /*
-     * set timeouts &c. They're measured in ticks. rpctimeout is in
-     * tenths of seconds.
+     * set timeouts &c. They're measured in ticks. rpctimeout_ms is in
+     * milliseconds (adaptive view call timeouts can be well under a tenth
+     * of a second).
      *
      * We used to call rpc_set_timeout() or xprt_set_timeout(), but
      * those only work right for linear backoff, not exponential
@@ -232,12 +233,12 @@ mdki_linux_clnt_call(
      * and set the exponential flag.  (NFS likewise has to set things
      * up itself.)
      */
-    rpc_cl->cl_timeout.to_initval = rpctimeout * HZ / 10;
+    rpc_cl->cl_timeout.to_initval = msecs_to_jiffies(rpctimeout_ms);
     rpc_cl->cl_timeout.to_maxval = 20*HZ; /* like Solaris kudp */
     rpc_cl->cl_timeout.to_exponential = 1;
     /* to_retries is set in mdki_linux_clntkudp_init() */
 #else
-    rpc_cl->cl_timeout_default.to_initval = rpctimeout * HZ / 10;
+    rpc_cl->cl_timeout_default.to_initval = msecs_to_jiffies(rpctimeout_ms);
     rpc_cl->cl_timeout_default.to_maxval = 20*HZ; /* like Solaris kudp */
     rpc_cl->cl_timeout_default.to_exponential = 1;
 #endif
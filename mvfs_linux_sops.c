@@ -274,6 +274,10 @@ vnlayer_write_super(struct super_block *super_p)
     mdki_linux_init_call_data(&cd);
     err = VFS_SYNC(SBTOVFS(super_p), SBTOVFS(super_p), 0, &cd);
     mdki_linux_destroy_call_data(&cd);
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,24)
+    /* No maintenance work items on these kernels, age the fh cache here. */
+    vnlayer_fhcache_age();
+#endif
     /* They rewrote sync_supers so that it won't proceed through their loop
      * until the dirty bit is cleared.
      */
@@ -816,6 +820,17 @@ vnlayer_mount(
 void
 vnlayer_kill_sb(SUPER_T *sbp)
 {
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,24)
+    /*
+     * Cached handle resolutions hold dentries, drop them first.  The mount
+     * stays findable by handle until put_super, so flag it first to keep
+     * vnlayer_fhcache_enter from caching it again behind the purge.
+     */
+    if (SBTOVFS(sbp) != NULL) {
+        SBTOVFS(sbp)->vfs_flag |= VFS_UNMOUNTING;
+        vnlayer_fhcache_purge(sbp);
+    }
+#endif
     generic_shutdown_super(sbp);
 }
 
@@ -824,7 +839,7 @@ vnlayer_alloc_inode(SUPER_T *sbp)
 {
     vnlayer_vnode_t *vnlvp;
 
-    vnlvp = (vnlayer_vnode_t *)kmem_cache_alloc(vnlayer_vnode_cache, GFP_KERNEL);
+    vnlvp = (vnlayer_vnode_t *)kmem_cache_alloc(vnlayer_vnode_cache, GFP_NOFS);
     if (vnlvp != NULL) {
         /* The inode used to be initialized by the kernel slab allocator
         ** because we used it to allocate an inode directly (see init_once() in
@@ -1065,6 +1080,18 @@ vnlayer_dentry_to_fh(
     return type;
 }
 
+/*
+ * Largest FID an MVFS file handle can carry (the handle type is twice the
+ * FID length and must stay below VNODE_NFS_FH_TYPE_ERROR).  Handles are
+ * decoded into stack buffers of this size rather than allocated ones.
+ */
+#define VNLAYER_FH_MAXFIDLEN (VNODE_NFS_FH_TYPE_ERROR / 2)
+
+typedef union {
+    MDKI_FID_T fid;
+    char buf[MDKI_FID_ALLOC_LEN(VNLAYER_FH_MAXFIDLEN)];
+} vnlayer_fidbuf_t;
+
 STATIC int
 vnlayer_unpack_fh(
     __u32 *fh,
@@ -1126,26 +1153,18 @@ vnlayer_decode_fh(
     void *context
 )
 {
-    MDKI_FID_T *lfidp, *plfidp;
+    vnlayer_fidbuf_t lfidbuf, plfidbuf;
+    MDKI_FID_T *lfidp = &lfidbuf.fid;
+    MDKI_FID_T *plfidp = &plfidbuf.fid;
     DENT_T *dp;
     int error, fidlen;
     struct svc_export *exp = context;   /* XXX cheating! */
     SUPER_T *realsb = exp->ex_dentry->d_inode->i_sb;
 
     fidlen = fhtype >> 1;
-    if (fidlen == 0)
+    if (fidlen == 0 || fidlen > VNLAYER_FH_MAXFIDLEN)
         return ERR_PTR(-EINVAL);
 
-    lfidp = KMEM_ALLOC(MDKI_FID_ALLOC_LEN(fidlen), KM_SLEEP);
-    if (lfidp == NULL)
-        return ERR_PTR(-ENOMEM);
-
-    plfidp = KMEM_ALLOC(MDKI_FID_ALLOC_LEN(fidlen), KM_SLEEP);
-    if (plfidp == NULL) {
-        KMEM_FREE(lfidp, MDKI_FID_ALLOC_LEN(fidlen));
-        return ERR_PTR(-ENOMEM);
-    }
-
     error = vnlayer_unpack_fh(fh, len, fhtype, fidlen, lfidp, plfidp);
     if (error == 0) {
         /*
@@ -1167,8 +1186,6 @@ vnlayer_decode_fh(
         dp = ERR_PTR(error);
     }
 
-    KMEM_FREE(lfidp, MDKI_FID_ALLOC_LEN(fidlen));
-    KMEM_FREE(plfidp, MDKI_FID_ALLOC_LEN(fidlen));
     return dp;
 }
 #else /* LINUX_VERSION_CODE < KERNEL_VERSION(2,6,24) */
@@ -1191,6 +1208,226 @@ vnlayer_eval_mount(
     return NULL;
 }
 
+/*
+ * Cache of recent file handle to dentry resolutions.  nfsd decodes the
+ * client's handle on every operation, and going through VFS_VGET and
+ * vnlayer_find_dentry each time is costly.  Each slot holds its dentry with
+ * dget; a hit is only used if the dentry is still hashed and its mnode
+ * hasn't been marked stale, and directories must also pass the rebind
+ * check the slow path does.  Entries expire after VNLAYER_FHCACHE_TTL and
+ * are swept periodically (by the maintenance work items, or by the
+ * superblock sync on kernels without them), so they don't pin mnodes (and
+ * their views) for long.  vnlayer_kill_sb marks the VFS VFS_UNMOUNTING and
+ * drops its entries before shutdown; inserts check the flag under the slot
+ * lock, so none can slip in after the purge.
+ */
+#define VNLAYER_FHCACHE_SIZE    256     /* slots, a power of 2 */
+#define VNLAYER_FHCACHE_FIDMAX  16      /* longer FIDs aren't cached */
+#define VNLAYER_FHCACHE_TTL     (2 * HZ)
+
+struct vnlayer_fhcache_ent {
+    spinlock_t lock;
+    SUPER_T *sb;
+    DENT_T *dp;                         /* held, NULL if slot is empty */
+    unsigned long stamp;                /* jiffies when cached */
+    u_short fidlen;
+    char fid[VNLAYER_FHCACHE_FIDMAX];
+};
+
+static struct vnlayer_fhcache_ent vnlayer_fhcache[VNLAYER_FHCACHE_SIZE];
+
+#ifdef MVFS_DEBUG
+/* Set only while vnlayer_fhcache_selftest times the uncached path. */
+static int vnlayer_fhcache_off;
+#define VNLAYER_FHCACHE_ON() (!vnlayer_fhcache_off)
+#else
+#define VNLAYER_FHCACHE_ON() 1
+#endif
+
+extern void
+vnlayer_fhcache_init(void)
+{
+    int i;
+
+    for (i = 0; i < VNLAYER_FHCACHE_SIZE; i++) {
+        spin_lock_init(&vnlayer_fhcache[i].lock);
+        vnlayer_fhcache[i].dp = NULL;
+    }
+}
+
+static struct vnlayer_fhcache_ent *
+vnlayer_fhcache_slot(
+    unsigned sbhash,
+    MDKI_FID_T *fidp
+)
+{
+    unsigned h = sbhash;
+    int i;
+
+    for (i = 0; i < fidp->fid_len; i++)
+        h = (h * 31) + (u_char)fidp->fid_data[i];
+    return &vnlayer_fhcache[h & (VNLAYER_FHCACHE_SIZE - 1)];
+}
+
+/* Empty the slot if it still holds dp, and drop the slot's hold on it. */
+static void
+vnlayer_fhcache_drop(
+    struct vnlayer_fhcache_ent *ent,
+    DENT_T *dp
+)
+{
+    DENT_T *olddp = NULL;
+
+    spin_lock(&ent->lock);
+    if (ent->dp == dp) {
+        olddp = ent->dp;
+        ent->dp = NULL;
+    }
+    spin_unlock(&ent->lock);
+    if (olddp != NULL)
+        dput(olddp);
+}
+
+/* Returns a held dentry if the handle resolved recently, else NULL. */
+static DENT_T *
+vnlayer_fhcache_lookup(
+    SUPER_T *sb,
+    unsigned sbhash,
+    MDKI_FID_T *fidp
+)
+{
+    struct vnlayer_fhcache_ent *ent;
+    DENT_T *dp = NULL;
+    DENT_T *olddp = NULL;
+    VNODE_T *vp;
+    CALL_DATA_T cd;
+    int rebound;
+
+    if (fidp->fid_len > VNLAYER_FHCACHE_FIDMAX)
+        return NULL;
+    ent = vnlayer_fhcache_slot(sbhash, fidp);
+
+    spin_lock(&ent->lock);
+    if (ent->dp != NULL && ent->sb == sb && ent->fidlen == fidp->fid_len &&
+        memcmp(ent->fid, fidp->fid_data, fidp->fid_len) == 0)
+    {
+        if (time_before(jiffies, ent->stamp + VNLAYER_FHCACHE_TTL)) {
+            dp = dget(ent->dp);
+        } else {
+            olddp = ent->dp;
+            ent->dp = NULL;
+        }
+    }
+    spin_unlock(&ent->lock);
+    if (olddp != NULL)
+        dput(olddp);
+    if (dp == NULL)
+        return NULL;
+
+    if (dp->d_inode == NULL || d_unhashed(dp) ||
+        mvfs_vget_valid(ITOV(dp->d_inode)) != 0)
+    {
+        goto stale;
+    }
+    if (S_ISDIR(dp->d_inode->i_mode)) {
+        vp = ITOV(dp->d_inode);
+        VN_HOLD(vp);
+        mdki_linux_init_call_data(&cd);
+        rebound = mfs_rebind_vpp(1, &vp, &cd);
+        VN_RELE(vp);
+        mdki_linux_destroy_call_data(&cd);
+        if (rebound)
+            goto stale;
+    }
+    return dp;
+
+  stale:
+    vnlayer_fhcache_drop(ent, dp);
+    dput(dp);
+    return NULL;
+}
+
+static void
+vnlayer_fhcache_enter(
+    SUPER_T *sb,
+    unsigned sbhash,
+    MDKI_FID_T *fidp,
+    DENT_T *dp
+)
+{
+    struct vnlayer_fhcache_ent *ent;
+    DENT_T *olddp;
+
+    if (fidp->fid_len > VNLAYER_FHCACHE_FIDMAX || dp->d_inode == NULL ||
+        mvfs_vget_valid(ITOV(dp->d_inode)) != 0)
+    {
+        return;
+    }
+    ent = vnlayer_fhcache_slot(sbhash, fidp);
+    dp = dget(dp);
+
+    spin_lock(&ent->lock);
+    if (SBTOVFS(sb)->vfs_flag & VFS_UNMOUNTING) {
+        /* Already purged for kill_sb, don't hold it up */
+        spin_unlock(&ent->lock);
+        dput(dp);
+        return;
+    }
+    olddp = ent->dp;
+    ent->sb = sb;
+    ent->dp = dp;
+    ent->stamp = jiffies;
+    ent->fidlen = fidp->fid_len;
+    BCOPY(fidp->fid_data, ent->fid, fidp->fid_len);
+    spin_unlock(&ent->lock);
+    if (olddp != NULL)
+        dput(olddp);
+}
+
+/*
+ * Drop cached resolutions for sb (or for every superblock if NULL), either
+ * all of them or only those past VNLAYER_FHCACHE_TTL.
+ */
+static void
+vnlayer_fhcache_sweep(
+    SUPER_T *sb,
+    int expired_only
+)
+{
+    struct vnlayer_fhcache_ent *ent;
+    DENT_T *olddp;
+    int i;
+
+    for (i = 0; i < VNLAYER_FHCACHE_SIZE; i++) {
+        ent = &vnlayer_fhcache[i];
+        olddp = NULL;
+        spin_lock(&ent->lock);
+        if (ent->dp != NULL && (sb == NULL || ent->sb == sb) &&
+            (!expired_only ||
+             !time_before(jiffies, ent->stamp + VNLAYER_FHCACHE_TTL)))
+        {
+            olddp = ent->dp;
+            ent->dp = NULL;
+        }
+        spin_unlock(&ent->lock);
+        if (olddp != NULL)
+            dput(olddp);
+    }
+}
+
+extern void
+vnlayer_fhcache_purge(SUPER_T *sb)
+{
+    vnlayer_fhcache_sweep(sb, 0);
+}
+
+/* Called periodically so idle entries don't keep their dentries. */
+extern void
+vnlayer_fhcache_age(void)
+{
+    vnlayer_fhcache_sweep(NULL, 1);
+}
+
 /* Common file handle decoding for both parent and dentry */
 static struct dentry *
 vnlayer_decode_fh(
@@ -1200,14 +1437,15 @@ vnlayer_decode_fh(
     int fhtype,
     int is_parent)
 {
-    MDKI_FID_T *lfidp;
+    vnlayer_fidbuf_t lfidbuf;
+    MDKI_FID_T *lfidp = &lfidbuf.fid;
     DENT_T *dp;
     int error, fidlen;
     SUPER_T *realsb;
     unsigned realsb_hash;
 
     fidlen = fhtype >> 1;
-    if (fidlen == 0) {
+    if (fidlen == 0 || fidlen > VNLAYER_FH_MAXFIDLEN) {
         return ERR_PTR(-EINVAL);
     }
 
@@ -1218,11 +1456,6 @@ vnlayer_decode_fh(
         return ERR_PTR(-EINVAL);
     }
 
-    lfidp = KMEM_ALLOC(MDKI_FID_ALLOC_LEN(fidlen), KM_SLEEP);
-    if (lfidp == NULL) {
-        return ERR_PTR(-ENOMEM);
-    }
-
     if (is_parent) {
         error = vnlayer_unpack_fh((__u32 *)fh, len, fhtype, fidlen,
                                   NULL, lfidp);
@@ -1239,8 +1472,18 @@ vnlayer_decode_fh(
          * If the result is not NULL, the superblock was locked with
          * MDKI_LOCK_SB and must be unlocked with MDKI_UNLOCK_SB.
          */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(3,8,0)
+        /*
+         * MDKI_LOCK_SB doesn't sleep here, so the callback can run from
+         * the hashed, lockless lookup.
+         */
+        realsb = (SUPER_T *) mvfs_find_mount_fhkey(realsb_hash,
+                                                   vnlayer_eval_mount,
+                                                   &realsb_hash);
+#else
         realsb = (SUPER_T *) mvfs_find_mount(vnlayer_eval_mount,
                                              &realsb_hash);
+#endif
 
         if (realsb != NULL) {
             /*
@@ -1248,7 +1491,13 @@ vnlayer_decode_fh(
              * vnlayer_get_dentry decides wether we can trust this FID, 
              * it should be able to smell any staleness.
              */
-            dp = vnlayer_get_dentry(realsb, lfidp);
+            dp = VNLAYER_FHCACHE_ON() ?
+                 vnlayer_fhcache_lookup(realsb, realsb_hash, lfidp) : NULL;
+            if (dp == NULL) {
+                dp = vnlayer_get_dentry(realsb, lfidp);
+                if (!IS_ERR(dp) && VNLAYER_FHCACHE_ON())
+                    vnlayer_fhcache_enter(realsb, realsb_hash, lfidp, dp);
+            }
             MDKI_UNLOCK_SB(realsb);
             if (IS_ERR(dp)) {
                 MDKI_VFS_LOG(VFS_LOG_ESTALE,
@@ -1263,7 +1512,6 @@ vnlayer_decode_fh(
     } else {
         dp = ERR_PTR(error);
     }
-    KMEM_FREE(lfidp, MDKI_FID_ALLOC_LEN(fidlen));
     return dp;
 }
 
@@ -1287,6 +1535,112 @@ vnlayer_fh_to_parent(
     return vnlayer_decode_fh(sb, fh, len, fhtype, 1);
 }
 
+#if defined(MVFS_DEBUG) && LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,36)
+/*
+ * File handle cache self-test.  Writing the path of a VOB object to
+ * /sys/module/mvfs/parameters/mvfs_fhcache_selftest encodes a handle for
+ * it, then decodes the handle mvfs_fhcache_selftest_loops times with the
+ * cache off and again with it on, and logs the time per decode.  Any nfsd
+ * decodes running meanwhile also bypass the cache during the first pass.
+ */
+static int mvfs_fhcache_selftest_loops = 10000;
+module_param(mvfs_fhcache_selftest_loops, int, 0644);
+MODULE_PARM_DESC(mvfs_fhcache_selftest_loops,
+                 "Decodes per pass of the mvfs_fhcache_selftest test");
+
+static int
+vnlayer_fhcache_time(
+    SUPER_T *sb,
+    __u32 *fh,
+    int len,
+    int fhtype,
+    int loops,
+    s64 *nsp
+)
+{
+    DENT_T *dp;
+    ktime_t start;
+    int i;
+
+    start = ktime_get();
+    for (i = 0; i < loops; i++) {
+        dp = vnlayer_fh_to_dentry(sb, (struct fid *) fh, len, fhtype);
+        if (IS_ERR(dp))
+            return PTR_ERR(dp);
+        dput(dp);
+    }
+    *nsp = ktime_to_ns(ktime_sub(ktime_get(), start));
+    return 0;
+}
+
+static int
+vnlayer_fhcache_selftest(
+    const char *val,
+    const struct kernel_param *kp
+)
+{
+    __u32 fh[VNODE_NFS_FH_TYPE_ERROR / sizeof(__u32) + 1];
+    int len = sizeof(fh) / sizeof(fh[0]);
+    int loops = mvfs_fhcache_selftest_loops;
+    struct path path;
+    s64 off_ns, on_ns;
+    char *name;
+    int fhtype, err;
+
+    if (loops <= 0)
+        return -EINVAL;
+    if ((name = kstrdup(val, GFP_KERNEL)) == NULL)
+        return -ENOMEM;
+    if ((err = kern_path(strim(name), LOOKUP_FOLLOW, &path)) != 0)
+        goto out;
+    if (path.dentry->d_inode == NULL ||
+        !MDKI_INOISMVFS(path.dentry->d_inode))
+    {
+        err = -EINVAL;
+        goto out_put;
+    }
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(3,5,0)
+    fhtype = vnlayer_inode_to_fh(path.dentry->d_inode, fh, &len,
+                                 path.dentry->d_parent->d_inode);
+#else
+    fhtype = vnlayer_dentry_to_fh(path.dentry, fh, &len, 1);
+#endif
+    if (fhtype == VNODE_NFS_FH_TYPE_ERROR) {
+        err = -EINVAL;
+        goto out_put;
+    }
+
+    vnlayer_fhcache_off = 1;
+    err = vnlayer_fhcache_time(path.dentry->d_sb, fh, len, fhtype, loops,
+                               &off_ns);
+    vnlayer_fhcache_off = 0;
+    if (err == 0) {
+        err = vnlayer_fhcache_time(path.dentry->d_sb, fh, len, fhtype, loops,
+                                   &on_ns);
+    }
+    if (err == 0) {
+        mdki_linux_printf("mvfs: fhcache selftest %s: %d decodes, "
+                          "%lld ns/op uncached, %lld ns/op cached\n",
+                          name, loops, div_s64(off_ns, loops),
+                          div_s64(on_ns, loops));
+    }
+  out_put:
+    path_put(&path);
+  out:
+    kfree(name);
+    return err;
+}
+
+static const struct kernel_param_ops vnlayer_fhcache_selftest_ops = {
+    .set = vnlayer_fhcache_selftest,
+};
+module_param_cb(mvfs_fhcache_selftest, &vnlayer_fhcache_selftest_ops,
+                NULL, 0200);
+MODULE_PARM_DESC(mvfs_fhcache_selftest,
+                 "Write a VOB pathname to time handle decoding with and "
+                 "without the file handle cache");
+#endif /* MVFS_DEBUG && LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,36) */
+
 #endif /* else LINUX_VERSION_CODE < KERNEL_VERSION(2,6,24) */
 
 struct dentry *
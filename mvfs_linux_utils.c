@@ -35,6 +35,17 @@ MODULE_INFO(supported,"external");
 MODULE_AUTHOR("IBM Rational Software");
 MODULE_DESCRIPTION("IBM Rational ClearCase Multi-Version File System");
 
+#ifdef MVFS_USE_SPLIT_ORDERED_HASH
+/* Lets a site go back to the splock pool thread hash at load time
+ * (mvfs_lockless_thrhash_enabled=0 on the insmod/modprobe line).  It is
+ * read only once loaded since the thread hash is set up at init.
+ */
+extern int mvfs_lockless_thrhash_enabled;
+module_param(mvfs_lockless_thrhash_enabled, int, 0444);
+MODULE_PARM_DESC(mvfs_lockless_thrhash_enabled,
+                 "Use the lock-free thread hash (1) or the splock pool one (0)");
+#endif
+
 VNODE_T *vnlayer_sysroot_clrvp;
 VFS_T *vnlayer_clrvnode_vfsp;
 VNODE_T *vnlayer_looproot_vp;
@@ -1481,12 +1481,43 @@ static struct rpc_stat albd_rpc_stats;
 */
 #define PROVIDE_V8_COMPAT
 
+/* Charge the time spent in an XDR routine to the view op it was for.  As
+** with mfs_viewopcnt, only view RPCs are counted; the albd wrappers pass
+** FALSE for view and skip this.  Retransmits are re-encoded and counted
+** again, which is the cost we want to see anyway.
+*/
+STATIC void
+mvfs_linux_xdr_time(
+    struct rpc_rqst *rq,
+    ktime_t start,
+    enum xdr_op op
+)
+{
+    struct timespec dtime;
+    u32 proc;
+
+    if (rq == NULL || rq->rq_task == NULL ||
+        rq->rq_task->tk_msg.rpc_proc == NULL)
+    {
+        return;
+    }
+    proc = rq->rq_task->tk_msg.rpc_proc->p_proc;
+    if (proc >= VIEW_NUM_PROCS)
+        return;
+    dtime = ktime_to_timespec(ktime_sub(ktime_get(), start));
+    if (op == XDR_ENCODE) {
+        MVFS_ADDTIME(dtime, mvfs_viewenctime[proc]);
+    } else {
+        MVFS_ADDTIME(dtime, mvfs_viewdectime[proc]);
+    }
+}
+
 /* The xdr routines changed enough in later kernels that it doesn't make sense
 ** to try to macroize the differences, so just do the full definitions here.
 */
 #if LINUX_VERSION_CODE > KERNEL_VERSION(2,6,32)
 
-#define XDR_RPC_ENCODE(type)                                            \
+#define XDR_RPC_ENCODE(type,view)                                       \
 /* return Linux error codes to RPC runtime */                           \
 STATIC void                                                             \
 mvfs_linux_xdr_encode_##type(                                           \
@@ -1497,11 +1528,16 @@ mvfs_linux_xdr_encode_##type(                                           \
 {                                                                       \
     XDR x;                                                              \
     bool_t stat;                                                        \
+    ktime_t start = ktime_get();                                        \
     x.x_op = XDR_ENCODE;                                                \
     x.x_origdata = x.x_data = (u8 *)xdr->p;                             \
     x.x_rq = rqstp;                                                     \
     x.x_limit = (u8 *)xdr->end;                                         \
     stat = xdr_##type##_req_t(&x, (type##_req_t *)obj);                 \
+    if (view) {                                                         \
+        mvfs_linux_xdr_time((struct rpc_rqst *)rqstp, start,            \
+                            XDR_ENCODE);                                \
+    }                                                                   \
     MDKI_TRACE(TRACE_XDR,                                               \
                "xdr_" #type "_req: rval %d, x_data %p,"                 \
                " x_origdata %p, obj %p, iov_base %p, limit %p\n",       \
@@ -1515,7 +1551,7 @@ mvfs_linux_xdr_encode_##type(                                           \
     xdr->buf->len += (x.x_data - x.x_origdata);                         \
 }
 
-#define XDR_RPC_DECODE(type)                                            \
+#define XDR_RPC_DECODE(type,view)                                       \
 /* return Linux error codes to RPC runtime */                           \
 STATIC int                                                              \
 mvfs_linux_xdr_decode_##type(                                           \
@@ -1526,11 +1562,16 @@ mvfs_linux_xdr_decode_##type(                                           \
 {                                                                       \
     XDR x;                                                              \
     bool_t stat;                                                        \
+    ktime_t start = ktime_get();                                        \
     x.x_op = XDR_DECODE;                                                \
     x.x_data = x.x_origdata = (u8 *)xdr->p;                             \
     x.x_rq = rqstp;                                                     \
     x.x_limit = (u8 *)xdr->end;                                         \
     stat = xdr_##type##_reply_t(&x, (type##_reply_t *)obj);             \
+    if (view) {                                                         \
+        mvfs_linux_xdr_time((struct rpc_rqst *)rqstp, start,            \
+                            XDR_DECODE);                                \
+    }                                                                   \
     MDKI_TRACE(TRACE_XDR,                                               \
                "xdr_" #type "_reply rval %d, x_data %p, x_origdata %p," \
                " x_limit %p, obj %p, iov_base %p\n",                    \
@@ -1560,7 +1601,7 @@ mvfs_linux_xdr_void(void)
 #define MAX(a,b) ((a) < (b) ? (b) : (a))
 #endif
 
-#define XDR_RPC_ENCODE(type)                                            \
+#define XDR_RPC_ENCODE(type,view)                                       \
 /* return Linux error codes to RPC runtime */                           \
 STATIC int                                                              \
 mvfs_linux_xdr_encode_##type(                                           \
@@ -1571,11 +1612,15 @@ mvfs_linux_xdr_encode_##type(                                           \
 {                                                                       \
     XDR x;                                                              \
     bool_t stat;                                                        \
+    ktime_t start = ktime_get();                                        \
     x.x_op = XDR_ENCODE;                                                \
     x.x_origdata = x.x_data = (u8 *)data;                               \
     x.x_rq = rq;                                                        \
     x.x_limit = (u8 *)rq->rq_svec[0].iov_base + rq->rq_snd_buf.buflen;  \
     stat = xdr_##type##_req_t(&x, (type##_req_t *)obj);                 \
+    if (view) {                                                         \
+        mvfs_linux_xdr_time(rq, start, XDR_ENCODE);                     \
+    }                                                                   \
     MDKI_TRACE(TRACE_XDR,                                               \
                "xdr_" #type "_req: rval %d, x_data %p,"                 \
                " x_origdata %p, obj %p, iov_base %p, limit %p\n",       \
@@ -1588,7 +1633,7 @@ mvfs_linux_xdr_encode_##type(                                           \
    return 0 /* MVFS_RPC_SUCCESS */;                                     \
 }
 
-#define XDR_RPC_DECODE(type)                                            \
+#define XDR_RPC_DECODE(type,view)                                       \
 /* return Linux error codes to RPC runtime */                           \
 STATIC int                                                              \
 mvfs_linux_xdr_decode_##type(                                           \
@@ -1599,11 +1644,15 @@ mvfs_linux_xdr_decode_##type(                                           \
 {                                                                       \
     XDR x;                                                              \
     bool_t stat;                                                        \
+    ktime_t start = ktime_get();                                        \
     x.x_op = XDR_DECODE;                                                \
     x.x_data = x.x_origdata = (u8 *)data;                               \
     x.x_rq = rq;                                                        \
     x.x_limit = (u8 *)rq->rq_rvec[0].iov_base + rq->rq_rlen;            \
     stat = xdr_##type##_reply_t(&x, (type##_reply_t *)obj);             \
+    if (view) {                                                         \
+        mvfs_linux_xdr_time(rq, start, XDR_DECODE);                     \
+    }                                                                   \
     MDKI_TRACE(TRACE_XDR,                                               \
                "xdr_" #type "_reply rval %d, x_data %p, x_origdata %p," \
                " x_limit %p, obj %p, iov_base %p, rlen %x\n",           \
@@ -1627,19 +1676,19 @@ mvfs_linux_xdr_void(
 
 #endif /* LINUX_VERSION_CODE > KERNEL_VERSION(2,6,32) */
 
-#define VIEW_XDR_FUNCS(type)    \
-    XDR_RPC_ENCODE(view_##type) \
-    XDR_RPC_DECODE(view_##type)
+#define VIEW_XDR_FUNCS(type)          \
+    XDR_RPC_ENCODE(view_##type, TRUE) \
+    XDR_RPC_DECODE(view_##type, TRUE)
 
-#define ALBD_XDR_FUNCS(type)    \
-    XDR_RPC_ENCODE(albd_##type) \
-    XDR_RPC_DECODE(albd_##type)
+#define ALBD_XDR_FUNCS(type)           \
+    XDR_RPC_ENCODE(albd_##type, FALSE) \
+    XDR_RPC_DECODE(albd_##type, FALSE)
 
 #ifdef PROVIDE_V8_COMPAT
 /* We only need the reply function since the req function is the same as the new
 ** rpc's.
 */
-#define VIEW_XDR_FUNCS_V8(type) XDR_RPC_DECODE(view_##type##_v8)
+#define VIEW_XDR_FUNCS_V8(type) XDR_RPC_DECODE(view_##type##_v8, TRUE)
 #endif
 
 /* The following macros lay down the actual entries in the
@@ -688,6 +688,7 @@ mvfs_linux_condlock(
 #define MVFS_RW_LOCK_DESTROY(rw_lptr) /* nothing */
 #define MVFS_RW_READ_LOCK(rw_lptr, opl) down_read(rw_lptr) 
 #define MVFS_RW_WRITE_LOCK(rw_lptr, opl) down_write(rw_lptr) 
+#define MVFS_RW_TRY_WRITE_LOCK(rw_lptr, opl) down_write_trylock(rw_lptr)
 #define MVFS_RW_READ_UNLOCK(rw_lptr, opl) up_read(rw_lptr)
 #define MVFS_RW_WRITE_UNLOCK(rw_lptr, opl) up_write(rw_lptr)
 
@@ -716,6 +717,24 @@ mvfs_linux_condlock(
 #define MVFS_LOCK_(lptr,line) MVFS_LOCK__(lptr,line)
 #define MVFS_LOCK(lptr) MVFS_LOCK_(lptr,__LINE__)
 
+/* Like MVFS_LOCK, but a signal ends the wait; *errp is set to 0 or EINTR. */
+#define MVFS_LOCK_INTR__(lptr,errp,line)       {                \
+        DEBUG_ASSERT(NOTLOCKEDBYME(lptr));                      \
+        if (MDKI_SLEEP_LOCK_INTR(&(lptr)->slock) != 0) {        \
+                *(errp) = EINTR;                                \
+        } else {                                                \
+                ++(lptr)->count;                                \
+                (lptr)->owner = MDKI_CURPROC();                 \
+                (lptr)->locker = __FILE__ ":" #line;            \
+                (lptr)->retpc = mdki_getreturn();               \
+                (lptr)->retpc2 = mdki_getmycaller();            \
+                *(errp) = 0;                                    \
+        }                                                       \
+    }
+
+#define MVFS_LOCK_INTR_(lptr,errp,line) MVFS_LOCK_INTR__(lptr,errp,line)
+#define MVFS_LOCK_INTR(lptr,errp) MVFS_LOCK_INTR_(lptr,errp,__LINE__)
+
 #define MVFS_RDDIR_MNLOCK_SET_RECURSIVE(mnp)                            \
     tbs_boolean_t was_recursive = LOCK_IS_RECURSIVE(MLOCK_ADDR(mnp));   \
     DEBUG_ASSERT(ISLOCKEDBYME(MLOCK_ADDR(mnp)));                              \
@@ -851,6 +870,7 @@ struct rpc_clnt;
 /* MDKI_AUTH_DESTROY is not used by us */
 #define MDKI_AUTH_DESTROY(au)
 /* AUTHKERN_CREATE() not used */
+/* rt, the first retransmit timeout, is in milliseconds. */
 #define MDKI_CLNT_CALL(cl,op,xa,ra,xr,rr,w,rt,m,i,cr,s) \
     mdki_linux_clnt_call(cl,op,ra,rr,rt,/*m,*/i,cr,&s)
 #define MDKI_CLNT_GETERR(cl,errp)		mvfs_linux_clnt_geterr(errp)
@@ -865,6 +885,7 @@ struct rpc_clnt;
 #define MDKI_SET_XID(cl,xid)
 
 #define MVFS_XID_T atomic_t
+#define MVFS_DNC_COUNT_T atomic_t
 #define MVFS_XID_ULIMIT (0x7fffffff)
 #define MDKI_ALLOC_XID() mvfs_alloc_xid()
 #define MVFS_COMMON_ALLOC_XID
@@ -1099,9 +1120,42 @@ mvfs_linux_ioctl_chk_cmd(
 /* Macros for atomic set and atomic read */
 #define MDKI_ATOMIC_SET_UINT32(addr, val)     atomic_set((addr), (val))
 #define MDKI_ATOMIC_READ_UINT32(addr)         atomic_read(addr)
-#define MDKI_ATOMIC_PTR_READ(addr)     (*((typeof(*(addr)) *)(addr)))
+#define MDKI_ATOMIC_PTR_READ(addr)     (*((volatile typeof(*(addr)) *)(addr)))
 #define MDKI_ATOMIC_PTR_SET(addr, val) \
     ((*((volatile typeof(*(addr)) *)(addr))) = (val))
 
+/* Full memory barrier (orders earlier loads and stores against later ones) */
+#define MDKI_MEMORY_BARRIER()          smp_mb()
+
+/* Load a possibly unaligned word from a string, as the dcache does for
+ * path components.  Bytes that would come from an unmapped page read as
+ * zero, and the load is not checked by KASAN, so it may run past the
+ * terminating null of the string.
+ */
+#ifdef CONFIG_DCACHE_WORD_ACCESS
+#define MVFS_LOAD_WORD_ZEROPAD(p) \
+    ((u_long)load_unaligned_zeropad((const void *)(p)))
+#endif
+
+/* Sequence counters, for data read without a lock.  Writers must be
+ * serialized by some other lock; preemption is held off while a write is
+ * in progress so readers spinning on it can't starve the writer.
+ */
+#define MDKI_SEQ_T                      seqcount_t
+#define MDKI_SEQ_INIT(sp)               seqcount_init(sp)
+#define MDKI_SEQ_READ_BEGIN(sp)         read_seqcount_begin(sp)
+#define MDKI_SEQ_READ_RETRY(sp, seq)    read_seqcount_retry((sp), (seq))
+#define MDKI_SEQ_WRITE_BEGIN(sp) \
+    { preempt_disable(); write_seqcount_begin(sp); }
+#define MDKI_SEQ_WRITE_END(sp) \
+    { write_seqcount_end(sp); preempt_enable(); }
+
+/* RCU read sections, and waiting for all readers in them to finish.  Data
+ * a lockless reader may be looking at is only freed after MDKI_RCU_SYNC().
+ */
+#define MDKI_RCU_READ_LOCK()            rcu_read_lock()
+#define MDKI_RCU_READ_UNLOCK()          rcu_read_unlock()
+#define MDKI_RCU_SYNC()                 synchronize_rcu()
+
 #endif /* MVFS_MDEP_LINUX_H_ */
 /* $Id: 8b15523a.46fd11e3.8592.00:01:84:c3:8a:52 $ */
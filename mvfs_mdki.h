@@ -374,6 +374,7 @@ typedef struct semaphore mdki_sleeplock_t;
 #define MDKI_SLEEP_LOCK(semap) down(semap)
 #define MDKI_SLEEP_UNLOCK(semap) up(semap)
 #define MDKI_SLEEP_TRYLOCK(semap) down_trylock(semap)
+#define MDKI_SLEEP_LOCK_INTR(semap) down_interruptible(semap)
 
 # if LINUX_VERSION_CODE < KERNEL_VERSION(2,6,33)
 #   define MDKI_INIT_SLEEPLOCK(semap) init_MUTEX(semap)
@@ -572,6 +573,8 @@ mdki_set_ichg(
 
 #define REAL_KMEM_ALLOC(bsize,flag)  mdki_linux_kmalloc((bsize),(flag))
 #define REAL_KMEM_FREE(ptr,bsize)    mdki_linux_kfree((ptr),(bsize))
+#define REAL_KMEM_ALLOC_NODE(bsize,flag,node) \
+        mdki_linux_kmalloc_node((bsize),(flag),(node))
 
 #if LINUX_VERSION_CODE < KERNEL_VERSION(2,6,24)
 #define MVFS_KMEM_CACHE_T kmem_cache_t
@@ -582,6 +585,7 @@ mdki_set_ichg(
 #ifndef KMEMDEBUG
 
 #define KMEM_ALLOC(bsize,flag) REAL_KMEM_ALLOC(bsize,flag)
+#define KMEM_ALLOC_NODE(bsize,flag,node) REAL_KMEM_ALLOC_NODE(bsize,flag,node)
 #define KMEM_FREE(ptr,bsize)   { REAL_KMEM_FREE(ptr,bsize); (ptr) = NULL; }
 #define STRFREE(str)           { REAL_KMEM_FREE((str),0); (str) = NULL; }
 #define STRDUP(str)            mfs_strdup(str)
@@ -1138,6 +1142,21 @@ mdki_linux_kfree(
     void *ptr,
     size_t size
 );
+/* Like mdki_linux_kmalloc, but from the given NUMA node if possible. */
+extern void *
+mdki_linux_kmalloc_node(
+    size_t size,
+    int flag,
+    int node
+);
+
+extern int
+mdki_linux_numa_node_id(void);
+extern int
+mdki_linux_numa_node_count(void);
+
+#define MVFS_NUMA_NODE_ID() mdki_linux_numa_node_id()
+#define MVFS_NUMA_NODE_COUNT() mdki_linux_numa_node_count()
 
 extern void *
 mdki_memset(
@@ -1301,7 +1320,7 @@ mdki_linux_clnt_call(
     int procnum,
     void *args,
     void *results,
-    int rpctimeout,
+    int rpctimeout_ms,
 /*    MDKI_SIGMASK_T *holdsigs,*/
     bool_t intr,
     CRED_T *cred,
@@ -1469,6 +1488,65 @@ mdki_linux_free_substitute_cred(
 
 #define MVFS_SUBSTITUTE_CRED_IS_VALID(CDP) ((CDP) != NULL)
 
+/*
+ * Cleartext prefetch workers are run from a dedicated workqueue (see
+ * mvfs_linux_mdki.c).  MVFS_CTXT_PREFETCH_START returns non-zero if the
+ * worker could not be started; the caller then leaves the request queued.
+ */
+extern int
+mdki_linux_ctxt_prefetch_start(int slot);
+extern void
+mdki_linux_ctxt_prefetch_wait(void);
+
+#define MVFS_CTXT_PREFETCH_START(slot) mdki_linux_ctxt_prefetch_start(slot)
+#define MVFS_CTXT_PREFETCH_WAIT() mdki_linux_ctxt_prefetch_wait()
+
+/*
+ * Kernel shrinkers for the MVFS caches (see mvfs_shrink() in mvfs_mnode.c).
+ * They are registered once the caches exist and unregistered before any
+ * of them are torn down.
+ */
+extern void
+mdki_linux_register_shrinkers(void);
+extern void
+mdki_linux_unregister_shrinkers(void);
+
+#define MVFS_REGISTER_SHRINKERS() mdki_linux_register_shrinkers()
+#define MVFS_UNREGISTER_SHRINKERS() mdki_linux_unregister_shrinkers()
+
+/*
+ * The mnode freelist is trimmed from a work item (see mvfs_mnfreelist_mgmt
+ * in mvfs_mnode.c).  START returns 0 once the reclaimer is queued.
+ */
+extern int
+mdki_linux_freelist_reclaim_start(void);
+extern void
+mdki_linux_freelist_reclaim_stop(void);
+
+#define MVFS_MNFREELIST_RECLAIM_START() mdki_linux_freelist_reclaim_start()
+#define MVFS_MNFREELIST_RECLAIM_STOP() mdki_linux_freelist_reclaim_stop()
+
+/*
+ * Periodic maintenance tasks run from work items (see mvfs_maint_run in
+ * mvfs_vfsops.c).  START returns 0 once they are queued.
+ */
+extern int
+mdki_linux_maint_start(int ntasks);
+extern void
+mdki_linux_maint_stop(void);
+
+#define MVFS_MAINT_START(ntasks) mdki_linux_maint_start(ntasks)
+#define MVFS_MAINT_STOP() mdki_linux_maint_stop()
+
+/*
+ * The superblock hash NFS file handles carry (see vnlayer_decode_fh), so
+ * VOB mounts can be indexed by it.
+ */
+extern u_int
+mdki_linux_vfs_fhkey(VFS_T *vfsp);
+
+#define MVFS_VFS_FHKEY(vfsp) mdki_linux_vfs_fhkey(vfsp)
+
 /* Declare functions that will manipulate the thread structure when
  * initializing and releasing call data structures.
  */
@@ -1485,6 +1563,16 @@ mvfs_find_mount(
     void *data
 );
 
+extern void *
+mvfs_find_mount_fhkey(
+    u_int fhkey,
+    void *(* eval_func)(VFS_T *vfsp, void *data),
+    void *data
+);
+
+extern int
+mvfs_vget_valid(VNODE_T *vp);
+
 /* This is put here because it needs the definition of file_ctx. */
 
 extern int
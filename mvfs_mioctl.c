@@ -188,6 +188,13 @@ mvfs_read_dnc(
     CALL_DATA_T *cd
 );
 
+STATIC int MVFS_NOINLINE
+mvfs_read_dnc_bulk(
+    mvfscmd_block_t *data, 
+    MVFS_CALLER_INFO *callinfo,
+    CALL_DATA_T *cd
+);
+
 STATIC int MVFS_NOINLINE
 mvfs_get_loginfo(
     mvfscmd_block_t *data, 
@@ -1414,6 +1421,10 @@ mvfs_mioctl(
             error = mvfs_disable_pview_stat(data, cd, callinfo);
             break;
 
+        case MVFS_CMD_READ_DNC_BULK:
+            error = mvfs_read_dnc_bulk(data, callinfo, cd);
+            break;
+
  	default:
 	    error = ENOTTY;
 	    break;
@@ -2597,6 +2608,24 @@ mvfs_read_dnc(
     return(error);
 }
 
+STATIC int MVFS_NOINLINE
+mvfs_read_dnc_bulk(
+    mvfscmd_block_t *data, 
+    MVFS_CALLER_INFO *callinfo,
+    CALL_DATA_T *cd
+)
+{
+    int error;
+    mvfs_iodncbulk_t bulk;
+
+    if ((error = CopyInMvfs_iodncbulk(data->infop, &bulk, callinfo)) == 0)
+    {
+        if ((error = mvfs_dnc_getbulk(&bulk, cd)) == 0)
+            error = CopyOutMvfs_iodncbulk(&bulk, data->infop, callinfo);
+    }
+    return(error);
+}
+
 STATIC int MVFS_NOINLINE
 mvfs_get_loginfo(
     mvfscmd_block_t *data, 
@@ -2741,7 +2770,7 @@ mvfs_get_stats(
         }
     }
 
-    if ((error = CopyInMvfs_statbufs(data->infop,
+    if ((error = CopyInMvfs_statbufs(data->infop, data->infolen,
                                      mvfs_statbufsp, callinfo)) == 0)
     {
 
@@ -2857,6 +2886,24 @@ mvfs_get_stats(
                         (caddr_t)mvfs_statbufsp->viewophist.s,
                          mvfs_statbufsp->viewophist.m, callinfo);
         }
+        if (error == 0 && mvfs_statbufsp->viewenctime.s &&
+                 mvfs_statbufsp->viewenctime.m)
+        {
+            error = CopyOuttimestruc_array(output_sdp->mvfs_viewenctime,
+                        (caddr_t)mvfs_statbufsp->viewenctime.s,
+                        mfs_viewopmax,
+                        KS_MIN(mvfs_statbufsp->viewenctime.m,
+                            sizeof(timestruc_t)*mfs_viewopmax), callinfo);
+        }
+        if (error == 0 && mvfs_statbufsp->viewdectime.s &&
+                 mvfs_statbufsp->viewdectime.m)
+        {
+            error = CopyOuttimestruc_array(output_sdp->mvfs_viewdectime,
+                        (caddr_t)mvfs_statbufsp->viewdectime.s,
+                        mfs_viewopmax,
+                        KS_MIN(mvfs_statbufsp->viewdectime.m,
+                            sizeof(timestruc_t)*mfs_viewopmax), callinfo);
+        }
     }
     KMEM_FREE(output_sdp, sizeof(mvfs_stats_data_t));
     KMEM_FREE(mvfs_statbufsp, sizeof(*mvfs_statbufsp));
@@ -3454,6 +3501,7 @@ mvfs_addup_clntstat(
     mvfs_stats_data_t *sdp
 )
 {
+    int i;
 
 #define ADDUP_FIELD(field) sdp->mfs_clntstat.field +=  \
                                 percpu_sdp->mfs_clntstat.field
@@ -3473,6 +3521,16 @@ mvfs_addup_clntstat(
 
     mvfs_add_times(&(sdp->mfs_clntstat.mvfsthread_time),
                    &(percpu_sdp->mfs_clntstat.mvfsthread_time));
+    for (i = 0; i < MVFS_VWHLTH_NSTATES; i++) {
+        ADDUP_FIELD(vwhlthtrans[i]);
+    }
+    ADDUP_FIELD(vwhlthfastfail);
+    ADDUP_FIELD(vwhlthwait);
+    ADDUP_FIELD(vwhlthdetect);
+    ADDUP_FIELD(vwhlthrecover);
+    sdp->mfs_clntstat.vwhlthmaxrecover =
+        KS_MAX(sdp->mfs_clntstat.vwhlthmaxrecover,
+               percpu_sdp->mfs_clntstat.vwhlthmaxrecover);
     return;
 
 #undef ADDUP_FIELD
@@ -3484,6 +3542,8 @@ mvfs_addup_mnstat(
     mvfs_stats_data_t *sdp
 )
 {
+    int i;
+
 #define ADDUP_FIELD(field) sdp->mfs_mnstat.field +=  \
                                 percpu_sdp->mfs_mnstat.field
 
@@ -3501,6 +3561,18 @@ mvfs_addup_mnstat(
     ADDUP_FIELD(mnotherhashcnt);
     ADDUP_FIELD(mnflushvfscnt);
     ADDUP_FIELD(mnflushvwcnt);
+    ADDUP_FIELD(mnshrinkvobfree);
+    ADDUP_FIELD(mnshrinkcvpfree);
+    ADDUP_FIELD(mnshrinkdnc);
+    ADDUP_FIELD(mnshrinkrddir);
+    ADDUP_FIELD(mnfreelistpass);
+    ADDUP_FIELD(mnfreelistinline);
+    for (i = 0; i < MVFS_MAINT_NTASKS; i++) {
+        ADDUP_FIELD(mnmaintrun[i]);
+        ADDUP_FIELD(mnmaintbusy[i]);
+        ADDUP_FIELD(mnmaintlate[i]);
+        ADDUP_FIELD(mnmaintusec[i]);
+    }
 
     return;
 
@@ -3541,6 +3613,11 @@ mvfs_addup_clearstat(
     ADDUP_FIELD(clearreclaim);
     ADDUP_FIELD(clearreclaimmiss);
     ADDUP_FIELD(cleargetlkup);
+    ADDUP_FIELD(clearprefetch);
+    ADDUP_FIELD(clearprefetchdone);
+    ADDUP_FIELD(clearprefetchdrop);
+    ADDUP_FIELD(clearprefetcherr);
+    ADDUP_FIELD(clearprefetchhit);
 
     return;
 
@@ -3610,6 +3687,7 @@ mvfs_addup_dncstat(
     ADDUP_FIELD(dnc_missdir);
     ADDUP_FIELD(dnc_missreg);
     ADDUP_FIELD(dnc_missnoent);
+    ADDUP_FIELD(dnc_lookupshared);
 
     return;
 
@@ -3640,6 +3718,9 @@ mvfs_addup_acstat(
     ADDUP_FIELD(ac_lvutmiss);
     ADDUP_FIELD(ac_rddirhit);
     ADDUP_FIELD(ac_rddirmiss);
+    ADDUP_FIELD(ac_shared);
+    ADDUP_FIELD(ac_revalsame);
+    ADDUP_FIELD(ac_revalchanged);
 
     return;
 
@@ -3701,6 +3782,11 @@ mvfs_addup_eacstat(
     ADDUP_FIELD(eac_hits);
     ADDUP_FIELD(eac_misses);
     ADDUP_FIELD(eac_hashcnt);
+    ADDUP_FIELD(eac_dchits);
+    ADDUP_FIELD(eac_dcmisses);
+    ADDUP_FIELD(eac_evalusec);
+    ADDUP_FIELD(eac_fetches);
+    ADDUP_FIELD(eac_fetchwaits);
 
     return;
 
@@ -3785,6 +3871,10 @@ mvfs_addup_viewoptime(
         for (i = 0; i < VIEW_NUM_PROCS; i++) {
              mvfs_add_times(&(sdp->mfs_viewoptime[i]),
                             &(percpu_sdp->mfs_viewoptime[i]));
+             mvfs_add_times(&(sdp->mvfs_viewenctime[i]),
+                            &(percpu_sdp->mvfs_viewenctime[i]));
+             mvfs_add_times(&(sdp->mvfs_viewdectime[i]),
+                            &(percpu_sdp->mvfs_viewdectime[i]));
         }
 
         return;
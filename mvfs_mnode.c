@@ -25,6 +25,7 @@
 
 #include "mvfs_systm.h"
 #include "mvfs.h"
+#include "mvfs_dnc.h"
 
 /*
  * Prototypes for internal routines
@@ -120,6 +121,31 @@ mvfs_mnfreelist_mgmt(
     CALL_DATA_T *cd
 );
 
+STATIC void
+mvfs_mnfreelist_trim(
+    CALL_DATA_T *cd
+);
+
+STATIC int
+mvfs_mnflush_cvpfreelist_subr(
+    int type,
+    int count,
+    time_t purge_time,
+    int *cursorp,
+    CALL_DATA_T *cd
+);
+
+STATIC int
+mvfs_mnshrink_vobfreelist(
+    int nr,
+    int start,
+    int *cursorp,
+    CALL_DATA_T *cd
+);
+
+STATIC int
+mvfs_mnshrink_rddir(int nr);
+
 STATIC void
 mvfs_mnhash(mfs_mnode_t *mnp);
 
@@ -249,8 +275,9 @@ mvfs_mnode_data_t mvfs_mnode_data_var;
  *			and prev links in the mnode header.
  * mnode header lock	all offsets in the mnode header EXCEPT:
  *				next, prev, free_next, free_prev links,
+ *				dirty_next, dirty_prev links,
  *				hdr_lock itself (obviously), mfree flag,
- *				trans_destroy flag, on_destroy flag,
+ *				trans_destroy flag, on_destroy flag, on_dirty flag,
  *				stale, flag containing bits for cached_pages,
  *				clear_dirty, and clear_mmap, fid?XXX, vp, 
  *				realvp, viewvp, freelist_time.
@@ -264,6 +291,9 @@ mvfs_mnode_data_t mvfs_mnode_data_var;
  * mvfs_mndestroylock	mvfs_mndestroy, the free_next and free_prev links in the
  *			mnode header (when on mvfs_mndestroy), the 
  *			on_destroy flag, and mvfs_mndestroycnt.
+ * mvfs_mndirtylock	mvfs_mndirtylist, the dirty_next and dirty_prev links
+ *			in the mnode header, the on_dirty flag, and
+ *			mvfs_mndirtycnt.
  * mnode lock		has not been altered, it is still used to lock the
  *			content of the type-specific mnode and 1 field
  *			in the mnode header: stale flag
@@ -341,6 +371,13 @@ mvfs_mnode_data_t mvfs_mnode_data_var;
  * And the mvfs_mndestroylock is taken to ensure the integrity of the
  * destroy list chain (mvfs_mndestroylist) and it's associated counter.
  * 
+ * The mvfs_mndirtylock is taken to ensure the integrity of the dirty list
+ * chain (mvfs_mndirtylist) and its counter.  A VOB mnode is appended to the
+ * dirty list when cached_pages is set (see MVFS_MN_SET_CACHED_PAGES) and
+ * stays there until a sync finds it clean or it is destroyed, so the cost
+ * of mvfs_mnsyncmnodes follows the number of dirty files rather than the
+ * size of the vob hash table.
+ * 
  *
  * Lock Ordering
  * We used to use 1 large-grained lock for the entire mnode cache.  This
@@ -351,6 +388,11 @@ mvfs_mnode_data_t mvfs_mnode_data_var;
  * The lock order is:
  * hash_chain->mnode_header->mfs_mnlock->mvfs_vobfreehash chain->mfs_mnstat
  *             mnode_header->            mvfs_vobfreehash chain->mvfs_mndestroylock->mfs_mnstat
+ *                                     mnode->mvfs_mndirtylock
+ *
+ * The sync pass holds the mvfs_mndirtylock while it pins mnodes, but it only
+ * uses NOWAIT/CONDITIONAL_LOCK on the header, vobfreehash and mnode locks, so
+ * it cannot deadlock against the order above.
  *
  * Intermediate steps in the lock order can be skipped.
  * 
@@ -429,8 +471,8 @@ mvfs_mnode_data_t mvfs_mnode_data_var;
 				* keep ratio same as in static array */
 #define MFS_VOBOTHER_RATIO 8   /* estimated ratio of:
 				* (# vobhash entries) / (# "other" entries) */
-#define MVFS_FLS_BFSZ_FACTOR 10/* used to calculate mnp buffer size when 
-				* sync'ing. */
+#define MVFS_FLS_BFSZ_FACTOR 10/* used to calculate the number of mnodes
+				* pinned per batch when sync'ing. */
 #define MVFS_DEFAULT_MNPLIST_SIZE (MFS_MNVOB_AVECHAIN * MVFS_FLS_BFSZ_FACTOR)
 
 /* 
@@ -529,6 +571,7 @@ mvfs_mnode_data_t mvfs_mnode_data_var;
  */
 
 #define MVFS_VOBFREEHASHMIN 16	   /* min vobfree hash size */
+#define MVFS_VOBFREE_MINRUN 4	   /* min vobfree chains per NUMA node run */
 #define MVFS_VOBFREEHASHMAX 1024   /* max vobfree hash size, corresponding 
 				    * largeinit is about 100 */
 #define MVFS_MNVOBFREE_AVECHAIN 200/* average chain length for vob hash */
@@ -548,10 +591,23 @@ mvfs_mnode_data_t mvfs_mnode_data_var;
 #define MNVOBFREEHASH_MVFS_UNLOCK(lockpp) { \
 	MVFS_UNLOCK(*(lockpp)); }
 
-/* vob free hash algorithm */
+/* 
+ * vob free hash algorithm
+ *
+ * The vobfree hash is split into mvfs_vobfree_nruns runs of consecutive
+ * chains, one per NUMA node slot, so mnodes from the same node are kept
+ * together and reclaim can pick the local node's mnodes first.  Within
+ * a run the mnum picks the chain as before.
+ */
 
+#define MVFS_VOBFREEHASH_RUNSIZE(dp) \
+	((dp)->mvfs_vobfreehashsize / (dp)->mvfs_vobfree_nruns)
+#define MVFS_VOBFREEHASH_RUN(dp, slot) \
+	((u_int)(slot) & ((dp)->mvfs_vobfree_nruns-1))
 #define MVFS_VOBFREEHASH(dp, mnp) \
-	((u_int)((mnp)->mn_hdr.mnum & ((dp)->mvfs_vobfreehashsize-1)))
+	((u_int)(MVFS_VOBFREEHASH_RUN(dp, (mnp)->mn_hdr.numa_node) * \
+		 MVFS_VOBFREEHASH_RUNSIZE(dp) + \
+		 ((mnp)->mn_hdr.mnum & (MVFS_VOBFREEHASH_RUNSIZE(dp)-1))))
 
 /* 
  * Freelist hash macros insert at the end of the hashed free list pointed to
@@ -584,6 +640,7 @@ mvfs_mnode_data_t mvfs_mnode_data_var;
 	(mnp)->mn_hdr.mfree = 1; \
 	MVFS_LOCK(&(dp)->mvfs_vobfreelock); \
 	(dp)->mvfs_vobfreecnt++; \
+	(dp)->mvfs_vobfreecnt_node[(mnp)->mn_hdr.numa_node]++; \
 	if ((mnp)->mn_hdr.realvp) \
 	    (dp)->mvfs_cvpfreecnt++; \
 	MVFS_UNLOCK(&(dp)->mvfs_vobfreelock); \
@@ -603,6 +660,7 @@ mvfs_mnode_data_t mvfs_mnode_data_var;
 	    DEBUG_ASSERT((dp)->mvfs_cvpfreecnt != ((u_long) -1)); \
 	} \
 	(dp)->mvfs_vobfreecnt--; \
+	(dp)->mvfs_vobfreecnt_node[(mnp)->mn_hdr.numa_node]--; \
 	DEBUG_ASSERT((dp)->mvfs_vobfreecnt != ((u_long) -1)); \
 	MVFS_UNLOCK(&((dp)->mvfs_vobfreelock)); \
 	(mnp)->mn_hdr.mfree = 0; \
@@ -667,6 +725,34 @@ mvfs_mnode_data_t mvfs_mnode_data_var;
 	DEBUG_ASSERT((dp)->mvfs_mndestroycnt != ((u_long) -1)); \
     }
 
+/* 
+ * Dirty list macros.  Both must be called with the mvfs_mndirtylock held.
+ */
+
+#define MN_INSDIRTY(dp, mnp) { \
+	register mfs_mnode_t *DLP;	\
+	DEBUG_ASSERT(ISLOCKEDBYME(&((dp)->mvfs_mndirtylock))); \
+	DEBUG_ASSERT((mnp)->mn_hdr.on_dirty == 0); \
+	DLP = (dp)->mvfs_mndirtylist.mn_hdr.dirty_prev; \
+	(mnp)->mn_hdr.dirty_next = (DLP)->mn_hdr.dirty_next; \
+	(mnp)->mn_hdr.dirty_prev = (DLP); \
+	(DLP)->mn_hdr.dirty_next->mn_hdr.dirty_prev = (mnp); \
+	(DLP)->mn_hdr.dirty_next = (mnp); \
+	(mnp)->mn_hdr.on_dirty = 1; \
+	(dp)->mvfs_mndirtycnt++; \
+    }
+
+#define MN_RMDIRTY(dp, mnp) { \
+	DEBUG_ASSERT(ISLOCKEDBYME(&((dp)->mvfs_mndirtylock))); \
+	DEBUG_ASSERT((mnp)->mn_hdr.on_dirty == 1); \
+	(mnp)->mn_hdr.dirty_next->mn_hdr.dirty_prev = (mnp)->mn_hdr.dirty_prev; \
+	(mnp)->mn_hdr.dirty_prev->mn_hdr.dirty_next = (mnp)->mn_hdr.dirty_next; \
+	(mnp)->mn_hdr.dirty_next = (mnp)->mn_hdr.dirty_prev = NULL; \
+	(mnp)->mn_hdr.on_dirty = 0; \
+	(dp)->mvfs_mndirtycnt--; \
+	DEBUG_ASSERT((dp)->mvfs_mndirtycnt != ((u_long) -1)); \
+    }
+
 /*
  * Mnode-related tuning formulae
  */
@@ -697,6 +783,7 @@ mvfs_mninit(mvfs_cache_sizes_t *mma_sizes)
     mvfs_common_data_t *mcdp = MDKI_COMMON_GET_DATAP();
     mvfs_mnode_data_t *mndp;
     int err;
+    int i;
 
     MDKI_MNODE_ALLOC_DATA();
     mndp = MDKI_MNODE_GET_DATAP();
@@ -709,11 +796,18 @@ mvfs_mninit(mvfs_cache_sizes_t *mma_sizes)
     mndp->mvfs_otherhash = NULL;
     mndp->mvfs_vobfreehashsize = MVFS_VOBFREEHASHMIN;
     mndp->mvfs_vobfreehash = NULL;
+    mndp->mvfs_vobfree_nruns = 1;
     mndp->mvfs_mnfreelist_mgmt_ip = 0;
+    mndp->mvfs_mnfreelist_reclaim_queued = 0;
+    for (i = 0; i < MVFS_NUMA_MAXNODES; i++)
+	mndp->mvfs_vobfree_cursor[i] = 0;
+    mndp->mvfs_cvpflush_cursor = 0;
+    mndp->mvfs_rddir_blkcnt = 0;
 
     INITLOCK(&(mndp->mfs_mnlock), "mfs_mnlk");
     INITLOCK(&(mndp->mvfs_vobfreelock), "mfs_vfl");
     INITLOCK(&(mndp->mvfs_mndestroylock), "mfs_dl");
+    INITLOCK(&(mndp->mvfs_mndirtylock), "mfs_dty");
 
     mndp->mfs_mncnt = 1;	/* We never take slot 0 */
 
@@ -737,11 +831,9 @@ mvfs_mninit(mvfs_cache_sizes_t *mma_sizes)
 				 * (we don't use slot 0) */
 
     /*
-     * Initialize the recommended size to start with for the mnplist used in 
-     * mvfs_sync_mnodes.  The average hash chain is targetted to have
-     * only MFS_MNVOB_AVECHAIN (4) items, start with a buffer 10 times this. 
+     * Allocate the batch buffer used by mvfs_mnsyncmnodes to hold the
+     * mnodes it has pinned while the mvfs_mndirtylock is dropped.
      */
-    mndp->mvfs_rec_fls_bufsz = MVFS_DEFAULT_MNPLIST_SIZE;
     mndp->mvfs_default_mnplist = 
         (mfs_mnode_t **)KMEM_ALLOC(MVFS_DEFAULT_MNPLIST_SIZE * sizeof(mfs_mnode_t *), 
 					 KM_SLEEP);
@@ -766,6 +858,12 @@ mvfs_mninit(mvfs_cache_sizes_t *mma_sizes)
 			(mfs_mnode_t *)&(mndp->mvfs_mndestroylist);
     mndp->mvfs_mndestroycnt = 0;
 
+    /* Initialize the mvfs_mndirty list */
+    mndp->mvfs_mndirtylist.mn_hdr.dirty_next = 
+		mndp->mvfs_mndirtylist.mn_hdr.dirty_prev =
+			(mfs_mnode_t *)&(mndp->mvfs_mndirtylist);
+    mndp->mvfs_mndirtycnt = 0;
+
     mvfs_rddir_cache_init(mma_sizes);
 
     /* Initialize mnode generation to something reasonable */
@@ -792,6 +890,14 @@ mvfs_mndata_free(void)
     mvfs_mnode_data_t *mndp = MDKI_MNODE_GET_DATAP();
     mvfs_common_data_t *mcdp = MDKI_COMMON_GET_DATAP();
 
+    /*
+     * Everything that can put mnodes on the freelist (and so queue the
+     * background reclaimer, see mvfs_mnfreelist_mgmt()) has been torn
+     * down by now, so cancel and wait out the reclaimer before the
+     * freelist it works on goes away.
+     */
+    MVFS_MNFREELIST_RECLAIM_STOP();
+
     /* 
      * Free vobhash table memory, if it was dynamically allocated and
      * the associated lock pool
@@ -848,6 +954,7 @@ mvfs_mndata_free(void)
 	KMEM_FREE(mndp->mnum_to_mnode, sizeof(mfs_mnode_t *)*mcdp->mvfs_mnmax);
 	mndp->mnum_to_mnode = NULL;
 
+	FREELOCK(&(mndp->mvfs_mndirtylock));
 	FREELOCK(&(mndp->mvfs_mndestroylock));
 	FREELOCK(&(mndp->mvfs_vobfreelock));
 	FREELOCK(&(mndp->mfs_mnlock));
@@ -1138,6 +1245,21 @@ mvfs_mninit_vobfreehash(mvfs_cache_sizes_t *mma_sizes)
 				(mfs_mnode_t *)&(mndp->mvfs_vobfreehash[i]);
     }
     mndp->mvfs_vobfreecnt = 0;
+    for (i = 0; i < MVFS_NUMA_MAXNODES; i++)
+	mndp->mvfs_vobfreecnt_node[i] = 0;
+
+    /*
+     * One run of chains per NUMA node slot, as long as every run still
+     * gets a few chains.
+     */
+    mndp->mvfs_vobfree_nruns = 1;
+    while (mndp->mvfs_vobfree_nruns < MVFS_NUMA_NODE_COUNT() &&
+	   mndp->mvfs_vobfree_nruns < MVFS_NUMA_MAXNODES &&
+	   (mndp->mvfs_vobfreehashsize / (mndp->mvfs_vobfree_nruns * 2)) >=
+							MVFS_VOBFREE_MINRUN)
+    {
+	mndp->mvfs_vobfree_nruns *= 2;
+    }
 
     /* Initialize the vobfreemax and min. */
     MVFS_SIZE_DEFLOAD_NONZERO(mcdp->mvfs_vobfreemax, mma_sizes, VOBFREEMAX,
@@ -1862,6 +1984,7 @@ int mnum;
     mnp->mn_hdr.mfree = 0;		/* not on the free list */
     mnp->mn_hdr.trans_destroy = 0;	/* not transitioning to destroy list */
     mnp->mn_hdr.on_destroy = 0;		/* not on the destroy list */
+    mnp->mn_hdr.on_dirty = 0;		/* not on the dirty list */
 
     /* Do class dependent init */
 
@@ -1882,6 +2005,11 @@ int mnum;
 	    return (0);
 	}
 	BZERO(mnp->mn_ramdir.ents, len);
+	if (mvfs_ramdir_hashinit(mnp) != 0) {
+	    KMEM_FREE(mnp->mn_ramdir.ents, len);
+	    mnp->mn_ramdir.ents = NULL;
+	    return (0);
+	}
 	mnp->mn_ramdir.atime.tv_sec = MDKI_CTIME();
 	mnp->mn_ramdir.mtime.tv_sec = MDKI_CTIME();
 	mnp->mn_ramdir.ctime.tv_sec = MDKI_CTIME();
@@ -1892,6 +2020,13 @@ int mnum;
       case MFS_VIEWCLAS:
       case MFS_NTVWCLAS:
 	INITLOCK(STAMPLOCK_ADDR(mnp), MAKESNAME(name, STAMPLOCK_PREFIX, mnum));
+	MDKI_SEQ_INIT(&(mnp->mn_view.stampseq));
+	mnp->mn_view.vobstamps = NULL;
+	INITSPLOCK(mnp->mn_view.hlthlock, "mvfs_vwhlth_spl");
+	INITLOCK(HLTHPROBE_ADDR(mnp), MAKESNAME(name, HLTHPROBE_PREFIX, mnum));
+	mnp->mn_view.hlthstate = MVFS_VWHLTH_HEALTHY;
+	mnp->mn_view.hlthsince = 0;
+	mnp->mn_view.hlthnext = 0;
 	mnp->mn_view.pvstat =
 	    (struct mvfs_pvstat *)KMEM_ALLOC(
 					sizeof(*mnp->mn_view.pvstat),
@@ -1903,6 +2038,13 @@ int mnum;
         MVFS_PVAC_STATLOCK_INIT(mnp->mn_view.pvstat->mvfs_pvac_statlock);
         MVFS_PVDNC_STATLOCK_INIT(mnp->mn_view.pvstat->mvfs_pvdnc_statlock);
 	mvfs_pview_stat_zero(mnp->mn_view.pvstat);
+	/* Without RTT estimates, view calls just use the mount's timeouts. */
+	INITSPLOCK(mnp->mn_view.rttlock, "mvfs_vwrtt_spl");
+	mnp->mn_view.rtt = (struct mvfs_rttest *)KMEM_ALLOC(
+			    VIEW_NUM_PROCS * sizeof(*mnp->mn_view.rtt), KM_SLEEP);
+	if (mnp->mn_view.rtt != NULL) {
+	    BZERO(mnp->mn_view.rtt, VIEW_NUM_PROCS * sizeof(*mnp->mn_view.rtt));
+	}
 	break;
       case MFS_VOBRTCLAS:
 	break;
@@ -2087,6 +2229,17 @@ mvfs_mndestroy(
     mvfs_mnunhash(mnp);	
     ASSERT(mnp->mn_hdr.next == NULL);
     ASSERT(mnp->mn_hdr.prev == NULL);
+
+    /*
+     * And off the dirty list.  A sync pass may be looking at it, but it
+     * will skip it because on_destroy is set, and it cannot free it.
+     */
+    if (mnp->mn_hdr.on_dirty) {
+	MVFS_LOCK(&(mndp->mvfs_mndirtylock));
+	if (mnp->mn_hdr.on_dirty)
+	    MN_RMDIRTY(mndp, mnp);
+	MVFS_UNLOCK(&(mndp->mvfs_mndirtylock));
+    }
     MVFS_LOCK(&(mndp->mfs_mnlock));
     MFS_MN_FREE_SLOT(mndp, mnp->mn_hdr.mnum);
     MVFS_UNLOCK(&(mndp->mfs_mnlock));
@@ -2187,6 +2340,7 @@ mvfs_mnclean(
 	    if (mnp->mn_ramdir.ents)
 		KMEM_FREE(mnp->mn_ramdir.ents, len);
 	    mnp->mn_ramdir.ents = NULL;
+	    mvfs_ramdir_hashfree(mnp);
 	    len = mnp->mn_ramdir.export_hwm * sizeof(int);
 	    if (mnp->mn_ramdir.export_ents)
 		KMEM_FREE(mnp->mn_ramdir.export_ents, len);
@@ -2197,7 +2351,10 @@ mvfs_mnclean(
 	case MFS_NTVWCLAS:
 	    mfs_svrdestroy(&mnp->mn_view.svr);
 	    if (mnp->mn_view.viewname) PN_STRFREE(mnp->mn_view.viewname);
+	    mvfs_viewdir_free_vobstamps(mnp);
 	    FREELOCK(STAMPLOCK_ADDR(mnp)); /* Free lock resources */
+	    FREELOCK(HLTHPROBE_ADDR(mnp));
+	    FREESPLOCK(mnp->mn_view.hlthlock);
 	    if (mnp->mn_view.pvstat != NULL) {
                 /*
                  * It would be good to have an ASSERT statement here to assert
@@ -2216,6 +2373,12 @@ mvfs_mnclean(
 		KMEM_FREE(mnp->mn_view.pvstat, sizeof(*mnp->mn_view.pvstat));
 		mnp->mn_view.pvstat = NULL;
 	    }
+	    if (mnp->mn_view.rtt != NULL) {
+		KMEM_FREE(mnp->mn_view.rtt,
+			  VIEW_NUM_PROCS * sizeof(*mnp->mn_view.rtt));
+		mnp->mn_view.rtt = NULL;
+	    }
+	    FREESPLOCK(mnp->mn_view.rttlock);
 	    MVFS_FREE_ID(&mnp->mn_view.cuid);
 	    MVFS_FREE_ID(&mnp->mn_view.cgid);
 	    break;
@@ -2310,16 +2473,134 @@ mvfs_mnfree(
 
 /*
  * MVFS_MNFREELIST_MGMT - manage the mnode freelist.
+ *
+ * This is called on the mnode release path, so it only checks the high
+ * water marks and, if one has been crossed, hands the trimming to the
+ * background reclaimer (see mvfs_mnfreelist_reclaim) and returns.  Only
+ * on ports without a background reclaimer is the trimming done here.
  */
 
 STATIC void
 mvfs_mnfreelist_mgmt(
     CALL_DATA_T *cd
 )
+{
+    mvfs_mnode_data_t *mndp = MDKI_MNODE_GET_DATAP();
+    mvfs_common_data_t *mcdp = MDKI_COMMON_GET_DATAP();
+
+    MVFS_LOCK(&(mndp->mvfs_vobfreelock));
+    if ((mndp->mvfs_cvpfreecnt <= mcdp->mvfs_cvpfreemax && 
+	 mndp->mvfs_vobfreecnt <= mcdp->mvfs_vobfreemax) ||
+	mndp->mvfs_mnfreelist_reclaim_queued)
+    {
+	MVFS_UNLOCK(&(mndp->mvfs_vobfreelock));
+	return;
+    }
+    mndp->mvfs_mnfreelist_reclaim_queued = 1;
+    MVFS_UNLOCK(&(mndp->mvfs_vobfreelock));
+
+    if (MVFS_MNFREELIST_RECLAIM_START() == 0)
+	return;
+
+    /* No background reclaimer, do it the old way. */
+    MVFS_LOCK(&(mndp->mvfs_vobfreelock));
+    mndp->mvfs_mnfreelist_reclaim_queued = 0;
+    MVFS_UNLOCK(&(mndp->mvfs_vobfreelock));
+    BUMPSTAT(mfs_mnstat.mnfreelistinline);
+    mvfs_mnfreelist_trim(cd);
+}
+
+/*
+ * MVFS_MNFREELIST_RECLAIM - one pass of the background freelist reclaimer.
+ *
+ * Once started by mvfs_mnfreelist_mgmt() (because a high water mark was
+ * crossed), the reclaimer takes the vob freelist and the cleartexts held
+ * on it back down to their low water marks.  Each pass destroys at most
+ * MVFS_MNFREELIST_QUANTUM mnodes and releases at most as many cleartext
+ * vnodes, resuming at the hash chain where the previous pass stopped.
+ * Returns non-zero if there is more to do; the port then runs another
+ * pass when it gets around to it, so no one caller pays for a large
+ * batch and other work gets a turn in between.
+ */
+#define MVFS_MNFREELIST_QUANTUM 64
+
+int
+mvfs_mnfreelist_reclaim(
+    CALL_DATA_T *cd
+)
+{
+    int vobf_count, cvp_count;
+    int run, run_size, run_start, next;
+    int done = 0;
+    mvfs_mnode_data_t *mndp = MDKI_MNODE_GET_DATAP();
+    mvfs_common_data_t *mcdp = MDKI_COMMON_GET_DATAP();
+
+    MVFS_LOCK(&(mndp->mvfs_vobfreelock));
+    /* Watermarks can be changed on line, so be ready for odd values. */
+    vobf_count = (mndp->mvfs_vobfreecnt > mcdp->mvfs_vobfreemin) ?
+		 mndp->mvfs_vobfreecnt - mcdp->mvfs_vobfreemin : 0;
+    cvp_count = (mndp->mvfs_cvpfreecnt > mcdp->mvfs_cvpfreemin) ?
+		mndp->mvfs_cvpfreecnt - mcdp->mvfs_cvpfreemin : 0;
+    MVFS_UNLOCK(&(mndp->mvfs_vobfreelock));
+
+    BUMPSTAT(mfs_mnstat.mnfreelistpass);
+
+    /*
+     * mnodes first, since freeing mnodes may drop the cleartexts that
+     * must be freed.  Start in this node's run of chains (as
+     * mvfs_mnfreelist_trim() does), resuming where the last pass on this
+     * node left off; the walk only goes on to other nodes' runs once
+     * ours has nothing left.
+     */
+    if (vobf_count > 0) {
+	if (vobf_count > MVFS_MNFREELIST_QUANTUM)
+	    vobf_count = MVFS_MNFREELIST_QUANTUM;
+	run = MVFS_VOBFREEHASH_RUN(mndp, MVFS_NUMA_SLOT(MVFS_NUMA_NODE_ID()));
+	run_size = MVFS_VOBFREEHASH_RUNSIZE(mndp);
+	run_start = run * run_size;
+	done += mvfs_mnshrink_vobfreelist(vobf_count,
+				run_start +
+				    mndp->mvfs_vobfree_cursor[run] % run_size,
+				&next, cd);
+	mndp->mvfs_vobfree_cursor[run] =
+	    (next + mndp->mvfs_vobfreehashsize - run_start) %
+						mndp->mvfs_vobfreehashsize;
+    }
+    if (cvp_count > 0) {
+	if (cvp_count > MVFS_MNFREELIST_QUANTUM)
+	    cvp_count = MVFS_MNFREELIST_QUANTUM;
+	done += mvfs_mnflush_cvpfreelist_subr(MVFS_MN_CVPFLUSH_COUNT,
+					      cvp_count, MDKI_CTIME(),
+					      &(mndp->mvfs_cvpflush_cursor), cd);
+    }
+
+    MVFS_LOCK(&(mndp->mvfs_vobfreelock));
+    if (done == 0 ||
+	(mndp->mvfs_vobfreecnt <= mcdp->mvfs_vobfreemin &&
+	 mndp->mvfs_cvpfreecnt <= mcdp->mvfs_cvpfreemin))
+    {
+	/* Down to the low water marks, or nothing more we can free. */
+	mndp->mvfs_mnfreelist_reclaim_queued = 0;
+	MVFS_UNLOCK(&(mndp->mvfs_vobfreelock));
+	return 0;
+    }
+    MVFS_UNLOCK(&(mndp->mvfs_vobfreelock));
+    return 1;
+}
+
+/*
+ * MVFS_MNFREELIST_TRIM - trim the freelist to the low water marks in one go.
+ */
+
+STATIC void
+mvfs_mnfreelist_trim(
+    CALL_DATA_T *cd
+)
 {
     mfs_mnode_t *mnp;
     int vobf_count, vobf_npc;
-    int i, j;
+    int i, j, k, pass, nchains;
+    int run_start, run_size;
     LOCK_T *flplockp;
     mfs_mnode_t *hp;
     mvfs_mnode_data_t *mndp = MDKI_MNODE_GET_DATAP();
@@ -2363,10 +2644,20 @@ mvfs_mnfreelist_mgmt(
      * Something needs "freeing".  Check for mnodes first, since
      * freeing mnodes may drop the cleartexts that must be freed.
      * Go through each vobfree hash chain and remove vobf_npc items from it.
+     * When the freelist is split by NUMA node, the local node's chains
+     * are done first and then again with everyone else's, so the memory
+     * given back is preferably memory this node will be allocating from.
      */
+    run_size = MVFS_VOBFREEHASH_RUNSIZE(mndp);
+    run_start = MVFS_VOBFREEHASH_RUN(mndp,
+				     MVFS_NUMA_SLOT(MVFS_NUMA_NODE_ID())) *
+								run_size;
 
-    for (i = 0; i < mndp->mvfs_vobfreehashsize; i++) {
-	for (j = 0; j < vobf_npc; j++) {
+    for (pass = (mndp->mvfs_vobfree_nruns > 1) ? 0 : 1; pass < 2; pass++) {
+      nchains = (pass == 0) ? run_size : mndp->mvfs_vobfreehashsize;
+      for (k = 0; k < nchains && vobf_count > 0; k++) {
+	i = (run_start + k) % mndp->mvfs_vobfreehashsize;
+	for (j = 0; j < vobf_npc && vobf_count > 0; j++) {
 
 
 	    /* Lock the hash chain. */
@@ -2402,7 +2693,9 @@ mvfs_mnfreelist_mgmt(
 	    MNVOBFREEHASH_MVFS_UNLOCK(&flplockp);
 
 	    MN_INSDESTROY(mndp, mnp);
+	    vobf_count--;
 	}
+      }
     }
 
     /*
@@ -2429,18 +2722,7 @@ void
 mvfs_mnflush_cvpfreelist(int type,
                          CALL_DATA_T *cd)
 {
-
-    mfs_mnode_t *mnp;
     int count;
-    int orig_count;
-    int count_per_chain;	/* max # of cvp's to remove from a hash chain */
-    int cur_cpc;		/* Current count per chain */
-    int cvpcnt;
-    int hash_num;		/* hash chain number */
-    LOCK_T *hash_lockp;		/* pointer to the mutex lock for a given hash */
-    mfs_mnode_t *hp;		
-    CLR_VNODE_T **cvplist;
-    CLR_VNODE_T *stack_cvplist[MVFS_STK_FREEQLEN];
     time_t purge_time;
     mvfs_mnode_data_t *mndp = MDKI_MNODE_GET_DATAP();
     mvfs_common_data_t *mcdp = MDKI_COMMON_GET_DATAP();
@@ -2472,12 +2754,45 @@ mvfs_mnflush_cvpfreelist(int type,
     }
     MVFS_UNLOCK(&(mndp->mvfs_vobfreelock));
 
+    (void) mvfs_mnflush_cvpfreelist_subr(type, count, purge_time, NULL, cd);
+}
+
+/*
+ * Release up to count cleartext vnodes held by mnodes on the vob freelist.
+ * The type decides how the count is spread over the hash chains (and, for
+ * MVFS_MN_CVPFLUSH_AGED, which mnodes qualify).  If cursorp is not NULL,
+ * the walk starts at chain *cursorp and the chain to start at next time is
+ * stored back there.  Returns the number of cleartext vnodes released.
+ */
+STATIC int
+mvfs_mnflush_cvpfreelist_subr(
+    int type,
+    int count,
+    time_t purge_time,
+    int *cursorp,
+    CALL_DATA_T *cd
+)
+{
+    mfs_mnode_t *mnp;
+    int orig_count;
+    int count_per_chain;	/* max # of cvp's to remove from a hash chain */
+    int cur_cpc;		/* Current count per chain */
+    int cvpcnt;
+    int nflushed;
+    int n, start;
+    int hash_num;		/* hash chain number */
+    LOCK_T *hash_lockp;		/* pointer to the mutex lock for a given hash */
+    mfs_mnode_t *hp;		
+    CLR_VNODE_T **cvplist;
+    CLR_VNODE_T *stack_cvplist[MVFS_STK_FREEQLEN];
+    mvfs_mnode_data_t *mndp = MDKI_MNODE_GET_DATAP();
+
     /* 
      * Check limits first before allocating memory, etc.
      */
-    if (count == 0) {
+    if (count <= 0) {
 	/* cvpfreecnt must have been 0 (AGED/ALL), or 1 (HALF) */
-	return;
+	return 0;
     }
 
     if ((cvplist = (CLR_VNODE_T **)KMEM_ALLOC(sizeof(CLR_VNODE_T *) * count, 
@@ -2498,6 +2813,7 @@ mvfs_mnflush_cvpfreelist(int type,
     /* Determine how many cvps to flush from each hash chain. */
     switch(type) {
 	case MVFS_MN_CVPFLUSH_HALF:
+	case MVFS_MN_CVPFLUSH_COUNT:
 	    /* Calculate the average number of cvps to take
 	     * from each hash chain and round up since there
 	     * won't be a perfect distribution on every hash 
@@ -2523,9 +2839,11 @@ mvfs_mnflush_cvpfreelist(int type,
 	    break;
     }
     cvpcnt = 0;
+    start = (cursorp != NULL) ? *cursorp % mndp->mvfs_vobfreehashsize : 0;
 
-    /* Run through every vobfree hash chain */
-    for (hash_num = 0; hash_num < mndp->mvfs_vobfreehashsize; hash_num++) {
+    /* Run through every vobfree hash chain, until we have enough */
+    for (n = 0; n < mndp->mvfs_vobfreehashsize && count > 0; n++) {
+	hash_num = (start + n) % mndp->mvfs_vobfreehashsize;
 
 	/* Lock the specific vob hash chain */
 	MNVOBFREEHASH_MVFS_LOCK(mndp, hash_num, &hash_lockp);
@@ -2579,22 +2897,32 @@ mvfs_mnflush_cvpfreelist(int type,
 	        }
 #endif
 
-		MVFS_LOCK(&(mndp->mvfs_vobfreelock));
-		mndp->mvfs_cvpfreecnt--;
-		MVFS_UNLOCK(&(mndp->mvfs_vobfreelock));
 		if (mnp->mn_vob.cleartext.nm) {	/* Free cltxt name too! */
 		   PN_STRFREE(mnp->mn_vob.cleartext.nm);
 		}
 		MVFS_RELEASE_CREDLIST(mnp);
 	    }
 	}
+	/*
+	 * Account for this chain's releases in one go.  This must be done
+	 * before the chain lock is dropped: MN_RMFREE, which also adjusts
+	 * the count, looks at realvp under this lock.
+	 */
+	if (cur_cpc != 0) {
+	    MVFS_LOCK(&(mndp->mvfs_vobfreelock));
+	    mndp->mvfs_cvpfreecnt -= cur_cpc;
+	    MVFS_UNLOCK(&(mndp->mvfs_vobfreelock));
+	}
 	MNVOBFREEHASH_MVFS_UNLOCK(&hash_lockp);
     }
+    if (cursorp != NULL)
+	*cursorp = (start + n) % mndp->mvfs_vobfreehashsize;
 
     /* 
      * Now that we don't have any of the vobfree hash locks, we can VN_RELE 
      * the vnode ptrs we took out of the mnodes.
      */
+    nflushed = cvpcnt;
     while (--cvpcnt >= 0) {
 	CVN_RELE(cvplist[cvpcnt], cd);
     }
@@ -2602,7 +2930,186 @@ mvfs_mnflush_cvpfreelist(int type,
     if (cvplist != &stack_cvplist[0])
 	KMEM_FREE(cvplist, (sizeof(CLR_VNODE_T *) * orig_count));
 
-    return;
+    return nflushed;
+}
+
+/*
+ * Kernel memory pressure support.
+ *
+ * The freelist watermarks (mvfs_vobfreemax/min, mvfs_cvpfreemax/min) are
+ * fixed at init, or by mvfs_set_cache_sizes, and freelist management only
+ * trims back to them.  On ports that can tell us when the system is short
+ * of memory (Linux shrinkers, see mvfs_linux_mdki.c) the kernel can also
+ * ask for objects back below the low watermarks.  mvfs_shrink_count() and
+ * mvfs_shrink() are the port independent halves of that.  They only ever
+ * release objects nobody references, so they are always safe to call (but
+ * not from a context that can't sleep, or one holding MVFS locks).
+ */
+
+int
+mvfs_shrink_count(int cache)
+{
+    mvfs_mnode_data_t *mndp = MDKI_MNODE_GET_DATAP();
+
+    /* These are hints, so no locks. */
+    switch (cache) {
+      case MVFS_SHRINK_VOBFREE:
+	return (int)mndp->mvfs_vobfreecnt;
+      case MVFS_SHRINK_CVPFREE:
+	return (int)mndp->mvfs_cvpfreecnt;
+      case MVFS_SHRINK_DNC:
+	return mvfs_dnc_shrink_count();
+      case MVFS_SHRINK_RDDIR:
+	return (int)mndp->mvfs_rddir_blkcnt;
+      default:
+	return 0;
+    }
+}
+
+int
+mvfs_shrink(
+    int cache,
+    int nr,
+    CALL_DATA_T *cd
+)
+{
+    int freed = 0;
+    mvfs_mnode_data_t *mndp = MDKI_MNODE_GET_DATAP();
+
+    if (nr <= 0)
+	return 0;
+
+    switch (cache) {
+      case MVFS_SHRINK_VOBFREE:
+	freed = mvfs_mnshrink_vobfreelist(nr,
+		    MVFS_VOBFREEHASH_RUN(mndp,
+					 MVFS_NUMA_SLOT(MVFS_NUMA_NODE_ID())) *
+					MVFS_VOBFREEHASH_RUNSIZE(mndp),
+		    NULL, cd);
+	BUMPSTAT_VAL(mfs_mnstat.mnshrinkvobfree, freed);
+	break;
+      case MVFS_SHRINK_CVPFREE:
+	freed = mvfs_mnflush_cvpfreelist_subr(MVFS_MN_CVPFLUSH_COUNT, nr,
+					      MDKI_CTIME(), NULL, cd);
+	BUMPSTAT_VAL(mfs_mnstat.mnshrinkcvpfree, freed);
+	break;
+      case MVFS_SHRINK_DNC:
+	freed = mvfs_dnc_shrink(nr, cd);
+	BUMPSTAT_VAL(mfs_mnstat.mnshrinkdnc, freed);
+	break;
+      case MVFS_SHRINK_RDDIR:
+	freed = mvfs_mnshrink_rddir(nr);
+	BUMPSTAT_VAL(mfs_mnstat.mnshrinkrddir, freed);
+	break;
+      default:
+	break;
+    }
+    return freed;
+}
+
+/*
+ * Destroy up to nr mnodes from the vob freelist, oldest first.  This is
+ * mvfs_mnfreelist_trim() without the watermarks: the chains are visited
+ * round robin from chain start, taking from the head (LRU end) of each,
+ * until nr have been taken or the freelist is empty.  If cursorp is not
+ * NULL, the chain after the last one taken from is stored there.
+ */
+STATIC int
+mvfs_mnshrink_vobfreelist(
+    int nr,
+    int start,
+    int *cursorp,
+    CALL_DATA_T *cd
+)
+{
+    mfs_mnode_t *mnp;
+    mfs_mnode_t *hp;
+    LOCK_T *flplockp;
+    int i, j, k, npc, taken, progress;
+    mvfs_mnode_data_t *mndp = MDKI_MNODE_GET_DATAP();
+
+    /*
+     * If freelist management is already running, let it finish; it is
+     * freeing mnodes too.
+     */
+    MVFS_LOCK(&(mndp->mvfs_vobfreelock));
+    if (mndp->mvfs_mnfreelist_mgmt_ip == 1 || mndp->mvfs_vobfreecnt == 0) {
+	MVFS_UNLOCK(&(mndp->mvfs_vobfreelock));
+	return 0;
+    }
+    mndp->mvfs_mnfreelist_mgmt_ip = 1;
+    MVFS_UNLOCK(&(mndp->mvfs_vobfreelock));
+
+    npc = (nr / mndp->mvfs_vobfreehashsize) + 1;
+    start = start % mndp->mvfs_vobfreehashsize;
+    i = start;
+    taken = 0;
+    do {
+	progress = 0;
+	for (k = 0; k < mndp->mvfs_vobfreehashsize && taken < nr; k++) {
+	    i = (start + k) % mndp->mvfs_vobfreehashsize;
+	    for (j = 0; j < npc && taken < nr; j++) {
+		MNVOBFREEHASH_MVFS_LOCK(mndp, i, &flplockp);
+		hp = (mfs_mnode_t *)&(mndp->mvfs_vobfreehash[i]);
+		mnp = hp->mn_hdr.free_next;
+		if (mnp == hp) {
+		    MNVOBFREEHASH_MVFS_UNLOCK(&flplockp);
+		    break;
+		}
+		/* See mvfs_mnfreelist_mgmt() */
+		mnp->mn_hdr.trans_destroy = 1;
+		MN_RMFREE(mndp, flplockp, mnp);
+		MNVOBFREEHASH_MVFS_UNLOCK(&flplockp);
+
+		MN_INSDESTROY(mndp, mnp);
+		taken++;
+		progress++;
+	    }
+	}
+    } while (progress != 0 && taken < nr);
+
+    if (cursorp != NULL)
+	*cursorp = (i + 1) % mndp->mvfs_vobfreehashsize;
+
+    mvfs_mndestroy_list(cd);
+
+    MVFS_LOCK(&(mndp->mvfs_vobfreelock));
+    mndp->mvfs_mnfreelist_mgmt_ip = 0;
+    MVFS_UNLOCK(&(mndp->mvfs_vobfreelock));
+
+    return taken;
+}
+
+/*
+ * Free readdir cache blocks held by mnodes on the vob freelist, until at
+ * least nr blocks are gone or every chain has been looked at.  Active
+ * mnodes are left alone; their caches go when they are inactivated and
+ * eventually destroyed.
+ */
+STATIC int
+mvfs_mnshrink_rddir(int nr)
+{
+    mfs_mnode_t *mnp;
+    mfs_mnode_t *hp;
+    LOCK_T *flplockp;
+    int i;
+    int freed = 0;
+    mvfs_mnode_data_t *mndp = MDKI_MNODE_GET_DATAP();
+
+    for (i = 0; i < mndp->mvfs_vobfreehashsize && freed < nr; i++) {
+	MNVOBFREEHASH_MVFS_LOCK(mndp, i, &flplockp);
+	hp = (mfs_mnode_t *)&(mndp->mvfs_vobfreehash[i]);
+	for (mnp = hp->mn_hdr.free_next;
+	     mnp != hp && freed < nr;
+	     mnp = mnp->mn_hdr.free_next)
+	{
+	    ASSERT(MFS_ISVOB(mnp));
+	    /* No MLOCK needed, see mvfs_rddir_cache_reclaim() */
+	    freed += mvfs_rddir_cache_reclaim(mnp);
+	}
+	MNVOBFREEHASH_MVFS_UNLOCK(&flplockp);
+    }
+    return freed;
 }
 
 /*
@@ -2673,6 +3180,7 @@ void
 mvfs_mn_count(usage)
 mvfs_cache_usage_t *usage;
 {
+    int i;
     mvfs_mnode_data_t *mndp = MDKI_MNODE_GET_DATAP();
     mvfs_common_data_t *mcdp = MDKI_COMMON_GET_DATAP();
 
@@ -2684,6 +3192,15 @@ mvfs_cache_usage_t *usage;
 
     usage->cache_usage[MVFS_CACHE_INUSE][MVFS_CACHE_CTFREE] = mndp->mvfs_cvpfreecnt;
     usage->cache_usage[MVFS_CACHE_MAX][MVFS_CACHE_CTFREE] = mcdp->mvfs_cvpfreemax;
+
+    usage->cache_usage[MVFS_CACHE_INUSE][MVFS_CACHE_NUMA_NODES] =
+	(MVFS_NUMA_NODE_COUNT() < MVFS_NUMA_MAXNODES) ?
+	    MVFS_NUMA_NODE_COUNT() : MVFS_NUMA_MAXNODES;
+    usage->cache_usage[MVFS_CACHE_MAX][MVFS_CACHE_NUMA_NODES] = MVFS_NUMA_MAXNODES;
+    for (i = 0; i < MVFS_NUMA_MAXNODES; i++) {
+	usage->cache_usage[MVFS_CACHE_INUSE][MVFS_CACHE_MFREE_NODE(i)] =
+					mndp->mvfs_vobfreecnt_node[i];
+    }
 }
 
 /*
@@ -3225,14 +3742,18 @@ mvfs_mnallocatemnode(
 
     mfs_mnode_t *mnp;
     VNODE_T *vp;
+    int node;
     /*
      * Vnode allocated separately from mnode in VNO_ALLOC system.
      * mn_hdr.vp will be filled in by makenode call
      */
     vp = NULL; 
-    mnp = (mfs_mnode_t *)KMEM_ALLOC(msize, MNODE_ALLOC_FLAG);
+    /* Take the memory from the node of the CPU that wants the mnode. */
+    node = MVFS_NUMA_NODE_ID();
+    mnp = (mfs_mnode_t *)KMEM_ALLOC_NODE(msize, MNODE_ALLOC_FLAG, node);
     if (mnp) {
 	BZERO(mnp, msize);
+	mnp->mn_hdr.numa_node = MVFS_NUMA_SLOT(node);
     }
 
     return(mnp);
@@ -3307,11 +3828,36 @@ mvfs_mn_compute_caches(
     return(0);
 }
 
+/*
+ * MVFS_MNDIRTY_ADD - append a VOB mnode whose cached_pages bit has just been
+ * set to the dirty list, if it is not already there.  Called with the mnode
+ * locked (see MVFS_MN_SET_CACHED_PAGES).
+ */
+void
+mvfs_mndirty_add(mfs_mnode_t *mnp)
+{
+    mvfs_mnode_data_t *mndp = MDKI_MNODE_GET_DATAP();
+
+    if (!MFS_ISVOB(mnp) || mnp->mn_hdr.on_dirty)
+	return;
+
+    MVFS_LOCK(&(mndp->mvfs_mndirtylock));
+    if (!mnp->mn_hdr.on_dirty && !mnp->mn_hdr.on_destroy)
+	MN_INSDIRTY(mndp, mnp);
+    MVFS_UNLOCK(&(mndp->mvfs_mndirtylock));
+}
+
 /*
  * MVFS_MNSYNCMNODES - locate all mnodes that match the vfsp (a NULL vfsp 
  * selects all) and need to be sync'ed (VOB mnodes with cached_pages), and 
  * flush them.
  * Called from sync().  Bypasses "locked" mnodes!
+ *
+ * Only the dirty list is walked.  Each entry visited is rotated to the tail,
+ * and we stop once we have visited as many entries as were on the list when
+ * we started, so mnodes added during the pass and mnodes we skip are simply
+ * picked up by the next sync.  Entries leave the list in mvfs_sync_mnode
+ * once they are clean, or in mvfs_mndestroy.
  */
 void
 mvfs_mnsyncmnodes(
@@ -3319,20 +3865,19 @@ mvfs_mnsyncmnodes(
     CALL_DATA_T *cd
 )
 {
-
-    int hash_num;		/* hash chain number */
-    LOCK_T *hash_lockp;		/* pointer to the mutex lock for a given hash */
     mfs_mnode_t *hp;		
     register mfs_mnode_t *mnp;
     mfs_mnode_t **mnplist;
+    u_long todo;
     int count;
-    int num_alloc;
     int f_hash_val;
     LOCK_T *flplockp;
     int i;
-    int increased_size = 0;	/* flag if allocated larger buffer */
     mvfs_mnode_data_t *mndp = MDKI_MNODE_GET_DATAP();
-    mvfs_common_data_t *mcdp = MDKI_COMMON_GET_DATAP();
+
+    /* Nothing cached anywhere, nothing to do. */
+    if (mndp->mvfs_mndirtycnt == 0)
+	return;
 
     /* Only allow 1 sync at a time.  Protected by mvfs_mnlock.  */
     MVFS_LOCK(&(mndp->mfs_mnlock));
@@ -3346,144 +3891,96 @@ mvfs_mnsyncmnodes(
     MVFS_UNLOCK(&(mndp->mfs_mnlock));
 
     /*
-     * Allocate a list of pointers to the mnodes (selected below) that need
-     * to be flushed.  Since we are covered by the mvfs_sync_in_progress
-     * flag, we can use a common buffer in the default case.  That is allocated
-     * at inititialization time so we don't need to worry about dealing with
-     * allocation failures.  The default buffer is 10 times as large 
-     * as the expected average hash chain length to accomodate uneven hash 
-     * chains.  If this is ever found to be too small, we will allocate a
-     * larger buffer.  If memory is not available we will use the smaller 
-     * buffer.
+     * Since we are covered by the mvfs_sync_in_progress flag, we can use the
+     * common batch buffer allocated at initialization time.
      */
-    num_alloc = mndp->mvfs_rec_fls_bufsz;
-    if (mndp->mvfs_mnplist_toosmall == 0) {
-        mnplist = mndp->mvfs_default_mnplist;
-    } else {
-        mnplist = (mfs_mnode_t **)KMEM_ALLOC(num_alloc * sizeof(*mnplist), KM_SLEEP);
-        if (mnplist == NULL) {
-            /* if we cannot get memory for bigger list, use default */
-            mnplist = mndp->mvfs_default_mnplist;
-	    num_alloc = MVFS_DEFAULT_MNPLIST_SIZE;
-        }
-    }
+    mnplist = mndp->mvfs_default_mnplist;
+    hp = (mfs_mnode_t *)&(mndp->mvfs_mndirtylist);
 
-    /* Run through every vob hash chain */
-    for (hash_num = 0; hash_num < mndp->mvfs_vobhashsize; hash_num++) {
+    MVFS_LOCK(&(mndp->mvfs_mndirtylock));
+    todo = mndp->mvfs_mndirtycnt;
 
-	/* Lock the specific vob hash chain */
-	MNVOBHASH_MVFS_LOCK(mndp, hash_num, &hash_lockp);
-	hp = (mfs_mnode_t *)&(mndp->mvfs_vobhash[hash_num]);
+    while (todo > 0 && (mnp = hp->mn_hdr.dirty_next) != hp) {
 
-	/* 
-	 * Search every entry on the hash chain.  Compile a list of mnodes
-	 * that need to be flushed, and ensure they stay around until we 
-	 * flush them.
+	/*
+	 * Pin up to a batch of mnodes that need to be flushed, and ensure
+	 * they stay around until we flush them.
 	 */
-	for (mnp = hp->mn_hdr.next, count = 0; 
-	     mnp != hp && count < num_alloc; 
-	     mnp = mnp->mn_hdr.next) 
+	for (count = 0;
+	     todo > 0 && count < MVFS_DEFAULT_MNPLIST_SIZE &&
+	     (mnp = hp->mn_hdr.dirty_next) != hp;
+	     todo--)
 	{
+	    /* Rotate to the tail whether or not we take it this time. */
+	    MN_RMDIRTY(mndp, mnp);
+	    MN_INSDIRTY(mndp, mnp);
 
-	    if (((vfsp == NULL) || (mnp->mn_hdr.vfsp == vfsp)) &&
-		(mnp->mn_hdr.cached_pages) && (MFS_ISVOB(mnp)))
+	    if (((vfsp != NULL) && (mnp->mn_hdr.vfsp != vfsp)) ||
+		!(mnp->mn_hdr.cached_pages))
 	    {
-		/*
-		 * Have found a likely mnode.  If we can't get the lock, bypass
-		 * this mnode for now (it can be sync'ed next time).
-		 */
-		if (!MHDRLOCK_NOWAIT(mnp)) {
-		    continue;
-		}
+		continue;
+	    }
 
-		/* Skip this mnode if its already on the destroy list */
-		if (mnp->mn_hdr.on_destroy) {
-		    MHDRUNLOCK(mnp);
-		    continue;
-		}
+	    /*
+	     * Have found a likely mnode.  If we can't get the lock, bypass
+	     * this mnode for now (it can be sync'ed next time).
+	     */
+	    if (!MHDRLOCK_NOWAIT(mnp)) {
+		continue;
+	    }
 
-		/*
-		 * VOB mnodes may be on the freelist.  Skip this mnode if is
-		 * is on the freelist but transitioning to the destroy list.
-		 */
-		f_hash_val = MVFS_VOBFREEHASH(mndp, mnp);
-		MVFS_LOCK_SELECT(&(mndp->mvfs_vobfreehash_mlp), f_hash_val,
-				 HASH_MVFS_LOCK_MAP, &flplockp);
-		if (!CONDITIONAL_LOCK((flplockp))) {
-		    MHDRUNLOCK(mnp);
-		    continue;
-		}
-		if (mnp->mn_hdr.trans_destroy) {
-		    MNVOBFREEHASH_MVFS_UNLOCK(&flplockp);
-		    MHDRUNLOCK(mnp);
-		    continue;
-		}
+	    /* Skip this mnode if its already on the destroy list */
+	    if (mnp->mn_hdr.on_destroy) {
+		MHDRUNLOCK(mnp);
+		continue;
+	    }
 
-		/* Remove this mnode from the freelist, if there. */
-		if (mnp->mn_hdr.mfree) {
-		    /* Update refcnt and VOB freelist */
-		    MN_RMFREE(mndp, flplockp, mnp);
-		}
+	    /*
+	     * VOB mnodes may be on the freelist.  Skip this mnode if is
+	     * is on the freelist but transitioning to the destroy list.
+	     */
+	    f_hash_val = MVFS_VOBFREEHASH(mndp, mnp);
+	    MVFS_LOCK_SELECT(&(mndp->mvfs_vobfreehash_mlp), f_hash_val,
+			     HASH_MVFS_LOCK_MAP, &flplockp);
+	    if (!CONDITIONAL_LOCK((flplockp))) {
+		MHDRUNLOCK(mnp);
+		continue;
+	    }
+	    if (mnp->mn_hdr.trans_destroy) {
 		MNVOBFREEHASH_MVFS_UNLOCK(&flplockp);
-
-		/* 
-		 * Try to lock the mnode, increment its use count, and unlock.
-		 */
-		if (!MLOCK_NOWAIT(mnp)) {
-		    MHDRUNLOCK(mnp);
-		    /* XXX this leaves an mnode taken off the freelist that
-		     * really still needs to be sync'ed XXX what to do? 
-		     * should we just wait for the header lock?  We wait for
-		     * other locks. */
-		    continue;
-		}
-		mnp->mn_hdr.mcount++;
 		MHDRUNLOCK(mnp);
+		continue;
+	    }
 
-		/*
-		 * Now that we have a locked mnode that needs to be flushed,
-		 * put it in the list to flush once we have released the
-		 * hash chain lock.
-		 */
-		mnplist[count++] = mnp;
-
-		if (count == num_alloc) {
-
-		    /* Can't handle any more mnodes from this hash chain in 
-		     * the mplist.  Setup to double the size of the mplist 
-		     * buffer for the next sync (if we haven't already done it
-		     * in this call to sync).
-		     */
-		    mndp->mvfs_mnplist_toosmall++;
-		    if (!increased_size) {
-			mndp->mvfs_rec_fls_bufsz = mndp->mvfs_rec_fls_bufsz * 2;
-			/* But shouldn't need to be above mvfs_mnmax */
-			if (mndp->mvfs_rec_fls_bufsz > mcdp->mvfs_mnmax)
-			    mndp->mvfs_rec_fls_bufsz = mcdp->mvfs_mnmax;
-			increased_size = 1;
-		    }
+	    /* Remove this mnode from the freelist, if there. */
+	    if (mnp->mn_hdr.mfree) {
+		/* Update refcnt and VOB freelist */
+		MN_RMFREE(mndp, flplockp, mnp);
+	    }
+	    MNVOBFREEHASH_MVFS_UNLOCK(&flplockp);
 
-		    /*
-		     * Check to see if count is already at mvfs_mnmax.
-		     * This would indicate a problem.  It would mean every
-		     * possible mnode (actually every possible mnode+1 since 
-		     * the 0 offset in mnum_to_mnode table is not used) is on 
-		     * this one hash chain, they are all dirty, and we may not 
-		     * be done with the loop yet.  
-		     */
-		    if (count == mcdp->mvfs_mnmax) 
-			mvfs_log(MFS_LOG_WARN, "sync: mvfs_mnmax mnodes found on 1 hash chain (hash chain = 0x%x\n", 
-				 hash_num);
-		    continue;
-		}
+	    /* 
+	     * Try to lock the mnode, increment its use count, and unlock.
+	     */
+	    if (!MLOCK_NOWAIT(mnp)) {
+		MHDRUNLOCK(mnp);
+		/* XXX this leaves an mnode taken off the freelist that
+		 * really still needs to be sync'ed XXX what to do? 
+		 * should we just wait for the header lock?  We wait for
+		 * other locks. */
+		continue;
 	    }
+	    mnp->mn_hdr.mcount++;
+	    MHDRUNLOCK(mnp);
+
+	    mnplist[count++] = mnp;
 	}
 
-	/* And unlock the hash chain to allow better concurrency */
-	MNVOBHASH_MVFS_UNLOCK(&hash_lockp);
+	/* And unlock the dirty list to allow better concurrency */
+	MVFS_UNLOCK(&(mndp->mvfs_mndirtylock));
 
 	/*
-	 * Now have all the mnodes that need to be flushed in mnplist,
+	 * Now have a batch of mnodes that need to be flushed in mnplist,
 	 * and each is locked.  Now we need to flush them.
 	 */
 	for (i = 0; i < count; i++) {
@@ -3491,11 +3988,9 @@ mvfs_mnsyncmnodes(
 	    mvfs_sync_mnode(mnplist[i], cd);
 	}
 
+	MVFS_LOCK(&(mndp->mvfs_mndirtylock));
     }
-
-    /* Free the buffer allocated to hold the mnode pointers. */
-    if (mnplist != mndp->mvfs_default_mnplist)
-        KMEM_FREE(mnplist, num_alloc * sizeof(*mnplist));
+    MVFS_UNLOCK(&(mndp->mvfs_mndirtylock));
 
     /* Only allow 1 sync at a time.  Protected by mvfs_mnlock.  */
     MVFS_LOCK(&(mndp->mfs_mnlock));
@@ -3518,6 +4013,7 @@ mvfs_sync_mnode(mfs_mnode_t *mnp,
     VNODE_T *vp;
     CRED_T *cred;
     int error;
+    mvfs_mnode_data_t *mndp = MDKI_MNODE_GET_DATAP();
 
     ASSERT (mnp != 0);
 
@@ -3561,6 +4057,17 @@ mvfs_sync_mnode(mfs_mnode_t *mnp,
     /* Flush MFS vnode first (with mnode unlocked).  */
     (void) PVN_FLUSH(vp, MFS_PVN_FLUSH, cd);
 
+    /*
+     * If that left no cached pages, take the mnode off the dirty list while
+     * we still hold the vnode.  MVFS_MN_SET_CACHED_PAGES puts it back.
+     */
+    if (!mnp->mn_hdr.cached_pages && mnp->mn_hdr.on_dirty) {
+	MVFS_LOCK(&(mndp->mvfs_mndirtylock));
+	if (!mnp->mn_hdr.cached_pages && mnp->mn_hdr.on_dirty)
+	    MN_RMDIRTY(mndp, mnp);
+	MVFS_UNLOCK(&(mndp->mvfs_mndirtylock));
+    }
+
     /* Release hold on cred */
     MDKI_CRFREE(cred);
 	 
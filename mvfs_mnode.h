@@ -113,8 +113,21 @@ typedef struct mvfs_mnode_data
 
     u_long mvfs_vobfreecnt;	   /* Count of mnodes on freelist */
     u_long mvfs_cvpfreecnt;	   /* Count of "cached" held vnodes in freelist */
+    u_long mvfs_rddir_blkcnt;	   /* Count of blocks in all readdir caches */
+    /* Count of mnodes on freelist per NUMA node slot */
+    u_long mvfs_vobfreecnt_node[MVFS_NUMA_MAXNODES];
+    /*
+     * Number of runs the vobfree hash is split into, one per NUMA node
+     * slot (a power of 2, fixed at init).  See MVFS_VOBFREEHASH.
+     */
+    int mvfs_vobfree_nruns;
 /* XXX no longer initialized to 0 here -- in mninit, OK? */
     int mvfs_mnfreelist_mgmt_ip;   /* Flag: freelist reduction in progress */
+    /* Flag: background freelist reclaimer has been started and not finished */
+    int mvfs_mnfreelist_reclaim_queued;
+    /* Per run: chain within the run the reclaimer resumes mnodes at */
+    int mvfs_vobfree_cursor[MVFS_NUMA_MAXNODES];
+    int mvfs_cvpflush_cursor;	   /* Chain the reclaimer resumes cvps at */
 
     /* Cleartext aging */
     time_t mvfs_nt_age_cvp_time;   /* Time to age cleartext */
@@ -129,16 +142,16 @@ typedef struct mvfs_mnode_data
     u_long mvfs_mndestroycnt;	  /* Count of entries on mndestroy list */
 
     /*
-     * Recommended buffer size used for sync'ing mnodes.  This size starts at
-     * MVFS_FLS_BUFSZ_FACTOR (10) times the size of the expected average hash 
-     * chain length.  It is automatically doubled whenever we detect it is too
-     * small, up to a maximum of mvfs_mnmax.
+     * The mnode dirty list.  See mvfs_mnode.c for full details.
      */
-    long mvfs_rec_fls_bufsz;	  /* Size of buffer to use for mnplist in sync */
-    				  /* Default buffer for mnplist in sync */
+
+    LOCK_T mvfs_mndirtylock;	  /* Control access to mvfs_mndirty list & cnt */
+
+    mvfs_mndirtylist_t  mvfs_mndirtylist;
+    u_long mvfs_mndirtycnt;	  /* Count of entries on mndirty list */
+
+    				  /* Batch buffer for mnplist in sync */
     mfs_mnode_t ** mvfs_default_mnplist;  
-    u_long mvfs_mnplist_toosmall; /* # of times needed mnplist was too small for
-				   * a hash chain during sync. */
 
 } mvfs_mnode_data_t;
 
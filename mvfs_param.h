@@ -197,12 +197,33 @@ EXTERN PARAM_TYPE mvfs_dncnoentmax;
  *                              will force access time of that file to be 
  *                              updated (keeps scrubber informed of access 
  *                              regardless of cleartext filesystem caching)  
+ * mvfs_ctxt_prefetch:          Activate the cleartext of VOB files in the
+ *                              background after lookup (0 off, 1 on).
+ * mvfs_ctxt_prefetch_threads:  Max number of cleartext prefetch workers.
+ * mvfs_ctxt_prefetch_view_max: Max number of prefetches queued per view.
+ * mvfs_ctxt_prefetch_qmax:     Max number of prefetches queued in all.
  * mvfs_expected_zone_count:    Number of Non-Global Zones(NGZ) that can be
  *                              expected on a Solaris host which supports
  *                              NGZ.
  * mvfs_pview_stat_enabled:     Tunable to enable or disable per-view statistics
  *                              collection.  Per-view statistics collection is
  *                              turned off by default.
+ * mvfs_procpurge_interval:     Time (in seconds) between purges of dead
+ *                              processes' MVFS state.
+ * mvfs_credlist_interval:      Time (in seconds) between trims of the
+ *                              cleartext cred list.
+ * mvfs_cleanhm_interval:       Time (in seconds) between scans for idle
+ *                              history-mode views.
+ * mvfs_view_health_policy:     What view calls do while another call probes
+ *                              a view server that stopped answering; one of
+ *                              the MVFS_VWHLTH_POLICY_* values.
+ * mvfs_view_down_interval:     Time (in seconds) between probes of a view
+ *                              server that gave no reply.
+ * mvfs_rpc_adaptive_timeo:     Base view RPC retransmit timeouts on measured
+ *                              round trip times, per view and per op.
+ * mvfs_rpc_rto_min:            Floor (in milliseconds) for adaptive timeouts.
+ * mvfs_rpc_rto_max:            Ceiling (in milliseconds) for adaptive
+ *                              timeouts, or 0 for the mount's timeout.
  */
 
 EXTERN PARAM_TYPE mvfs_max_rpcdelay;
@@ -215,8 +236,20 @@ EXTERN PARAM_TYPE mvfs_client_cache_size;
 EXTERN PARAM_TYPE mvfs_rddir_blocks;
 EXTERN PARAM_TYPE mvfs_threadhash_sz;
 EXTERN PARAM_TYPE mvfs_ctxt_atime_refresh;
+EXTERN PARAM_TYPE mvfs_ctxt_prefetch;
+EXTERN PARAM_TYPE mvfs_ctxt_prefetch_threads;
+EXTERN PARAM_TYPE mvfs_ctxt_prefetch_view_max;
+EXTERN PARAM_TYPE mvfs_ctxt_prefetch_qmax;
 
 EXTERN PARAM_TYPE mvfs_pview_stat_enabled;
+EXTERN PARAM_TYPE mvfs_procpurge_interval;
+EXTERN PARAM_TYPE mvfs_credlist_interval;
+EXTERN PARAM_TYPE mvfs_cleanhm_interval;
+EXTERN PARAM_TYPE mvfs_view_health_policy;
+EXTERN PARAM_TYPE mvfs_view_down_interval;
+EXTERN PARAM_TYPE mvfs_rpc_adaptive_timeo;
+EXTERN PARAM_TYPE mvfs_rpc_rto_min;
+EXTERN PARAM_TYPE mvfs_rpc_rto_max;
 
 #undef PARAM_TYPE
 /* leave MVFS_PARAM_TYPE visible for other users */
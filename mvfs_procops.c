@@ -56,6 +56,13 @@ STATIC int mvfs_purgechain(
 STATIC void mvfs_procpurge_afps(P_NONE);
 STATIC unsigned int mvfs_pidhash(MVFS_PROCID_T *pidp);
 STATIC mvfs_thread_t *mvfs_mythread_subr(MVFS_THREADID_T *threadid_in);
+STATIC int mvfs_threadcache_init(mvfs_common_data_t *mcdp);
+STATIC void mvfs_threadcache_free(mvfs_common_data_t *mcdp);
+STATIC void mvfs_threadcache_set(
+  mvfs_common_data_t *mcdp,
+  unsigned int bucket,
+  mvfs_thread_t *mth
+);
 
 #ifdef MVFS_USE_SPLIT_ORDERED_HASH
 STATIC mvfs_thread_t *mvfs_mythread_subr_sohash(MVFS_THREADID_T *threadid_in);
@@ -112,7 +119,12 @@ EXTERN int mvfs_lockless_thrhash_enabled;
  *
  * (e) All mvfs_thread_t's are chained into a hash table by
  * mvfs_thread_t.thr_hashnxt.  Operations on the thread hash table
- * are protected by a pool of spin locks.
+ * are protected by a pool of spin locks.  Each bucket also has a
+ * one-entry cache (mvfs_threadid_cache) of the last thread found on
+ * it, which mvfs_mythread() checks without taking the bucket lock.
+ * The cache entry is only changed under the bucket lock, and it is
+ * cleared before a thread is unhashed, so a hit can never return a
+ * thread that mvfs_threadrele() has already let go of.
  *
  * (f) Some system threads must not block in paging contexts.  In case
  * they ever get into this code, their thread and process structures
@@ -262,6 +274,64 @@ extern int mvfs_maxnproc;
         SPLOCK_SELECT(&(_mcdp->proc_thr.mvfs_threadid_spl_pool), hash_val, HASH_SPLOCK_MAP, lockpp); \
         SPUNLOCK(**(lockpp), st); }
 
+/*
+ * Allocate/free the per-bucket thread cache.  It has the same number of
+ * entries as mvfs_threadid_hashtable and uses the same splock pool.
+ */
+STATIC int
+mvfs_threadcache_init(mvfs_common_data_t *mcdp)
+{
+    u_long len;
+    int i;
+
+    len = sizeof(mvfs_thread_cache_t) * MVFS_THREADHASH_SZ(mcdp);
+    mcdp->proc_thr.mvfs_threadid_cache =
+                        (mvfs_thread_cache_t *)KMEM_ALLOC(len, KM_SLEEP);
+    if (mcdp->proc_thr.mvfs_threadid_cache == NULL) {
+        mvfs_log(MFS_LOG_ERR, "mvfs_procinit: no memory (threadcache)");
+        return ENOMEM;
+    }
+    BZERO(mcdp->proc_thr.mvfs_threadid_cache, len);
+    for (i = 0; i < MVFS_THREADHASH_SZ(mcdp); i++)
+        MDKI_SEQ_INIT(&mcdp->proc_thr.mvfs_threadid_cache[i].tc_seq);
+    return 0;
+}
+
+STATIC void
+mvfs_threadcache_free(mvfs_common_data_t *mcdp)
+{
+    if (mcdp->proc_thr.mvfs_threadid_cache != NULL) {
+        KMEM_FREE(mcdp->proc_thr.mvfs_threadid_cache,
+                  sizeof(mvfs_thread_cache_t) * MVFS_THREADHASH_SZ(mcdp));
+        mcdp->proc_thr.mvfs_threadid_cache = NULL;
+    }
+}
+
+/*
+ * Point a bucket's cache entry at mth (or empty it if mth is NULL).
+ * Caller must hold the bucket's THREADID_SPLOCK.
+ */
+STATIC void
+mvfs_threadcache_set(
+    mvfs_common_data_t *mcdp,
+    unsigned int bucket,
+    mvfs_thread_t *mth
+)
+{
+    mvfs_thread_cache_t *tcp = &mcdp->proc_thr.mvfs_threadid_cache[bucket];
+
+    if (tcp->tc_thread == mth)
+        return;
+    MDKI_SEQ_WRITE_BEGIN(&tcp->tc_seq);
+    if (mth != NULL) {
+        tcp->tc_threadid = mth->thr_threadid;
+        tcp->tc_procid = mth->thr_proc->mp_procid;
+        tcp->tc_proctag = mth->thr_proc->mp_proctag;
+    }
+    tcp->tc_thread = mth;
+    MDKI_SEQ_WRITE_END(&tcp->tc_seq);
+}
+
 #ifndef MVFS_SYSTEM_KMEM
 struct mvfs_slab_list *mvfs_thread_slabs;
 struct mvfs_slab_list *mvfs_proc_slabs;
@@ -346,6 +416,10 @@ mvfs_procinit(mvfs_cache_sizes_t *mma_sizes)
                 KMEM_FREE(mcdp->proc_thr.mvfs_threadid_hashtable,
                           sizeof(mvfs_thread_t *)*MVFS_THREADHASH_SZ(mcdp));
                 error = ENOMEM;
+            } else if ((error = mvfs_threadcache_init(mcdp)) != 0) {
+                mvfs_splock_pool_free(&(mcdp->proc_thr.mvfs_threadid_spl_pool));
+                KMEM_FREE(mcdp->proc_thr.mvfs_threadid_hashtable,
+                          sizeof(mvfs_thread_t *)*MVFS_THREADHASH_SZ(mcdp));
             }
         }
     }
@@ -371,6 +445,10 @@ mvfs_procinit(mvfs_cache_sizes_t *mma_sizes)
             KMEM_FREE(mcdp->proc_thr.mvfs_threadid_hashtable,
                       sizeof(mvfs_thread_t *)*MVFS_THREADHASH_SZ(mcdp));
             error = ENOMEM;
+        } else if ((error = mvfs_threadcache_init(mcdp)) != 0) {
+            mvfs_splock_pool_free(&(mcdp->proc_thr.mvfs_threadid_spl_pool));
+            KMEM_FREE(mcdp->proc_thr.mvfs_threadid_hashtable,
+                      sizeof(mvfs_thread_t *)*MVFS_THREADHASH_SZ(mcdp));
         }
     }
 #endif /* MVFS_USE_SPLIT_ORDERED_HASH */
@@ -394,10 +472,12 @@ mvfs_procinit(mvfs_cache_sizes_t *mma_sizes)
                              "error = %u\n", error);
                 }
             } else {
+                mvfs_threadcache_free(mcdp);
                 KMEM_FREE(mcdp->proc_thr.mvfs_threadid_hashtable,
                           sizeof(mvfs_thread_t *)*MVFS_THREADHASH_SZ(mcdp));
             }
 #else
+            mvfs_threadcache_free(mcdp);
             KMEM_FREE(mcdp->proc_thr.mvfs_threadid_hashtable,
                       sizeof(mvfs_thread_t *)*MVFS_THREADHASH_SZ(mcdp));
 #endif /* MVFS_USE_SPLIT_ORDERED_HASH */
@@ -470,11 +550,13 @@ mvfs_procdata_free()
                      "mvfs_procdata_free: Failed to cleanup thread hash"); 
         }
     } else {
+        mvfs_threadcache_free(mcdp);
         KMEM_FREE(mcdp->proc_thr.mvfs_threadid_hashtable,
     	          sizeof(mvfs_thread_t *)*MVFS_THREADHASH_SZ(mcdp));
         mvfs_splock_pool_free(&(mcdp->proc_thr.mvfs_threadid_spl_pool));
     }
 #else
+    mvfs_threadcache_free(mcdp);
     KMEM_FREE(mcdp->proc_thr.mvfs_threadid_hashtable,
               sizeof(mvfs_thread_t *)*MVFS_THREADHASH_SZ(mcdp));
     mvfs_splock_pool_free(&(mcdp->proc_thr.mvfs_threadid_spl_pool));
@@ -1241,6 +1323,8 @@ mvfs_mythread_subr(MVFS_THREADID_T *threadid_in)
     MVFS_PROCID_T mthpid;
     mvfs_proc_t *mthproc = NULL;
     register mvfs_proc_t *mpchase, **mpp;
+    mvfs_thread_cache_t *tcp;
+    unsigned int seq;
     mvfs_common_data_t *mcdp = MDKI_COMMON_GET_DATAP();
 
     /*
@@ -1264,6 +1348,30 @@ mvfs_mythread_subr(MVFS_THREADID_T *threadid_in)
     MDKI_MYPROCTAG(&metag, &mepid, &threadid);
     hashindex = MDKI_THREADHASH(&threadid, mcdp);
 
+    /*
+     * Try the bucket's cache first.  A thread keyed by our thread ID and
+     * belonging to our process is only released by us (changing
+     * allegiance, below), so if the entry still names our thread ID,
+     * process id and tag after the sequence check the thread is ours to
+     * use, exactly as if we had found it on the chain and dropped the
+     * splock.  If the thread ID has been reused, the cached thread
+     * belongs to a dead process and mvfs_procpurge may be freeing it
+     * right now, so everything is compared from the copies in the entry,
+     * never through mth.
+     */
+    tcp = &mcdp->proc_thr.mvfs_threadid_cache[hashindex];
+    do {
+        seq = MDKI_SEQ_READ_BEGIN(&tcp->tc_seq);
+        mth = tcp->tc_thread;
+        foundrealthr = (mth != NULL &&
+                        MDKI_THREADID_EQ(&threadid, &tcp->tc_threadid) &&
+                        MDKI_PROCID_EQ(&tcp->tc_procid, &mepid) &&
+                        MDKI_PROCTAG_EQ(&tcp->tc_proctag, &metag));
+    } while (MDKI_SEQ_READ_RETRY(&tcp->tc_seq, seq));
+
+    if (foundrealthr)
+        return(mth);
+
     THREADID_SPLOCK(hashindex, mcdp, &lockp, s);
     for (mth = mcdp->proc_thr.mvfs_threadid_hashtable[hashindex];
          mth;
@@ -1272,6 +1380,8 @@ mvfs_mythread_subr(MVFS_THREADID_T *threadid_in)
         ASSERT(mth->thr_hashbucket == hashindex);
         if (MDKI_THREADID_EQ(&threadid, &mth->thr_threadid)) {
             foundrealthr = (MDKI_PROC_EQ(mth->thr_proc, &mepid, &metag));
+            if (foundrealthr)
+                mvfs_threadcache_set(mcdp, hashindex, mth);
 
             mthproctag = mth->thr_proc->mp_proctag;
             mthpid = mth->thr_proc->mp_procid;
@@ -1344,6 +1454,7 @@ realloc:
         mth->thr_hashbucket = hashindex;
         mth->thr_hashnxt = mcdp->proc_thr.mvfs_threadid_hashtable[hashindex];
         mcdp->proc_thr.mvfs_threadid_hashtable[hashindex] = mth;
+        mvfs_threadcache_set(mcdp, hashindex, mth);
         THREADID_SPUNLOCK(hashindex, mcdp, &lockp, s);
     }
 
@@ -1851,6 +1962,8 @@ mvfs_threadrele_subr(mvfs_thread_t *thr)
     bucket = thr->thr_hashbucket;
     MDB_XLOG((MDB_PROCOPS,"mvfs_threadrele %"KS_FMT_PTR_T" bucket %d\n", thr, bucket));
     THREADID_SPLOCK(bucket, mcdp, &lockp, s);
+    if (mcdp->proc_thr.mvfs_threadid_cache[bucket].tc_thread == thr)
+        mvfs_threadcache_set(mcdp, bucket, NULL);
     mthp = &(mcdp->proc_thr.mvfs_threadid_hashtable[bucket]);
     ASSERT(*mthp != NULL);
 
@@ -30,7 +30,7 @@
  * Prototypes for internal routines
  */
 
-STATIC void
+STATIC int
 mvfs_rddir_cache_empty(struct mfs_mnode *mnp);
 
 /*
@@ -58,6 +58,11 @@ mvfs_rddir_cache_empty(struct mfs_mnode *mnp);
  * whenever this client changes a directory, this ensures the readdir
  * cache is no more stale than the directory attributes.
  *
+ * The caches of mnodes sitting on the vob freelist can also be released
+ * when the kernel is short of memory (see mvfs_rddir_cache_reclaim() and
+ * mvfs_shrink()).  The total number of blocks cached is kept in
+ * mvfs_rddir_blkcnt, under the mvfs_vobfreelock, for that purpose.
+ *
  * The code path for cache flushing after RPCs which successfully
  * modify directories is:
  * mfs_clnt_xxx()->mfs_attrcache()->mfs_ac_modevents()->mvfs_rddir_cache_flush()
@@ -72,24 +77,34 @@ mvfs_rddir_cache_empty(struct mfs_mnode *mnp);
  * invoke the system call with standard sizes.
  */
 
-STATIC void
+STATIC int
 mvfs_rddir_cache_empty(struct mfs_mnode *mnp)
 {
     register int i;
     struct mvfs_rce *ep;
+    int nblocks = 0;
+    mvfs_mnode_data_t *mndp = MDKI_MNODE_GET_DATAP();
 
     for (i = 0, ep = &mnp->mn_vob.rddir_cache->entries[0];
 	 i < mnp->mn_vob.rddir_cache->nentries;
 	 i++, ep++)
     {
 	if (ep->valid) {
-	    if (ep->block != NULL)
+	    if (ep->block != NULL) {
 		KMEM_FREE(ep->block, ep->bsize);
+		nblocks++;
+	    }
 
 	    ep->valid = FALSE;
 	    ep->block = NULL;
 	}
     }
+    if (nblocks != 0) {
+	MVFS_LOCK(&(mndp->mvfs_vobfreelock));
+	mndp->mvfs_rddir_blkcnt -= nblocks;
+	MVFS_UNLOCK(&(mndp->mvfs_vobfreelock));
+    }
+    return nblocks;
 }
 
 void
@@ -122,6 +137,31 @@ mvfs_rddir_cache_destroy(struct mfs_mnode *mnp)
     }
 }
 
+/*
+ * Give back the readdir cache of an idle mnode.  The mnode lock is not
+ * held: the caller has the mnode on the vob freelist and holds its hash
+ * chain lock, so nobody can reactivate the mnode until we are done (the
+ * same reasoning as for the cleartext flush in mvfs_mnflush_cvpfreelist).
+ * Returns the number of blocks freed.
+ */
+int
+mvfs_rddir_cache_reclaim(struct mfs_mnode *mnp)
+{
+    int nblocks;
+
+    ASSERT(MFS_ISVOB(mnp));
+
+    if (mnp->mn_vob.rddir_cache == NULL)
+	return 0;
+
+    MDB_XLOG((MDB_MNOPS, "rddir cache reclaim mnp %lx\n", mnp));
+    nblocks = mvfs_rddir_cache_empty(mnp);
+    KMEM_FREE(mnp->mn_vob.rddir_cache,
+	      RDDIR_CACHE_SIZE(mnp->mn_vob.rddir_cache));
+    mnp->mn_vob.rddir_cache = NULL;
+    return nblocks;
+}
+
 tbs_boolean_t
 mvfs_rddir_cache_get(
     struct mfs_mnode *mnp,
@@ -226,6 +266,8 @@ mvfs_rddir_cache_enter_mnlocked(
     register int i;
     register struct mvfs_rce *ep;
     register mvfs_common_data_t *mcdp = MDKI_COMMON_GET_DATAP();
+    mvfs_mnode_data_t *mndp = MDKI_MNODE_GET_DATAP();
+    int nblocks = 0;
 
     ASSERT(MFS_ISVOB(mnp));
     ASSERT(MISLOCKED(mnp));
@@ -287,9 +329,18 @@ mvfs_rddir_cache_enter_mnlocked(
 
     if (ep->valid && ep->block != NULL) {
         KMEM_FREE(ep->block, ep->bsize);
+        nblocks--;
     }
 
     *ep = *entryp;
+    if (ep->valid && ep->block != NULL) {
+        nblocks++;
+    }
+    if (nblocks != 0) {
+        MVFS_LOCK(&(mndp->mvfs_vobfreelock));
+        mndp->mvfs_rddir_blkcnt += nblocks;
+        MVFS_UNLOCK(&(mndp->mvfs_vobfreelock));
+    }
     MDB_XLOG((MDB_MNOPS,
               "rddir cache enter mnp %lx off %lx size %lx\n",
               mnp,
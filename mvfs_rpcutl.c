@@ -629,6 +629,101 @@ retry:
 #define MVFS_MAXTIME	300
 #define BACKOFF(tim) ((((tim) << 1) > MVFS_MAXTIME) ? MVFS_MAXTIME : ((tim) << 1))
 
+/*
+ * Adaptive timeouts for view calls.
+ *
+ * The mount's timeout (scaled per op by the timeshft tables below) has to
+ * allow for the slowest server on the slowest link, so a lost datagram to a
+ * nearby view_server costs seconds.  Instead, each view keeps an estimate of
+ * the round trip time of each op, the way TCP does (RFC 6298): the smoothed
+ * RTT plus four times its mean deviation, doubled after each call that timed
+ * out or was retransmitted.  That is the first retransmit timeout handed to
+ * the RPC layer, kept between mvfs_rpc_rto_min and the lesser of
+ * mvfs_rpc_rto_max and the mount's timeout.  Following Karn, a call that
+ * took longer than its timeout may have been retransmitted, so its time is
+ * not used as a sample.  A call that times out on an adaptive timeout is
+ * sent again with the mount's timeout (see mfscall_int()), so the time a
+ * soft mount waits before failing is never shortened.
+ */
+STATIC int
+mvfs_rtt_timeo(
+    VNODE_T *view,
+    int op,
+    int ceiling		/* Mount's timeout for the op, in milliseconds */
+)
+{
+    struct mfs_viewnode *vwp = &(VTOM(view)->mn_view);
+    struct mvfs_rttest *rp;
+    int rto, floor;
+    SPL_T s;
+
+    if (!mvfs_rpc_adaptive_timeo || vwp->rtt == NULL ||
+        op < 0 || op >= VIEW_NUM_PROCS)
+    {
+        return(ceiling);
+    }
+    if (mvfs_rpc_rto_max > 0 && mvfs_rpc_rto_max < ceiling)
+        ceiling = mvfs_rpc_rto_max;
+    floor = KS_MIN(KS_MAX(mvfs_rpc_rto_min, 1), ceiling);
+
+    rp = &(vwp->rtt[op]);
+    SPLOCK(vwp->rttlock, s);
+    if (rp->srtt == 0) {
+        rto = ceiling;          /* No samples yet */
+    } else {
+        rto = ((rp->srtt >> 3) + rp->rttvar) << rp->backoff;
+    }
+    SPUNLOCK(vwp->rttlock, s);
+
+    return(KS_MAX(floor, KS_MIN(rto, ceiling)));
+}
+
+/*
+ * MVFS_RTT_SAMPLE - fold the time a view call took into its op's estimate.
+ * rto is the timeout the call was made with; pass 0 if it timed out.
+ */
+STATIC void
+mvfs_rtt_sample(
+    VNODE_T *view,
+    int op,
+    int msecs,
+    int rto
+)
+{
+    struct mfs_viewnode *vwp = &(VTOM(view)->mn_view);
+    struct mvfs_rttest *rp;
+    int delta;
+    SPL_T s;
+
+    if (vwp->rtt == NULL || op < 0 || op >= VIEW_NUM_PROCS)
+        return;
+
+    rp = &(vwp->rtt[op]);
+    SPLOCK(vwp->rttlock, s);
+    if (msecs >= rto) {
+        /* Timed out, or may have been retransmitted: back off. */
+        if (rp->backoff < MVFS_RTT_MAXBACKOFF)
+            rp->backoff++;
+    } else {
+        if (msecs <= 0)
+            msecs = 1;
+        if (rp->srtt == 0) {
+            rp->srtt = msecs << 3;
+            rp->rttvar = msecs << 1;
+        } else {
+            /* srtt += (m - srtt)/8; rttvar += (|m - srtt| - rttvar)/4 */
+            delta = msecs - (rp->srtt >> 3);
+            rp->srtt += delta;
+            if (delta < 0)
+                delta = -delta;
+            delta -= (rp->rttvar >> 2);
+            rp->rttvar += delta;
+        }
+        rp->backoff = 0;
+    }
+    SPUNLOCK(vwp->rttlock, s);
+}
+
 /* VIEW SERVER TABLES */
 
 /* Base time shift for each call.  This allows the user
@@ -1233,6 +1328,250 @@ mvfs_bindsvr_port(
     return(error);
 }
 
+/*
+ * View server health.
+ *
+ * When a view_server hangs, each view call used to run through the whole
+ * timeout, retry and rebind sequence on its own.  Instead, the first call to
+ * time out marks the view SUSPECT and becomes its probe: it carries on
+ * retrying and rebinding as before, holding the view's hlthprobe lock.  Other
+ * callers wait for that lock and then look at the result, or with
+ * MVFS_VWHLTH_POLICY_FAILFAST, soft mount calls fail with ETIMEDOUT at once.
+ * A probe that gets no reply, or whose rebind fails, marks the view DOWN, and
+ * soft mount calls then fail at once until mvfs_view_down_interval has passed
+ * and one of them probes again.  Any reply makes the view HEALTHY.  Every
+ * transition is counted in the clntstat stats, along with the time taken to
+ * go from SUSPECT to DOWN and the time spent out of HEALTHY.
+ */
+
+/*
+ * MVFS_VWHEALTH_NOTE - count a health transition.  Called without hlthlock
+ * held, since bumping the stats may allocate.
+ */
+STATIC void
+mvfs_vwhealth_note(
+    VNODE_T *vw,
+    u_int state,
+    time_t secs         /* DOWN: time to detect, HEALTHY: time to recover */
+)
+{
+    BUMPSTAT(mfs_clntstat.vwhlthtrans[state]);
+    BUMP_PVCLNTSTAT(vw, clntstat.vwhlthtrans[state]);
+    switch (state) {
+      case MVFS_VWHLTH_DOWN:
+        BUMPSTAT_VAL(mfs_clntstat.vwhlthdetect, secs);
+        BUMP_PVCLNTSTAT_VAL(vw, clntstat.vwhlthdetect, secs);
+        break;
+      case MVFS_VWHLTH_HEALTHY:
+        SETSTAT_VWHLTH_RECOVER(secs);
+        SETPVSTAT_VWHLTH_RECOVER(vw, secs);
+        break;
+      default:
+        break;
+    }
+    MDB_XLOG((MDB_RPCOPS, "vwhealth: view %s state %d after %d secs\n",
+              mfs_vw2nm(vw), state, (int)secs));
+}
+
+/*
+ * MVFS_VWHEALTH_UPDATE - record whether the view server answered a call.
+ * replied is 1 if it did, 0 if it did not, and -1 if the call doesn't say
+ * either way (it was interrupted or never sent).
+ */
+STATIC void
+mvfs_vwhealth_update(
+    VNODE_T *vw,
+    int replied
+)
+{
+    struct mfs_viewnode *vwp = &(VTOM(vw)->mn_view);
+    u_int newstate = MVFS_VWHLTH_NSTATES;
+    time_t now, secs = 0;
+    SPL_T s;
+
+    if (replied < 0)
+        return;
+    now = MDKI_CTIME();
+    SPLOCK(vwp->hlthlock, s);
+    if (replied) {
+        if (vwp->hlthstate != MVFS_VWHLTH_HEALTHY) {
+            newstate = MVFS_VWHLTH_HEALTHY;
+            secs = now - vwp->hlthsince;
+        }
+    } else {
+        if (vwp->hlthstate == MVFS_VWHLTH_HEALTHY) {
+            newstate = MVFS_VWHLTH_DOWN;
+            vwp->hlthsince = now;
+        } else if (vwp->hlthstate == MVFS_VWHLTH_SUSPECT) {
+            newstate = MVFS_VWHLTH_DOWN;
+            secs = now - vwp->hlthsince;
+        }
+        vwp->hlthnext = now + mvfs_view_down_interval;
+    }
+    if (newstate != MVFS_VWHLTH_NSTATES)
+        vwp->hlthstate = newstate;
+    SPUNLOCK(vwp->hlthlock, s);
+
+    if (newstate != MVFS_VWHLTH_NSTATES)
+        mvfs_vwhealth_note(vw, newstate, secs);
+}
+
+/*
+ * MVFS_VWHEALTH_REPLIED - did a call that ended with this status get an
+ * answer from the server?  See mvfs_vwhealth_update().
+ */
+STATIC int
+mvfs_vwhealth_replied(enum clnt_stat status)
+{
+    switch (status) {
+      case RPC_SUCCESS:
+      case RPC_PROCUNAVAIL:
+      case RPC_PROGUNAVAIL:
+      case RPC_AUTHERROR:
+      case RPC_CANTDECODERES:
+      case RPC_VERSMISMATCH:
+      case RPC_PROGVERSMISMATCH:
+      case RPC_CANTDECODEARGS:
+        return(1);
+      case RPC_INTR:
+      case RPC_CANTENCODEARGS:
+      case RPC_CANTSEND:
+      case RPC_SYSTEMERROR:
+        return(-1);     /* Failed here, the server wasn't asked */
+      default:
+        return(0);
+    }
+}
+
+STATIC int
+mvfs_vwhealth_failfast(
+    VNODE_T *vw
+)
+{
+    BUMPSTAT(mfs_clntstat.vwhlthfastfail);
+    BUMP_PVCLNTSTAT(vw, clntstat.vwhlthfastfail);
+    return(ETIMEDOUT);
+}
+
+/*
+ * MVFS_VWHEALTH_ENTER - decide whether a view call may go to the server.
+ * Returns 0 to make the call, with *probep set if the caller now holds the
+ * view's hlthprobe lock, or ETIMEDOUT to fail the call without an RPC.
+ * Unless the mount is nointr, a signal ends a wait for another caller's
+ * probe with EINTR.
+ */
+STATIC int
+mvfs_vwhealth_enter(
+    VNODE_T *vw,
+    struct mfs_retryinfo *rinfop,
+    int *probep
+)
+{
+    struct mfs_viewnode *vwp = &(VTOM(vw)->mn_view);
+    u_int state;
+    time_t next;
+    int error;
+    SPL_T s;
+
+    *probep = 0;
+    if (mvfs_view_health_policy == MVFS_VWHLTH_POLICY_OFF)
+        return(0);
+
+    for (;;) {
+        SPLOCK(vwp->hlthlock, s);
+        state = vwp->hlthstate;
+        next = vwp->hlthnext;
+        SPUNLOCK(vwp->hlthlock, s);
+
+        if (state == MVFS_VWHLTH_HEALTHY)
+            return(0);
+
+        /* A soft mount doesn't wait out a server known to be down. */
+        if (state == MVFS_VWHLTH_DOWN && rinfop->soft && MDKI_CTIME() < next)
+            return(mvfs_vwhealth_failfast(vw));
+
+        if (CONDITIONAL_LOCK(HLTHPROBE_ADDR(VTOM(vw)))) {
+            /* The last probe may have finished since we looked. */
+            if (vwp->hlthstate == MVFS_VWHLTH_HEALTHY) {
+                MVFS_UNLOCK(HLTHPROBE_ADDR(VTOM(vw)));
+                return(0);
+            }
+            *probep = 1;
+            return(0);
+        }
+        if (rinfop->soft &&
+            mvfs_view_health_policy == MVFS_VWHLTH_POLICY_FAILFAST)
+        {
+            return(mvfs_vwhealth_failfast(vw));
+        }
+
+        /* Wait for the probe in flight to finish, then look again. */
+        BUMPSTAT(mfs_clntstat.vwhlthwait);
+        BUMP_PVCLNTSTAT(vw, clntstat.vwhlthwait);
+        if (rinfop->nointr) {
+            MVFS_LOCK(HLTHPROBE_ADDR(VTOM(vw)));
+        } else {
+            MVFS_LOCK_INTR(HLTHPROBE_ADDR(VTOM(vw)), &error);
+            if (error != 0)
+                return(error);
+        }
+        MVFS_UNLOCK(HLTHPROBE_ADDR(VTOM(vw)));
+    }
+}
+
+/*
+ * MVFS_VWHEALTH_SUSPECT - a view call timed out.  Mark the view SUSPECT and
+ * make the caller its probe if no one else is.  Otherwise the caller never
+ * retries alongside the probe: it fails with ETIMEDOUT (soft mount, fail
+ * fast policy), or waits for the probe as in mvfs_vwhealth_enter() and
+ * looks again.  Returns 0 to rebind and retry, as the probe or with the
+ * policy off; or 0 with *waitedp set if the view answered the probe we
+ * waited for, so the call should just be sent again.
+ */
+STATIC int
+mvfs_vwhealth_suspect(
+    VNODE_T *vw,
+    struct mfs_retryinfo *rinfop,
+    int *probep,
+    int *waitedp
+)
+{
+    struct mfs_viewnode *vwp = &(VTOM(vw)->mn_view);
+    int noted = 0;
+    int error;
+    SPL_T s;
+
+    *waitedp = 0;
+    if (mvfs_view_health_policy == MVFS_VWHLTH_POLICY_OFF)
+        return(0);
+
+    SPLOCK(vwp->hlthlock, s);
+    if (vwp->hlthstate == MVFS_VWHLTH_HEALTHY) {
+        vwp->hlthstate = MVFS_VWHLTH_SUSPECT;
+        vwp->hlthsince = MDKI_CTIME();
+        noted = 1;
+    }
+    SPUNLOCK(vwp->hlthlock, s);
+    if (noted)
+        mvfs_vwhealth_note(vw, MVFS_VWHLTH_SUSPECT, 0);
+
+    if (*probep || CONDITIONAL_LOCK(HLTHPROBE_ADDR(VTOM(vw)))) {
+        *probep = 1;
+        return(0);
+    }
+    if (rinfop->soft &&
+        mvfs_view_health_policy == MVFS_VWHLTH_POLICY_FAILFAST)
+    {
+        return(mvfs_vwhealth_failfast(vw));
+    }
+
+    /* Someone else is the probe: wait for it, then look again. */
+    if ((error = mvfs_vwhealth_enter(vw, rinfop, probep)) != 0)
+        return(error);
+    *waitedp = !*probep;
+    return(0);
+}
+
 /*
  * MVFS_VWCALL - make an rpc call to the view
  */
@@ -1256,6 +1595,9 @@ mvfs_vwcall(
     int status;
     int retrans;
     int suppress_console_msg;
+    int probe;
+    int waited;
+    int replied = -1;
     MDKI_CLNTKUDP_ADDR_T addr;
     static MVFS_PROCID_T suppress_last_pid = 0;
 
@@ -1282,11 +1624,18 @@ mvfs_vwcall(
     }
     alloc_unitp->mnp = VTOM(vw);
 
+    /* Fail fast, or wait for another caller's probe, if the view server
+    ** has stopped answering.
+    */
+    if ((error = mvfs_vwhealth_enter(vw, rinfop, &probe)) != 0) {
+        goto cleanup;
+    }
+
     if (alloc_unitp->mnp->mn_view.rpctime + mvfs_view_rebind_timeout < MDKI_CTIME()) {
         /* probe ALBD first */
         error = mvfs_bindsvr_port(&alloc_unitp->mnp->mn_view.svr, vfsp, cred, vw);
         if (error) {
-            goto cleanup;
+            goto health;
         }
     }
 
@@ -1294,7 +1643,7 @@ mvfs_vwcall(
                           rinfop, cred, vw, &alloc_unitp->client);
     if (error != 0) {
         /* oh boy, this really bites... */
-        goto cleanup;
+        goto health;
     }
     xid = (XID_T)MDKI_ALLOC_XID();  /* Allocate an XID we can keep */
 
@@ -1303,8 +1652,24 @@ mvfs_vwcall(
                         xdrres, resp, cred, alloc_unitp->client, vw,
                         rpc_status)) == EAGAIN)
     {
-        error = mvfs_bindsvr_port(&VTOM(vw)->mn_view.svr, vfsp, cred, vw);
+        /* Leave the retries to the probe if another caller is already it.
+        ** Only a timeout says the server stopped answering; EAGAIN also
+        ** comes back for an unregistered or unbound server, which a rebind
+        ** may fix.
+        */
+        waited = 0;
+        if (*rpc_status == RPC_TIMEDOUT &&
+            (error = mvfs_vwhealth_suspect(vw, rinfop, &probe, &waited)) != 0)
+        {
+            break;
+        }
+        /* The probe we waited for has rebound already. */
+        error = waited ? 0 :
+                mvfs_bindsvr_port(&VTOM(vw)->mn_view.svr, vfsp, cred, vw);
         if (error) {
+            /* Not answering and not found by the ALBD: it's down. */
+            if (*rpc_status == RPC_TIMEDOUT)
+                mvfs_vwhealth_update(vw, 0);
             if (rinfop->soft) {
                 mvfs_log(MFS_LOG_ERR,
                          "View op %s failed rebind for %s:%s%s\n",
@@ -1348,9 +1713,12 @@ mvfs_vwcall(
                  VFS_TO_MMI(vfsp)->mmi_mntpath, error, mvfs_get_boottime());
 
         if (error != 0) {
-            goto cleanup;
+            goto health;
         }
     }
+    if (callerr != EAGAIN) {
+        replied = mvfs_vwhealth_replied(*rpc_status);
+    }
 
     mvfs_clnt_free(alloc_unitp->client, error, vw);
 
@@ -1526,6 +1894,11 @@ print_error:
         VTOM(vw)->mn_view.needs_reformat = 0;
         VTOM(vw)->mn_view.zombie_view = 0;
     }
+  health:
+    mvfs_vwhealth_update(vw, replied);
+    if (probe) {
+        MVFS_UNLOCK(HLTHPROBE_ADDR(VTOM(vw)));
+    }
   cleanup:
     KMEM_FREE(rinfop, sizeof(*rinfop));
     KMEM_FREE(alloc_unitp, sizeof(*alloc_unitp));
@@ -1591,6 +1964,7 @@ mfscall_int(
 {
     struct timeval wait;
     int rpctimeout;
+    int rpcto_ms;                       /* First retransmit timeout */
     int error, remote_error;
     XID_T xid = 0;
     int retrans;
@@ -1656,6 +2030,10 @@ mfscall_int(
 
     /* Set initial timeout based on operation type */
     rpctimeout = KS_MIN((rinfo->timeo << (trait->optimeoshft)[op]), MVFS_MAXTIME);
+    rpcto_ms = rpctimeout * 100;
+    if (view && trait == &mfs_vwcallstruct) {
+        rpcto_ms = mvfs_rtt_timeo(view, op, rpcto_ms);
+    }
 
     /* Allocate the vars we need to save stack space.  Don't return without
     ** freeing after this (i.e. return through the errout: label).
@@ -1717,7 +2095,7 @@ retry_call:
     MDKI_CLNTKUDP_INTR(client, !rinfo->nointr);
 
     ASSERT(cred);
-    MDKI_CLNT_CALL(client, op, xdrargs, argsp, xdrres, resp, wait, rpctimeout,
+    MDKI_CLNT_CALL(client, op, xdrargs, argsp, xdrres, resp, wait, rpcto_ms,
                    &saved_holdmask, !(rinfo->nointr), cred, *status);
     BUMPSTAT(mfs_clntstat.clntcalls);
     if (view) {
@@ -1753,6 +2131,12 @@ retry_call:
              */
             MVFS_BUMPTIME(alloc_unitp->start_time, alloc_unitp->dtime,
                          mfs_viewoptime[op]);
+            if (view) {
+                mvfs_rtt_sample(view, op,
+                                (int)(alloc_unitp->dtime.tv_sec * 1000 +
+                                      alloc_unitp->dtime.tv_nsec / 1000000),
+                                rpcto_ms);
+            }
             if (alloc_unitp->dtime.tv_sec > mvfs_max_rpcdelay) {
                 mvfs_log(MFS_LOG_INFO,
                          "View op %s delayed %d seconds!\n",
@@ -1826,6 +2210,18 @@ retry_call:
 
     case RPC_TIMEDOUT:
         error = ETIMEDOUT;
+        if (view && trait == &mfs_vwcallstruct) {
+            mvfs_rtt_sample(view, op, 0, 0);
+            /*
+             * An adaptive timeout only shortens the first try.  Send once
+             * more with the mount's own timeout before going on as usual,
+             * so a soft mount never gives up sooner than it did without.
+             */
+            if (rpcto_ms < rpctimeout * 100) {
+                rpcto_ms = rpctimeout * 100;
+                goto resend;
+            }
+        }
         /* Fall through */
 
     default:
@@ -1859,6 +2255,8 @@ retry_call:
                 goto errout;
             } else {			/* Hard mount, retry call */
                 rpctimeout = BACKOFF(rpctimeout);
+                rpcto_ms = KS_MIN(rpcto_ms << 1, MVFS_MAXTIME * 100);
+              resend:
                 retrans = (svr->down) ? 1 : rinfo->retries;
 
                 /* Free client creds */
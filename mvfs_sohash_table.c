@@ -510,8 +510,7 @@ retry_loop:
                         MDKI_ATOMIC_PTR_READ(
                         &hashd->hashtable[segment_index][bucket_index]);
                     MDKI_ATOMIC_CAS_PTR(
-                            &(MDKI_ATOMIC_PTR_READ(
-                            &hashd->hashtable[segment_index][bucket_index])),
+                            &hashd->hashtable[segment_index][bucket_index],
                             sentinel_node,
                             SOHASH_UNINITIALIZED);
                     ASSERT(MDKI_ATOMIC_PTR_READ(
@@ -836,6 +835,7 @@ sohash_delete_entry(
                  "sohash key 0x%x, bucket 0x%x\n", 
                  hashd, hashindex, sohash_key, bucket));
 
+        sohash_hp_release(myhp);
         return(EFAULT);
     }
 
@@ -1258,13 +1258,21 @@ sohash_list_find(
 
     ASSERT((hashd != NULL) && (head != NULL));
 
+    /* Each hazard pointer must be visible to a scanning thread before we
+     * re-read the link it protects, otherwise the scan can miss it and
+     * free the node under us.  That is a store followed by a load, which
+     * even x86 may reorder, hence the full barriers below.  The links
+     * themselves are re-read through MDKI_ATOMIC_PTR_READ so the compiler
+     * can't reuse the first load for the check.
+     */
 try_again:
     MDKI_ATOMIC_PTR_SET(&myhp->prev, head);
 
-    myhp->cur = *(MDKI_ATOMIC_PTR_READ(&myhp->prev));
+    myhp->cur = MDKI_ATOMIC_PTR_READ(myhp->prev);
 
     *(myhp->hp1) = myhp->cur;
-    if (*(MDKI_ATOMIC_PTR_READ(&myhp->prev)) != myhp->cur) {
+    MDKI_MEMORY_BARRIER();
+    if (MDKI_ATOMIC_PTR_READ(myhp->prev) != myhp->cur) {
         goto try_again;
     }
 
@@ -1275,13 +1283,14 @@ try_again:
         myhp->next = MDKI_ATOMIC_PTR_READ(&myhp->cur->hashentry_next);
 
         *(myhp->hp0) = myhp->next;
+        MDKI_MEMORY_BARRIER();
         if (MDKI_ATOMIC_PTR_READ(&myhp->cur->hashentry_next) != myhp->next) {
             goto try_again;
         }
 
         cur_reverse_key = myhp->cur->reverse_so_key;
 
-        if (*(MDKI_ATOMIC_PTR_READ(&myhp->prev)) != myhp->cur) goto try_again;
+        if (MDKI_ATOMIC_PTR_READ(myhp->prev) != myhp->cur) goto try_again;
 
         if (SOHASH_IS_DELETE_BIT_SET(myhp->next)) {
             goto try_again;
@@ -1338,6 +1347,7 @@ try_again:
             myhp->cur = myhp->next;
         }
         *(myhp->hp1) = myhp->next;
+        MDKI_MEMORY_BARRIER();
     }
 }
 
@@ -1556,7 +1566,7 @@ sohash_hprec_scan(
     plist_idx = 0;
     while (hp != NULL) {
         for (i = 0; i < 3; i++) {
-            hptr = hp->hprec.hazard_ptrs[i];
+            hptr = MDKI_ATOMIC_PTR_READ(&hp->hprec.hazard_ptrs[i]);
             if (hptr != NULL) {
                 /* It could be possible that the hazard reference has the delete
                  * bit set.  Use the address with its delete bit unset for the 
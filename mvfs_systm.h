@@ -365,6 +365,10 @@
 #define MVFS_XID_T uint32_t
 #endif
 
+#ifndef MVFS_DNC_COUNT_T
+#define MVFS_DNC_COUNT_T uint32_t
+#endif
+
 #ifndef MVFS_XID_ULIMIT
 #define MVFS_XID_ULIMIT (0xffffffff)
 #endif
@@ -678,6 +682,63 @@
 #define MVFS_RECORD_CREDLIST(mnp, record_creds, cred) \
     if (DO_CLTXT_CREDS() && record_creds) \
         mvfs_record_cred(mnp, cred); 
+
+/*
+ * Ports without a way to run the cleartext prefetch worker asynchronously
+ * leave these undefined, and prefetch requests are then never queued.
+ */
+#ifndef MVFS_CTXT_PREFETCH_START
+#define MVFS_CTXT_PREFETCH_START(slot) ENOSYS
+#define MVFS_CTXT_PREFETCH_WAIT()
+#endif
+
+/*
+ * Ports that can't be told about memory pressure leave these undefined;
+ * the caches are then only trimmed by the freelist watermarks.
+ */
+#ifndef MVFS_REGISTER_SHRINKERS
+#define MVFS_REGISTER_SHRINKERS()
+#define MVFS_UNREGISTER_SHRINKERS()
+#endif
+
+/*
+ * Ports that can run mvfs_mnfreelist_reclaim() in the background define
+ * these.  Without them the freelist is trimmed by whoever crosses the
+ * high water mark.
+ */
+#ifndef MVFS_MNFREELIST_RECLAIM_START
+#define MVFS_MNFREELIST_RECLAIM_START() ENOSYS
+#define MVFS_MNFREELIST_RECLAIM_STOP()
+#endif
+
+/*
+ * Ports that can schedule periodic work define these to run each
+ * maintenance task on its own.  Without them the tasks run from mfs_vsync().
+ */
+/*
+ * Key a port uses to find a VOB mount from an exported file handle (see
+ * mvfs_find_mount_fhkey).  Ports without one hash every mount to 0.
+ */
+#ifndef MVFS_VFS_FHKEY
+#define MVFS_VFS_FHKEY(vfsp) 0
+#endif
+
+#ifndef MVFS_MAINT_START
+#define MVFS_MAINT_START(ntasks) ENOSYS
+#define MVFS_MAINT_STOP()
+#endif
+
+/*
+ * NUMA placement.  Ports that don't know about nodes put everything on
+ * node 0, which leaves the vob freelist in a single partition.
+ */
+#ifndef MVFS_NUMA_NODE_ID
+#define MVFS_NUMA_NODE_ID() 0
+#define MVFS_NUMA_NODE_COUNT() 1
+#endif
+#ifndef KMEM_ALLOC_NODE
+#define KMEM_ALLOC_NODE(bsize, flag, node) KMEM_ALLOC(bsize, flag)
+#endif
 #ifdef MVFS_DEBUG
 #define DO_CLTXT_CREDS() (mvfs_cltxt_creds_enabled != 0)
 #else
@@ -934,6 +995,8 @@ extern struct mvfs_slab_list* mvfs_vattr_slabs;
     BZERO(&(sdp->mfs_viewophist.histperop[0][0]), \
           sizeof(sdp->mfs_viewophist.histperop)); \
     BZERO(&(sdp->mfs_viewoptime[0]), sizeof(sdp->mfs_viewoptime)); \
+    BZERO(&(sdp->mvfs_viewenctime[0]), sizeof(sdp->mvfs_viewenctime)); \
+    BZERO(&(sdp->mvfs_viewdectime[0]), sizeof(sdp->mvfs_viewdectime)); \
     sdp->mfs_clntstat.version = MFS_CLNTSTAT_VERS; \
     sdp->mfs_mnstat.version = MFS_MNSTAT_VERS; \
     sdp->mfs_clearstat.version = MFS_CLEARSTAT_VERS; \
@@ -961,6 +1024,18 @@ extern struct mvfs_slab_list* mvfs_vattr_slabs;
 #define MDKI_ATOMIC_SET_UINT32(addr, val)   (*(addr) = (val))
 #endif
 
+/* Full memory barrier.  Ports should map this to their kernel's own; the
+ * compiler builtin is a full hardware and compiler barrier where it exists.
+ */
+#ifndef MDKI_MEMORY_BARRIER
+#define MDKI_MEMORY_BARRIER()               __sync_synchronize()
+#endif
+
+/* Sleep lock whose wait a signal can end.  Ports without one just wait. */
+#ifndef MVFS_LOCK_INTR
+#define MVFS_LOCK_INTR(lptr, errp) { MVFS_LOCK(lptr); *(errp) = 0; }
+#endif
+
 #ifndef MDKI_ATOMIC_READ_UINT32
 #define MDKI_ATOMIC_READ_UINT32(addr)       (*(addr))
 #endif
@@ -142,6 +142,8 @@ mfs_timestruc_to_mfs_timestruc_32(timestruc_t *vbl, struct timestruc_32 *vbl_32)
 void
 mfs_clntstat_to_mfs_clntstat_32(struct mfs_clntstat *vbl, struct mfs_clntstat_32 *vbl_32)
 {
+        int i;
+
         vbl_32->version = vbl->version;
         vbl_32->clntget = vbl->clntget;
         vbl_32->clntfree = vbl->clntfree;
@@ -156,6 +158,13 @@ mfs_clntstat_to_mfs_clntstat_32(struct mfs_clntstat *vbl, struct mfs_clntstat_32
         vbl_32->mfsmaxdelaytime = vbl->mfsmaxdelaytime;
         mfs_timestruc_to_mfs_timestruc_32(&vbl->mvfsthread_time,
                 &vbl_32->mvfsthread_time);
+        for (i = 0; i < MVFS_VWHLTH_NSTATES; i++)
+                vbl_32->vwhlthtrans[i] = vbl->vwhlthtrans[i];
+        vbl_32->vwhlthfastfail = vbl->vwhlthfastfail;
+        vbl_32->vwhlthwait = vbl->vwhlthwait;
+        vbl_32->vwhlthdetect = vbl->vwhlthdetect;
+        vbl_32->vwhlthrecover = vbl->vwhlthrecover;
+        vbl_32->vwhlthmaxrecover = vbl->vwhlthmaxrecover;
 }
 
 void
@@ -191,6 +200,12 @@ mfs_clearstat_to_mfs_clearstat_32(struct mfs_clearstat *vbl, struct mfs_clearsta
         vbl_32->cleargetmiss = vbl->cleargetmiss;
         vbl_32->clearreclaim = vbl->clearreclaim;
         vbl_32->clearreclaimmiss = vbl->clearreclaimmiss;
+        vbl_32->cleargetlkup = vbl->cleargetlkup;
+        vbl_32->clearprefetch = vbl->clearprefetch;
+        vbl_32->clearprefetchdone = vbl->clearprefetchdone;
+        vbl_32->clearprefetchdrop = vbl->clearprefetchdrop;
+        vbl_32->clearprefetcherr = vbl->clearprefetcherr;
+        vbl_32->clearprefetchhit = vbl->clearprefetchhit;
 }
 
 void
@@ -291,8 +306,8 @@ struct {
 	{TRUE, sizeof(struct mvfs_bhinfo_32), sizeof(struct mvfs_bhinfo_32)},
 	/* MVFS_CMD_SET_BH 30 */
 	{TRUE, sizeof(struct mvfs_bhinfo_32), sizeof(struct mvfs_bhinfo_32)},
-	/* MVFS_CMD_GET_STATS 31 */
-	{TRUE, sizeof(struct mvfs_statbufs_32), sizeof(struct mvfs_statbufs_32)},
+	/* MVFS_CMD_GET_STATS 31 (older callers stop before viewenctime) */
+	{TRUE, offsetof(struct mvfs_statbufs_32, viewenctime), sizeof(struct mvfs_statbufs_32)},
 	/* MVFS_CMD_SETPROCVIEW 32 */
 	{TRUE, sizeof(struct mvfs_viewtag_info_32), sizeof(struct mvfs_viewtag_info_32)},
 	/* MVFS_CMD_GET_PROCVIEWINFO 33 */
@@ -363,6 +378,9 @@ struct {
 
        /* MVFS_CMD_DISABLE_PVIEW_STATS 64 */
        {TRUE, 0, 0},
+
+       /* MVFS_CMD_READ_DNC_BULK 65 */
+       {TRUE, sizeof(mvfs_iodncbulk_t), sizeof(mvfs_iodncbulk_t)},
 };
 
 int
@@ -924,6 +942,8 @@ mvfs_statbufs_32_to_mvfs_statbufs(struct mvfs_statbufs_32 *vbl_32, struct mvfs_s
 	mfs_strbuf_32_to_mfs_strbuf(&vbl_32->viewopcnt, &vbl->viewopcnt);
 	mfs_strbuf_32_to_mfs_strbuf(&vbl_32->viewoptime, &vbl->viewoptime);
 	mfs_strbuf_32_to_mfs_strbuf(&vbl_32->viewophist, &vbl->viewophist);
+	mfs_strbuf_32_to_mfs_strbuf(&vbl_32->viewenctime, &vbl->viewenctime);
+	mfs_strbuf_32_to_mfs_strbuf(&vbl_32->viewdectime, &vbl->viewdectime);
 }
 
 void
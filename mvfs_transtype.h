@@ -119,6 +119,12 @@ struct mfs_clntstat_32 {
     MVFS_STAT_CNT_T mfsmaxdelay;
     MVFS_STAT_CNT_T mfsmaxdelaytime;
     struct timestruc_32  mvfsthread_time;
+    MVFS_STAT_CNT_T vwhlthtrans[MVFS_VWHLTH_NSTATES];
+    MVFS_STAT_CNT_T vwhlthfastfail;
+    MVFS_STAT_CNT_T vwhlthwait;
+    MVFS_STAT_CNT_T vwhlthdetect;
+    MVFS_STAT_CNT_T vwhlthrecover;
+    MVFS_STAT_CNT_T vwhlthmaxrecover;
     ks_uint32_t version;
 };
 
@@ -144,6 +150,11 @@ struct mfs_clearstat_32 {
     MVFS_STAT_CNT_T clearreclaim;
     MVFS_STAT_CNT_T clearreclaimmiss;
     MVFS_STAT_CNT_T cleargetlkup;
+    MVFS_STAT_CNT_T clearprefetch;
+    MVFS_STAT_CNT_T clearprefetchdone;
+    MVFS_STAT_CNT_T clearprefetchdrop;
+    MVFS_STAT_CNT_T clearprefetcherr;
+    MVFS_STAT_CNT_T clearprefetchhit;
     ks_uint32_t version;
 };
 
@@ -435,6 +446,8 @@ struct mvfs_statbufs_32 {
     struct mfs_strbuf_32 viewopcnt;
     struct mfs_strbuf_32 viewoptime;
     struct mfs_strbuf_32 viewophist;
+    struct mfs_strbuf_32 viewenctime;
+    struct mfs_strbuf_32 viewdectime;
 };
 
 struct mvfs_io_xattr_32 {
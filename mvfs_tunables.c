@@ -198,6 +198,36 @@ int mvfs_rddir_blocks = 0;
  *                              access time of that file to be updated (keeps
  *                              scrubber informed of access regardless of
  *                              cleartext filesystem caching)
+ * mvfs_ctxt_prefetch:          Speculatively activate the cleartext of VOB
+ *                              files in the background before they are
+ *                              opened.  0 (default) disables prefetch,
+ *                              1 prefetches after every lookup of a file.
+ * mvfs_ctxt_prefetch_threads:  max number of prefetch workers run at once
+ *                              (default 2, up to 8)
+ * mvfs_ctxt_prefetch_view_max: max number of prefetches queued for any one
+ *                              view (default 16)
+ * mvfs_ctxt_prefetch_qmax:     max number of prefetches queued in all
+ *                              (default 256)
+ * mvfs_procpurge_interval:     time (in seconds) between purges of dead
+ *                              processes' MVFS state
+ * mvfs_credlist_interval:      time (in seconds) between trims of the
+ *                              cleartext cred list
+ * mvfs_cleanhm_interval:       time (in seconds) between scans for idle
+ *                              history-mode views
+ * mvfs_view_health_policy:     what view calls do while another call probes
+ *                              a view server that stopped answering: 0 runs
+ *                              each call's own retries, 1 waits for the
+ *                              probe, 2 (default) fails soft mounts at once
+ * mvfs_view_down_interval:     time (in seconds) a view server that gave no
+ *                              reply is left alone before it is probed again
+ *                              (soft mounts fail at once meanwhile)
+ * mvfs_rpc_adaptive_timeo:     1 (default) bases view RPC retransmit timeouts
+ *                              on each view's measured round trip time for
+ *                              each op; 0 uses the mount's timeouts only
+ * mvfs_rpc_rto_min:            floor (in milliseconds) for adaptive timeouts
+ * mvfs_rpc_rto_max:            ceiling (in milliseconds) for adaptive
+ *                              timeouts; 0 (default) uses the mount's timeout
+ *                              for the op
  */
 
 int mvfs_max_rpcdelay = 30;
@@ -213,6 +243,18 @@ int mvfs_cowbufsiz = 4096;
 int mvfs_duplsearchmax = 20;
 int mvfs_threadhash_sz = MVFS_THREADHASH_SZ_DEFAULT;
 int mvfs_ctxt_atime_refresh = 3600; 
+int mvfs_ctxt_prefetch = 0;
+int mvfs_ctxt_prefetch_threads = 0;
+int mvfs_ctxt_prefetch_view_max = 0;
+int mvfs_ctxt_prefetch_qmax = 0;
+int mvfs_procpurge_interval = 10;
+int mvfs_credlist_interval = 10;
+int mvfs_cleanhm_interval = 10;
+int mvfs_view_health_policy = MVFS_VWHLTH_POLICY_FAILFAST;
+int mvfs_view_down_interval = 10;
+int mvfs_rpc_adaptive_timeo = 1;
+int mvfs_rpc_rto_min = 100;
+int mvfs_rpc_rto_max = 0;
 
 /*
  * Version string for MFS
@@ -244,6 +286,10 @@ int mvfs_copy_tunable(mvfs_common_data_t *mcdp)
     mcdp->mvfs_rddir_blocks = mvfs_rddir_blocks;
     mcdp->mvfs_client_cache_size = mvfs_client_cache_size;
     mcdp->mvfs_ctxt_atime_refresh = mvfs_ctxt_atime_refresh;
+    mcdp->mvfs_ctxt_prefetch = mvfs_ctxt_prefetch;
+    mcdp->mvfs_ctxt_prefetch_threads = mvfs_ctxt_prefetch_threads;
+    mcdp->mvfs_ctxt_prefetch_view_max = mvfs_ctxt_prefetch_view_max;
+    mcdp->mvfs_ctxt_prefetch_qmax = mvfs_ctxt_prefetch_qmax;
     mcdp->mvfs_threadhash_sz = mvfs_threadhash_sz;
 
     mcdp->mvfs_dncenabled = mvfs_dncenabled;
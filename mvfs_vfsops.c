@@ -91,6 +91,15 @@ mvfs_vobmount_free(void);
 STATIC void
 mvfs_misc_free(void);
 
+STATIC void
+mvfs_maint_init(void);
+
+STATIC void
+mvfs_maint_free(void);
+
+STATIC int
+mvfs_maint_interval(int task);
+
 STATIC int
 mvfs_find_devnum(
     int mmi_minor, 
@@ -263,6 +272,8 @@ mvfs_misc_free(void)
      * Time to unload our data structures
      */
 
+    mvfs_maint_free();
+    MVFS_UNREGISTER_SHRINKERS();
     MVFS_FREE_CREDLIST();
     mvfs_clnt_destroy();
     mvfs_acl_free();
@@ -537,6 +548,10 @@ mvfs_misc_init(
         mvfs_minormap_free();
       mdeperr:
         MVFS_MDEP_MISC_FREE();
+    } else {
+        /* Everything is set up, let the kernel ask for memory back. */
+        MVFS_REGISTER_SHRINKERS();
+        mvfs_maint_init();
     }
     return error;
 }
@@ -566,8 +581,94 @@ mvfs_stats_data_per_cpu_init(void)
 
 /*
  * Routines to search for vob mounts
+ *
+ * Besides the mfs_vobmounts table (indexed by minor number), every VOB
+ * mount is linked into one hash chain per MVFS_VOBMNT_HKEY_* index.  The
+ * chains are only changed under the mvfs_mountlock.  New mounts are
+ * published at the head of a chain after their links are set, and an
+ * unmount does MDKI_RCU_SYNC() before freeing the mntinfo, so a chain can
+ * also be walked under MDKI_RCU_READ_LOCK (see mvfs_find_mount_fhkey).
  */
 
+#define MVFS_VOBMNT_BUCKET(mvdp, key, hval) \
+	(&(mvdp)->mvfs_vobmnt_hash[key][(hval) & (MVFS_VOBMNT_HASHSIZE - 1)])
+
+#define MVFS_VOBMNT_UUIDHASH(u) \
+	((u).time_low ^ ((u_int)(u).time_mid << 16) ^ (u).time_hi_and_version)
+
+STATIC u_int
+mvfs_vobmnt_strhash(mfs_pn_char_t *nm)
+{
+    u_int h = 0;
+
+    if (nm == NULL)
+	return(0);
+    while (*nm != '\0')
+	h = (h * 31) + (u_char)*nm++;
+    return(h);
+}
+
+/*
+ * Add a new VOB mount to the hash indexes.  Called with the mvfs_mountlock
+ * held.
+ */
+STATIC void
+mvfs_vobmnt_addhash(VFS_T *vfsp)
+{
+    struct mfs_mntinfo *mmi = VFS_TO_MMI(vfsp);
+    mvfs_vfs_data_t *mvdp = MDKI_VFS_GET_DATAP();
+    VFS_T **bpp;
+    int key;
+
+    ASSERT(ISLOCKEDBYME(&(mvdp->mvfs_mountlock)));
+
+    mmi->mmi_hval[MVFS_VOBMNT_HKEY_TAG] = mvfs_vobmnt_strhash(mmi->mmi_vobtag);
+    mmi->mmi_hval[MVFS_VOBMNT_HKEY_MNTPATH] =
+		mvfs_vobmnt_strhash(mmi->mmi_mntpath);
+    mmi->mmi_hval[MVFS_VOBMNT_HKEY_OID] =
+		MVFS_VOBMNT_UUIDHASH(mmi->mmi_voboid.obj_uuid);
+    mmi->mmi_hval[MVFS_VOBMNT_HKEY_UUID] =
+		MVFS_VOBMNT_UUIDHASH(mmi->mmi_vobuuid);
+    mmi->mmi_hval[MVFS_VOBMNT_HKEY_FH] = MVFS_VFS_FHKEY(vfsp);
+
+    for (key = 0; key < MVFS_VOBMNT_NHKEYS; key++) {
+	bpp = MVFS_VOBMNT_BUCKET(mvdp, key, mmi->mmi_hval[key]);
+	mmi->mmi_hnext[key] = *bpp;
+    }
+    /* Links must be visible before the mount is. */
+    MDKI_MEMORY_BARRIER();
+    for (key = 0; key < MVFS_VOBMNT_NHKEYS; key++) {
+	bpp = MVFS_VOBMNT_BUCKET(mvdp, key, mmi->mmi_hval[key]);
+	MDKI_ATOMIC_PTR_SET(bpp, vfsp);
+    }
+}
+
+/*
+ * Take a VOB mount out of the hash indexes.  Called with the mvfs_mountlock
+ * held; the caller must MDKI_RCU_SYNC() before freeing the mntinfo.  The
+ * mount's own links are left alone so a lockless walker standing on it can
+ * carry on down the chain.
+ */
+STATIC void
+mvfs_vobmnt_rmhash(VFS_T *vfsp)
+{
+    struct mfs_mntinfo *mmi = VFS_TO_MMI(vfsp);
+    mvfs_vfs_data_t *mvdp = MDKI_VFS_GET_DATAP();
+    VFS_T **vpp;
+    int key;
+
+    ASSERT(ISLOCKEDBYME(&(mvdp->mvfs_mountlock)));
+
+    for (key = 0; key < MVFS_VOBMNT_NHKEYS; key++) {
+	vpp = MVFS_VOBMNT_BUCKET(mvdp, key, mmi->mmi_hval[key]);
+	while (*vpp != NULL && *vpp != vfsp)
+	    vpp = &(VFS_TO_MMI(*vpp)->mmi_hnext[key]);
+	ASSERT(*vpp == vfsp);
+	if (*vpp == vfsp)
+	    MDKI_ATOMIC_PTR_SET(vpp, mmi->mmi_hnext[key]);
+    }
+}
+
 void
 mfs_findvfs_lock()
 {
@@ -592,12 +693,30 @@ tbs_boolean_t case_insensitive;
 mfs_pn_char_t *nm;
 {
     int i;
+    u_int h;
     VFS_T *vfsp;
     int myzoneid = MDKI_GETZONEID();
     mvfs_vfs_data_t *mvdp = MDKI_VFS_GET_DATAP();
 
     ASSERT(ISLOCKED(&(MDKI_VFS_GET_DATAP()->mvfs_mountlock)));
 
+    if (!case_insensitive) {
+	h = mvfs_vobmnt_strhash(nm);
+	for (vfsp = *MVFS_VOBMNT_BUCKET(mvdp, MVFS_VOBMNT_HKEY_TAG, h);
+	     vfsp != NULL;
+	     vfsp = VFS_TO_MMI(vfsp)->mmi_hnext[MVFS_VOBMNT_HKEY_TAG])
+	{
+	    if (VFS_TO_MMI(vfsp)->mmi_hval[MVFS_VOBMNT_HKEY_TAG] == h &&
+		PN_STRCMP(FALSE, VFS_TO_MMI(vfsp)->mmi_vobtag, nm) == 0)
+	    {
+		ASSERT(myzoneid == VFS_TO_MMI(vfsp)->mmi_zoneid);
+		return(vfsp);
+	    }
+	}
+	return(NULL);	/* Not found */
+    }
+
+    /* The tag index is case-sensitive, so scan the table. */
     for (i=0; i <= mvdp->mfs_vobmount_hwm; i++) {
 	vfsp = mvdp->mfs_vobmounts[i];
         if (vfsp == NULL) continue;
@@ -615,18 +734,21 @@ VFS_T *
 mfs_findvfs_mntpath(path)
 mfs_pn_char_t *path;
 {
-    int i;
+    u_int h;
     VFS_T *vfsp;
     int myzoneid = MDKI_GETZONEID();
     mvfs_vfs_data_t *mvdp = MDKI_VFS_GET_DATAP();
 
     ASSERT(ISLOCKED(&(MDKI_VFS_GET_DATAP()->mvfs_mountlock)));
 
-    for (i=0; i <= mvdp->mfs_vobmount_hwm; i++) {
-	vfsp = mvdp->mfs_vobmounts[i];
-        if (vfsp == NULL) continue;
+    h = mvfs_vobmnt_strhash(path);
+    for (vfsp = *MVFS_VOBMNT_BUCKET(mvdp, MVFS_VOBMNT_HKEY_MNTPATH, h);
+	 vfsp != NULL;
+	 vfsp = VFS_TO_MMI(vfsp)->mmi_hnext[MVFS_VOBMNT_HKEY_MNTPATH])
+    {
         /* FIXME: findvfs_mntpath should support case-insensitive someday */
-	if (myzoneid == VFS_TO_MMI(vfsp)->mmi_zoneid &&
+	if (VFS_TO_MMI(vfsp)->mmi_hval[MVFS_VOBMNT_HKEY_MNTPATH] == h &&
+	    myzoneid == VFS_TO_MMI(vfsp)->mmi_zoneid &&
             PN_STRCMP(FALSE, VFS_TO_MMI(vfsp)->mmi_mntpath, path) == 0)
             return(vfsp);
     }
@@ -649,9 +771,36 @@ tbs_boolean_t *unique;
     *unique = TRUE;
 
     ASSERT(ISLOCKED(&(MDKI_VFS_GET_DATAP()->mvfs_mountlock)));
-   
-    if (indx)
-	i = *indx;
+
+    if (indx == NULL) {
+	/*
+	 * Walk the oid chain, returning the match with the lowest table
+	 * index as the table scan below would.
+	 */
+	for (vfsp = *MVFS_VOBMNT_BUCKET(mvdp, MVFS_VOBMNT_HKEY_OID,
+				MVFS_VOBMNT_UUIDHASH(oidp->obj_uuid));
+	     vfsp != NULL;
+	     vfsp = VFS_TO_MMI(vfsp)->mmi_hnext[MVFS_VOBMNT_HKEY_OID])
+	{
+	    if (!MFS_OIDEQ(VFS_TO_MMI(vfsp)->mmi_voboid, *oidp))
+		continue;
+	    ASSERT(myzoneid == VFS_TO_MMI(vfsp)->mmi_zoneid);
+	    if (saved_vfsp == NULL) {
+		saved_vfsp = vfsp;
+	    } else {
+		*unique = FALSE;
+		if (VFS_TO_MMI(vfsp)->mmi_minor <
+		    VFS_TO_MMI(saved_vfsp)->mmi_minor)
+		{
+		    saved_vfsp = vfsp;
+		}
+	    }
+	}
+	return(saved_vfsp);
+    }
+
+    /* Callers iterating with indx want table order, so scan the table. */
+    i = *indx;
     for (; i <= mvdp->mfs_vobmount_hwm; i++) {
 	vfsp = mvdp->mfs_vobmounts[i];
         if (vfsp == NULL) continue;
@@ -676,15 +825,16 @@ mfs_findvfs_uuid(uuidp)
 tbs_uuid_t *uuidp;
 {
     VFS_T *vfsp;
-    int i;
     int myzoneid = MDKI_GETZONEID();
     mvfs_vfs_data_t *mvdp = MDKI_VFS_GET_DATAP();
 
     ASSERT(ISLOCKED(&(MDKI_VFS_GET_DATAP()->mvfs_mountlock)));
 
-    for (i=0; i <= mvdp->mfs_vobmount_hwm; i++) {
-	vfsp = mvdp->mfs_vobmounts[i];
-	if (vfsp == NULL) continue;
+    for (vfsp = *MVFS_VOBMNT_BUCKET(mvdp, MVFS_VOBMNT_HKEY_UUID,
+				    MVFS_VOBMNT_UUIDHASH(*uuidp));
+	 vfsp != NULL;
+	 vfsp = VFS_TO_MMI(vfsp)->mmi_hnext[MVFS_VOBMNT_HKEY_UUID])
+    {
 	if (MFS_UUIDEQ(VFS_TO_MMI(vfsp)->mmi_vobuuid, *uuidp)) {
 	    ASSERT(myzoneid == VFS_TO_MMI(vfsp)->mmi_zoneid);
 	    return(vfsp);
@@ -1392,6 +1542,7 @@ mfs_vmount_subr(
     mvdp->mfs_vobmounts[mmi->mmi_minor] = vfsp;
     mvdp->mfs_vobmount_hwm = (mmi->mmi_minor > mvdp->mfs_vobmount_hwm) ? 
 		mmi->mmi_minor : mvdp->mfs_vobmount_hwm;
+    mvfs_vobmnt_addhash(vfsp);
 
     /* Cleanup (if error) and return */
 
@@ -1626,6 +1777,9 @@ mfs_vunmount(
         mvfs_logfile_close(cd);
     } else {
         mvdp->mfs_vobmounts[mmi->mmi_minor] = NULL;	/* Clear vfs table */
+        mvfs_vobmnt_rmhash(vfsp);
+        /* Let lockless index walkers get off this mount before it is freed. */
+        MDKI_RCU_SYNC();
     }
 
     mfs_svrdestroy(&mmi->mmi_svr);
@@ -1804,6 +1958,158 @@ int mfs_do_sync = 1;
 int mdb_crash = 0;
 
 extern void mfs_prkmem(P_NONE);
+/*
+ * Periodic maintenance tasks.  Ports that can schedule work define
+ * MVFS_MAINT_START() and run each task from its own work item, which calls
+ * mvfs_maint_run() and comes back when it says the task is next due.
+ * mfs_vsync() still runs whichever tasks are due through
+ * mfs_periodic_maintenance(); a task already running elsewhere is skipped.
+ */
+STATIC void
+mvfs_maint_init(void)
+{
+    mvfs_common_data_t *mcdp = MDKI_COMMON_GET_DATAP();
+    time_t now = MDKI_CTIME();
+    int task;
+
+    INITSPLOCK(mcdp->maint.mm_lock, "mvfs_maint_spl");
+    for (task = 0; task < MVFS_MAINT_NTASKS; task++) {
+        mcdp->maint.mm_busy[task] = FALSE;
+        mcdp->maint.mm_due[task] = now + mvfs_maint_interval(task);
+    }
+    if (MVFS_MAINT_START(MVFS_MAINT_NTASKS) != 0) {
+        mvfs_log(MFS_LOG_DEBUG,
+                 "maintenance runs from sync only\n");
+    }
+}
+
+STATIC void
+mvfs_maint_free(void)
+{
+    mvfs_common_data_t *mcdp = MDKI_COMMON_GET_DATAP();
+
+    /* Waits for running work items */
+    MVFS_MAINT_STOP();
+    FREESPLOCK(mcdp->maint.mm_lock);
+}
+
+STATIC int
+mvfs_maint_interval(int task)
+{
+    int secs;
+
+    switch (task) {
+      case MVFS_MAINT_PROCPURGE:
+        secs = mvfs_procpurge_interval;
+        break;
+      case MVFS_MAINT_CREDLIST:
+        secs = mvfs_credlist_interval;
+        break;
+      case MVFS_MAINT_CLEANHM:
+      default:
+        secs = mvfs_cleanhm_interval;
+        break;
+    }
+    return (secs > 0 ? secs : 1);
+}
+
+/*
+ * Run one maintenance task if it is due and not already running.  Returns
+ * the number of seconds until the task is next due.  A run that starts a
+ * whole interval or more after it was due is counted as late; that is the
+ * sign the task (or the queue it runs from) isn't keeping up.
+ */
+int
+mvfs_maint_run(
+    int task,
+    CALL_DATA_T *cd
+)
+{
+    mvfs_common_data_t *mcdp = MDKI_COMMON_GET_DATAP();
+    mvfs_viewroot_data_t *vrdp;
+    VNODE_T *rootvp;
+    timestruc_t stime, dtime, ztime;
+    time_t now;
+    int secs, late;
+    SPL_T s;
+
+    ASSERT(task >= 0 && task < MVFS_MAINT_NTASKS);
+    secs = mvfs_maint_interval(task);
+
+    /* Nothing to do if not initialized, or on the way down in a panic */
+
+    if (mvfs_init_state != MVFS_INIT_COMPLETE || MDKI_PANICSTR())
+        return(secs);
+
+    now = MDKI_CTIME();
+    SPLOCK(mcdp->maint.mm_lock, s);
+    if (mcdp->maint.mm_busy[task]) {
+        SPUNLOCK(mcdp->maint.mm_lock, s);
+        BUMPSTAT(mfs_mnstat.mnmaintbusy[task]);
+        return(secs);
+    }
+    if (now < mcdp->maint.mm_due[task]) {
+        secs = mcdp->maint.mm_due[task] - now;
+        SPUNLOCK(mcdp->maint.mm_lock, s);
+        return(secs);
+    }
+    late = (now >= mcdp->maint.mm_due[task] + secs);
+    mcdp->maint.mm_busy[task] = TRUE;
+    SPUNLOCK(mcdp->maint.mm_lock, s);
+
+    if (late)
+        BUMPSTAT(mfs_mnstat.mnmaintlate[task]);
+    MDKI_HRTIME(&stime);
+
+    switch (task) {
+      case MVFS_MAINT_PROCPURGE:
+        /* 
+         * Check for debug crash requested.
+         * The only way to set this flag is for 'root'
+         * to patch the kernel with a debugger.
+         * mdb_crash can be used for "delayed" crashes
+         * by setting it to a value greater than 1;
+         * it will be decremented on each run and
+         * panic on the transition to 0.
+         */
+
+        if ((mdb_crash != 0) && (--mdb_crash == 0))
+            MDKI_PANIC("MVFS debug crash");
+
+        MDB_CHKPOINT(1);    /* debug scan in background */
+
+        MFS_PRKMEM();	/* Display heap if flag set && using mvfs kmem */
+
+        mvfs_procpurge(MVFS_PROCPURGE_NOSLEEP); /* Clean up dead processes */
+        break;
+      case MVFS_MAINT_CREDLIST:
+        MVFS_FLUSH_CREDLIST(FALSE);
+        break;
+      case MVFS_MAINT_CLEANHM:
+        vrdp = MDKI_VIEWROOT_GET_DATAP();
+        if (vrdp->mfs_viewroot_vfsp) { 	/* Clean up stale HM views */
+            rootvp = vrdp->mfs_viewroot_vp;
+            VN_HOLD(rootvp);
+            /* Flushes views without holding the viewroot lock */
+            mfs_viewdircleanhm(rootvp, cd);
+            ATRIA_VN_RELE(rootvp, cd);
+        }
+        break;
+    }
+
+    MVFS_TIME_DELTA(stime, dtime, ztime);
+    BUMPSTAT(mfs_mnstat.mnmaintrun[task]);
+    BUMPSTAT_VAL(mfs_mnstat.mnmaintusec[task],
+                 (MVFS_STAT_CNT_T) dtime.tv_sec * 1000000 +
+                 dtime.tv_nsec / 1000);
+
+    SPLOCK(mcdp->maint.mm_lock, s);
+    mcdp->maint.mm_busy[task] = FALSE;
+    mcdp->maint.mm_due[task] = MDKI_CTIME() + secs;
+    SPUNLOCK(mcdp->maint.mm_lock, s);
+    return(secs);
+}
+
 /****************************************************************************
  * mfs_periodic_maintenance
  * Perform periodic maintenance tasks for the MVFS
@@ -1812,8 +2118,10 @@ extern void mfs_prkmem(P_NONE);
  *
  * Description:
  *	This routine performs the standard MVFS periodic maintenance
- *	that is not related to any mountpoint. The tasks this routine
- *	performs are:
+ *	that is not related to any mountpoint, by running each of the
+ *	MVFS_MAINT_* tasks that is due (see mvfs_maint_run()).  The
+ *	tasks are:
+ *	- MVFS_MAINT_PROCPURGE:
  *	- Panics the system if the internal flag 'mdb_crash' goes
  *	  to zero (this is a countdown counter do allow for setting
  *	  it with a time-delay).  Normally, it is just set to
@@ -1829,17 +2137,16 @@ extern void mfs_prkmem(P_NONE);
  *	  the flag is set to print the heap (used for debug of memory leaks)
  *	- Call mfs_procpurge() to garbage collect mfs proc structs
  *	  for any dead processes.
- *	- Calls mfs_vwdircleanhm() to timeout any history mode 
- *	  view-tags we created dynamically after a suitable time-period.
+ *	- MVFS_MAINT_CREDLIST: trims the cleartext cred list.
+ *	- MVFS_MAINT_CLEANHM: calls mfs_vwdircleanhm() to timeout any
+ *	  history mode view-tags we created dynamically after a suitable
+ *	  time-period.
  */
 
 void
 mfs_periodic_maintenance(CALL_DATA_T *cd)
 {
-    VNODE_T *rootvp;
-    mvfs_viewroot_data_t *vrdp;
-    mvfs_common_data_t *zmcdp;  
-    int z;
+    int task;
 
     /* Nothing to do if not initialized */
 
@@ -1854,33 +2161,8 @@ mfs_periodic_maintenance(CALL_DATA_T *cd)
 
     if (MDKI_PANICSTR()) return;
 
-    /* 
-     * Check for debug crash requested.
-     * The only way to set this flag is for 'root'
-     * to patch the kernel with a debugger.
-     * mdb_crash can be used for "delayed" crashes
-     * by setting it to a value greater than 1;
-     * it will be decremented on each sync and
-     * panic on the transition to 0.
-     */
-
-    if ((mdb_crash != 0) && (--mdb_crash == 0)) MDKI_PANIC("MVFS debug crash");
-
-    MDB_CHKPOINT(1);    /* debug scan in background */
-
-    MFS_PRKMEM();		/* Display heap if flag set && using mvfs kmem */
-
-    mvfs_procpurge(MVFS_PROCPURGE_NOSLEEP); /* Clean up dead processes */
-    MVFS_FLUSH_CREDLIST(FALSE);
-
-    vrdp = MDKI_VIEWROOT_GET_DATAP();
-    if (vrdp->mfs_viewroot_vfsp) { 		/* Clean up stale HM views */
-	rootvp = vrdp->mfs_viewroot_vp;
-	VN_HOLD(rootvp);
-	/* FIXME: needs nowait option! */
-	mfs_viewdircleanhm(rootvp, cd);
-	ATRIA_VN_RELE(rootvp, cd);
-    }
+    for (task = 0; task < MVFS_MAINT_NTASKS; task++)
+        (void) mvfs_maint_run(task, cd);
 
     return;
 }
@@ -2455,4 +2737,57 @@ mvfs_find_mount(
     MVFS_UNLOCK(&(mvdp->mvfs_mountlock));
     return result;
 }
+
+/*
+ * Check that vp is a VOB object that hasn't been marked stale, so a port
+ * that caches file handle resolutions can tell when one has gone bad.
+ * Returns ESTALE for stale or non-VOB objects.  Read without the mnode lock.
+ */
+int
+mvfs_vget_valid(VNODE_T *vp)
+{
+    mfs_mnode_t *mnp;
+
+    if (!MFS_VPISMFS(vp))
+	return(EINVAL);
+    mnp = VTOM(vp);
+    if (!MFS_ISVOB(mnp) || mnp->mn_hdr.stale)
+	return(ESTALE);
+    return(0);
+}
+
+/*
+ * Like mvfs_find_mount, but only offers eval_func the VOB mounts whose
+ * MVFS_VFS_FHKEY equals fhkey, and does not take the mvfs_mountlock.
+ * eval_func is called under MDKI_RCU_READ_LOCK, so it must not sleep, and
+ * anything it returns must stay valid on its own once the read section
+ * ends (the mount may be going away).
+ */
+void *
+mvfs_find_mount_fhkey(
+    u_int fhkey,
+    void *(* eval_func)(VFS_T *vfsp, void *data),
+    void *data
+)
+{
+    VFS_T *vfsp;
+    void *result  = NULL;
+    mvfs_vfs_data_t *mvdp = MDKI_VFS_GET_DATAP();
+
+    MDKI_RCU_READ_LOCK();
+    for (vfsp = MDKI_ATOMIC_PTR_READ(MVFS_VOBMNT_BUCKET(mvdp,
+					MVFS_VOBMNT_HKEY_FH, fhkey));
+	 vfsp != NULL;
+	 vfsp = MDKI_ATOMIC_PTR_READ(
+		    &(VFS_TO_MMI(vfsp)->mmi_hnext[MVFS_VOBMNT_HKEY_FH])))
+    {
+	if (VFS_TO_MMI(vfsp)->mmi_hval[MVFS_VOBMNT_HKEY_FH] == fhkey) {
+	    result = eval_func(vfsp, data);
+	    if (result != NULL)
+		break;
+	}
+    }
+    MDKI_RCU_READ_UNLOCK();
+    return result;
+}
 static const char vnode_verid_mvfs_vfsops_c[] = "$Id:  79a466bc.83d311e3.89ff.00:01:84:c3:8a:52 $";
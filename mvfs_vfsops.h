@@ -32,6 +32,8 @@ typedef struct mvfs_vfs_data
     u_long mvfs_mount_count;
     VFS_T **mfs_vobmounts;	/* Table of VOB mounts */
     int mfs_vobmount_hwm;	/* High water mark on table */
+    /* Hash indexes over mfs_vobmounts, chained through mmi_hnext[] */
+    VFS_T *mvfs_vobmnt_hash[MVFS_VOBMNT_NHKEYS][MVFS_VOBMNT_HASHSIZE];
 } mvfs_vfs_data_t;
 
 #endif /* MVFS_VFSOPS_H_ */
@@ -57,6 +57,7 @@ typedef struct vfs {
  */
 #define VFS_RDONLY	0x0001		/* VFS read-only */
 #define VFS_NOSUID	0x0002		/* No setuid on VFS */
+#define VFS_UNMOUNTING	0x0004		/* In kill_sb, don't cache handles */
 #define VFS_POSIXACL	0x8000		/* Support POSIX ACL's */
 
 /*
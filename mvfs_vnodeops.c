@@ -2029,8 +2029,8 @@ struct {
         {TRUE, sizeof(mvfs_bhinfo_t), sizeof(mvfs_bhinfo_t)},
         /* MVFS_CMD_SET_BH 30 */
         {TRUE, sizeof(mvfs_bhinfo_t), sizeof(mvfs_bhinfo_t)},
-        /* MVFS_CMD_GET_STATS 31 */
-        {TRUE, sizeof(mvfs_statbufs_t), sizeof(mvfs_statbufs_t)},
+        /* MVFS_CMD_GET_STATS 31 (older callers stop before viewenctime) */
+        {TRUE, offsetof(mvfs_statbufs_t, viewenctime), sizeof(mvfs_statbufs_t)},
         /* MVFS_CMD_SETPROCVIEW 32 */
         {TRUE, sizeof(mvfs_viewtag_info_t), sizeof(mvfs_viewtag_info_t)},
         /* MVFS_CMD_GET_PROCVIEWINFO 33 */
@@ -2100,6 +2100,9 @@ struct {
         /* MVFS_CMD_DISABLE_PVIEW_STATS 64 */
         {TRUE, 0, 0},
 
+        /* MVFS_CMD_READ_DNC_BULK 65 */
+        {TRUE, sizeof(mvfs_iodncbulk_t), sizeof(mvfs_iodncbulk_t)},
+
 /* If you add items here, add them as well to the 32/64 bit conversion
    table in mvfs_transtype.c */
 
@@ -2427,7 +2430,7 @@ time_t nlt;		/* delta must not extend later than this time */
 int bumpgen;
 int goodlvut;
 {
-    time_t delta;
+    time_t delta, dmin, dmax;
     time_t ctime = MDKI_CTIME();
     struct mfs_mntinfo *mmi = VFS_TO_MMI(vfsp);
     mvfs_mnode_data_t *mndp = MDKI_MNODE_GET_DATAP();
@@ -2435,7 +2438,7 @@ int goodlvut;
     ASSERT(MISLOCKED(mnp));
 
     /* To be used from makevobnode, this must only depend on
-       mn_vob.attr and mmi_xxx fields. */
+       mn_vob.attr, mn_vob.ac_adapt and mmi_xxx fields. */
 
     /* Default timeout delta is about 1/10 the time since the last
        modified time.  (Actually 1/8 since that is quicker...) */
@@ -2445,18 +2448,30 @@ int goodlvut;
     /* Clamp to min/max based on dir or not. */
 
     if (mnp->mn_vob.attr.fstat.type == TBS_FTYPE_DIR) {
-        if (delta < mmi->mmi_ac_dirmin) {
-            delta = mmi->mmi_ac_dirmin;
-        } else if (delta > mmi->mmi_ac_dirmax) {
-            delta = mmi->mmi_ac_dirmax;
-        }
+        dmin = mmi->mmi_ac_dirmin;
+        dmax = mmi->mmi_ac_dirmax;
     } else {
-        if (delta < mmi->mmi_ac_regmin) {
-            delta = mmi->mmi_ac_regmin;
-        } else if (delta > mmi->mmi_ac_regmax) {
-            delta = mmi->mmi_ac_regmax;
-        }
-        
+        dmin = mmi->mmi_ac_regmin;
+        dmax = mmi->mmi_ac_regmax;
+    }
+    if (delta < dmin) {
+        delta = dmin;
+    } else if (delta > dmax) {
+        delta = dmax;
+    }
+
+    /* Scale by what revalidations of this object have been finding (see
+       mvfs_ac_adapt()): objects that keep coming back unchanged move
+       towards the max timeout, ones that keep changing towards the min. */
+
+    if (mnp->mn_vob.ac_adapt > 0) {
+        delta <<= mnp->mn_vob.ac_adapt;
+        if (delta > dmax)
+            delta = dmax;
+    } else if (mnp->mn_vob.ac_adapt < 0) {
+        delta >>= -mnp->mn_vob.ac_adapt;
+        if (delta < dmin)
+            delta = dmin;
     }
 
     /* 
@@ -2522,6 +2537,39 @@ int goodlvut;
 #define MFS_EXPMOD	0x4
 #define MFS_DOMOD	0x8
 
+/* Bound on mn_vob.ac_adapt either way; 4 scales the timeout by up to 16. */
+#define MVFS_AC_ADAPT_MAX	4
+
+/*
+ * MVFS_AC_ADAPT - adjust an mnode's attribute timeout scaling after its
+ * attributes have been fetched again.  Each refetch that finds nothing
+ * changed lengthens the next timeout; a change drops any credit built up
+ * and further refetches that find changes shorten it.  The mount's
+ * ac_*min/ac_*max options still bound the result, so setting min == max
+ * turns this off.
+ */
+STATIC void
+mvfs_ac_adapt(
+    mfs_mnode_t *mnp,
+    int changed
+)
+{
+    if (changed) {
+        BUMPSTAT(mfs_acstat.ac_revalchanged);
+        BUMP_VACSTATM(mnp, acstat.ac_revalchanged);
+        if (mnp->mn_vob.ac_adapt > 0) {
+            mnp->mn_vob.ac_adapt = 0;
+        } else if (mnp->mn_vob.ac_adapt > -MVFS_AC_ADAPT_MAX) {
+            mnp->mn_vob.ac_adapt--;
+        }
+    } else {
+        BUMPSTAT(mfs_acstat.ac_revalsame);
+        BUMP_VACSTATM(mnp, acstat.ac_revalsame);
+        if (mnp->mn_vob.ac_adapt < MVFS_AC_ADAPT_MAX)
+            mnp->mn_vob.ac_adapt++;
+    }
+}
+
 /*
  * MVFS_AC_SET_STAT - set the stats in the mnode
  * Return modified flags.
@@ -2588,6 +2636,12 @@ mvfs_ac_set_stat(
                  mnp->mn_vob.attr.mtype, vstatp->mtype);
 #endif
     }
+    /* Attributes set before mean this is a revalidation; learn from it. */
+    if (mnp->mn_vob.attrsettime.tv_sec != 0) {
+        mvfs_ac_adapt(mnp, flags != 0 ||
+                      !MVFS_TIMEVAL_EQUAL(&(mnp->mn_vob.attr.fstat.ctime),
+                                          &(vstatp->fstat.ctime)));
+    }
     /* Cache the view attributes by copying them into the mnode.  The subsequent
     ** calls convert some of the attribute fields and cache those results, too.
     */
@@ -4557,6 +4611,13 @@ mvfs_lookup_ctx(
                 mfs_rebind_self(*vpp, cd);
             }
 
+            /*
+             * Optionally start activating the cleartext of a VOB file
+             * in the background, anticipating an open of it.
+             */
+            if (!error && *vpp != NULL)
+                mvfs_ctxt_prefetch(*vpp, cd);
+
             /* 
              * Check if we looked up ".." and found a vob root synonym.
              *
@@ -36,6 +36,158 @@ mvfs_ramdir_insert(
     VNODE_T *vp,
     CALL_DATA_T *cd
 );
+STATIC u_int
+mvfs_ramdir_nmhash(mfs_pn_char_t *nm);
+STATIC int
+mvfs_ramdir_find(
+    mfs_mnode_t *mnp,
+    mfs_pn_char_t *nm,
+    u_int h
+);
+STATIC void
+mvfs_ramdir_setent(
+    mfs_mnode_t *mnp,
+    int vnum,
+    mfs_pn_char_t *nm,
+    u_int h,
+    VNODE_T *vp
+);
+STATIC mfs_pn_char_t *
+mvfs_ramdir_clearent(
+    mfs_mnode_t *mnp,
+    int vnum
+);
+
+/*
+ * Ramdir hash helpers.  See the comment on struct mfs_ramdirent.
+ */
+#define RAMDIR_CHAIN(mnp, h)	((h) & ((mnp)->mn_ramdir.hashsize - 1))
+
+int
+mvfs_ramdir_hashinit(mnp)
+mfs_mnode_t *mnp;
+{
+    int i;
+
+    ASSERT(MFS_ISVIEWDIR(mnp));
+
+    /* About two slots per chain when the table is full */
+    for (i = 16; i < mnp->mn_ramdir.max / 2; i <<= 1) {}
+    mnp->mn_ramdir.hashtbl = (int *) KMEM_ALLOC(i * sizeof(int), KM_SLEEP);
+    if (mnp->mn_ramdir.hashtbl == NULL)
+        return(ENOMEM);
+    mnp->mn_ramdir.hashsize = i;
+    for (i = 0; i < mnp->mn_ramdir.hashsize; i++)
+        mnp->mn_ramdir.hashtbl[i] = -1;
+    for (i = 0; i < mnp->mn_ramdir.max; i++)
+        mnp->mn_ramdir.ents[i].hnext = -1;
+    MDKI_SEQ_INIT(&(mnp->mn_ramdir.hashseq));
+    return(0);
+}
+
+void
+mvfs_ramdir_hashfree(mnp)
+mfs_mnode_t *mnp;
+{
+    if (mnp->mn_ramdir.hashtbl != NULL)
+        KMEM_FREE(mnp->mn_ramdir.hashtbl,
+                  mnp->mn_ramdir.hashsize * sizeof(int));
+    mnp->mn_ramdir.hashtbl = NULL;
+    mnp->mn_ramdir.hashsize = 0;
+}
+
+STATIC u_int
+mvfs_ramdir_nmhash(nm)
+mfs_pn_char_t *nm;
+{
+    u_int h = 0;
+
+    while (*nm != '\0')
+        h = (h * 31) + (u_char) *nm++;
+    return(h);
+}
+
+/*
+ * Look for nm (whose hash is h) on its chain.  Returns its slot, or -1.
+ * The caller either holds the ramdir's mnode lock, or is in an RCU read
+ * section and rechecks hashseq afterwards.  In the latter case a chain can
+ * be rewired under us, so the walk is bounded.
+ */
+STATIC int
+mvfs_ramdir_find(
+    mfs_mnode_t *mnp,
+    mfs_pn_char_t *nm,
+    u_int h
+)
+{
+    int vnum, n;
+    mfs_pn_char_t *enm;
+
+    vnum = MDKI_ATOMIC_PTR_READ(&(mnp->mn_ramdir.hashtbl[RAMDIR_CHAIN(mnp, h)]));
+    for (n = 0; vnum != -1 && n < mnp->mn_ramdir.max; n++) {
+        if (mnp->mn_ramdir.ents[vnum].nmhash == h) {
+            enm = MDKI_ATOMIC_PTR_READ(&(mnp->mn_ramdir.ents[vnum].nm));
+            if (enm != NULL && STRCMP(enm, nm) == 0)
+                return(vnum);
+        }
+        vnum = MDKI_ATOMIC_PTR_READ(&(mnp->mn_ramdir.ents[vnum].hnext));
+    }
+    return(-1);
+}
+
+/*
+ * Fill in the empty slot vnum and put it on its chain.  The caller holds
+ * the ramdir's mnode lock.
+ */
+STATIC void
+mvfs_ramdir_setent(
+    mfs_mnode_t *mnp,
+    int vnum,
+    mfs_pn_char_t *nm,
+    u_int h,
+    VNODE_T *vp
+)
+{
+    int *chainp = &(mnp->mn_ramdir.hashtbl[RAMDIR_CHAIN(mnp, h)]);
+
+    MDKI_SEQ_WRITE_BEGIN(&(mnp->mn_ramdir.hashseq));
+    mnp->mn_ramdir.ents[vnum].vp = vp;
+    mnp->mn_ramdir.ents[vnum].nmhash = h;
+    mnp->mn_ramdir.ents[vnum].hnext = *chainp;
+    MDKI_ATOMIC_PTR_SET(&(mnp->mn_ramdir.ents[vnum].nm), nm);
+    MDKI_ATOMIC_PTR_SET(chainp, vnum);
+    MDKI_SEQ_WRITE_END(&(mnp->mn_ramdir.hashseq));
+}
+
+/*
+ * Take slot vnum off its chain and empty it, returning its name.  The
+ * caller holds the ramdir's mnode lock, and must MDKI_RCU_SYNC() before
+ * freeing the name or dropping the ramdir's hold on the vnode.  The slot's
+ * own link is left alone so a reader standing on it can keep walking.
+ */
+STATIC mfs_pn_char_t *
+mvfs_ramdir_clearent(
+    mfs_mnode_t *mnp,
+    int vnum
+)
+{
+    int *linkp;
+    mfs_pn_char_t *nm = mnp->mn_ramdir.ents[vnum].nm;
+
+    ASSERT(nm != NULL);
+    linkp = &(mnp->mn_ramdir.hashtbl[RAMDIR_CHAIN(mnp,
+                                      mnp->mn_ramdir.ents[vnum].nmhash)]);
+    while (*linkp != vnum) {
+        ASSERT(*linkp != -1);
+        linkp = &(mnp->mn_ramdir.ents[*linkp].hnext);
+    }
+    MDKI_SEQ_WRITE_BEGIN(&(mnp->mn_ramdir.hashseq));
+    MDKI_ATOMIC_PTR_SET(linkp, mnp->mn_ramdir.ents[vnum].hnext);
+    MDKI_ATOMIC_PTR_SET(&(mnp->mn_ramdir.ents[vnum].nm), NULL);
+    mnp->mn_ramdir.ents[vnum].vp = NULL;
+    MDKI_SEQ_WRITE_END(&(mnp->mn_ramdir.hashseq));
+    return(nm);
+}
 
 /* MFS_RAMDIR_ADD - add a ramdir link to a vnode.
    Assumes the vnode pointer is already held. */
@@ -52,27 +204,31 @@ mfs_ramdir_add(
     register mfs_mnode_t *mnp;
     register int vnum;
     int freevnum;
+    u_int h;
+    mfs_pn_char_t *dupnm;
     int error;
 
     ASSERT(MFS_ISVIEWDIR(VTOM(dvp)));
 
     mnp =  VTOM(dvp);
+    h = mvfs_ramdir_nmhash(nm);
     MLOCK(mnp);
 
     *num = 0;
 
-    /* Must scan for duplicates and first hole to put
+    /* Check for duplicates, then scan for the first hole to put
        element into */
 
+    if (mvfs_ramdir_find(mnp, nm, h) != -1) {
+        MUNLOCK(mnp);
+        return(EEXIST);
+    }
+
     freevnum = -1;
     for (vnum=0; vnum < mnp->mn_ramdir.hwm; vnum++) {
 	if (mnp->mn_ramdir.ents[vnum].nm == NULL) {
-	    if (freevnum == -1) freevnum = vnum;
-	    continue;
-	}
-	if (STRCMP(mnp->mn_ramdir.ents[vnum].nm, nm) == 0) {
-	    MUNLOCK(mnp);
-	    return(EEXIST);
+	    freevnum = vnum;
+	    break;
 	}
     }
 
@@ -84,10 +240,10 @@ mfs_ramdir_add(
     /* If have a slot, fill it in.  Otherwise return an error */
 
     if (freevnum != -1) {
-        mnp->mn_ramdir.ents[freevnum].nm = STRDUP(nm);
-        if (mnp->mn_ramdir.ents[freevnum].nm == NULL) error = ENOMEM;
+        dupnm = STRDUP(nm);
+        if (dupnm == NULL) error = ENOMEM;
         else {
-            mnp->mn_ramdir.ents[freevnum].vp = vp;
+            mvfs_ramdir_setent(mnp, freevnum, dupnm, h, vp);
             mnp->mn_ramdir.mtime.tv_sec = MDKI_CTIME();	
             if (MVFS_ISVTYPE(vp, VDIR))
                 mnp->mn_ramdir.lnk_cnt++;
@@ -118,6 +274,7 @@ mfs_ramdir_remove(
 {
     register mfs_mnode_t *mnp;
     register int vnum;
+    mfs_pn_char_t *oldnm = NULL;
     int error;
 
     ASSERT(MFS_ISVIEWDIR(VTOM(dvp)));
@@ -126,34 +283,35 @@ mfs_ramdir_remove(
     MLOCK(mnp);
 
     error = ENOENT;
-    for (vnum=0; vnum < mnp->mn_ramdir.hwm; vnum++) {
-        if (mnp->mn_ramdir.ents[vnum].nm == NULL) continue;
-        if (STRCMP(mnp->mn_ramdir.ents[vnum].nm, nm) == 0) {
-            if (MVFS_ISVTYPE(mnp->mn_ramdir.ents[vnum].vp, VDIR))
-                mnp->mn_ramdir.lnk_cnt--;
-            *vpp = mnp->mn_ramdir.ents[vnum].vp;  /* return vnode */
-            mnp->mn_ramdir.ents[vnum].vp = NULL;
-            STRFREE(mnp->mn_ramdir.ents[vnum].nm);
+    vnum = mvfs_ramdir_find(mnp, nm, mvfs_ramdir_nmhash(nm));
+    if (vnum != -1) {
+        if (MVFS_ISVTYPE(mnp->mn_ramdir.ents[vnum].vp, VDIR))
+            mnp->mn_ramdir.lnk_cnt--;
+        *vpp = mnp->mn_ramdir.ents[vnum].vp;  /* return vnode */
+        oldnm = mvfs_ramdir_clearent(mnp, vnum);
 
-            mnp->mn_ramdir.mtime.tv_sec = MDKI_CTIME();	
+        mnp->mn_ramdir.mtime.tv_sec = MDKI_CTIME();	
 
-            /* Update high water mark if required */
+        /* Update high water mark if required */
         
-            if (vnum == mnp->mn_ramdir.hwm-1) {
-                while (mnp->mn_ramdir.ents[--vnum].nm == NULL) {}
-                mnp->mn_ramdir.hwm = vnum+1;
-            }
-
-            error = 0;
-            MVFS_WRAP_UPDATE_ATTRS(dvp, cd);
-            break;
+        if (vnum == mnp->mn_ramdir.hwm-1) {
+            while (mnp->mn_ramdir.ents[--vnum].nm == NULL) {}
+            mnp->mn_ramdir.hwm = vnum+1;
         }
+
+        error = 0;
+        MVFS_WRAP_UPDATE_ATTRS(dvp, cd);
     }
     MUNLOCK(mnp);
     if (error)
         *vpp = NULL;
-    else
+    else {
+        /* Let lockless lookups that may have found the entry finish
+           before the name is freed and the caller drops the vnode. */
+        MDKI_RCU_SYNC();
+        STRFREE(oldnm);
         MVFS_RM_DCACHE(*vpp);
+    }
     return(error);
 }
 
@@ -162,6 +320,8 @@ mfs_ramdir_remove(
  * 	Assumes vnode ptrs are held and does a release on them
  */
 
+#define MVFS_PURGEVP_BATCH	8
+
 void
 mfs_ramdir_purgevp(
     VNODE_T *dvp,
@@ -171,36 +331,53 @@ mfs_ramdir_purgevp(
 {
     register mfs_mnode_t *mnp;
     register int vnum;
-    int hwm;
+    mfs_pn_char_t *nm[MVFS_PURGEVP_BATCH];
+    int hwm, next, n, i;
 
     ASSERT(MFS_ISVIEWDIR(VTOM(dvp)));
 
     mnp =  VTOM(dvp);
-    MLOCK(mnp);
 
-    /* Must continue scan to remove multiple links to same object. */
+    /*
+     * Must continue scan to remove multiple links to same object.  Unlink
+     * a batch under the lock, then wait out lockless lookups once for the
+     * whole batch with the lock dropped before freeing the names and
+     * releasing the ramdir's holds.
+     */
+    next = 0;
+    do {
+        n = 0;
+        MLOCK(mnp);
+        for (vnum = next;
+             vnum < mnp->mn_ramdir.hwm && n < MVFS_PURGEVP_BATCH;
+             vnum++)
+        {
+            if (mnp->mn_ramdir.ents[vnum].vp == vp) {
+                if (MVFS_ISVTYPE(vp, VDIR))
+                    mnp->mn_ramdir.lnk_cnt--;
+                nm[n++] = mvfs_ramdir_clearent(mnp, vnum);
 
-    for (vnum=0; vnum < mnp->mn_ramdir.hwm; vnum++) {
-        if (mnp->mn_ramdir.ents[vnum].vp == vp) {
-            if (MVFS_ISVTYPE(vp, VDIR))
-                mnp->mn_ramdir.lnk_cnt--;
-            ATRIA_VN_RELE(vp, cd);
-            mnp->mn_ramdir.ents[vnum].vp = NULL;
-            ASSERT(mnp->mn_ramdir.ents[vnum].nm);
-            STRFREE(mnp->mn_ramdir.ents[vnum].nm);
+                mnp->mn_ramdir.mtime.tv_sec = MDKI_CTIME();	
 
-            mnp->mn_ramdir.mtime.tv_sec = MDKI_CTIME();	
+                /* Update high water mark if releasing the highest slot */
 
-            /* Update high water mark if releasing the highest slot */
+                if (vnum == mnp->mn_ramdir.hwm-1) {
+                    for (hwm = vnum-1; (hwm >= 0) &&
+                                (mnp->mn_ramdir.ents[hwm].nm == NULL); hwm--) {}
+                    mnp->mn_ramdir.hwm = hwm+1;
+                }
+            }
+        }
+        next = vnum;
+        MUNLOCK(mnp);
 
-	    if (vnum == mnp->mn_ramdir.hwm-1) {
-	        hwm = vnum;
-		while (mnp->mn_ramdir.ents[--hwm].nm == NULL) {}
-		mnp->mn_ramdir.hwm = hwm+1;
-	    }
-	}
-    }
-    MUNLOCK(mnp);
+        if (n != 0)
+            MDKI_RCU_SYNC();    /* Wait out lockless lookups */
+        for (i = 0; i < n; i++) {
+            STRFREE(nm[i]);
+            ATRIA_VN_RELE(vp, cd);
+        }
+    } while (n == MVFS_PURGEVP_BATCH);
 }
 
 /* MFS_RAMDIR_PURGE - purge all entries in a ramdir. */
@@ -233,7 +410,10 @@ mfs_ramdir_purge(
                 ATRIA_VN_RELE(mnp->mn_ramdir.ents[vnum].vp, cd);
             mnp->mn_ramdir.ents[vnum].vp = NULL;
         }
+        mnp->mn_ramdir.ents[vnum].hnext = -1;
     }
+    for (vnum=0; vnum < mnp->mn_ramdir.hashsize; vnum++)
+        mnp->mn_ramdir.hashtbl[vnum] = -1;
 }
 
 /* 
@@ -687,6 +867,7 @@ mfs_viewdirlookup(
     char *snm = NULL;
     VNODE_T *vw;
     int len;
+    u_int seq;
     int error, error2;
 
     ASSERT(MFS_ISVIEWDIR(VTOM(dvp)));
@@ -698,6 +879,62 @@ mfs_viewdirlookup(
     hm = mfs_hmname(nm, &snm);
     if (!hm) snm = nm;
 
+    /*
+     * Exact-case lookups go through the name hash without the viewroot
+     * lock.  Once the entry is found in a consistent snapshot, the vnode
+     * is held before leaving the RCU read section; removers wait for that
+     * before they drop the ramdir's hold.  History mode views are left to
+     * the locked scan: mfs_viewdircleanhm() decides one is unused from
+     * its hold count under the lock, which a lockless hold would slip past.
+     */
+    if (!MVFS_PN_CI_LOOKUP(pnp)) {
+        u_int h = mvfs_ramdir_nmhash(snm);
+        int locked_scan = FALSE;
+
+        MDKI_RCU_READ_LOCK();
+        do {
+            seq = MDKI_SEQ_READ_BEGIN(&(mnp->mn_ramdir.hashseq));
+            vnum = mvfs_ramdir_find(mnp, snm, h);
+            vw = (vnum == -1) ? NULL :
+                 MDKI_ATOMIC_PTR_READ(&(mnp->mn_ramdir.ents[vnum].vp));
+        } while (MDKI_SEQ_READ_RETRY(&(mnp->mn_ramdir.hashseq), seq));
+        if (vw != NULL) {
+            if (MFS_VPISMFS(vw) && MFS_ISVIEW(VTOM(vw))) {
+                if (VTOM(vw)->mn_view.hm)
+                    locked_scan = TRUE;
+                else
+                    MFS_HOLDVW(vw);
+            } else {
+                VN_HOLD(vw);
+            }
+        }
+        MDKI_RCU_READ_UNLOCK();
+        if (locked_scan)
+            goto scan;
+
+        if (hm) STRFREE(snm);
+        if (vw == NULL) {
+            *vpp = NULL;
+            return(ENOENT);
+        }
+        if (!hm) {
+            *vpp = vw;
+            return(0);
+        }
+
+        /* History mode name, find/create hm view from this view */
+        if (!MFS_VPISMFS(vw) || !MFS_ISVIEW(VTOM(vw))) {
+            ATRIA_VN_RELE(vw, cd);
+            return(ENOENT);
+        }
+        error = mfs_viewdirhmview(vw, vpp, cd);
+        ATRIA_VN_RELE(vw, cd);		/* Done with view */
+        return(error);
+    }
+
+    /* Case-insensitive lookups and history mode views scan under the lock */
+
+  scan:
     MLOCK(mnp);
     for (vnum=0; vnum < mnp->mn_ramdir.hwm; vnum++) {
 	if (mnp->mn_ramdir.ents[vnum].nm == NULL) continue;
@@ -1008,27 +1245,24 @@ mfs_viewdirhmview(
         return(ENOMEM);
     }
 
-    for (vnum=0; vnum < viewrootmnp->mn_ramdir.hwm; vnum++) {
-	if (viewrootmnp->mn_ramdir.ents[vnum].nm == NULL) continue;
-	if (STRCMP(viewrootmnp->mn_ramdir.ents[vnum].nm, hmnm) == 0) {
-	    hmvw = viewrootmnp->mn_ramdir.ents[vnum].vp;
-	    ASSERT(MFS_VPISMFS(hmvw) && MFS_ISVIEW(VTOM(hmvw)));
+    vnum = mvfs_ramdir_find(viewrootmnp, hmnm, mvfs_ramdir_nmhash(hmnm));
+    if (vnum != -1) {
+        hmvw = viewrootmnp->mn_ramdir.ents[vnum].vp;
+        ASSERT(MFS_VPISMFS(hmvw) && MFS_ISVIEW(VTOM(hmvw)));
 
-	    /* Release locks, dir, storage */
+        /* Release locks, dir, storage */
 
-            *vpp = hmvw;
-            VN_HOLD(hmvw);
-            MUNLOCK(viewrootmnp);
-            ATRIA_VN_RELE(vdir, cd);
-            STRFREE(hmnm);
+        *vpp = hmvw;
+        VN_HOLD(hmvw);
+        MUNLOCK(viewrootmnp);
+        ATRIA_VN_RELE(vdir, cd);
+        STRFREE(hmnm);
 
-            /* Go update the hmview with the latest svr info
-             * from the "master" view
-             */
+        /* Go update the hmview with the latest svr info
+         * from the "master" view
+         */
 
-            goto update_hmview;
-        }
-            
+        goto update_hmview;
     }
 
     /*
@@ -1100,8 +1334,19 @@ update_hmview:
 }
 
 /*
- * Purge unused history mode views from the view directory
+ * Purge unused history mode views from the view directory.
+ *
+ * Flushing a view's cached mnodes can take a long time, so it is not done
+ * under the viewroot lock.  Each pass picks (and holds) a batch of idle HM
+ * views under the lock, flushes them with the lock dropped, then retakes
+ * the lock and unlinks the ones that are still in their slot, still idle
+ * and have no users besides the ramdir and us.
  */
+#define MVFS_CLEANHM_BATCH	16
+
+#define MVFS_HMVIEW_IDLE(vw) \
+    (MFS_VPISMFS(vw) && MFS_ISVIEW(VTOM(vw)) && VTOM(vw)->mn_view.hm && \
+     (VTOM(vw)->mn_view.usedtime + mvfs_idleview_timeout < MDKI_CTIME()))
 
 void
 mfs_viewdircleanhm(
@@ -1112,55 +1357,95 @@ mfs_viewdircleanhm(
     register mfs_mnode_t *mnp;
     register int vnum;
     VNODE_T *vw;
-    int hwm;
+    int hwm, next, n, i, removed;
+    struct {
+        VNODE_T *vw;
+        int vnum;
+        mfs_pn_char_t *nm;      /* Set if unlinked */
+    } cand[MVFS_CLEANHM_BATCH];
 
     ASSERT(MFS_ISVIEWDIR(VTOM(dvp)));
 
     mnp = VTOM(dvp);
-    MLOCK(mnp);
-    for (vnum=0; vnum < mnp->mn_ramdir.hwm; vnum++) {
-	vw = mnp->mn_ramdir.ents[vnum].vp;
+    next = 0;
+    do {
+        /* Pick candidates */
+
+        n = 0;
+        MLOCK(mnp);
+        for (vnum = next;
+             vnum < mnp->mn_ramdir.hwm && n < MVFS_CLEANHM_BATCH;
+             vnum++)
+        {
+            vw = mnp->mn_ramdir.ents[vnum].vp;
+
+            /* XXX Checking VTOM(vw) for NULL to be sure we don't panic
+             * accessing a NULL mnode, this shouldn't happen but has been
+             * seen in practice.  This will help prevent panics until we
+             * understand the root cause of the problem.  See ESC
+             * RATLC01024800. */
+            if ((vw == NULL) || (VTOM(vw) == NULL)) continue;
+            if (MVFS_HMVIEW_IDLE(vw)) {
+                VN_HOLD(vw);
+                cand[n].vw = vw;
+                cand[n].vnum = vnum;
+                cand[n].nm = NULL;
+                n++;
+            }
+        }
+        next = vnum;
+        MUNLOCK(mnp);
+
+        /* Flush cached mnodes for refcnt, without the viewroot lock */
 
-        /* XXX Checking VTOM(vw) for NULL to be sure we don't panic
-         * accessing a NULL mnode, this shouldn't happen but has been seen
-         * in practice.  This will help prevent panics until we understand the
-         * root cause of the problem.  See ESC RATLC01024800. */
-        if ((vw == NULL) || (VTOM(vw) == NULL)) continue;
-        if (MFS_VPISMFS(vw) && 
-                        MFS_ISVIEW(VTOM(vw)) &&
-                        VTOM(vw)->mn_view.hm &&
-                        (VTOM(vw)->mn_view.usedtime+mvfs_idleview_timeout
-                                                        < MDKI_CTIME())) {
-            mfs_mnflushvw(vw, cd);	    	/* Flushed cached mnodes for refcnt */
-            if (V_COUNT(vw) == 1) {	/* No users, remove */
-                ASSERT(mnp->mn_ramdir.ents[vnum].nm);
-                STRFREE(mnp->mn_ramdir.ents[vnum].nm);
+        for (i = 0; i < n; i++)
+            mfs_mnflushvw(cand[i].vw, cd);
+
+        /* Recheck and unlink */
+
+        removed = 0;
+        MLOCK(mnp);
+        for (i = 0; i < n; i++) {
+            vw = cand[i].vw;
+            vnum = cand[i].vnum;
+            if (mnp->mn_ramdir.ents[vnum].vp != vw || !MVFS_HMVIEW_IDLE(vw))
+                continue;
+            if (V_COUNT(vw) == 2) {	/* No users but us, remove */
                 if (MVFS_ISVTYPE(vw, VDIR))
                     mnp->mn_ramdir.lnk_cnt--;
-                mnp->mn_ramdir.ents[vnum].nm = NULL;
-                mnp->mn_ramdir.ents[vnum].vp = NULL;
-                ATRIA_VN_RELE(vw, cd);
+                cand[i].nm = mvfs_ramdir_clearent(mnp, vnum);
+                removed++;
 
                 /* Update dir mod time */
 
                 mnp->mn_ramdir.mtime.tv_sec = MDKI_CTIME();
-                
+
                 /* Update high water mark if releasing highest slot */
 
                 if (vnum == mnp->mn_ramdir.hwm-1) {
-                    for (hwm = vnum-1; (mnp->mn_ramdir.ents[hwm].nm == NULL)
-                                && (hwm >= 0); hwm--) {}
+                    for (hwm = vnum-1; (hwm >= 0) &&
+                                (mnp->mn_ramdir.ents[hwm].nm == NULL); hwm--) {}
                     mnp->mn_ramdir.hwm = hwm+1;
                 }
             } else {
                 /* Update "used time" so we don't constantly try to
                    get rid of a HM view the user is still using */
-		VTOM(vw)->mn_view.usedtime = MDKI_CTIME();
-	    }
-	}
-    }
+                VTOM(vw)->mn_view.usedtime = MDKI_CTIME();
+            }
+        }
+        MUNLOCK(mnp);
+
+        if (removed != 0)
+            MDKI_RCU_SYNC();	/* Wait out lockless lookups */
+        for (i = 0; i < n; i++) {
+            if (cand[i].nm != NULL) {
+                STRFREE(cand[i].nm);
+                ATRIA_VN_RELE(cand[i].vw, cd);	/* The ramdir's hold */
+            }
+            ATRIA_VN_RELE(cand[i].vw, cd);	/* Ours */
+        }
+    } while (n == MVFS_CLEANHM_BATCH);
 
-    MUNLOCK(mnp);
     return;
 }
 
@@ -1205,41 +1490,97 @@ mfs_viewdirflushrvc(CALL_DATA_T *cd)
     return;
 }
 
-#define NEXTSTAMP_INCR(mnp) \
-	    (mnp)->mn_view.vobstamp_next++; \
-	    if ((mnp)->mn_view.vobstamp_next == MVFS_NUM_VOB_STAMPS) \
-		(mnp)->mn_view.vobstamp_next = 0
+/*
+ * Vobstamp table helpers.  See the comment on struct mvfs_vobstamp_tbl.
+ */
+#define VOBSTAMP_SLOT(tbl, h, i)	(((h) + (i)) & ((tbl)->size - 1))
 
-STATIC int mvfs_viewdir_find_vobstamp_subr(
-    struct mfs_mnode *mnp,
-    tbs_uuid_t *uuid
+STATIC int mvfs_vobstamp_probe(
+    struct mvfs_vobstamp_tbl *tbl,
+    tbs_uuid_t *uuid,
+    int *freep
+);
+STATIC struct mvfs_vobstamp_tbl *mvfs_vobstamp_grow(
+    struct mvfs_vobstamp_tbl *otbl
 );
 
+/*
+ * Look for uuid in tbl.  Returns its slot, or -1.  If freep is not NULL,
+ * it is set to the first free slot on the probe sequence (or -1 if there
+ * is none), which is where the uuid should go.
+ */
 STATIC int
-mvfs_viewdir_find_vobstamp_subr(mnp, uuid)
-register struct mfs_mnode *mnp;
-tbs_uuid_t *uuid;
+mvfs_vobstamp_probe(
+    struct mvfs_vobstamp_tbl *tbl,
+    tbs_uuid_t *uuid,
+    int *freep
+)
 {
-    register int i;
-
-    for (i = 0; i < MVFS_NUM_VOB_STAMPS; i++) {
-	if (MFS_UUIDEQ(mnp->mn_view.vobstamps[i].vobuuid, *uuid)) {
-	    /* Since we'll use this entry now, make sure it's not the next
-	     * ejection candidate so it sticks around for a while.
-	     */
-	    if (mnp->mn_view.vobstamp_next == i) {
-		NEXTSTAMP_INCR(mnp);
-	    }
-	    return i;
-	}
+    u_long h;
+    int i, slot;
+
+    if (freep != NULL) *freep = -1;
+    if (tbl == NULL) return -1;
+
+    h = mfs_uuid_to_hash32(uuid);
+    for (i = 0; i < MVFS_VOBSTAMP_PROBES && i < tbl->size; i++) {
+        slot = VOBSTAMP_SLOT(tbl, h, i);
+        if (MFS_UUIDNULL(tbl->ents[slot].vobuuid)) {
+            /* Nothing is ever removed, so the uuid isn't further on. */
+            if (freep != NULL) *freep = slot;
+            return -1;
+        }
+        if (MFS_UUIDEQ(tbl->ents[slot].vobuuid, *uuid)) {
+            return slot;
+        }
     }
     return -1;
 }
 
+/*
+ * Make a table twice the size of otbl (or the minimum size if there is
+ * none) holding its entries.  Returns NULL if we are at the maximum size.
+ * Called with the view's stamplock (a sleep lock) held, so it waits for
+ * memory rather than leave the table full.  The new table is not yet
+ * visible to anyone.
+ */
+STATIC struct mvfs_vobstamp_tbl *
+mvfs_vobstamp_grow(
+    struct mvfs_vobstamp_tbl *otbl
+)
+{
+    struct mvfs_vobstamp_tbl *ntbl;
+    int size, i, slot;
+
+    size = (otbl == NULL) ? MVFS_VOBSTAMP_TBL_MIN : otbl->size * 2;
+    if (size > MVFS_VOBSTAMP_TBL_MAX) return NULL;
+
+    ntbl = (struct mvfs_vobstamp_tbl *)
+        KMEM_ALLOC(MVFS_VOBSTAMP_TBL_BYTES(size), KM_SLEEP);
+    if (ntbl == NULL) return NULL;
+    BZERO(ntbl, MVFS_VOBSTAMP_TBL_BYTES(size));
+    ntbl->size = size;
+    ntbl->retired = otbl;
+
+    if (otbl != NULL) {
+        for (i = 0; i < otbl->size; i++) {
+            if (MFS_UUIDNULL(otbl->ents[i].vobuuid)) continue;
+            (void) mvfs_vobstamp_probe(ntbl, &(otbl->ents[i].vobuuid), &slot);
+            if (slot == -1) continue;	/* Unlucky, it just gets refetched */
+            ntbl->ents[slot] = otbl->ents[i];
+            ntbl->count++;
+        }
+    }
+    return ntbl;
+}
+
 /*
  * mvfs_viewdir_find_vobstamp: find the VOB stamp matching the given replica
  * uuid.  If no stamp is cached, or the stamp is out of date,
  * return 0.  If stamp is valid, return 1.
+ *
+ * This is on the attribute cache hot path, so it takes no lock: it reads
+ * the table and retries if an update got in the way.
  */
 int
 mvfs_viewdir_find_vobstamp(vw, vobuuid, outstamp, outlife)
@@ -1249,34 +1590,38 @@ struct timeval *outstamp;
 time_t *outlife;
 {
     register int i;
-    SPL_T s;
+    u_int seq;
     time_t ctime;
+    struct mvfs_vobstamp_tbl *tbl;
+    struct mvfs_vobstamp vs;
     register struct mfs_mnode *mnp = VTOM(vw);
 
     ASSERT(MFS_ISVIEW(mnp));
     ctime = MDKI_CTIME();
 
-    MVFS_LOCK(STAMPLOCK_ADDR(mnp));
-    i = mvfs_viewdir_find_vobstamp_subr(mnp, vobuuid);
-    if (i != -1 && ctime <= mnp->mn_view.vobstamps[i].valid_thru) {
-	*outstamp = mnp->mn_view.vobstamps[i].lvut;
-	*outlife = mnp->mn_view.vobstamps[i].valid_thru;
-	/* Since we just used this entry, make sure it's not the next
-	 * ejection candidate
-	 */
-	if (mnp->mn_view.vobstamp_next == i) {
-	    NEXTSTAMP_INCR(mnp);
-	}
-	MVFS_UNLOCK(STAMPLOCK_ADDR(mnp));
+    do {
+        seq = MDKI_SEQ_READ_BEGIN(&(mnp->mn_view.stampseq));
+        tbl = MDKI_ATOMIC_PTR_READ(&(mnp->mn_view.vobstamps));
+        i = mvfs_vobstamp_probe(tbl, vobuuid, NULL);
+        if (i != -1) {
+            vs = tbl->ents[i];
+        }
+    } while (MDKI_SEQ_READ_RETRY(&(mnp->mn_view.stampseq), seq));
+
+    if (i != -1 && ctime <= vs.valid_thru) {
+	*outstamp = vs.lvut;
+	*outlife = vs.valid_thru;
 	return 1;
     }
-    MVFS_UNLOCK(STAMPLOCK_ADDR(mnp));
     return 0;
 }
 
 /*
  * mvfs_viewdir_save_vobstamp: Save the new LVUT in the view for this VOB.
- * Replace the previous entry for this VOB, if possible.
+ * Replace the previous entry for this VOB, if possible.  A new VOB goes in
+ * a free slot, growing the table first if it is getting full; if it can't
+ * grow, the entry on the VOB's probe sequence that runs out first is
+ * replaced.
  */
 void
 mvfs_viewdir_save_vobstamp(vw, vobuuid, timeout, newlvut)
@@ -1286,32 +1631,81 @@ time_t timeout;
 struct timeval *newlvut;
 {
     register int i;
-    SPL_T s;
+    int freeslot, j, slot;
+    u_long h;
+    struct mvfs_vobstamp_tbl *tbl, *ntbl;
     register struct mfs_mnode *mnp = VTOM(vw);
 
     ASSERT(MFS_ISVIEW(mnp));
 
     MVFS_LOCK(STAMPLOCK_ADDR(mnp));
-    i = mvfs_viewdir_find_vobstamp_subr(mnp, vobuuid);
+    tbl = mnp->mn_view.vobstamps;
+    i = mvfs_vobstamp_probe(tbl, vobuuid, &freeslot);
+    if (i == -1 &&
+        (tbl == NULL || freeslot == -1 || (tbl->count + 1) * 4 > tbl->size * 3) &&
+        (ntbl = mvfs_vobstamp_grow(tbl)) != NULL)
+    {
+        MDKI_SEQ_WRITE_BEGIN(&(mnp->mn_view.stampseq));
+        MDKI_ATOMIC_PTR_SET(&(mnp->mn_view.vobstamps), ntbl);
+        MDKI_SEQ_WRITE_END(&(mnp->mn_view.stampseq));
+        tbl = ntbl;
+        i = mvfs_vobstamp_probe(tbl, vobuuid, &freeslot);
+    }
+    if (tbl == NULL) {
+        /* Never had a table and can't get one now */
+        MVFS_UNLOCK(STAMPLOCK_ADDR(mnp));
+        return;
+    }
+
+    MDKI_SEQ_WRITE_BEGIN(&(mnp->mn_view.stampseq));
     if (i == -1) {
-	/*
-	 * eject some other entry.
-	 */
-	i = mnp->mn_view.vobstamp_next;
-	NEXTSTAMP_INCR(mnp);
-	mnp->mn_view.vobstamps[i].vobuuid = *vobuuid;
+        if (freeslot != -1) {
+            i = freeslot;
+            tbl->count++;
+        } else {
+	    /*
+	     * eject some other entry.
+	     */
+            h = mfs_uuid_to_hash32(vobuuid);
+            i = VOBSTAMP_SLOT(tbl, h, 0);
+            for (j = 1; j < MVFS_VOBSTAMP_PROBES && j < tbl->size; j++) {
+                slot = VOBSTAMP_SLOT(tbl, h, j);
+                if (tbl->ents[slot].valid_thru < tbl->ents[i].valid_thru)
+                    i = slot;
+            }
+        }
+	tbl->ents[i].vobuuid = *vobuuid;
+        tbl->ents[i].valid_thru = 0;
     }
-    mnp->mn_view.vobstamps[i].lvut = *newlvut;
-    if (mnp->mn_view.vobstamps[i].valid_thru < timeout) {
+    tbl->ents[i].lvut = *newlvut;
+    if (tbl->ents[i].valid_thru < timeout) {
         MDB_XLOG((MDB_LVUT,
 		  "save_vobstamp: timeout (%"KS_FMT_TIME_T_D") < existing timeout (%ld)\n",
-		  timeout, mnp->mn_view.vobstamps[i].valid_thru));
+		  timeout, tbl->ents[i].valid_thru));
     }
-    mnp->mn_view.vobstamps[i].valid_thru = timeout;
+    tbl->ents[i].valid_thru = timeout;
+    MDKI_SEQ_WRITE_END(&(mnp->mn_view.stampseq));
     MVFS_UNLOCK(STAMPLOCK_ADDR(mnp));
     return;
 }
 
+/*
+ * mvfs_viewdir_free_vobstamps: free a view node's vobstamp tables when the
+ * node is destroyed.  Nobody can be reading them by then.
+ */
+void
+mvfs_viewdir_free_vobstamps(mnp)
+struct mfs_mnode *mnp;
+{
+    struct mvfs_vobstamp_tbl *tbl, *next;
+
+    for (tbl = mnp->mn_view.vobstamps; tbl != NULL; tbl = next) {
+        next = tbl->retired;
+        KMEM_FREE(tbl, MVFS_VOBSTAMP_TBL_BYTES(tbl->size));
+    }
+    mnp->mn_view.vobstamps = NULL;
+}
+
 int
 mvfs_viewinit(mvfs_cache_sizes_t *mma_sizes)
 {
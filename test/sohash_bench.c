@@ -0,0 +1,407 @@
+/* * (C) Copyright IBM Corporation 2011. */
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2, or (at your option)
+ any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301, USA
+
+
+ Author: IBM Corporation
+ This module is part of the IBM (R) Rational (R) ClearCase (R)
+ Multi-version file system (MVFS).
+ For support, please visit http://www.ibm.com/software/support
+
+*/
+/*
+ * User-space stress and throughput test of the two MVFS thread hashes:
+ * the split ordered hash in mvfs_sohash_table.c (built with the shims in
+ * sohash_ushim.h) and a model of the splock pool hash in mvfs_procops.c
+ * (MVFS_THREADHASH_SZ_DEFAULT chains, one spinlock per chain as with
+ * HASH_SPLOCK_PER_CHAIN on Linux).
+ *
+ * Each worker stands for one kernel thread doing vnode ops: it looks up
+ * its own entry as mvfs_mythread() does, and every "churn" lookups it
+ * deletes the entry and inserts a new one, as a thread exit and a new
+ * thread would.  The table also holds "resident" entries for threads that
+ * are not running.  Every lookup must find the worker's current entry;
+ * any miss or wrong entry is counted as an error and makes the run fail.
+ *
+ * Usage: sohash_bench [-d msecs] [-r resident] [-c churn] [threads ...]
+ * With no thread counts it runs 1 2 4 8 16 32 64 128.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sohash_ushim.h"
+#include "mvfs_sohash_table.h"
+
+#define BENCH_CHAINS        511     /* MVFS_THREADHASH_SZ_DEFAULT */
+#define BENCH_MAXTHREADS    1024
+
+typedef struct bench_thr {
+    struct bench_thr *next;         /* splock hash chain */
+    uint32_t key;                   /* as MDKI_THREAD_SOHASH_KEY */
+    int owner;                      /* worker index, -1 if resident */
+    unsigned gen;                   /* bumped by each re-insert */
+} bench_thr_t;
+
+typedef struct bench_ops {
+    const char *name;
+    int (*init)(void);
+    void (*fini)(void);
+    int (*insert)(bench_thr_t *thr);
+    bench_thr_t *(*find)(uint32_t key, int owner);
+    int (*delete)(uint32_t key, int owner);
+} bench_ops_t;
+
+static volatile int bench_stop;
+static int bench_msecs = 1000;
+static int bench_resident = 1024;
+static int bench_churn = 1000;
+
+/* Keys look like the kernel's: a pid plus a task pointer >> 2. */
+static uint32_t
+bench_key(int id, unsigned gen)
+{
+    return (uint32_t)(4096 + id) + (uint32_t)((0x1000000UL +
+            ((unsigned long) id * 64 + gen) * 0x2400UL) >> 2);
+}
+
+/* Splock pool thread hash, as in mvfs_procops.c. */
+
+static bench_thr_t *spl_chain[BENCH_CHAINS];
+static pthread_spinlock_t spl_lock[BENCH_CHAINS];
+
+static int
+spl_init(void)
+{
+    int i;
+
+    for (i = 0; i < BENCH_CHAINS; i++) {
+        spl_chain[i] = NULL;
+        pthread_spin_init(&spl_lock[i], PTHREAD_PROCESS_PRIVATE);
+    }
+    return 0;
+}
+
+static void
+spl_fini(void)
+{
+    bench_thr_t *thr, *nthr;
+    int i;
+
+    for (i = 0; i < BENCH_CHAINS; i++) {
+        for (thr = spl_chain[i]; thr != NULL; thr = nthr) {
+            nthr = thr->next;
+            free(thr);
+        }
+        pthread_spin_destroy(&spl_lock[i]);
+    }
+}
+
+static int
+spl_insert(bench_thr_t *thr)
+{
+    int h = thr->key % BENCH_CHAINS;
+
+    pthread_spin_lock(&spl_lock[h]);
+    thr->next = spl_chain[h];
+    spl_chain[h] = thr;
+    pthread_spin_unlock(&spl_lock[h]);
+    return 0;
+}
+
+static bench_thr_t *
+spl_find(uint32_t key, int owner)
+{
+    bench_thr_t *thr;
+    int h = key % BENCH_CHAINS;
+
+    pthread_spin_lock(&spl_lock[h]);
+    for (thr = spl_chain[h]; thr != NULL; thr = thr->next) {
+        if (thr->key == key && thr->owner == owner)
+            break;
+    }
+    pthread_spin_unlock(&spl_lock[h]);
+    return thr;
+}
+
+static int
+spl_delete(uint32_t key, int owner)
+{
+    bench_thr_t **thrp, *thr;
+    int h = key % BENCH_CHAINS;
+
+    pthread_spin_lock(&spl_lock[h]);
+    for (thrp = &spl_chain[h]; (thr = *thrp) != NULL; thrp = &thr->next) {
+        if (thr->key == key && thr->owner == owner) {
+            *thrp = thr->next;
+            break;
+        }
+    }
+    pthread_spin_unlock(&spl_lock[h]);
+    if (thr == NULL)
+        return ENOENT;
+    free(thr);
+    return 0;
+}
+
+/* Split ordered hash, set up as mvfs_procinit() does. */
+
+static sohash_table_t *so_hashd;
+
+static SOHASH_KEY_T
+so_get_key(void *data)
+{
+    return ((bench_thr_t *) data)->key;
+}
+
+static void
+so_free_data(void *data)
+{
+    free(data);
+}
+
+static SOHASH_BOOL_T
+so_verify(sohash_entry_t *entry, void *arg)
+{
+    return (((bench_thr_t *) entry->data)->owner == *(int *) arg) ?
+           SOHASH_TRUE : SOHASH_FALSE;
+}
+
+static void
+so_on_delete(sohash_entry_t *entry)
+{
+}
+
+static int
+so_init(void)
+{
+    sohash_init_args_t args;
+
+    memset(&args, 0, sizeof(args));
+    MDKI_ATOMIC_SET_UINT32(&args.sohash_num_segments, SOHASH_SET_SEG_DEFAULT);
+    args.sohash_segment_sz = SOHASH_SET_SEG_DEFAULT;
+    args.sohash_keys_unique = SOKEY_UNIQUE_FALSE;
+    args.fn_verify_matched_entry = so_verify;
+    args.fn_data_free = so_free_data;
+    args.fn_compute_sohashkey = so_get_key;
+    args.fn_on_delete = so_on_delete;
+    so_hashd = sohash_init_hashtable(&args);
+    return so_hashd == NULL ? ENOMEM : 0;
+}
+
+static int
+so_insert(bench_thr_t *thr)
+{
+    sohash_entry_t *entry;
+
+    return sohash_insert_entry(so_hashd, thr->key, thr, &thr->owner, &entry);
+}
+
+static bench_thr_t *
+so_find(uint32_t key, int owner)
+{
+    sohash_entry_t *entry;
+
+    entry = sohash_find_entry(so_hashd, key, &owner);
+    return entry == NULL ? NULL : (bench_thr_t *) entry->data;
+}
+
+static int
+so_delete(uint32_t key, int owner)
+{
+    return sohash_delete_entry(so_hashd, key, &owner);
+}
+
+static void
+so_fini(void)
+{
+    int i;
+
+    for (i = 0; i < bench_resident; i++)
+        (void) so_delete(bench_key(BENCH_MAXTHREADS + i, 0), -1);
+    if (sohash_cleanup_hashtable(so_hashd) != 0)
+        fprintf(stderr, "sohash_cleanup_hashtable failed\n");
+}
+
+static const bench_ops_t bench_tables[] = {
+    { "splock", spl_init, spl_fini, spl_insert, spl_find, spl_delete },
+    { "sohash", so_init, so_fini, so_insert, so_find, so_delete },
+};
+
+typedef struct bench_worker {
+    pthread_t tid;
+    const bench_ops_t *ops;
+    int id;
+    unsigned long ops_done;
+    unsigned long errors;
+} bench_worker_t;
+
+static bench_thr_t *
+bench_thr_alloc(int id, int owner, unsigned gen)
+{
+    bench_thr_t *thr = malloc(sizeof(*thr));
+
+    if (thr == NULL) {
+        perror("malloc");
+        exit(2);
+    }
+    thr->next = NULL;
+    thr->key = bench_key(id, gen);
+    thr->owner = owner;
+    thr->gen = gen;
+    return thr;
+}
+
+static void *
+bench_worker(void *arg)
+{
+    bench_worker_t *w = arg;
+    const bench_ops_t *ops = w->ops;
+    bench_thr_t *thr;
+    unsigned gen = 0;
+    uint32_t key = bench_key(w->id, gen);
+    unsigned long n = 0;
+
+    if (ops->insert(bench_thr_alloc(w->id, w->id, gen)) != 0)
+        w->errors++;
+    while (!bench_stop) {
+        thr = ops->find(key, w->id);
+        if (thr == NULL || thr->key != key || thr->gen != gen)
+            w->errors++;
+        if (++n % bench_churn == 0) {
+            if (ops->delete(key, w->id) != 0)
+                w->errors++;
+            key = bench_key(w->id, ++gen);
+            if (ops->insert(bench_thr_alloc(w->id, w->id, gen)) != 0)
+                w->errors++;
+        }
+    }
+    if (ops->delete(key, w->id) != 0)
+        w->errors++;
+    w->ops_done = n;
+    return NULL;
+}
+
+/* Returns lookups per second, or -1 if anything went wrong. */
+static double
+bench_run(const bench_ops_t *ops, int nthreads)
+{
+    static bench_worker_t workers[BENCH_MAXTHREADS];
+    struct timespec t0, t1, nap;
+    unsigned long total = 0, errors = 0;
+    double secs;
+    int i;
+
+    if (ops->init() != 0) {
+        fprintf(stderr, "%s: init failed\n", ops->name);
+        return -1;
+    }
+    for (i = 0; i < bench_resident; i++) {
+        if (ops->insert(bench_thr_alloc(BENCH_MAXTHREADS + i, -1, 0)) != 0)
+            errors++;
+    }
+    bench_stop = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i = 0; i < nthreads; i++) {
+        workers[i].ops = ops;
+        workers[i].id = i;
+        workers[i].ops_done = 0;
+        workers[i].errors = 0;
+        if (pthread_create(&workers[i].tid, NULL, bench_worker,
+                           &workers[i]) != 0)
+        {
+            perror("pthread_create");
+            exit(2);
+        }
+    }
+    nap.tv_sec = bench_msecs / 1000;
+    nap.tv_nsec = (bench_msecs % 1000) * 1000000L;
+    nanosleep(&nap, NULL);
+    bench_stop = 1;
+    for (i = 0; i < nthreads; i++) {
+        pthread_join(workers[i].tid, NULL);
+        total += workers[i].ops_done;
+        errors += workers[i].errors;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    ops->fini();
+
+    if (errors != 0) {
+        fprintf(stderr, "%s: %d threads: %lu errors\n",
+                ops->name, nthreads, errors);
+        return -1;
+    }
+    secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+    return total / secs;
+}
+
+int
+main(int argc, char **argv)
+{
+    static const int def_threads[] = { 1, 2, 4, 8, 16, 32, 64, 128 };
+    int threads[64], nthreads = 0;
+    double rate[2];
+    int i, t, opt, failed = 0;
+
+    while ((opt = getopt(argc, argv, "d:r:c:")) != -1) {
+        switch (opt) {
+          case 'd': bench_msecs = atoi(optarg); break;
+          case 'r': bench_resident = atoi(optarg); break;
+          case 'c': bench_churn = atoi(optarg); break;
+          default:
+            fprintf(stderr, "usage: %s [-d msecs] [-r resident] "
+                    "[-c churn] [threads ...]\n", argv[0]);
+            return 2;
+        }
+    }
+    for (i = optind; i < argc && nthreads < 64; i++) {
+        t = atoi(argv[i]);
+        if (t < 1 || t > BENCH_MAXTHREADS) {
+            fprintf(stderr, "thread count must be 1-%d\n", BENCH_MAXTHREADS);
+            return 2;
+        }
+        threads[nthreads++] = t;
+    }
+    if (nthreads == 0) {
+        for (i = 0; i < (int)(sizeof(def_threads) / sizeof(def_threads[0])); i++)
+            threads[nthreads++] = def_threads[i];
+    }
+    if (bench_msecs <= 0 || bench_resident < 0 || bench_churn <= 0) {
+        fprintf(stderr, "bad option value\n");
+        return 2;
+    }
+
+    printf("cpus %ld, %d ms per run, %d resident entries, churn every %d\n",
+           sysconf(_SC_NPROCESSORS_ONLN), bench_msecs, bench_resident,
+           bench_churn);
+    printf("%8s %16s %16s %8s\n", "threads", "splock lookups/s",
+           "sohash lookups/s", "ratio");
+    for (i = 0; i < nthreads; i++) {
+        for (t = 0; t < 2; t++) {
+            if ((rate[t] = bench_run(&bench_tables[t], threads[i])) < 0)
+                failed = 1;
+        }
+        printf("%8d %16.0f %16.0f %8.2f\n", threads[i], rate[0], rate[1],
+               rate[0] > 0 ? rate[1] / rate[0] : 0.0);
+        fflush(stdout);
+    }
+    return failed;
+}
@@ -0,0 +1,80 @@
+/* * (C) Copyright IBM Corporation 2011. */
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2, or (at your option)
+ any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301, USA
+
+
+ Author: IBM Corporation
+ This module is part of the IBM (R) Rational (R) ClearCase (R)
+ Multi-version file system (MVFS).
+ For support, please visit http://www.ibm.com/software/support
+
+*/
+/*
+ * User-space shims for building mvfs_sohash_table.c outside the kernel
+ * (see sohash_bench.c).  This file is forced in ahead of the source with
+ * -include; it claims the include guards of the MVFS kernel headers and
+ * supplies just the MDKI atomics, barriers, allocator and logging the
+ * table uses, mapped the way mvfs_mdep_linux.h maps them onto the
+ * kernel's primitives.
+ */
+#ifndef SOHASH_USHIM_H_
+#define SOHASH_USHIM_H_
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Keep the kernel headers out. */
+#define MVFS_SYSTM_H_
+#define MVFS_H_
+#define MFS_DEBUG_H_
+
+typedef int atomic_t;
+
+/* As in mvfs_mdep_linux.h: CAS return 1 on success, reads and sets of
+ * pointers are volatile accesses, counters are full-barrier atomics.
+ */
+#define MDKI_ATOMIC_CAS_UINT32(addr, cmpval, newval) \
+    (__sync_bool_compare_and_swap((addr), (cmpval), (newval)) ? 1 : 0)
+#define MDKI_ATOMIC_CAS_PTR(addr, cmp_addr, new_addr) \
+    (__sync_bool_compare_and_swap((void **)(addr), (void *)(cmp_addr), \
+                                  (void *)(new_addr)) ? 1 : 0)
+#define MDKI_ATOMIC_INCR_UINT32(addr)       ((void) __sync_fetch_and_add((addr), 1))
+#define MDKI_ATOMIC_DECR_UINT32(addr)       ((void) __sync_fetch_and_sub((addr), 1))
+#define MDKI_ATOMIC_INCR_UINT32_NV(addr)    __sync_add_and_fetch((addr), 1)
+#define MDKI_ATOMIC_SET_UINT32(addr, val)   (*((volatile atomic_t *)(addr)) = (val))
+#define MDKI_ATOMIC_READ_UINT32(addr)       (*((volatile atomic_t *)(addr)))
+#define MDKI_ATOMIC_PTR_READ(addr)     (*((volatile __typeof__(*(addr)) *)(addr)))
+#define MDKI_ATOMIC_PTR_SET(addr, val) \
+    ((*((volatile __typeof__(*(addr)) *)(addr))) = (val))
+#define MDKI_MEMORY_BARRIER()               __sync_synchronize()
+
+#define KM_SLEEP                0
+#define KM_NOSLEEP              1
+#define KMEM_ALLOC(size, flag)  ((void *) malloc(size))
+#define KMEM_FREE(ptr, size)    free(ptr)
+#define BZERO(ptr, len)         memset((ptr), 0, (len))
+
+#define ASSERT(expr)            assert(expr)
+#define MDKI_PANIC(msg)         (fprintf(stderr, "panic: %s\n", (msg)), abort())
+
+#define MFS_LOG_ERR             1
+#define mvfs_log(level, ...)    fprintf(stderr, __VA_ARGS__)
+#define MDB_XLOG(args)
+#define MDB_SOHASH              0
+
+#endif /* SOHASH_USHIM_H_ */
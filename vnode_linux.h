@@ -79,6 +79,9 @@
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,32)
 #include <linux/fs_struct.h>
 #endif
+#ifdef CONFIG_DCACHE_WORD_ACCESS
+#include <asm/word-at-a-time.h>
+#endif
 
 /* common adapter headers */
 #include "mvfs_mdki.h"
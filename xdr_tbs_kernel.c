@@ -52,7 +52,18 @@ xdr_timeval(xdrs, objp)
     XDR *xdrs;
     struct timeval *objp;
 {
-
+    rpc_inline_t *buf;
+
+    if ((buf = XDR_INLINE(xdrs, 2 * BYTES_PER_XDR_UNIT)) != NULL) {
+	if (xdrs->x_op == XDR_ENCODE) {
+	    IXDR_PUT_LONG(buf, objp->tv_sec);
+	    IXDR_PUT_LONG(buf, objp->tv_usec);
+	} else {
+	    objp->tv_sec = IXDR_GET_LONG(buf);
+	    objp->tv_usec = IXDR_GET_LONG(buf);
+	}
+	return (TRUE);
+    }
     if (!xdr_long(xdrs, &objp->tv_sec) ||
 	!xdr_long(xdrs, &objp->tv_usec))
 	return (FALSE);
@@ -107,6 +118,7 @@ EZ_XDR_ROUTINE(tbs_uuid_t)
     ks_uint32_t l1,l2,l3;
     int i; 
     ks_uint32_t ulong_time_low;
+    rpc_inline_t *buf;
 
 
     if (xdrs->x_op == XDR_FREE)
@@ -128,10 +140,23 @@ EZ_XDR_ROUTINE(tbs_uuid_t)
 	}
     }
     ulong_time_low = objp->time_low;
-    if (!XDR_KS_U_INT32(xdrs, &ulong_time_low) ||
-	!XDR_KS_U_INT32(xdrs, &l1) ||
-	!XDR_KS_U_INT32(xdrs, &l2) ||
-	!XDR_KS_U_INT32(xdrs, &l3))
+    if ((buf = XDR_INLINE(xdrs, 4 * BYTES_PER_XDR_UNIT)) != NULL) {
+	/* The whole UUID is in the buffer; move it without per-word calls. */
+	if (xdrs->x_op == XDR_ENCODE) {
+	    IXDR_PUT_U_LONG(buf, ulong_time_low);
+	    IXDR_PUT_U_LONG(buf, l1);
+	    IXDR_PUT_U_LONG(buf, l2);
+	    IXDR_PUT_U_LONG(buf, l3);
+	} else {
+	    ulong_time_low = (ks_uint32_t) IXDR_GET_U_LONG(buf);
+	    l1 = (ks_uint32_t) IXDR_GET_U_LONG(buf);
+	    l2 = (ks_uint32_t) IXDR_GET_U_LONG(buf);
+	    l3 = (ks_uint32_t) IXDR_GET_U_LONG(buf);
+	}
+    } else if (!XDR_KS_U_INT32(xdrs, &ulong_time_low) ||
+	       !XDR_KS_U_INT32(xdrs, &l1) ||
+	       !XDR_KS_U_INT32(xdrs, &l2) ||
+	       !XDR_KS_U_INT32(xdrs, &l3))
 	return (FALSE);
 
     if (xdrs->x_op == XDR_DECODE) {
@@ -184,6 +209,7 @@ EZ_XDR_ROUTINE(tbs_fstat_db_t)
 {
     ks_int32_t size_high; 
     ks_uint32_t size_low;
+    rpc_inline_t *buf;
 
     /*
      * We need to have the code independent of Big/Little endian.
@@ -193,19 +219,67 @@ EZ_XDR_ROUTINE(tbs_fstat_db_t)
 	KS_LLONG_SPLIT(objp->size, size_high, size_low);
     }
 
-    if (!xdr_tbs_ftype_t(xdrs, &objp->type EZ_XDR_ARG_PASSTHRU) ||
-	!xdr_tbs_fmode_t(xdrs, &objp->mode EZ_XDR_ARG_PASSTHRU) ||
-	!xdr_u_long(xdrs, &objp->nlink) ||
-	!xdr_u_long(xdrs, &objp->flags) ||
-	!xdr_credutl_sid_t(xdrs, &objp->usid EZ_XDR_ARG_PASSTHRU) ||
-	!xdr_credutl_sid_t(xdrs, &objp->gsid EZ_XDR_ARG_PASSTHRU) ||
-	!XDR_KS_U_INT32(xdrs, &size_low) ||
-	!XDR_KS_INT32(xdrs, &size_high) ||
-	!xdr_u_long(xdrs, &objp->nodeid) ||
-	!xdr_timeval(xdrs, &objp->xtime) ||
-	!xdr_timeval(xdrs, &objp->atime) ||
-	!xdr_timeval(xdrs, &objp->mtime) ||
-	!xdr_timeval(xdrs, &objp->ctime)) {
+    /*
+     * The SIDs are variable length, so the fixed fields on either side of
+     * them are each moved inline when the buffer has room.
+     */
+    if ((buf = XDR_INLINE(xdrs, 4 * BYTES_PER_XDR_UNIT)) != NULL) {
+	if (xdrs->x_op == XDR_ENCODE) {
+	    IXDR_PUT_U_LONG(buf, objp->type);
+	    IXDR_PUT_U_LONG(buf, objp->mode);
+	    IXDR_PUT_U_LONG(buf, objp->nlink);
+	    IXDR_PUT_U_LONG(buf, objp->flags);
+	} else {
+	    objp->type = (tbs_ftype_t) IXDR_GET_U_LONG(buf);
+	    objp->mode = (tbs_fmode_t) IXDR_GET_U_LONG(buf);
+	    objp->nlink = IXDR_GET_U_LONG(buf);
+	    objp->flags = IXDR_GET_U_LONG(buf);
+	}
+    } else if (!xdr_tbs_ftype_t(xdrs, &objp->type EZ_XDR_ARG_PASSTHRU) ||
+	       !xdr_tbs_fmode_t(xdrs, &objp->mode EZ_XDR_ARG_PASSTHRU) ||
+	       !xdr_u_long(xdrs, &objp->nlink) ||
+	       !xdr_u_long(xdrs, &objp->flags)) {
+	return (FALSE);
+    }
+
+    if (!xdr_credutl_sid_t(xdrs, &objp->usid EZ_XDR_ARG_PASSTHRU) ||
+	!xdr_credutl_sid_t(xdrs, &objp->gsid EZ_XDR_ARG_PASSTHRU)) {
+	return (FALSE);
+    }
+
+    if ((buf = XDR_INLINE(xdrs, 11 * BYTES_PER_XDR_UNIT)) != NULL) {
+	if (xdrs->x_op == XDR_ENCODE) {
+	    IXDR_PUT_U_LONG(buf, size_low);
+	    IXDR_PUT_LONG(buf, size_high);
+	    IXDR_PUT_U_LONG(buf, objp->nodeid);
+	    IXDR_PUT_LONG(buf, objp->xtime.tv_sec);
+	    IXDR_PUT_LONG(buf, objp->xtime.tv_usec);
+	    IXDR_PUT_LONG(buf, objp->atime.tv_sec);
+	    IXDR_PUT_LONG(buf, objp->atime.tv_usec);
+	    IXDR_PUT_LONG(buf, objp->mtime.tv_sec);
+	    IXDR_PUT_LONG(buf, objp->mtime.tv_usec);
+	    IXDR_PUT_LONG(buf, objp->ctime.tv_sec);
+	    IXDR_PUT_LONG(buf, objp->ctime.tv_usec);
+	} else {
+	    size_low = (ks_uint32_t) IXDR_GET_U_LONG(buf);
+	    size_high = (ks_int32_t) IXDR_GET_LONG(buf);
+	    objp->nodeid = IXDR_GET_U_LONG(buf);
+	    objp->xtime.tv_sec = IXDR_GET_LONG(buf);
+	    objp->xtime.tv_usec = IXDR_GET_LONG(buf);
+	    objp->atime.tv_sec = IXDR_GET_LONG(buf);
+	    objp->atime.tv_usec = IXDR_GET_LONG(buf);
+	    objp->mtime.tv_sec = IXDR_GET_LONG(buf);
+	    objp->mtime.tv_usec = IXDR_GET_LONG(buf);
+	    objp->ctime.tv_sec = IXDR_GET_LONG(buf);
+	    objp->ctime.tv_usec = IXDR_GET_LONG(buf);
+	}
+    } else if (!XDR_KS_U_INT32(xdrs, &size_low) ||
+	       !XDR_KS_INT32(xdrs, &size_high) ||
+	       !xdr_u_long(xdrs, &objp->nodeid) ||
+	       !xdr_timeval(xdrs, &objp->xtime) ||
+	       !xdr_timeval(xdrs, &objp->atime) ||
+	       !xdr_timeval(xdrs, &objp->mtime) ||
+	       !xdr_timeval(xdrs, &objp->ctime)) {
 	return (FALSE);
     }
 
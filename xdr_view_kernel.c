@@ -38,6 +38,7 @@
 
 EZ_XDR_ROUTINE(view_fhandle_t)
 {
+    rpc_inline_t *buf;
 
     if (xdrs->x_op == XDR_FREE)
 	return TRUE;
@@ -45,6 +46,23 @@ EZ_XDR_ROUTINE(view_fhandle_t)
     if (!xdr_tbs_uuid_t(xdrs, &objp->vob_uuid EZ_XDR_ARG_PASSTHRU)) {
 	return (FALSE);
     }
+    /* Every RPC carries at least one of these; do the rest in one go. */
+    if ((buf = XDR_INLINE(xdrs, 5 * BYTES_PER_XDR_UNIT)) != NULL) {
+	if (xdrs->x_op == XDR_ENCODE) {
+	    IXDR_PUT_U_LONG(buf, objp->ver_dbid);
+	    IXDR_PUT_U_LONG(buf, objp->elem_dbid);
+	    IXDR_PUT_U_LONG(buf, objp->gen);
+	    IXDR_PUT_U_LONG(buf, objp->flags);
+	    IXDR_PUT_U_LONG(buf, objp->pad0);
+	} else {
+	    objp->ver_dbid = (tbs_dbid_t) IXDR_GET_U_LONG(buf);
+	    objp->elem_dbid = (tbs_dbid_t) IXDR_GET_U_LONG(buf);
+	    objp->gen = IXDR_GET_U_LONG(buf);
+	    objp->flags = IXDR_GET_U_LONG(buf);
+	    objp->pad0 = IXDR_GET_U_LONG(buf);
+	}
+	return (TRUE);
+    }
     return (xdr_tbs_dbid_t(xdrs, &objp->ver_dbid EZ_XDR_ARG_PASSTHRU) &&
 	    xdr_tbs_dbid_t(xdrs, &objp->elem_dbid EZ_XDR_ARG_PASSTHRU) &&
 	    xdr_u_long(xdrs, &objp->gen) &&